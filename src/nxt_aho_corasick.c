@@ -0,0 +1,252 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+
+
+/*
+ * The Aho-Corasick automaton finds whether any of the keywords occurs
+ * in a string in a single pass.  The goto and failure functions are
+ * compiled into a complete transition table, the columns of the table
+ * are the classes of bytes which occur in the keywords, all other bytes
+ * share the class 0.  In the caseless automaton the upper and the lower
+ * case letters share the same class.  Each state links the nearest state
+ * on its failure path which has keywords, so only the states ending
+ * some keywords are visited at each position.
+ */
+
+
+typedef struct {
+    u_char                    *start;
+    uint32_t                  length;
+    uint32_t                  next;    /* The next keyword number. */
+    uint8_t                   anchor;
+} nxt_aho_corasick_keyword_t;
+
+
+typedef struct {
+    uint32_t                  fail;
+    uint32_t                  output;  /* The nearest state with keywords. */
+    uint32_t                  keyword; /* The first keyword number. */
+} nxt_aho_corasick_state_t;
+
+
+struct nxt_aho_corasick_s {
+    nxt_mp_t                  *mem_pool;
+    nxt_array_t               *keywords;
+    nxt_aho_corasick_state_t  *states;
+    uint32_t                  *next;
+    uint32_t                  classes;
+    uint8_t                   caseless;  /* 1 bit */
+    uint16_t                  map[256];
+};
+
+
+nxt_aho_corasick_t *
+nxt_aho_corasick_create(nxt_mp_t *mp, nxt_bool_t caseless)
+{
+    nxt_aho_corasick_t  *ac;
+
+    ac = nxt_mp_zget(mp, sizeof(nxt_aho_corasick_t));
+    if (nxt_slow_path(ac == NULL)) {
+        return NULL;
+    }
+
+    ac->keywords = nxt_array_create(mp, 8, sizeof(nxt_aho_corasick_keyword_t));
+    if (nxt_slow_path(ac->keywords == NULL)) {
+        return NULL;
+    }
+
+    ac->mem_pool = mp;
+    ac->caseless = caseless;
+
+    return ac;
+}
+
+
+/* The keyword must not be changed until the automaton is compiled. */
+
+nxt_int_t
+nxt_aho_corasick_add(nxt_aho_corasick_t *ac, u_char *start, size_t length,
+    nxt_uint_t anchor)
+{
+    nxt_aho_corasick_keyword_t  *kw;
+
+    if (nxt_slow_path(length == 0 || ac->states != NULL)) {
+        return NXT_ERROR;
+    }
+
+    kw = nxt_array_add(ac->keywords);
+    if (nxt_slow_path(kw == NULL)) {
+        return NXT_ERROR;
+    }
+
+    kw->start = start;
+    kw->length = length;
+    kw->next = 0;
+    kw->anchor = anchor;
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+nxt_aho_corasick_compile(nxt_aho_corasick_t *ac)
+{
+    u_char                      c;
+    size_t                      size;
+    uint32_t                    i, j, n, s, t, f, cl, head, tail, *queue;
+    nxt_aho_corasick_state_t    *states;
+    nxt_aho_corasick_keyword_t  *kw;
+
+    kw = ac->keywords->elts;
+    n = 1;
+
+    for (i = 0; i < ac->keywords->nelts; i++) {
+        for (j = 0; j < kw[i].length; j++) {
+            c = kw[i].start[j];
+
+            if (ac->caseless) {
+                c = nxt_lowcase(c);
+            }
+
+            ac->map[c] = 1;
+        }
+
+        n += kw[i].length;
+    }
+
+    ac->classes = 1;
+
+    for (i = 0; i < 256; i++) {
+        if (ac->map[i] != 0) {
+            ac->map[i] = ac->classes++;
+        }
+    }
+
+    if (ac->caseless) {
+        for (c = 'a'; c <= 'z'; c++) {
+            ac->map[c - 'a' + 'A'] = ac->map[c];
+        }
+    }
+
+    size = (size_t) n * ac->classes * sizeof(uint32_t);
+
+    ac->next = nxt_mp_zget(ac->mem_pool, size);
+    if (nxt_slow_path(ac->next == NULL)) {
+        return NXT_ERROR;
+    }
+
+    states = nxt_mp_zget(ac->mem_pool, n * sizeof(nxt_aho_corasick_state_t));
+    if (nxt_slow_path(states == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ac->states = states;
+
+    /* The goto function, the state 0 is the root. */
+
+    n = 1;
+
+    for (i = 0; i < ac->keywords->nelts; i++) {
+        s = 0;
+
+        for (j = 0; j < kw[i].length; j++) {
+            cl = ac->map[kw[i].start[j]];
+            t = ac->next[s * ac->classes + cl];
+
+            if (t == 0) {
+                t = n++;
+                ac->next[s * ac->classes + cl] = t;
+            }
+
+            s = t;
+        }
+
+        kw[i].next = states[s].keyword;
+        states[s].keyword = i + 1;
+    }
+
+    /* The failure function in the breadth-first order. */
+
+    queue = nxt_mp_alloc(ac->mem_pool, n * sizeof(uint32_t));
+    if (nxt_slow_path(queue == NULL)) {
+        return NXT_ERROR;
+    }
+
+    head = 0;
+    tail = 0;
+
+    for (cl = 0; cl < ac->classes; cl++) {
+        t = ac->next[cl];
+
+        if (t != 0) {
+            queue[tail++] = t;
+        }
+    }
+
+    while (head < tail) {
+        s = queue[head++];
+
+        for (cl = 0; cl < ac->classes; cl++) {
+            t = ac->next[s * ac->classes + cl];
+            f = ac->next[states[s].fail * ac->classes + cl];
+
+            if (t == 0) {
+                ac->next[s * ac->classes + cl] = f;
+                continue;
+            }
+
+            states[t].fail = f;
+            states[t].output = (states[f].keyword != 0) ? f : states[f].output;
+
+            queue[tail++] = t;
+        }
+    }
+
+    nxt_mp_free(ac->mem_pool, queue);
+
+    return NXT_OK;
+}
+
+
+nxt_bool_t
+nxt_aho_corasick_match(nxt_aho_corasick_t *ac, u_char *start, size_t length)
+{
+    size_t                      i;
+    uint32_t                    s, t, k;
+    nxt_aho_corasick_state_t    *states;
+    nxt_aho_corasick_keyword_t  *kw, *keywords;
+
+    states = ac->states;
+    keywords = ac->keywords->elts;
+
+    s = 0;
+
+    for (i = 0; i < length; i++) {
+        s = ac->next[s * ac->classes + ac->map[start[i]]];
+
+        for (t = s; t != 0; t = states[t].output) {
+
+            for (k = states[t].keyword; k != 0; k = kw->next) {
+                kw = &keywords[k - 1];
+
+                if ((kw->anchor & NXT_AHO_CORASICK_BEGIN)
+                    && kw->length != i + 1)
+                {
+                    continue;
+                }
+
+                if ((kw->anchor & NXT_AHO_CORASICK_END) && i + 1 != length) {
+                    continue;
+                }
+
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,27 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_AHO_CORASICK_H_INCLUDED_
+#define _NXT_AHO_CORASICK_H_INCLUDED_
+
+
+typedef struct nxt_aho_corasick_s  nxt_aho_corasick_t;
+
+
+/* The keyword must start and/or end the matched string. */
+#define NXT_AHO_CORASICK_BEGIN  1
+#define NXT_AHO_CORASICK_END    2
+
+
+NXT_EXPORT nxt_aho_corasick_t *nxt_aho_corasick_create(nxt_mp_t *mp,
+    nxt_bool_t caseless);
+NXT_EXPORT nxt_int_t nxt_aho_corasick_add(nxt_aho_corasick_t *ac,
+    u_char *start, size_t length, nxt_uint_t anchor);
+NXT_EXPORT nxt_int_t nxt_aho_corasick_compile(nxt_aho_corasick_t *ac);
+NXT_EXPORT nxt_bool_t nxt_aho_corasick_match(nxt_aho_corasick_t *ac,
+    u_char *start, size_t length);
+
+
+#endif /* _NXT_AHO_CORASICK_H_INCLUDED_ */
@@ -53,6 +53,8 @@ static nxt_int_t nxt_proto_setup(nxt_task_t *task, nxt_process_t *process);
 static nxt_int_t nxt_proto_start(nxt_task_t *task, nxt_process_data_t *data);
 static nxt_int_t nxt_app_setup(nxt_task_t *task, nxt_process_t *process);
 static nxt_int_t nxt_app_set_environment(nxt_conf_value_t *environment);
+static nxt_int_t nxt_proto_cpu_affinity(nxt_task_t *task,
+    nxt_process_t *process, nxt_conf_value_t *value);
 static void nxt_proto_start_process_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
 static void nxt_proto_quit_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg);
@@ -80,6 +82,10 @@ static nxt_lvlhsh_t           nxt_proto_processes;
 static nxt_queue_t            nxt_proto_children;
 static nxt_bool_t             nxt_proto_exiting;
 
+static nxt_cpuset_t           *nxt_proto_cpuset;
+static nxt_bool_t             nxt_proto_cpu_spread;
+static nxt_uint_t             nxt_proto_cpu;
+
 static nxt_app_module_t       *nxt_app;
 static nxt_common_app_conf_t  *nxt_app_conf;
 
@@ -540,6 +546,13 @@ nxt_proto_setup(nxt_task_t *task, nxt_process_t *process)
         return NXT_ERROR;
     }
 
+    if (app_conf->cpu_affinity != NULL) {
+        ret = nxt_proto_cpu_affinity(task, process, app_conf->cpu_affinity);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
     if (nxt_app->setup != NULL) {
         ret = nxt_app->setup(task, process, app_conf);
         if (nxt_slow_path(ret != NXT_OK)) {
@@ -652,6 +665,8 @@ nxt_proto_start_process_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         goto failed;
     }
 
+    nxt_proto_cpu++;
+
     nxt_proto_process_add(task, process);
 
     return;
@@ -1015,12 +1030,52 @@ nxt_app_setup(nxt_task_t *task, nxt_process_t *process)
 
     process->state = NXT_PROCESS_STATE_CREATED;
 
+    if (nxt_proto_cpu_spread) {
+        (void) nxt_cpuset_bind(task, 0, nxt_proto_cpuset, nxt_proto_cpu);
+    }
+
     init = nxt_process_init(process);
 
     return init->start(task, &process->data);
 }
 
 
+/*
+ * Application processes inherit the CPU mask of the prototype process;
+ * with "spread" each next process is bound to the next CPU of the set.
+ */
+
+static nxt_int_t
+nxt_proto_cpu_affinity(nxt_task_t *task, nxt_process_t *process,
+    nxt_conf_value_t *value)
+{
+    nxt_str_t         str;
+    nxt_conf_value_t  *spread;
+
+    static nxt_str_t  cpus_name = nxt_string("cpus");
+    static nxt_str_t  spread_name = nxt_string("spread");
+
+    if (nxt_conf_type(value) == NXT_CONF_OBJECT) {
+        spread = nxt_conf_get_object_member(value, &spread_name, NULL);
+
+        nxt_proto_cpu_spread = (spread != NULL
+                                && nxt_conf_get_boolean(spread));
+
+        value = nxt_conf_get_object_member(value, &cpus_name, NULL);
+    }
+
+    nxt_conf_get_string(value, &str);
+
+    nxt_proto_cpuset = nxt_cpuset_parse(process->mem_pool, &str);
+    if (nxt_slow_path(nxt_proto_cpuset == NULL)) {
+        nxt_alert(task, "invalid CPU list \"%V\"", &str);
+        return NXT_ERROR;
+    }
+
+    return nxt_cpuset_bind(task, 0, nxt_proto_cpuset, -1);
+}
+
+
 nxt_app_lang_module_t *
 nxt_app_lang_module(nxt_runtime_t *rt, nxt_str_t *name)
 {
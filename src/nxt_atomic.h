@@ -12,6 +12,7 @@
  * nxt_atomic_try_lock() must set an acquire barrier on lock.
  * nxt_atomic_xchg() must set an acquire barrier.
  * nxt_atomic_release() must set a release barrier.
+ * nxt_memory_barrier() must set a full barrier.
  */
 
 #if (NXT_HAVE_GCC_ATOMIC) /* GCC 4.1 builtin atomic operations */
@@ -54,6 +55,10 @@ typedef volatile nxt_atomic_uint_t  nxt_atomic_t;
     __sync_and_and_fetch(ptr, val)
 
 
+#define nxt_memory_barrier()                                                  \
+    __sync_synchronize()
+
+
 #if (__i386__ || __i386 || __amd64__ || __amd64)
 #define nxt_cpu_pause()                                                       \
     __asm__ ("pause")
@@ -96,6 +101,10 @@ typedef volatile nxt_atomic_uint_t  nxt_atomic_t;
     atomic_and_ulong_nv(ptr, val)
 
 
+#define nxt_memory_barrier()                                                  \
+    do { membar_producer(); membar_consumer(); } while (0)
+
+
 /*
  * Solaris uses SPARC Total Store Order model.  In this model:
  * 1) Each atomic load-store instruction behaves as if it were followed by
@@ -260,6 +269,10 @@ nxt_atomic_try_lock(nxt_atomic_t *lock)
     do { __lwsync(); *lock = 0; } while (0)
 
 
+#define nxt_memory_barrier()                                                  \
+    __sync()
+
+
 #define nxt_cpu_pause()
 
 
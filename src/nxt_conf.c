@@ -399,6 +399,25 @@ nxt_conf_set_element_string_dup(nxt_conf_value_t *array, nxt_mp_t *mp,
 }
 
 
+void
+nxt_conf_set_element_integer(nxt_conf_value_t *array, nxt_uint_t index,
+    int64_t value)
+{
+    u_char            *p, *end;
+    nxt_conf_value_t  *element;
+
+    element = &array->u.array->elements[index];
+
+    p = element->u.number;
+    end = p + NXT_CONF_MAX_NUMBER_LEN;
+
+    end = nxt_sprintf(p, end, "%L", value);
+    *end = '\0';
+
+    element->type = NXT_CONF_VALUE_INTEGER;
+}
+
+
 nxt_uint_t
 nxt_conf_array_elements_count(nxt_conf_value_t *value)
 {
@@ -143,6 +143,8 @@ void nxt_conf_set_element(nxt_conf_value_t *array, nxt_uint_t index,
     const nxt_conf_value_t *value);
 nxt_int_t nxt_conf_set_element_string_dup(nxt_conf_value_t *array, nxt_mp_t *mp,
     nxt_uint_t index, nxt_str_t *value);
+void nxt_conf_set_element_integer(nxt_conf_value_t *array, nxt_uint_t index,
+    int64_t value);
 NXT_EXPORT nxt_uint_t nxt_conf_array_elements_count(nxt_conf_value_t *value);
 NXT_EXPORT nxt_uint_t nxt_conf_array_elements_count_or_1(
     nxt_conf_value_t *value);
@@ -12,6 +12,7 @@
 #include <nxt_http.h>
 #include <nxt_sockaddr.h>
 #include <nxt_http_route_addr.h>
+#include <nxt_http_compress.h>
 #include <nxt_regex.h>
 
 
@@ -51,6 +52,11 @@ typedef nxt_int_t (*nxt_conf_vldt_element_t)(nxt_conf_validation_t *vldt,
 
 typedef struct nxt_conf_vldt_object_s  nxt_conf_vldt_object_t;
 
+typedef struct {
+    const char                    *name;
+    int64_t                       min;
+} nxt_conf_vldt_number_t;
+
 struct nxt_conf_vldt_object_s {
     nxt_str_t                     name;
     nxt_conf_vldt_type_t          type:32;
@@ -63,6 +69,7 @@ struct nxt_conf_vldt_object_s {
         nxt_conf_vldt_member_t    object;
         nxt_conf_vldt_element_t   array;
         const char                *string;
+        nxt_conf_vldt_number_t    *number;
     } u;
 };
 
@@ -71,6 +78,10 @@ struct nxt_conf_vldt_object_s {
 #define NXT_CONF_VLDT_END         { .name = nxt_null_string }
 
 
+#define NXT_CONF_VLDT_ACCESS_LOG_BUFFER_MAX  (1024 * 1024 * 1024)
+#define NXT_CONF_VLDT_ACCESS_LOG_FLUSH_MAX   86400
+
+
 static nxt_int_t nxt_conf_vldt_type(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value, nxt_conf_vldt_type_t type);
 static nxt_int_t nxt_conf_vldt_error(nxt_conf_validation_t *vldt,
@@ -90,6 +101,8 @@ static nxt_int_t nxt_conf_vldt_mtypes_extension(nxt_conf_validation_t *vldt,
 static nxt_int_t nxt_conf_vldt_listener(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 #if (NXT_TLS)
+static nxt_int_t nxt_conf_vldt_tls(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_certificate(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 #if (NXT_HAVE_OPENSSL_CONF_CMD)
@@ -119,6 +132,12 @@ static nxt_int_t nxt_conf_vldt_share(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_share_element(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_precompressed(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_precompressed_element(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_proxy(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_python(nxt_conf_validation_t *vldt,
@@ -167,12 +186,24 @@ static nxt_int_t nxt_conf_vldt_match_addrs(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_match_addr(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_compress(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compress_encodings(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compress_encoding(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_compress_level(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compress_min_length(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_response_header(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_app_name(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_forwarded(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_reuseport(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_app(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_object(nxt_conf_validation_t *vldt,
@@ -207,11 +238,29 @@ static nxt_int_t nxt_conf_vldt_server(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_server_weight(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_keepalive_max_idle(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_access_log(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_access_log_buffer(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_access_log_flush(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_access_log_sample(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_access_log_status(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_access_log_status_element(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value);
 
 static nxt_int_t nxt_conf_vldt_isolation(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+static nxt_int_t nxt_conf_vldt_cpu_affinity(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_cpu_list(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+#endif
 static nxt_int_t nxt_conf_vldt_clone_namespaces(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 
@@ -257,6 +306,9 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_common_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_limits_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_processes_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_isolation_members[];
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+static nxt_conf_vldt_object_t  nxt_conf_vldt_app_cpu_affinity_members[];
+#endif
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_namespaces_members[];
 #if (NXT_HAVE_CGROUP)
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_cgroup_members[];
@@ -265,6 +317,7 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_app_cgroup_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_automount_members[];
 #endif
 static nxt_conf_vldt_object_t  nxt_conf_vldt_access_log_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_access_log_filter_members[];
 
 
 static nxt_conf_vldt_object_t  nxt_conf_vldt_root_members[] = {
@@ -313,6 +366,12 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_setting_members[] = {
         .name       = nxt_string("js_module"),
         .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
         .validator  = nxt_conf_vldt_js_module,
+#endif
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+    }, {
+        .name       = nxt_string("cpu_affinity"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_cpu_list,
 #endif
     },
 
@@ -420,14 +479,22 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_listener_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_client_ip_members
+    }, {
+        .name       = nxt_string("access_log"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_access_log_filter_members,
+    }, {
+        .name       = nxt_string("reuseport"),
+        .type       = NXT_CONF_VLDT_BOOLEAN | NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_reuseport,
     },
 
 #if (NXT_TLS)
     {
         .name       = nxt_string("tls"),
         .type       = NXT_CONF_VLDT_OBJECT,
-        .validator  = nxt_conf_vldt_object,
-        .u.members  = nxt_conf_vldt_tls_members,
+        .validator  = nxt_conf_vldt_tls,
     },
 #endif
 
@@ -497,6 +564,26 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_tls_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_session_members,
+    }, {
+        .name       = nxt_string("http2"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    }, {
+        .name       = nxt_string("ktls"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_OPENSSL_KTLS)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "ktls",
+#endif
+    }, {
+        .name       = nxt_string("handshake_offload"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    }, {
+        .name       = nxt_string("early_data"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_OPENSSL_EARLY_DATA)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "early_data",
+#endif
     },
 
     NXT_CONF_VLDT_END
@@ -680,6 +767,100 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_match_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT | NXT_CONF_VLDT_ARRAY,
         .validator  = nxt_conf_vldt_match_patterns_sets,
         .u.string   = "cookies"
+    }, {
+        .name       = nxt_string("tls_early_data"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_compress_members[] = {
+    {
+        .name       = nxt_string("encodings"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_compress_encodings,
+    }, {
+        .name       = nxt_string("types"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_match_patterns,
+    }, {
+        .name       = nxt_string("level"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_compress_level,
+    }, {
+        .name       = nxt_string("min_length"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_compress_min_length,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_number_t  nxt_conf_vldt_open_file_cache_max = {
+    "max", 1
+};
+
+static nxt_conf_vldt_number_t  nxt_conf_vldt_open_file_cache_valid = {
+    "valid", 1
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_open_file_cache_members[] = {
+    {
+        .name       = nxt_string("max"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_number,
+        .u.number   = &nxt_conf_vldt_open_file_cache_max,
+    }, {
+        .name       = nxt_string("valid"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_number,
+        .u.number   = &nxt_conf_vldt_open_file_cache_valid,
+    }, {
+        .name       = nxt_string("errors"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_number_t  nxt_conf_vldt_cache_max_size = {
+    "max_size", 0
+};
+
+static nxt_conf_vldt_number_t  nxt_conf_vldt_cache_valid = {
+    "valid", 0
+};
+
+static nxt_conf_vldt_number_t  nxt_conf_vldt_cache_stale_while_revalidate = {
+    "stale_while_revalidate", 0
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_cache_members[] = {
+    {
+        .name       = nxt_string("key"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("max_size"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_number,
+        .u.number   = &nxt_conf_vldt_cache_max_size,
+    }, {
+        .name       = nxt_string("valid"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_number,
+        .u.number   = &nxt_conf_vldt_cache_valid,
+    }, {
+        .name       = nxt_string("stale_while_revalidate"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_number,
+        .u.number   = &nxt_conf_vldt_cache_stale_while_revalidate,
     },
 
     NXT_CONF_VLDT_END
@@ -698,6 +879,24 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_action_common_members[] = {
         .validator  = nxt_conf_vldt_object_iterator,
         .u.object   = nxt_conf_vldt_response_header,
     },
+    {
+        .name       = nxt_string("compress"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_compress,
+        .u.members  = nxt_conf_vldt_compress_members,
+    },
+    {
+        .name       = nxt_string("cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_cache_members,
+    },
+    {
+        .name       = nxt_string("access_log"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_access_log_filter_members,
+    },
 
     NXT_CONF_VLDT_END
 };
@@ -742,6 +941,16 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_share_action_members[] = {
         .name       = nxt_string("types"),
         .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
         .validator  = nxt_conf_vldt_match_patterns,
+    }, {
+        .name       = nxt_string("precompressed"),
+        .type       = NXT_CONF_VLDT_BOOLEAN | NXT_CONF_VLDT_STRING
+                      | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_precompressed,
+    }, {
+        .name       = nxt_string("open_file_cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_open_file_cache_members,
     }, {
         .name       = nxt_string("fallback"),
         .type       = NXT_CONF_VLDT_OBJECT,
@@ -1137,6 +1346,13 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_common_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_isolation,
         .u.members  = nxt_conf_vldt_app_isolation_members,
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+    }, {
+        .name       = nxt_string("cpu_affinity"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_cpu_affinity,
+        .u.members  = nxt_conf_vldt_app_cpu_affinity_members,
+#endif
     }, {
         .name       = nxt_string("stdout"),
         .type       = NXT_CONF_VLDT_STRING,
@@ -1149,6 +1365,25 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_common_members[] = {
 };
 
 
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_app_cpu_affinity_members[] = {
+    {
+        .name       = nxt_string("cpus"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_cpu_list,
+        .flags      = NXT_CONF_VLDT_REQUIRED,
+    }, {
+        .name       = nxt_string("spread"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+#endif
+
+
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_limits_members[] = {
     {
         .name       = nxt_string("timeout"),
@@ -1339,12 +1574,31 @@ static nxt_conf_vldt_object_t nxt_conf_vldt_app_procmap_members[] = {
 #endif
 
 
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_keepalive_members[] = {
+    {
+        .name       = nxt_string("max_idle"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_keepalive_max_idle,
+    }, {
+        .name       = nxt_string("idle_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
 static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_members[] = {
     {
         .name       = nxt_string("servers"),
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object_iterator,
         .u.object   = nxt_conf_vldt_server,
+    }, {
+        .name       = nxt_string("keepalive"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_upstream_keepalive_members,
     },
 
     NXT_CONF_VLDT_END
@@ -1369,6 +1623,29 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_access_log_members[] = {
     }, {
         .name       = nxt_string("format"),
         .type       = NXT_CONF_VLDT_STRING,
+    }, {
+        .name       = nxt_string("buffer"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_access_log_buffer,
+    }, {
+        .name       = nxt_string("flush"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_access_log_flush,
+    },
+
+    NXT_CONF_VLDT_NEXT(nxt_conf_vldt_access_log_filter_members)
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_access_log_filter_members[] = {
+    {
+        .name       = nxt_string("sample"),
+        .type       = NXT_CONF_VLDT_NUMBER,
+        .validator  = nxt_conf_vldt_access_log_sample,
+    }, {
+        .name       = nxt_string("status"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_access_log_status,
     },
 
     NXT_CONF_VLDT_END
@@ -1894,6 +2171,79 @@ nxt_conf_vldt_share_element(nxt_conf_validation_t *vldt,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_precompressed(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    switch (nxt_conf_type(value)) {
+
+    case NXT_CONF_BOOLEAN:
+        return NXT_OK;
+
+    case NXT_CONF_ARRAY:
+        if (nxt_conf_array_elements_count(value) == 0) {
+            return nxt_conf_vldt_error(vldt, "The \"precompressed\" array "
+                                       "must contain at least one element.");
+        }
+
+        return nxt_conf_vldt_array_iterator(vldt, value,
+                                       &nxt_conf_vldt_precompressed_element);
+
+    default:
+        /* NXT_CONF_STRING */
+        return nxt_conf_vldt_precompressed_element(vldt, value);
+    }
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_precompressed_element(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value)
+{
+    nxt_str_t  token;
+
+    if (nxt_conf_type(value) != NXT_CONF_STRING) {
+        return nxt_conf_vldt_error(vldt, "The \"precompressed\" array must "
+                                   "contain only string values.");
+    }
+
+    nxt_conf_get_string(value, &token);
+
+    if (nxt_http_static_encoding_index(&token) < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%V\" precompressed "
+                                   "encoding is not supported.", &token);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_number(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    int64_t                 n;
+    nxt_conf_vldt_number_t  *number;
+
+    number = data;
+    n = nxt_conf_get_number(value);
+
+    if (n < number->min) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "equal to or greater than %L.",
+                                   number->name, number->min);
+    }
+
+    if (n > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed %d.", number->name,
+                                   NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_proxy(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
     void *data)
@@ -2431,6 +2781,56 @@ nxt_conf_vldt_match_patterns_set_member(nxt_conf_validation_t *vldt,
 
 #if (NXT_TLS)
 
+static nxt_int_t
+nxt_conf_vldt_tls(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    nxt_int_t         ret;
+    nxt_conf_value_t  *early_data, *cache_size, *tickets;
+
+    static nxt_str_t  early_data_path = nxt_string("/early_data");
+    static nxt_str_t  cache_size_path = nxt_string("/session/cache_size");
+    static nxt_str_t  tickets_path = nxt_string("/session/tickets");
+
+    ret = nxt_conf_vldt_object(vldt, value, nxt_conf_vldt_tls_members);
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
+    early_data = nxt_conf_get_path(value, &early_data_path);
+
+    if (early_data == NULL || !nxt_conf_get_boolean(early_data)) {
+        return NXT_OK;
+    }
+
+    /*
+     * Early data are protected against replays by single use sessions
+     * in the shared session cache, hence stateless tickets are not used.
+     */
+
+    cache_size = nxt_conf_get_path(value, &cache_size_path);
+
+    if (cache_size == NULL || nxt_conf_get_number(cache_size) == 0) {
+        return nxt_conf_vldt_error(vldt, "The \"early_data\" option requires "
+                                   "the \"session\" \"cache_size\" option "
+                                   "to be set.");
+    }
+
+    tickets = nxt_conf_get_path(value, &tickets_path);
+
+    if (tickets != NULL
+        && (nxt_conf_type(tickets) != NXT_CONF_BOOLEAN
+            || nxt_conf_get_boolean(tickets)))
+    {
+        return nxt_conf_vldt_error(vldt, "The \"early_data\" option cannot "
+                                   "be used with stateless session "
+                                   "\"tickets\".");
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_certificate(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
     void *data)
@@ -2510,6 +2910,91 @@ nxt_conf_vldt_object_conf_commands(nxt_conf_validation_t *vldt,
 #endif
 
 
+static nxt_int_t
+nxt_conf_vldt_compress(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    if (nxt_http_compressors_count() == 0) {
+        return nxt_conf_vldt_error(vldt, "Response compression is not "
+                                         "supported by this build.");
+    }
+
+    return nxt_conf_vldt_object(vldt, value, data);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compress_encodings(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_type(value) == NXT_CONF_ARRAY) {
+        if (nxt_conf_array_elements_count(value) == 0) {
+            return nxt_conf_vldt_error(vldt, "The \"encodings\" array "
+                                             "must not be empty.");
+        }
+
+        return nxt_conf_vldt_array_iterator(vldt, value,
+                                            &nxt_conf_vldt_compress_encoding);
+    }
+
+    /* NXT_CONF_STRING */
+
+    return nxt_conf_vldt_compress_encoding(vldt, value);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compress_encoding(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value)
+{
+    nxt_str_t  token;
+
+    if (nxt_conf_type(value) != NXT_CONF_STRING) {
+        return nxt_conf_vldt_error(vldt, "The \"encodings\" array must "
+                                         "contain only string values.");
+    }
+
+    nxt_conf_get_string(value, &token);
+
+    if (nxt_http_compressor_find(&token) == NULL) {
+        return nxt_conf_vldt_error(vldt, "The \"%V\" content encoding "
+                                         "is not supported.", &token);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compress_level(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  level;
+
+    level = nxt_conf_get_number(value);
+
+    if (level < 1 || level > 19) {
+        return nxt_conf_vldt_error(vldt, "The \"level\" number must be "
+                                         "in the 1-19 range.");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compress_min_length(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_get_number(value) < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"min_length\" number must "
+                                         "not be negative.");
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_response_header(nxt_conf_validation_t *vldt, nxt_str_t *name,
     nxt_conf_value_t *value)
@@ -2594,6 +3079,27 @@ nxt_conf_vldt_forwarded(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_reuseport(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    nxt_str_t  str;
+
+    if (nxt_conf_type(value) != NXT_CONF_STRING) {
+        return NXT_OK;
+    }
+
+    nxt_conf_get_string(value, &str);
+
+    if (nxt_str_eq(&str, "cpu", 3)) {
+        return NXT_OK;
+    }
+
+    return nxt_conf_vldt_error(vldt, "The \"reuseport\" option must be "
+                               "a boolean or \"cpu\".");
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_app(nxt_conf_validation_t *vldt, nxt_str_t *name,
     nxt_conf_value_t *value)
@@ -3049,6 +3555,42 @@ nxt_conf_vldt_isolation(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
 }
 
 
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+
+static nxt_int_t
+nxt_conf_vldt_cpu_affinity(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_type(value) == NXT_CONF_OBJECT) {
+        return nxt_conf_vldt_object(vldt, value, data);
+    }
+
+    return nxt_conf_vldt_cpu_list(vldt, value, NULL);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_cpu_list(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    nxt_str_t  str;
+
+    nxt_conf_get_string(value, &str);
+
+    if (nxt_cpuset_parse(vldt->pool, &str) == NULL) {
+        return nxt_conf_vldt_error(vldt, "The CPU list \"%V\" is invalid, "
+                                   "it must consist of CPU numbers and "
+                                   "ranges less than %d separated by "
+                                   "commas, such as \"0-3,8\".",
+                                   &str, NXT_CPUSET_MAX);
+    }
+
+    return NXT_OK;
+}
+
+#endif
+
+
 #if (NXT_HAVE_CLONE_NEWUSER)
 
 typedef struct {
@@ -3339,6 +3881,28 @@ nxt_conf_vldt_server_weight(nxt_conf_validation_t *vldt,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_keepalive_max_idle(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  max_idle;
+
+    max_idle = nxt_conf_get_number(value);
+
+    if (max_idle < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"max_idle\" number must be "
+                                   "equal to or greater than 0.");
+    }
+
+    if (max_idle > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"max_idle\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
 #if (NXT_HAVE_NJS)
 
 static nxt_int_t
@@ -3442,3 +4006,110 @@ nxt_conf_vldt_access_log(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
 
     return NXT_OK;
 }
+
+
+static nxt_int_t
+nxt_conf_vldt_access_log_buffer(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  size;
+
+    size = nxt_conf_get_number(value);
+
+    if (size < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"buffer\" number must be "
+                                   "equal to or greater than 0.");
+    }
+
+    if (size > NXT_CONF_VLDT_ACCESS_LOG_BUFFER_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"buffer\" number must "
+                                   "not exceed %d.",
+                                   NXT_CONF_VLDT_ACCESS_LOG_BUFFER_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_access_log_flush(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  flush;
+
+    flush = nxt_conf_get_number(value);
+
+    if (flush < 1) {
+        return nxt_conf_vldt_error(vldt, "The \"flush\" number must be "
+                                   "equal to or greater than 1.");
+    }
+
+    if (flush > NXT_CONF_VLDT_ACCESS_LOG_FLUSH_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"flush\" number must "
+                                   "not exceed %d.",
+                                   NXT_CONF_VLDT_ACCESS_LOG_FLUSH_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_access_log_sample(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    double  sample;
+
+    sample = nxt_conf_get_number(value);
+
+    if (sample < 0 || sample > 1) {
+        return nxt_conf_vldt_error(vldt, "The \"sample\" number must be "
+                                   "between 0 and 1.");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_access_log_status(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_type(value) == NXT_CONF_ARRAY) {
+        if (nxt_conf_array_elements_count(value) == 0) {
+            return nxt_conf_vldt_error(vldt, "The \"status\" array must "
+                                       "contain at least one element.");
+        }
+
+        return nxt_conf_vldt_array_iterator(vldt, value,
+                                     &nxt_conf_vldt_access_log_status_element);
+    }
+
+    return nxt_conf_vldt_access_log_status_element(vldt, value);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_access_log_status_element(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value)
+{
+    nxt_str_t  str;
+
+    if (nxt_conf_type(value) != NXT_CONF_STRING) {
+        return nxt_conf_vldt_error(vldt, "The \"status\" array must "
+                                   "contain only string values.");
+    }
+
+    nxt_conf_get_string(value, &str);
+
+    if (str.length != 3
+        || str.start[0] < '1' || str.start[0] > '5'
+        || (str.start[1] | 0x20) != 'x' || (str.start[2] | 0x20) != 'x')
+    {
+        return nxt_conf_vldt_error(vldt, "The \"status\" value \"%V\" is "
+                                   "not a status class from \"1xx\" to "
+                                   "\"5xx\".", &str);
+    }
+
+    return NXT_OK;
+}
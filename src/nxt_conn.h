@@ -168,6 +168,8 @@ struct nxt_conn_s {
 
     uint8_t                       sendfile;     /* 2 bits */
     uint8_t                       tcp_nodelay;  /* 1 bit */
+    uint8_t                       http2;        /* 1 bit */
+    uint8_t                       tls_early_data;  /* 1 bit */
 
     nxt_queue_link_t              link;
 };
@@ -237,6 +239,8 @@ void nxt_conn_connect_error(nxt_task_t *task, void *obj, void *data);
 
 NXT_EXPORT nxt_listen_event_t *nxt_listen_event(nxt_task_t *task,
     nxt_listen_socket_t *ls);
+NXT_EXPORT nxt_listen_event_t *nxt_listen_event_socket(nxt_task_t *task,
+    nxt_listen_socket_t *ls, nxt_socket_t s);
 void nxt_conn_io_accept(nxt_task_t *task, void *obj, void *data);
 NXT_EXPORT void nxt_conn_accept(nxt_task_t *task, nxt_listen_event_t *lev,
     nxt_conn_t *c);
@@ -250,6 +254,13 @@ ssize_t nxt_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b);
 ssize_t nxt_conn_io_recv(nxt_conn_t *c, void *buf, size_t size,
     nxt_uint_t flags);
 
+#if (NXT_HAVE_IO_URING)
+void nxt_io_uring_conn_io_accept(nxt_task_t *task, void *obj, void *data);
+ssize_t nxt_io_uring_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b);
+ssize_t nxt_io_uring_conn_io_recv(nxt_conn_t *c, void *buf, size_t size,
+    nxt_uint_t flags);
+#endif
+
 void nxt_conn_io_write(nxt_task_t *task, void *obj, void *data);
 ssize_t nxt_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb);
 ssize_t nxt_conn_io_writev(nxt_task_t *task, nxt_sendbuf_t *sb,
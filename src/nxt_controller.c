@@ -32,6 +32,7 @@ typedef struct {
 typedef struct {
     nxt_uint_t        status;
     nxt_conf_value_t  *conf;
+    nxt_buf_t         *text;
 
     u_char            *title;
     nxt_str_t         detail;
@@ -93,6 +94,10 @@ static void nxt_controller_status_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_controller_status_response(nxt_task_t *task,
     nxt_controller_request_t *req, nxt_str_t *path);
+static void nxt_controller_process_metrics(nxt_task_t *task,
+    nxt_controller_request_t *req);
+static void nxt_controller_status_shm_handler(nxt_task_t *task,
+    nxt_port_recv_msg_t *msg, void *data);
 #if (NXT_TLS)
 static void nxt_controller_process_cert(nxt_task_t *task,
     nxt_controller_request_t *req, nxt_str_t *path);
@@ -138,6 +143,7 @@ static nxt_controller_conf_t   nxt_controller_conf;
 static nxt_queue_t             nxt_controller_waiting_requests;
 static nxt_bool_t              nxt_controller_waiting_init_conf;
 static nxt_conf_value_t        *nxt_controller_status;
+static nxt_status_shm_t        *nxt_controller_status_shm;
 
 
 static const nxt_event_conn_state_t  nxt_controller_conn_read_state;
@@ -498,6 +504,11 @@ nxt_controller_remove_pid_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
     process = nxt_runtime_process_find(rt, pid);
     if (process != NULL && nxt_process_type(process) == NXT_PROCESS_ROUTER) {
         nxt_controller_router_ready = 0;
+
+        if (nxt_controller_status_shm != NULL) {
+            nxt_mem_munmap(nxt_controller_status_shm, NXT_STATUS_SHM_SIZE);
+            nxt_controller_status_shm = NULL;
+        }
     }
 
     nxt_port_remove_pid_handler(task, msg);
@@ -1136,6 +1147,16 @@ nxt_controller_process_request(nxt_task_t *task, nxt_controller_request_t *req)
         return;
     }
 
+    if (nxt_str_eq(&path, "/metrics", 8)) {
+
+        if (!nxt_str_eq(&req->parser.method, "GET", 3)) {
+            goto invalid_method;
+        }
+
+        nxt_controller_process_metrics(task, req);
+        return;
+    }
+
 #if (NXT_TLS)
 
     if (nxt_str_start(&path, "/certificates", 13)
@@ -1686,6 +1707,121 @@ nxt_controller_status_response(nxt_task_t *task, nxt_controller_request_t *req,
 }
 
 
+/*
+ * Metrics are read from the status shared memory segment of the router
+ * without a request to the router, the segment is requested once.
+ */
+
+static void
+nxt_controller_process_metrics(nxt_task_t *task, nxt_controller_request_t *req)
+{
+    uint32_t                   stream;
+    nxt_int_t                  rc;
+    nxt_port_t                 *router_port, *controller_port;
+    nxt_runtime_t              *rt;
+    nxt_status_report_t        *report;
+    nxt_controller_response_t  resp;
+
+    nxt_memzero(&resp, sizeof(nxt_controller_response_t));
+
+    if (nxt_controller_status_shm != NULL) {
+        report = nxt_status_shm_read(nxt_controller_status_shm,
+                                     req->conn->mem_pool);
+        if (nxt_slow_path(report == NULL)) {
+            goto fail;
+        }
+
+        resp.text = nxt_status_metrics(report, req->conn->mem_pool);
+        if (nxt_slow_path(resp.text == NULL)) {
+            goto fail;
+        }
+
+        resp.status = 200;
+
+        nxt_controller_response(task, req, &resp);
+        return;
+    }
+
+    if (nxt_controller_check_postpone_request(task)) {
+        nxt_queue_insert_tail(&nxt_controller_waiting_requests, &req->link);
+        return;
+    }
+
+    rt = task->thread->runtime;
+
+    router_port = rt->port_by_type[NXT_PROCESS_ROUTER];
+    controller_port = rt->port_by_type[NXT_PROCESS_CONTROLLER];
+
+    stream = nxt_port_rpc_register_handler(task, controller_port,
+                                           nxt_controller_status_shm_handler,
+                                           nxt_controller_status_shm_handler,
+                                           router_port->pid, req);
+    if (nxt_slow_path(stream == 0)) {
+        goto fail;
+    }
+
+    rc = nxt_port_socket_write(task, router_port, NXT_PORT_MSG_STATUS_SHM,
+                               -1, stream, controller_port->id, NULL);
+
+    if (nxt_slow_path(rc != NXT_OK)) {
+        nxt_port_rpc_cancel(task, controller_port, stream);
+
+        goto fail;
+    }
+
+    nxt_queue_insert_head(&nxt_controller_waiting_requests, &req->link);
+    return;
+
+fail:
+
+    resp.status = 500;
+    resp.title = (u_char *) "Failed to get metrics.";
+    resp.offset = -1;
+
+    nxt_controller_response(task, req, &resp);
+}
+
+
+static void
+nxt_controller_status_shm_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
+    void *data)
+{
+    void                       *mem;
+    nxt_controller_request_t   *req;
+    nxt_controller_response_t  resp;
+
+    nxt_debug(task, "controller status shm handler");
+
+    req = data;
+    mem = MAP_FAILED;
+
+    if (msg->port_msg.type == NXT_PORT_MSG_RPC_READY && msg->fd[0] != -1) {
+        mem = nxt_mem_mmap(NULL, NXT_STATUS_SHM_SIZE, PROT_READ, MAP_SHARED,
+                           msg->fd[0], 0);
+
+        nxt_fd_close(msg->fd[0]);
+        msg->fd[0] = -1;
+    }
+
+    if (mem == MAP_FAILED) {
+        nxt_queue_remove(&req->link);
+
+        nxt_memzero(&resp, sizeof(nxt_controller_response_t));
+
+        resp.status = 500;
+        resp.title = (u_char *) "Failed to get metrics.";
+        resp.offset = -1;
+
+        nxt_controller_response(task, req, &resp);
+
+    } else {
+        nxt_controller_status_shm = mem;
+    }
+
+    nxt_controller_flush_requests(task);
+}
+
+
 #if (NXT_TLS)
 
 static void
@@ -2479,7 +2615,7 @@ nxt_controller_response(nxt_task_t *task, nxt_controller_request_t *req,
     nxt_controller_response_t *resp)
 {
     size_t                  size;
-    nxt_str_t               status_line, str;
+    nxt_str_t               status_line, str, type;
     nxt_buf_t               *b, *body;
     nxt_conn_t              *c;
     nxt_uint_t              n;
@@ -2527,6 +2663,16 @@ nxt_controller_response(nxt_task_t *task, nxt_controller_request_t *req,
     }
 
     c = req->conn;
+
+    if (resp->text != NULL) {
+        body = resp->text;
+        nxt_str_set(&type, "text/plain; version=0.0.4; charset=utf-8");
+
+        goto header;
+    }
+
+    nxt_str_set(&type, "application/json");
+
     value = resp->conf;
 
     if (value == NULL) {
@@ -2595,10 +2741,12 @@ nxt_controller_response(nxt_task_t *task, nxt_controller_request_t *req,
 
     body->mem.free = nxt_cpymem(body->mem.free, "\r\n", 2);
 
+header:
+
     size = nxt_length("HTTP/1.1 " "\r\n") + status_line.length
            + nxt_length("Server: " NXT_SERVER "\r\n")
            + nxt_length("Date: Wed, 31 Dec 1986 16:40:00 GMT\r\n")
-           + nxt_length("Content-Type: application/json\r\n")
+           + nxt_length("Content-Type: " "\r\n") + type.length
            + nxt_length("Content-Length: " "\r\n") + NXT_SIZE_T_LEN
            + nxt_length("Connection: close\r\n")
            + nxt_length("\r\n");
@@ -2627,7 +2775,12 @@ nxt_controller_response(nxt_task_t *task, nxt_controller_request_t *req,
                                          b->mem.free);
 
     nxt_str_set(&str, "\r\n"
-                      "Content-Type: application/json\r\n"
+                      "Content-Type: ");
+
+    b->mem.free = nxt_cpymem(b->mem.free, str.start, str.length);
+    b->mem.free = nxt_cpymem(b->mem.free, type.start, type.length);
+
+    nxt_str_set(&str, "\r\n"
                       "Content-Length: ");
 
     b->mem.free = nxt_cpymem(b->mem.free, str.start, str.length);
@@ -0,0 +1,148 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+
+
+static u_char *nxt_cpuset_number(u_char *p, u_char *end, nxt_uint_t *number);
+
+
+nxt_cpuset_t *
+nxt_cpuset_parse(nxt_mp_t *mp, nxt_str_t *str)
+{
+    u_char        *p, *end;
+    uint8_t       map[NXT_CPUSET_MAX / 8];
+    nxt_uint_t    i, n, first, last;
+    nxt_cpuset_t  *set;
+
+    nxt_memzero(map, sizeof(map));
+
+    p = str->start;
+    end = p + str->length;
+    n = 0;
+
+    for ( ;; ) {
+        p = nxt_cpuset_number(p, end, &first);
+        if (p == NULL) {
+            return NULL;
+        }
+
+        last = first;
+
+        if (p < end && *p == '-') {
+            p = nxt_cpuset_number(p + 1, end, &last);
+            if (p == NULL || last < first) {
+                return NULL;
+            }
+        }
+
+        for (i = first; i <= last; i++) {
+            if ((map[i / 8] & (1 << (i % 8))) == 0) {
+                map[i / 8] |= 1 << (i % 8);
+                n++;
+            }
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        if (*p != ',') {
+            return NULL;
+        }
+
+        p++;
+    }
+
+    set = nxt_mp_alloc(mp, sizeof(nxt_cpuset_t) + n * sizeof(uint16_t));
+    if (nxt_slow_path(set == NULL)) {
+        return NULL;
+    }
+
+    set->nelts = 0;
+
+    for (i = 0; i < NXT_CPUSET_MAX; i++) {
+        if ((map[i / 8] & (1 << (i % 8))) != 0) {
+            set->cpus[set->nelts++] = i;
+        }
+    }
+
+    return set;
+}
+
+
+static u_char *
+nxt_cpuset_number(u_char *p, u_char *end, nxt_uint_t *number)
+{
+    nxt_uint_t  n;
+
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+
+    n = 0;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        n = n * 10 + (*p++ - '0');
+
+        if (n >= NXT_CPUSET_MAX) {
+            return NULL;
+        }
+    }
+
+    *number = n;
+
+    return p;
+}
+
+
+/*
+ * Binds the process or thread "pid" (0 is the calling thread) to the n-th
+ * CPU of the set, or to all CPUs of the set if n is negative.  A NULL set
+ * restores the CPU mask of the process main thread.
+ */
+
+nxt_int_t
+nxt_cpuset_bind(nxt_task_t *task, nxt_pid_t pid, nxt_cpuset_t *set,
+    nxt_int_t n)
+{
+#if (NXT_HAVE_SCHED_SETAFFINITY)
+    uint32_t   i;
+    cpu_set_t  mask;
+
+    CPU_ZERO(&mask);
+
+    if (set == NULL) {
+        if (sched_getaffinity(getpid(), sizeof(cpu_set_t), &mask) != 0) {
+            nxt_alert(task, "sched_getaffinity() failed %E", nxt_errno);
+            return NXT_ERROR;
+        }
+
+    } else if (n < 0) {
+        for (i = 0; i < set->nelts; i++) {
+            CPU_SET(set->cpus[i], &mask);
+        }
+
+    } else {
+        CPU_SET(set->cpus[n % set->nelts], &mask);
+    }
+
+    if (sched_setaffinity(pid, sizeof(cpu_set_t), &mask) != 0) {
+        nxt_alert(task, "sched_setaffinity(%PI) failed %E", pid, nxt_errno);
+        return NXT_ERROR;
+    }
+
+    nxt_debug(task, "sched_setaffinity(%PI, %d CPUs)", pid, CPU_COUNT(&mask));
+
+    return NXT_OK;
+
+#else
+
+    nxt_alert(task, "CPU affinity is not supported on this platform");
+
+    return NXT_ERROR;
+
+#endif
+}
@@ -0,0 +1,26 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_CPUSET_H_INCLUDED_
+#define _NXT_CPUSET_H_INCLUDED_
+
+
+#define NXT_CPUSET_MAX  1024
+
+
+/* A CPU list such as "0-3,8", the CPU numbers are in ascending order. */
+
+typedef struct {
+    uint32_t  nelts;
+    uint16_t  cpus[];
+} nxt_cpuset_t;
+
+
+NXT_EXPORT nxt_cpuset_t *nxt_cpuset_parse(nxt_mp_t *mp, nxt_str_t *str);
+NXT_EXPORT nxt_int_t nxt_cpuset_bind(nxt_task_t *task, nxt_pid_t pid,
+    nxt_cpuset_t *set, nxt_int_t n);
+
+
+#endif /* _NXT_CPUSET_H_INCLUDED_ */
@@ -86,6 +86,26 @@ static void nxt_epoll_conn_io_accept4(nxt_task_t *task, void *obj,
     void *data);
 #endif
 
+#if (NXT_HAVE_IO_URING)
+static nxt_int_t nxt_epoll_io_uring_create(nxt_event_engine_t *engine,
+    nxt_uint_t mchanges, nxt_uint_t mevents);
+static void nxt_epoll_io_uring_free(nxt_event_engine_t *engine);
+static void nxt_epoll_io_uring_disable(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_epoll_io_uring_delete(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static nxt_bool_t nxt_epoll_io_uring_close(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_epoll_io_uring_enable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_epoll_io_uring_disable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_epoll_io_uring_poll(nxt_event_engine_t *engine,
+    nxt_msec_t timeout);
+static ssize_t nxt_epoll_io_uring_conn_io_recvbuf(nxt_conn_t *c,
+    nxt_buf_t *b);
+#endif
+
 
 #if (NXT_HAVE_EPOLL_EDGE)
 
@@ -208,6 +228,83 @@ const nxt_event_interface_t  nxt_epoll_level_engine = {
 };
 
 
+#if (NXT_HAVE_IO_URING)
+
+/*
+ * The io_uring engine is the edge-triggered epoll engine which waits
+ * for events in io_uring_enter() instead of epoll_wait(), accepts
+ * connections with multishot accept, and receives data with multishot
+ * recv, see nxt_io_uring_engine.c.
+ */
+
+static nxt_conn_io_t  nxt_io_uring_conn_io = {
+    .connect = nxt_epoll_edge_conn_io_connect,
+    .accept = nxt_io_uring_conn_io_accept,
+
+    .read = nxt_conn_io_read,
+    .recvbuf = nxt_epoll_io_uring_conn_io_recvbuf,
+    .recv = nxt_io_uring_conn_io_recv,
+
+    .write = nxt_conn_io_write,
+    .sendbuf = nxt_conn_io_sendbuf,
+
+#if (NXT_HAVE_LINUX_SENDFILE)
+    .old_sendbuf = nxt_linux_event_conn_io_sendfile,
+#else
+    .old_sendbuf = nxt_event_conn_io_sendbuf,
+#endif
+
+    .writev = nxt_event_conn_io_writev,
+    .send = nxt_event_conn_io_send,
+};
+
+
+const nxt_event_interface_t  nxt_io_uring_engine = {
+    "io_uring",
+    nxt_epoll_io_uring_create,
+    nxt_epoll_io_uring_free,
+    nxt_epoll_enable,
+    nxt_epoll_io_uring_disable,
+    nxt_epoll_io_uring_delete,
+    nxt_epoll_io_uring_close,
+    nxt_epoll_io_uring_enable_read,
+    nxt_epoll_enable_write,
+    nxt_epoll_io_uring_disable_read,
+    nxt_epoll_disable_write,
+    nxt_epoll_block_read,
+    nxt_epoll_block_write,
+    nxt_epoll_oneshot_read,
+    nxt_epoll_oneshot_write,
+    nxt_io_uring_enable_accept,
+    NULL,
+    NULL,
+#if (NXT_HAVE_EVENTFD)
+    nxt_epoll_enable_post,
+    nxt_epoll_signal,
+#else
+    NULL,
+    NULL,
+#endif
+    nxt_epoll_io_uring_poll,
+
+    &nxt_io_uring_conn_io,
+
+#if (NXT_HAVE_INOTIFY)
+    NXT_FILE_EVENTS,
+#else
+    NXT_NO_FILE_EVENTS,
+#endif
+
+#if (NXT_HAVE_SIGNALFD)
+    NXT_SIGNAL_EVENTS,
+#else
+    NXT_NO_SIGNAL_EVENTS,
+#endif
+};
+
+#endif
+
+
 #if (NXT_HAVE_EPOLL_EDGE)
 
 static nxt_int_t
@@ -270,7 +367,9 @@ nxt_epoll_create(nxt_event_engine_t *engine, nxt_uint_t mchanges,
 
 #endif
 
-        nxt_epoll_test_accept4(engine, io);
+        if (io != NULL) {
+            nxt_epoll_test_accept4(engine, io);
+        }
     }
 
     return NXT_OK;
@@ -589,6 +688,15 @@ nxt_epoll_change(nxt_event_engine_t *engine, nxt_fd_event_t *ev, int op,
 {
     nxt_epoll_change_t  *change;
 
+#if (NXT_HAVE_IO_URING)
+
+    if (ev->io_uring) {
+        /* Data are received by io_uring multishot recv. */
+        events &= ~EPOLLIN;
+    }
+
+#endif
+
     nxt_debug(ev->task, "epoll %d set event: fd:%d op:%d ev:%XD",
               engine->u.epoll.fd, ev->fd, op, events);
 
@@ -742,6 +850,14 @@ nxt_epoll_signalfd_handler(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "signalfd(%d) signo:%d", ev->fd, sfd.ssi_signo);
 
+#if (NXT_HAVE_IO_URING)
+    /*
+     * The signalfd descriptor is level-triggered, the io_uring engine
+     * should test it again since other signals might be pending.
+     */
+    task->thread->engine->u.epoll.pending = 1;
+#endif
+
     handler(task, (void *) (uintptr_t) sfd.ssi_signo, NULL);
 }
 
@@ -901,6 +1017,11 @@ nxt_epoll_poll(nxt_event_engine_t *engine, nxt_msec_t timeout)
 
     nxt_debug(&engine->task, "epoll_wait(%d): %d", engine->u.epoll.fd, nevents);
 
+#if (NXT_HAVE_IO_URING)
+    /* Not all ready events might be returned. */
+    engine->u.epoll.pending = (nevents == engine->u.epoll.mevents);
+#endif
+
     if (nevents == -1) {
         level = (err == NXT_EINTR) ? NXT_LOG_INFO : NXT_LOG_ALERT;
 
@@ -933,6 +1054,14 @@ nxt_epoll_poll(nxt_event_engine_t *engine, nxt_msec_t timeout)
             error = 0;
         }
 
+        if (ev->io_uring && ev->read_ready && ev->read != NXT_EVENT_BLOCKED) {
+            /*
+             * EPOLLIN is masked, and the read handler enqueued
+             * by io_uring recv reports end of file or error.
+             */
+            error = 0;
+        }
+
 #if (NXT_HAVE_EPOLL_EDGE)
 
         ev->epoll_eof = ((events & EPOLLRDHUP) != 0);
@@ -1172,3 +1301,181 @@ nxt_epoll_edge_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
 }
 
 #endif
+
+
+#if (NXT_HAVE_IO_URING)
+
+static nxt_int_t
+nxt_epoll_io_uring_create(nxt_event_engine_t *engine, nxt_uint_t mchanges,
+    nxt_uint_t mevents)
+{
+    nxt_int_t  ret;
+
+    /* Connections are accepted by io_uring, so accept4() is not tested. */
+
+    ret = nxt_epoll_create(engine, mchanges, mevents, NULL,
+                           EPOLLET | EPOLLRDHUP);
+
+    if (ret == NXT_OK && nxt_io_uring_create(engine) != NXT_OK) {
+        nxt_epoll_io_uring_free(engine);
+
+        return NXT_ERROR;
+    }
+
+    return ret;
+}
+
+
+static void
+nxt_epoll_io_uring_free(nxt_event_engine_t *engine)
+{
+    nxt_io_uring_free(engine);
+    nxt_epoll_free(engine);
+}
+
+
+/*
+ * Listening sockets are not added to the epoll set, their events are
+ * handled by io_uring multishot accept.  Connections receiving data
+ * with io_uring are present in the epoll set for write and error events.
+ */
+
+static void
+nxt_epoll_io_uring_disable(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->io_uring && nxt_io_uring_is_listen(engine, ev)) {
+        nxt_io_uring_disable_accept(engine, ev);
+        return;
+    }
+
+    nxt_epoll_disable(engine, ev);
+}
+
+
+static void
+nxt_epoll_io_uring_delete(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    (void) nxt_epoll_io_uring_close(engine, ev);
+}
+
+
+static nxt_bool_t
+nxt_epoll_io_uring_close(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_bool_t  listen;
+
+    if (ev->io_uring) {
+        listen = nxt_io_uring_is_listen(engine, ev);
+
+        nxt_io_uring_delete(engine, ev);
+
+        if (listen) {
+            ev->read = NXT_EVENT_INACTIVE;
+            return 0;
+        }
+    }
+
+    return nxt_epoll_close(engine, ev);
+}
+
+
+static void
+nxt_epoll_io_uring_enable_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->io_uring && nxt_io_uring_is_listen(engine, ev)) {
+        nxt_io_uring_enable_accept(engine, ev);
+        return;
+    }
+
+    nxt_epoll_enable_read(engine, ev);
+}
+
+
+static void
+nxt_epoll_io_uring_disable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev)
+{
+    if (ev->io_uring && nxt_io_uring_is_listen(engine, ev)) {
+        nxt_io_uring_disable_accept(engine, ev);
+        return;
+    }
+
+    nxt_epoll_disable_read(engine, ev);
+}
+
+
+/*
+ * The ring polls the epoll descriptor, and the epoll set is read
+ * without waiting only if the descriptor has been reported as ready
+ * or if the previous epoll_wait() might leave some events unread.
+ */
+
+static void
+nxt_epoll_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout)
+{
+    nxt_bool_t  ready;
+
+    if (engine->u.epoll.nchanges != 0) {
+        nxt_epoll_commit_changes(engine);
+    }
+
+    if (engine->u.epoll.error || engine->u.epoll.pending) {
+        engine->u.epoll.error = 0;
+        /* Error handlers have been enqueued on failure. */
+        timeout = 0;
+    }
+
+    ready = nxt_io_uring_poll(engine, timeout);
+
+    if (ready || engine->u.epoll.pending) {
+        nxt_epoll_poll(engine, 0);
+    }
+}
+
+
+/*
+ * A connection starts to receive data with io_uring after the first
+ * read has drained the socket.  TLS connections have their own I/O
+ * methods and are never switched to io_uring.
+ */
+
+static ssize_t
+nxt_epoll_io_uring_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
+{
+    ssize_t             n;
+    uint32_t            events;
+    nxt_fd_event_t      *ev;
+    nxt_event_engine_t  *engine;
+
+    ev = &c->socket;
+
+    if (ev->io_uring) {
+        return nxt_io_uring_conn_io_recvbuf(c, b);
+    }
+
+    n = nxt_epoll_edge_conn_io_recvbuf(c, b);
+
+    if (ev->read_ready || n == 0 || n == NXT_ERROR) {
+        return n;
+    }
+
+    engine = ev->task->thread->engine;
+
+    if (nxt_io_uring_recv(engine, ev) == NXT_OK
+        && (ev->read != NXT_EVENT_INACTIVE || ev->write != NXT_EVENT_INACTIVE))
+    {
+        /* Read notifications are not needed anymore. */
+
+        events = engine->u.epoll.mode;
+
+        if (ev->write >= NXT_EVENT_BLOCKED) {
+            events |= EPOLLOUT;
+        }
+
+        nxt_epoll_change(engine, ev, EPOLL_CTL_MOD, events);
+    }
+
+    return n;
+}
+
+#endif
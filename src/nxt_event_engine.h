@@ -195,6 +195,11 @@ typedef struct {
 } nxt_epoll_change_t;
 
 
+#if (NXT_HAVE_IO_URING)
+typedef struct nxt_io_uring_s     nxt_io_uring_t;
+#endif
+
+
 typedef struct {
     int                           fd;
     uint32_t                      mode;
@@ -216,12 +221,40 @@ typedef struct {
 #if (NXT_HAVE_SIGNALFD)
     nxt_fd_event_t                signalfd;
 #endif
+
+#if (NXT_HAVE_IO_URING)
+    nxt_io_uring_t                *io_uring;
+    /* The epoll ready list may have events not reported by the ring. */
+    uint8_t                       pending;  /* 1 bit */
+#endif
 } nxt_epoll_engine_t;
 
 
 extern const nxt_event_interface_t  nxt_epoll_edge_engine;
 extern const nxt_event_interface_t  nxt_epoll_level_engine;
 
+#if (NXT_HAVE_IO_URING)
+
+extern const nxt_event_interface_t  nxt_io_uring_engine;
+
+nxt_int_t nxt_io_uring_create(nxt_event_engine_t *engine);
+void nxt_io_uring_free(nxt_event_engine_t *engine);
+nxt_bool_t nxt_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout);
+nxt_bool_t nxt_io_uring_is_listen(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+void nxt_io_uring_enable_accept(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+void nxt_io_uring_disable_accept(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+nxt_int_t nxt_io_uring_recv(nxt_event_engine_t *engine, nxt_fd_event_t *ev);
+void nxt_io_uring_delete(nxt_event_engine_t *engine, nxt_fd_event_t *ev);
+
+#if (NXT_TESTS)
+nxt_int_t nxt_io_uring_test(nxt_thread_t *thr);
+#endif
+
+#endif
+
 #endif
 
 
@@ -470,6 +503,9 @@ struct nxt_event_engine_s {
     /* The engine ID, the main engine has ID 0. */
     uint32_t                   id;
 
+    /* The router worker engine index in per-engine status slots. */
+    uint32_t                   status_index;
+
     uint8_t                    shutdown;  /* 1 bit */
 
     uint32_t                   batch;
@@ -481,12 +517,23 @@ struct nxt_event_engine_s {
     nxt_queue_t                joints;
     nxt_queue_t                listen_connections;
     nxt_queue_t                idle_connections;
+    nxt_lvlhsh_t               upstream_keepalive;
+    nxt_queue_t                compress_cache;
+    uint32_t                   compress_cached;
     nxt_array_t                *mem_cache;
+#if (NXT_HAVE_REGEX)
+    /* The route regex match data are reused by all engine requests. */
+    void                       *regex_match;
+#endif
 
     nxt_atomic_uint_t          accepted_conns_cnt;
     nxt_atomic_uint_t          idle_conns_cnt;
     nxt_atomic_uint_t          closed_conns_cnt;
     nxt_atomic_uint_t          requests_cnt;
+    nxt_atomic_uint_t          static_cache_hits_cnt;
+    nxt_atomic_uint_t          static_cache_misses_cnt;
+    nxt_atomic_uint_t          tls_session_cache_hits_cnt;
+    nxt_atomic_uint_t          tls_session_cache_misses_cnt;
 
     nxt_queue_link_t           link;
     // STUB: router link
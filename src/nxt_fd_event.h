@@ -74,6 +74,9 @@ struct nxt_fd_event_s {
     uint8_t                   epoll_eof:1;
     uint8_t                   epoll_error:1;
 #endif
+#if (NXT_HAVE_IO_URING)
+    uint8_t                   io_uring:1;
+#endif
 #if (NXT_HAVE_KQUEUE)
     uint8_t                   kq_eof:1;
 #endif
@@ -91,6 +94,9 @@ struct nxt_fd_event_s {
     uint8_t                   epoll_eof:1;
     uint8_t                   epoll_error:1;
 #endif
+#if (NXT_HAVE_IO_URING)
+    uint8_t                   io_uring:1;
+#endif
 #if (NXT_HAVE_KQUEUE)
     uint8_t                   kq_eof:1;
 #endif
@@ -8,6 +8,7 @@
 #include <nxt_http.h>
 #include <nxt_upstream.h>
 #include <nxt_h1proto.h>
+#include <nxt_h2proto.h>
 #include <nxt_websocket.h>
 #include <nxt_websocket_header.h>
 
@@ -87,6 +88,8 @@ static void nxt_h1p_conn_closing(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_conn_free(nxt_task_t *task, void *obj, void *data);
 
 static void nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer);
+static nxt_int_t nxt_h1p_peer_init(nxt_task_t *task, nxt_http_peer_t *peer,
+    nxt_conn_t *c);
 static void nxt_h1p_peer_connected(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_refused(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer);
@@ -95,6 +98,7 @@ static void nxt_h1p_peer_header_read(nxt_task_t *task, nxt_http_peer_t *peer);
 static ssize_t nxt_h1p_peer_io_read_handler(nxt_task_t *task, nxt_conn_t *c);
 static void nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj,
     void *data);
+static nxt_bool_t nxt_h1p_peer_no_body(nxt_http_peer_t *peer);
 static nxt_int_t nxt_h1p_peer_header_parse(nxt_http_peer_t *peer,
     nxt_buf_mem_t *bm);
 static void nxt_h1p_peer_read(nxt_task_t *task, nxt_http_peer_t *peer);
@@ -102,11 +106,14 @@ static void nxt_h1p_peer_read_done(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_body_process(nxt_task_t *task, nxt_http_peer_t *peer, nxt_buf_t *out);
 static void nxt_h1p_peer_closed(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_error(nxt_task_t *task, void *obj, void *data);
+static nxt_bool_t nxt_h1p_peer_retry(nxt_task_t *task, nxt_http_peer_t *peer);
 static void nxt_h1p_peer_send_timeout(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_read_timeout(nxt_task_t *task, void *obj, void *data);
 static nxt_msec_t nxt_h1p_peer_timer_value(nxt_conn_t *c, uintptr_t data);
 static void nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer);
 static void nxt_h1p_peer_free(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_h1p_peer_connection(void *ctx, nxt_http_field_t *field,
+    uintptr_t data);
 static nxt_int_t nxt_h1p_peer_transfer_encoding(void *ctx,
     nxt_http_field_t *field, uintptr_t data);
 
@@ -149,7 +156,16 @@ const nxt_http_proto_table_t  nxt_http_proto[3] = {
 
         .ws_frame_start   = nxt_h1p_websocket_frame_start,
     },
-    /* NXT_HTTP_PROTO_H2      */
+    /* NXT_HTTP_PROTO_H2 */
+    {
+        .body_read        = nxt_h2p_request_body_read,
+        .local_addr       = nxt_h2p_request_local_addr,
+        .header_send      = nxt_h2p_request_header_send,
+        .send             = nxt_h2p_request_send,
+        .body_bytes_sent  = nxt_h2p_request_body_bytes_sent,
+        .discard          = nxt_h2p_request_discard,
+        .close            = nxt_h2p_request_close,
+    },
     /* NXT_HTTP_PROTO_DEVNULL */
 };
 
@@ -176,13 +192,21 @@ static nxt_http_field_proc_t           nxt_h1p_fields[] = {
     { nxt_string("Content-Length"),    &nxt_http_request_content_length, 0 },
     { nxt_string("Authorization"),     &nxt_http_request_field,
         offsetof(nxt_http_request_t, authorization) },
+    { nxt_string("Range"),             &nxt_http_request_field,
+        offsetof(nxt_http_request_t, range) },
+    { nxt_string("If-Range"),          &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_range) },
+    { nxt_string("If-None-Match"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_none_match) },
+    { nxt_string("If-Modified-Since"), &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_modified_since) },
 };
 
 
 static nxt_lvlhsh_t                    nxt_h1p_peer_fields_hash;
 
 static nxt_http_field_proc_t           nxt_h1p_peer_fields[] = {
-    { nxt_string("Connection"),        &nxt_http_proxy_skip, 0 },
+    { nxt_string("Connection"),        &nxt_h1p_peer_connection, 0 },
     { nxt_string("Transfer-Encoding"), &nxt_h1p_peer_transfer_encoding, 0 },
     { nxt_string("Server"),            &nxt_http_proxy_skip, 0 },
     { nxt_string("Date"),              &nxt_http_proxy_date, 0 },
@@ -450,6 +474,11 @@ nxt_h1p_conn_proto_init(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "h1p conn proto init");
 
+    if (c->http2) {
+        nxt_h2p_conn_init(task, c);
+        return;
+    }
+
     h1p = nxt_mp_zget(c->mem_pool, sizeof(nxt_h1proto_t));
     if (nxt_slow_path(h1p == NULL)) {
         nxt_h1p_closing(task, c);
@@ -491,6 +520,8 @@ nxt_h1p_conn_request_init(nxt_task_t *task, void *obj, void *data)
 
 #if (NXT_TLS)
         r->tls = (c->u.tls != NULL);
+        r->tls_early_data = c->tls_early_data;
+        r->sendfile = (c->sendfile == NXT_CONN_SENDFILE_ON);
 #endif
 
         r->task = c->task;
@@ -2139,49 +2170,98 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
 {
     nxt_mp_t            *mp;
     nxt_int_t           ret;
-    nxt_conn_t          *c, *client;
-    nxt_h1proto_t       *h1p;
-    nxt_fd_event_t      *socket;
-    nxt_work_queue_t    *wq;
+    nxt_conn_t          *c;
     nxt_http_request_t  *r;
 
     nxt_debug(task, "h1p peer connect");
 
     peer->status = NXT_HTTP_UNSET;
+    peer->reused = 0;
     r = peer->request;
 
+    if (peer->server->upstream->keepalive != NULL && !peer->retried) {
+        c = nxt_upstream_keepalive_get(task, peer->server);
+
+        if (c != NULL) {
+            nxt_debug(task, "h1p peer reuse");
+
+            ret = nxt_h1p_peer_init(task, peer, c);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                c->write_state = &nxt_h1p_peer_close_state;
+                nxt_conn_close(task->thread->engine, c);
+
+                goto fail;
+            }
+
+            peer->reused = 1;
+
+            r->state->ready_handler(task, r, peer);
+            return;
+        }
+    }
+
     mp = nxt_mp_create(1024, 128, 256, 32);
 
     if (nxt_slow_path(mp == NULL)) {
         goto fail;
     }
 
-    h1p = nxt_mp_zalloc(mp, sizeof(nxt_h1proto_t));
-    if (nxt_slow_path(h1p == NULL)) {
+    c = nxt_conn_create(mp, task);
+    if (nxt_slow_path(c == NULL)) {
         goto fail;
     }
 
-    ret = nxt_http_parse_request_init(&h1p->parser, r->mem_pool);
+    ret = nxt_h1p_peer_init(task, peer, c);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto fail;
     }
 
-    c = nxt_conn_create(mp, task);
-    if (nxt_slow_path(c == NULL)) {
-        goto fail;
+    c->remote = peer->server->sockaddr;
+
+    c->socket.write_ready = 1;
+    c->write_state = &nxt_h1p_peer_connect_state;
+
+    nxt_conn_connect(task->thread->engine, c);
+
+    return;
+
+fail:
+
+    peer->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+
+    r->state->error_handler(task, r, peer);
+}
+
+
+static nxt_int_t
+nxt_h1p_peer_init(nxt_task_t *task, nxt_http_peer_t *peer, nxt_conn_t *c)
+{
+    nxt_int_t           ret;
+    nxt_conn_t          *client;
+    nxt_h1proto_t       *h1p;
+    nxt_fd_event_t      *socket;
+    nxt_work_queue_t    *wq;
+    nxt_http_request_t  *r;
+
+    r = peer->request;
+
+    h1p = nxt_mp_zalloc(c->mem_pool, sizeof(nxt_h1proto_t));
+    if (nxt_slow_path(h1p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_http_parse_request_init(&h1p->parser, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
     }
 
-    c->mem_pool = mp;
     h1p->conn = c;
+    h1p->keepalive = (peer->server->upstream->keepalive != NULL);
 
     peer->proto.h1 = h1p;
     h1p->request = r;
 
     c->socket.data = peer;
-    c->remote = peer->server->sockaddr;
-
-    c->socket.write_ready = 1;
-    c->write_state = &nxt_h1p_peer_connect_state;
 
     /*
      * TODO: queues should be implemented via client proto interface.
@@ -2200,15 +2280,7 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
     c->write_timer.work_queue = wq;
     /* TODO END */
 
-    nxt_conn_connect(task->thread->engine, c);
-
-    return;
-
-fail:
-
-    peer->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
-
-    r->state->error_handler(task, r, peer);
+    return NXT_OK;
 }
 
 
@@ -2265,11 +2337,14 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     size_t              size;
     nxt_buf_t           *header, *body;
     nxt_conn_t          *c;
+    nxt_h1proto_t       *h1p;
     nxt_http_field_t    *field;
     nxt_http_request_t  *r;
 
     nxt_debug(task, "h1p peer header send");
 
+    h1p = peer->proto.h1;
+
     r = peer->request;
 
     size = r->method->length + sizeof(" ") + r->target.length
@@ -2298,7 +2373,10 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     *p++ = ' ';
     p = nxt_cpymem(p, r->target.start, r->target.length);
     p = nxt_cpymem(p, " HTTP/1.1\r\n", 11);
-    p = nxt_cpymem(p, "Connection: close\r\n", 19);
+
+    if (!h1p->keepalive) {
+        p = nxt_cpymem(p, "Connection: close\r\n", 19);
+    }
 
     nxt_list_each(field, r->fields) {
 
@@ -2315,7 +2393,7 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     header->mem.free = p;
     size = p - header->mem.pos;
 
-    c = peer->proto.h1->conn;
+    c = h1p->conn;
     c->write = header;
     c->write_state = &nxt_h1p_peer_header_send_state;
 
@@ -2557,6 +2635,24 @@ nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj, void *data)
             h1p->remainder = r->resp.content_length_n;
         }
 
+        if (h1p->keepalive && !h1p->chunked) {
+
+            if (nxt_h1p_peer_no_body(peer)) {
+                h1p->keepalive = (nxt_buf_mem_used_size(&b->mem) == 0);
+
+                peer->body = nxt_http_buf_last(r);
+                peer->closed = 1;
+
+                r->state->ready_handler(task, r, peer);
+                return;
+            }
+
+            if (r->resp.content_length == NULL) {
+                /* The response is delimited by the connection close. */
+                h1p->keepalive = 0;
+            }
+        }
+
         if (nxt_buf_mem_used_size(&b->mem) != 0) {
             nxt_h1p_peer_body_process(task, peer, b);
             return;
@@ -2588,6 +2684,25 @@ nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static nxt_bool_t
+nxt_h1p_peer_no_body(nxt_http_peer_t *peer)
+{
+    nxt_http_request_t  *r;
+
+    r = peer->request;
+
+    if (peer->status == NXT_HTTP_NO_CONTENT
+        || peer->status == NXT_HTTP_NOT_MODIFIED
+        || (r->method->length == 4
+            && memcmp(r->method->start, "HEAD", 4) == 0))
+    {
+        return 1;
+    }
+
+    return (r->resp.content_length != NULL && r->resp.content_length_n == 0);
+}
+
+
 static nxt_int_t
 nxt_h1p_peer_header_parse(nxt_http_peer_t *peer, nxt_buf_mem_t *bm)
 {
@@ -2616,6 +2731,11 @@ nxt_h1p_peer_header_parse(nxt_http_peer_t *peer, nxt_buf_mem_t *bm)
             return NXT_ERROR;
         }
 
+        if (p[7] == '0') {
+            /* HTTP/1.0 server connections are not kept alive. */
+            peer->proto.h1->keepalive = 0;
+        }
+
         p += 12;
         length -= 12;
 
@@ -2705,11 +2825,22 @@ nxt_h1p_peer_body_process(nxt_task_t *task, nxt_http_peer_t *peer,
         if (h1p->chunked_parse.last) {
             nxt_buf_chain_add(&out, nxt_http_buf_last(peer->request));
             peer->closed = 1;
+
+            if (h1p->chunked_parse.trailing) {
+                h1p->keepalive = 0;
+            }
         }
 
     } else if (h1p->remainder > 0) {
         length = nxt_buf_chain_length(out);
         h1p->remainder -= length;
+
+        if (h1p->keepalive && h1p->remainder <= 0) {
+            nxt_buf_chain_add(&out, nxt_http_buf_last(peer->request));
+            peer->closed = 1;
+
+            h1p->keepalive = (h1p->remainder == 0);
+        }
     }
 
     peer->body = out;
@@ -2729,6 +2860,12 @@ nxt_h1p_peer_closed(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "h1p peer closed");
 
+    peer->proto.h1->keepalive = 0;
+
+    if (nxt_h1p_peer_retry(task, peer)) {
+        return;
+    }
+
     r = peer->request;
 
     if (peer->header_received) {
@@ -2756,6 +2893,12 @@ nxt_h1p_peer_error(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "h1p peer error");
 
+    peer->proto.h1->keepalive = 0;
+
+    if (nxt_h1p_peer_retry(task, peer)) {
+        return;
+    }
+
     peer->status = NXT_HTTP_BAD_GATEWAY;
 
     r = peer->request;
@@ -2763,6 +2906,59 @@ nxt_h1p_peer_error(nxt_task_t *task, void *obj, void *data)
 }
 
 
+/*
+ * A reused server connection can be closed by the server at any time
+ * before the request is received, so an idempotent request is sent
+ * once more over a new connection.  Unknown methods are not retried.
+ */
+
+static const nxt_str_t  nxt_h1p_idempotent_methods[] = {
+    nxt_string("GET"),
+    nxt_string("HEAD"),
+    nxt_string("PUT"),
+    nxt_string("DELETE"),
+    nxt_string("OPTIONS"),
+    nxt_string("TRACE"),
+};
+
+
+static nxt_bool_t
+nxt_h1p_peer_retry(nxt_task_t *task, nxt_http_peer_t *peer)
+{
+    nxt_str_t           *method;
+    nxt_uint_t          i;
+    nxt_http_request_t  *r;
+
+    if (!peer->reused || peer->header_received) {
+        return 0;
+    }
+
+    r = peer->request;
+    method = r->method;
+
+    for (i = 0; i < nxt_nitems(nxt_h1p_idempotent_methods); i++) {
+        if (nxt_strstr_eq(method, &nxt_h1p_idempotent_methods[i])) {
+            break;
+        }
+    }
+
+    if (i == nxt_nitems(nxt_h1p_idempotent_methods)) {
+        return 0;
+    }
+
+    nxt_debug(task, "h1p peer retry");
+
+    nxt_h1p_peer_close(task, peer);
+
+    peer->closed = 0;
+    peer->retried = 1;
+
+    peer->server->state->ready(task, peer->server);
+
+    return 1;
+}
+
+
 static void
 nxt_h1p_peer_send_timeout(nxt_task_t *task, void *obj, void *data)
 {
@@ -2781,6 +2977,7 @@ nxt_h1p_peer_send_timeout(nxt_task_t *task, void *obj, void *data)
 
     peer = c->socket.data;
     peer->status = NXT_HTTP_GATEWAY_TIMEOUT;
+    peer->proto.h1->keepalive = 0;
 
     r = peer->request;
     r->state->error_handler(task, r, peer);
@@ -2805,6 +3002,7 @@ nxt_h1p_peer_read_timeout(nxt_task_t *task, void *obj, void *data)
 
     peer = c->socket.data;
     peer->status = NXT_HTTP_GATEWAY_TIMEOUT;
+    peer->proto.h1->keepalive = 0;
 
     r = peer->request;
     r->state->error_handler(task, r, peer);
@@ -2825,13 +3023,30 @@ nxt_h1p_peer_timer_value(nxt_conn_t *c, uintptr_t data)
 static void
 nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer)
 {
-    nxt_conn_t  *c;
+    nxt_int_t      ret;
+    nxt_conn_t     *c;
+    nxt_h1proto_t  *h1p;
 
     nxt_debug(task, "h1p peer close");
 
+    h1p = peer->proto.h1;
+    c = h1p->conn;
+
+    /*
+     * The peer is marked as closed before this call only if
+     * the response has been read completely.
+     */
+    if (peer->closed && h1p->keepalive) {
+        nxt_mp_free(c->mem_pool, h1p);
+
+        ret = nxt_upstream_keepalive_put(task, peer->server, c);
+        if (ret == NXT_OK) {
+            return;
+        }
+    }
+
     peer->closed = 1;
 
-    c = peer->proto.h1->conn;
     task = &c->task;
     c->socket.task = task;
     c->read_timer.task = task;
@@ -2868,6 +3083,24 @@ nxt_h1p_peer_free(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static nxt_int_t
+nxt_h1p_peer_connection(void *ctx, nxt_http_field_t *field, uintptr_t data)
+{
+    nxt_http_request_t  *r;
+
+    r = ctx;
+    field->skip = 1;
+
+    if (field->value_length == 5
+        && nxt_memcasecmp(field->value, "close", 5) == 0)
+    {
+        r->peer->proto.h1->keepalive = 0;
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_h1p_peer_transfer_encoding(void *ctx, nxt_http_field_t *field,
     uintptr_t data)
@@ -0,0 +1,2711 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_h2proto.h>
+
+
+/*
+ * nxt_h2p_conn_ prefix is used for connection handlers.
+ * nxt_h2p_request_ prefix is used for HTTP/2 protocol request methods.
+ */
+
+
+#define NXT_H2P_PREFACE           "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+
+#define NXT_H2P_FRAME_HEADER_SIZE 9
+#define NXT_H2P_DEFAULT_FRAME     16384
+#define NXT_H2P_MAX_FRAME         ((1 << 24) - 1)
+#define NXT_H2P_DEFAULT_WINDOW    65535
+#define NXT_H2P_MAX_WINDOW        0x7fffffff
+
+/* The receive windows advertised for connection and each stream. */
+#define NXT_H2P_WINDOW            (1024 * 1024)
+#define NXT_H2P_MAX_STREAMS       128
+
+/*
+ * A connection is closed when the client has reset more than this
+ * number of open streams, and more than half of the streams it opened.
+ */
+#define NXT_H2P_MAX_RESETS        NXT_H2P_MAX_STREAMS
+
+#define NXT_H2P_READ_BUFFER_SIZE  (2 * NXT_H2P_DEFAULT_FRAME)
+
+#define NXT_H2P_DATA              0x0
+#define NXT_H2P_HEADERS           0x1
+#define NXT_H2P_PRIORITY          0x2
+#define NXT_H2P_RST_STREAM        0x3
+#define NXT_H2P_SETTINGS          0x4
+#define NXT_H2P_PUSH_PROMISE      0x5
+#define NXT_H2P_PING              0x6
+#define NXT_H2P_GOAWAY            0x7
+#define NXT_H2P_WINDOW_UPDATE     0x8
+#define NXT_H2P_CONTINUATION      0x9
+
+#define NXT_H2P_END_STREAM        0x01
+#define NXT_H2P_ACK               0x01
+#define NXT_H2P_END_HEADERS       0x04
+#define NXT_H2P_PADDED            0x08
+
+#define NXT_H2P_PRIORITY_FLAG     0x20
+
+#define NXT_H2P_HEADER_TABLE_SIZE      0x1
+#define NXT_H2P_ENABLE_PUSH            0x2
+#define NXT_H2P_MAX_CONCURRENT_STREAMS 0x3
+#define NXT_H2P_INITIAL_WINDOW_SIZE    0x4
+#define NXT_H2P_MAX_FRAME_SIZE         0x5
+
+#define NXT_H2P_NO_ERROR          0x0
+#define NXT_H2P_PROTOCOL_ERROR    0x1
+#define NXT_H2P_INTERNAL_ERROR    0x2
+#define NXT_H2P_FLOW_CONTROL_ERROR 0x3
+#define NXT_H2P_STREAM_CLOSED     0x5
+#define NXT_H2P_FRAME_SIZE_ERROR  0x6
+#define NXT_H2P_REFUSED_STREAM    0x7
+#define NXT_H2P_COMPRESSION_ERROR 0x9
+#define NXT_H2P_ENHANCE_YOUR_CALM 0xb
+
+#define NXT_H2P_PSEUDO_METHOD     0
+#define NXT_H2P_PSEUDO_SCHEME     1
+#define NXT_H2P_PSEUDO_PATH       2
+#define NXT_H2P_PSEUDO_AUTHORITY  3
+#define NXT_H2P_PSEUDO_FIELDS     4
+
+/* Sync buffers have no memory, and response buffers are never files. */
+#define nxt_h2p_buf_used_size(b)                                              \
+    (nxt_buf_is_sync(b) ? 0 : nxt_buf_mem_used_size(&(b)->mem))
+
+
+typedef struct {
+    u_char                    *pos;
+    uint32_t                  length;
+    uint32_t                  stream;
+    uint8_t                   type;
+    uint8_t                   flags;
+} nxt_h2p_frame_t;
+
+
+typedef nxt_int_t (*nxt_h2p_frame_handler_t)(nxt_task_t *task,
+    nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame);
+
+
+static void nxt_h2p_conn_read(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_h2p_data(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_headers(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_priority(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_settings(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_push_promise(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_ping(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_goaway(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_window_update(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_continuation(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_int_t nxt_h2p_header_block(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, u_char *end);
+static nxt_int_t nxt_h2p_header_block_skip(nxt_h2proto_t *h2p, u_char *pos,
+    u_char *end);
+static nxt_int_t nxt_h2p_stream_create(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, u_char *end);
+static nxt_int_t nxt_h2p_request_line(nxt_h2p_stream_t *stream,
+    nxt_array_t *fields, nxt_str_t *pseudo);
+static nxt_int_t nxt_h2p_target_test(nxt_str_t *str);
+static nxt_int_t nxt_h2p_header_process(nxt_task_t *task,
+    nxt_h2p_stream_t *stream, nxt_http_request_t *r);
+static nxt_int_t nxt_h2p_field_test(nxt_hpack_field_t *field);
+static nxt_h2p_stream_t *nxt_h2p_stream_find(nxt_h2proto_t *h2p, uint32_t id);
+static void nxt_h2p_stream_abort(nxt_task_t *task, nxt_h2p_stream_t *stream);
+static void nxt_h2p_body(nxt_task_t *task, nxt_h2p_stream_t *stream,
+    u_char *pos, size_t size);
+static nxt_buf_t *nxt_h2p_body_file(nxt_task_t *task, nxt_http_request_t *r);
+static nxt_int_t nxt_h2p_content_length(nxt_http_request_t *r, nxt_off_t n);
+static void nxt_h2p_stream_send(nxt_task_t *task, nxt_h2p_stream_t *stream);
+static void nxt_h2p_stream_drop(nxt_task_t *task, nxt_h2p_stream_t *stream,
+    nxt_buf_t *b);
+static nxt_bool_t nxt_h2p_hop_by_hop(nxt_http_field_t *field);
+static nxt_int_t nxt_h2p_settings_send(nxt_task_t *task, nxt_h2proto_t *h2p);
+static nxt_int_t nxt_h2p_frame_send(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_uint_t type, nxt_uint_t flags, uint32_t id, u_char *payload,
+    size_t size);
+static nxt_int_t nxt_h2p_window_update_send(nxt_task_t *task,
+    nxt_h2proto_t *h2p, uint32_t id, uint32_t increment);
+static nxt_int_t nxt_h2p_rst_stream_send(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, uint32_t code);
+static nxt_buf_t *nxt_h2p_frame_alloc(nxt_task_t *task, nxt_h2proto_t *h2p,
+    size_t size);
+static u_char *nxt_h2p_uint32(u_char *p, uint32_t n);
+static u_char *nxt_h2p_frame_header(u_char *p, size_t length, nxt_uint_t type,
+    nxt_uint_t flags, uint32_t id);
+static void nxt_h2p_frame_completion(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_send(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_buf_t *out);
+static nxt_buf_t *nxt_h2p_completion(nxt_task_t *task, nxt_buf_t *b,
+    nxt_bool_t all);
+static void nxt_h2p_conn_sent(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_error(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_timeout(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_send_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_msec_t nxt_h2p_conn_timer_value(nxt_conn_t *c, uintptr_t data);
+static nxt_msec_t nxt_h2p_conn_send_timer_value(nxt_conn_t *c,
+    uintptr_t data);
+static void nxt_h2p_goaway_send(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_uint_t code);
+static void nxt_h2p_conn_abort(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_conn_active(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_conn_idle(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_conn_finalize(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_closing(nxt_task_t *task, nxt_conn_t *c);
+static void nxt_h2p_conn_closing(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_free(nxt_task_t *task, void *obj, void *data);
+
+
+static const nxt_conn_state_t  nxt_h2p_read_state;
+static const nxt_conn_state_t  nxt_h2p_send_state;
+static const nxt_conn_state_t  nxt_h2p_close_state;
+#if (NXT_TLS)
+static const nxt_conn_state_t  nxt_h2p_shutdown_state;
+#endif
+
+
+static const nxt_h2p_frame_handler_t  nxt_h2p_frame_handlers[] = {
+    nxt_h2p_data,
+    nxt_h2p_headers,
+    nxt_h2p_priority,
+    nxt_h2p_rst_stream,
+    nxt_h2p_settings,
+    nxt_h2p_push_promise,
+    nxt_h2p_ping,
+    nxt_h2p_goaway,
+    nxt_h2p_window_update,
+    nxt_h2p_continuation,
+};
+
+
+static nxt_lvlhsh_t                    nxt_h2p_fields_hash;
+
+static nxt_http_field_proc_t           nxt_h2p_fields[] = {
+    { nxt_string("Host"),              &nxt_http_request_host, 0 },
+    { nxt_string("Cookie"),            &nxt_http_request_field,
+        offsetof(nxt_http_request_t, cookie) },
+    { nxt_string("Referer"),           &nxt_http_request_field,
+        offsetof(nxt_http_request_t, referer) },
+    { nxt_string("User-Agent"),        &nxt_http_request_field,
+        offsetof(nxt_http_request_t, user_agent) },
+    { nxt_string("Content-Type"),      &nxt_http_request_field,
+        offsetof(nxt_http_request_t, content_type) },
+    { nxt_string("Content-Length"),    &nxt_http_request_content_length, 0 },
+    { nxt_string("Authorization"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, authorization) },
+    { nxt_string("Range"),             &nxt_http_request_field,
+        offsetof(nxt_http_request_t, range) },
+    { nxt_string("If-Range"),          &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_range) },
+    { nxt_string("If-None-Match"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_none_match) },
+    { nxt_string("If-Modified-Since"), &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_modified_since) },
+};
+
+
+static const nxt_str_t  nxt_h2p_pseudo_fields[] = {
+    nxt_string(":method"),
+    nxt_string(":scheme"),
+    nxt_string(":path"),
+    nxt_string(":authority"),
+};
+
+
+/* Connection-specific fields are not allowed in HTTP/2, RFC 9113, 8.2.2. */
+
+static const nxt_str_t  nxt_h2p_connection_fields[] = {
+    nxt_string("connection"),
+    nxt_string("keep-alive"),
+    nxt_string("proxy-connection"),
+    nxt_string("transfer-encoding"),
+    nxt_string("upgrade"),
+};
+
+
+nxt_int_t
+nxt_h2p_init(nxt_task_t *task)
+{
+    if (nxt_slow_path(nxt_hpack_init() != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    return nxt_http_fields_hash(&nxt_h2p_fields_hash,
+                                nxt_h2p_fields, nxt_nitems(nxt_h2p_fields));
+}
+
+
+void
+nxt_h2p_conn_init(nxt_task_t *task, nxt_conn_t *c)
+{
+    size_t         size;
+    nxt_buf_t      *b, *in;
+    nxt_h2proto_t  *h2p;
+
+    nxt_debug(task, "h2p conn init");
+
+    h2p = nxt_mp_zget(c->mem_pool, sizeof(nxt_h2proto_t));
+    if (nxt_slow_path(h2p == NULL)) {
+        goto fail;
+    }
+
+    b = nxt_buf_mem_alloc(c->mem_pool, NXT_H2P_READ_BUFFER_SIZE, 0);
+    if (nxt_slow_path(b == NULL)) {
+        goto fail;
+    }
+
+    in = c->read;
+
+    if (in != NULL) {
+        size = nxt_buf_mem_used_size(&in->mem);
+        size = nxt_min(size, NXT_H2P_READ_BUFFER_SIZE);
+
+        b->mem.free = nxt_cpymem(b->mem.free, in->mem.pos, size);
+
+        in->completion_handler(task, in, in->parent);
+    }
+
+    c->read = b;
+    c->socket.data = h2p;
+
+    h2p->conn = c;
+    h2p->idle = 1;
+
+    nxt_queue_init(&h2p->streams);
+    nxt_hpack_table_init(&h2p->hpack, c->mem_pool);
+
+    h2p->send_window = NXT_H2P_DEFAULT_WINDOW;
+    h2p->recv_window = NXT_H2P_DEFAULT_WINDOW;
+    h2p->init_window = NXT_H2P_DEFAULT_WINDOW;
+
+    c->read_state = &nxt_h2p_read_state;
+    c->write_state = &nxt_h2p_send_state;
+
+    if (nxt_slow_path(nxt_h2p_settings_send(task, h2p) != NXT_OK)) {
+        c->socket.data = NULL;
+        goto fail;
+    }
+
+    nxt_h2p_conn_read(task, c, h2p);
+    return;
+
+fail:
+
+    nxt_h2p_closing(task, c);
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_read_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_read,
+    .close_handler = nxt_h2p_conn_error,
+    .error_handler = nxt_h2p_conn_error,
+
+    .timer_handler = nxt_h2p_conn_timeout,
+    .timer_value = nxt_h2p_conn_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, idle_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h2p_conn_read(nxt_task_t *task, void *obj, void *data)
+{
+    size_t           size;
+    u_char           *p, *end;
+    nxt_int_t        ret;
+    nxt_buf_t        *b;
+    nxt_conn_t       *c;
+    nxt_h2proto_t    *h2p;
+    nxt_h2p_frame_t  frame;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn read");
+
+    if (nxt_slow_path(h2p == NULL || h2p->closing)) {
+        return;
+    }
+
+    b = c->read;
+    p = b->mem.pos;
+    end = b->mem.free;
+
+    if (!h2p->preface) {
+        size = nxt_min((size_t) (end - p), nxt_length(NXT_H2P_PREFACE));
+
+        if (nxt_slow_path(memcmp(p, NXT_H2P_PREFACE, size) != 0)) {
+            nxt_log(task, NXT_LOG_INFO, "h2p invalid connection preface");
+
+            nxt_h2p_goaway_send(task, h2p, NXT_H2P_PROTOCOL_ERROR);
+            return;
+        }
+
+        if (size < nxt_length(NXT_H2P_PREFACE)) {
+            goto read;
+        }
+
+        p += size;
+        h2p->preface = 1;
+    }
+
+    while (end - p >= NXT_H2P_FRAME_HEADER_SIZE) {
+        frame.length = (p[0] << 16) | (p[1] << 8) | p[2];
+        frame.type = p[3];
+        frame.flags = p[4];
+        frame.stream = ((p[5] & 0x7f) << 24) | (p[6] << 16) | (p[7] << 8)
+                       | p[8];
+
+        if (nxt_slow_path(frame.length > NXT_H2P_DEFAULT_FRAME)) {
+            ret = NXT_H2P_FRAME_SIZE_ERROR;
+            goto error;
+        }
+
+        if ((size_t) (end - p) < NXT_H2P_FRAME_HEADER_SIZE + frame.length) {
+            break;
+        }
+
+        frame.pos = p + NXT_H2P_FRAME_HEADER_SIZE;
+        p = frame.pos + frame.length;
+
+        nxt_debug(task, "h2p frame type:%d flags:%xd stream:%uD length:%uD",
+                  frame.type, frame.flags, frame.stream, frame.length);
+
+        if (nxt_slow_path(h2p->header_stream != 0
+                          && frame.type != NXT_H2P_CONTINUATION))
+        {
+            ret = NXT_H2P_PROTOCOL_ERROR;
+            goto error;
+        }
+
+        if (frame.type < nxt_nitems(nxt_h2p_frame_handlers)) {
+            ret = nxt_h2p_frame_handlers[frame.type](task, h2p, &frame);
+
+            if (nxt_slow_path(ret != NXT_H2P_NO_ERROR)) {
+                goto error;
+            }
+
+            if (h2p->closing) {
+                return;
+            }
+        }
+    }
+
+    size = end - p;
+
+    if (p != b->mem.start) {
+        nxt_memmove(b->mem.start, p, size);
+    }
+
+    b->mem.pos = b->mem.start;
+    b->mem.free = b->mem.start + size;
+
+read:
+
+    nxt_conn_read(task->thread->engine, c);
+    return;
+
+error:
+
+    nxt_log(task, NXT_LOG_INFO, "h2p protocol error %d in frame type %d",
+            ret, frame.type);
+
+    nxt_h2p_goaway_send(task, h2p, ret);
+}
+
+
+static nxt_int_t
+nxt_h2p_data(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame)
+{
+    u_char            *p;
+    size_t            size, padding;
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(frame->stream == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    p = frame->pos;
+    size = frame->length;
+
+    if (frame->flags & NXT_H2P_PADDED) {
+        if (nxt_slow_path(size == 0 || p[0] >= size)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        padding = p[0];
+        p++;
+        size -= 1 + padding;
+    }
+
+    if (nxt_slow_path(frame->length > (uint32_t) h2p->recv_window)) {
+        return NXT_H2P_FLOW_CONTROL_ERROR;
+    }
+
+    h2p->recv_window -= frame->length;
+
+    if (h2p->recv_window < NXT_H2P_WINDOW / 2) {
+        if (nxt_slow_path(nxt_h2p_window_update_send(task, h2p, 0,
+                                          NXT_H2P_WINDOW - h2p->recv_window)
+                          != NXT_OK))
+        {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        h2p->recv_window = NXT_H2P_WINDOW;
+    }
+
+    stream = nxt_h2p_stream_find(h2p, frame->stream);
+
+    if (stream == NULL) {
+        if (frame->stream > h2p->last_stream) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        /* The stream has been already closed. */
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(stream->in_closed)) {
+        (void) nxt_h2p_rst_stream_send(task, h2p, stream->id,
+                                       NXT_H2P_STREAM_CLOSED);
+        nxt_h2p_stream_abort(task, stream);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length > (uint32_t) stream->recv_window)) {
+        (void) nxt_h2p_rst_stream_send(task, h2p, stream->id,
+                                       NXT_H2P_FLOW_CONTROL_ERROR);
+        nxt_h2p_stream_abort(task, stream);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream->recv_window -= frame->length;
+
+    if (frame->flags & NXT_H2P_END_STREAM) {
+        stream->in_closed = 1;
+
+    } else if (stream->recv_window < NXT_H2P_WINDOW / 2) {
+        if (nxt_slow_path(nxt_h2p_window_update_send(task, h2p, stream->id,
+                                        NXT_H2P_WINDOW - stream->recv_window)
+                          != NXT_OK))
+        {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        stream->recv_window = NXT_H2P_WINDOW;
+    }
+
+    nxt_h2p_body(task, stream, p, size);
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_headers(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame)
+{
+    u_char                   *p, *end;
+    size_t                   size, padding;
+    nxt_socket_conf_joint_t  *joint;
+
+    if (nxt_slow_path(frame->stream == 0 || (frame->stream & 1) == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    p = frame->pos;
+    end = p + frame->length;
+    padding = 0;
+
+    if (frame->flags & NXT_H2P_PADDED) {
+        if (nxt_slow_path(p == end)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        padding = *p++;
+    }
+
+    if (frame->flags & NXT_H2P_PRIORITY_FLAG) {
+        if (nxt_slow_path(end - p < 5)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        p += 5;
+    }
+
+    if (nxt_slow_path((size_t) (end - p) < padding)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    end -= padding;
+
+    if (frame->flags & NXT_H2P_END_HEADERS) {
+        return nxt_h2p_header_block(task, h2p, frame->stream, frame->flags,
+                                    p, end);
+    }
+
+    if (h2p->header_block == NULL) {
+        joint = h2p->conn->listen->socket.data;
+
+        size = (joint != NULL)
+               ? joint->socket_conf->large_header_buffer_size
+                 * joint->socket_conf->large_header_buffers
+               : NXT_H2P_DEFAULT_FRAME;
+
+        size = nxt_max(size, NXT_H2P_DEFAULT_FRAME);
+
+        h2p->header_block = nxt_mp_nget(h2p->conn->mem_pool, size);
+        if (nxt_slow_path(h2p->header_block == NULL)) {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        h2p->header_size = size;
+    }
+
+    size = end - p;
+
+    if (nxt_slow_path(size > h2p->header_size)) {
+        return NXT_H2P_ENHANCE_YOUR_CALM;
+    }
+
+    nxt_memcpy(h2p->header_block, p, size);
+
+    h2p->header_length = size;
+    h2p->header_stream = frame->stream;
+    h2p->header_flags = frame->flags;
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_priority(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame)
+{
+    if (nxt_slow_path(frame->stream == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length != 5)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    /* Stream priorities are not supported. */
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(frame->stream == 0
+                      || frame->stream > h2p->last_stream))
+    {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length != 4)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    stream = nxt_h2p_stream_find(h2p, frame->stream);
+
+    if (stream != NULL) {
+        nxt_debug(task, "h2p stream %uD reset by client", stream->id);
+
+        stream->in_closed = 1;
+        stream->reset = 1;
+
+        nxt_h2p_stream_abort(task, stream);
+
+        h2p->resets++;
+
+        if (nxt_slow_path(h2p->resets > NXT_H2P_MAX_RESETS
+                          && h2p->resets > h2p->opened / 2))
+        {
+            nxt_log(task, NXT_LOG_INFO,
+                    "h2p client reset too many streams: %uD of %uD",
+                    h2p->resets, h2p->opened);
+
+            return NXT_H2P_ENHANCE_YOUR_CALM;
+        }
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_settings(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char            *p, *end;
+    int64_t           delta;
+    uint32_t          value;
+    nxt_uint_t        id;
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(frame->stream != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (frame->flags & NXT_H2P_ACK) {
+        if (nxt_slow_path(frame->length != 0)) {
+            return NXT_H2P_FRAME_SIZE_ERROR;
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length % 6 != 0)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    p = frame->pos;
+    end = p + frame->length;
+
+    while (p < end) {
+        id = (p[0] << 8) | p[1];
+        value = ((uint32_t) p[2] << 24) | (p[3] << 16) | (p[4] << 8) | p[5];
+        p += 6;
+
+        nxt_debug(task, "h2p setting %ui: %uD", id, value);
+
+        switch (id) {
+
+        case NXT_H2P_ENABLE_PUSH:
+            if (nxt_slow_path(value > 1)) {
+                return NXT_H2P_PROTOCOL_ERROR;
+            }
+
+            break;
+
+        case NXT_H2P_INITIAL_WINDOW_SIZE:
+            if (nxt_slow_path(value > NXT_H2P_MAX_WINDOW)) {
+                return NXT_H2P_FLOW_CONTROL_ERROR;
+            }
+
+            delta = (int64_t) value - h2p->init_window;
+
+            nxt_queue_each(stream, &h2p->streams, nxt_h2p_stream_t, link) {
+
+                if (nxt_slow_path(stream->send_window + delta
+                                  > NXT_H2P_MAX_WINDOW))
+                {
+                    return NXT_H2P_FLOW_CONTROL_ERROR;
+                }
+
+                stream->send_window += (int32_t) delta;
+
+            } nxt_queue_loop;
+
+            h2p->init_window = value;
+            break;
+
+        case NXT_H2P_MAX_FRAME_SIZE:
+            if (nxt_slow_path(value < NXT_H2P_DEFAULT_FRAME
+                              || value > NXT_H2P_MAX_FRAME))
+            {
+                return NXT_H2P_PROTOCOL_ERROR;
+            }
+
+            /* DATA and HEADERS frames are sent with the default size. */
+            break;
+
+        default:
+            /*
+             * SETTINGS_HEADER_TABLE_SIZE is ignored since
+             * the encoder does not use the dynamic table.
+             */
+            break;
+        }
+    }
+
+    if (nxt_slow_path(nxt_h2p_frame_send(task, h2p, NXT_H2P_SETTINGS,
+                                         NXT_H2P_ACK, 0, NULL, 0)
+                      != NXT_OK))
+    {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    nxt_queue_each(stream, &h2p->streams, nxt_h2p_stream_t, link) {
+        nxt_h2p_stream_send(task, stream);
+    } nxt_queue_loop;
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_push_promise(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    /* A client cannot push streams. */
+
+    return NXT_H2P_PROTOCOL_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_ping(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame)
+{
+    if (nxt_slow_path(frame->stream != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length != 8)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    if (frame->flags & NXT_H2P_ACK) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(nxt_h2p_frame_send(task, h2p, NXT_H2P_PING, NXT_H2P_ACK,
+                                         0, frame->pos, 8)
+                      != NXT_OK))
+    {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_goaway(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame)
+{
+    if (nxt_slow_path(frame->stream != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length < 8)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    nxt_debug(task, "h2p goaway received");
+
+    /* The active streams are completed, new streams are refused. */
+
+    h2p->goaway = 1;
+
+    if (h2p->nstreams == 0) {
+        nxt_h2p_conn_finalize(task, h2p);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_window_update(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char            *p;
+    uint32_t          increment;
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(frame->length != 4)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    p = frame->pos;
+    increment = ((p[0] & 0x7f) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+
+    nxt_debug(task, "h2p window update %uD: %uD", frame->stream, increment);
+
+    if (frame->stream == 0) {
+        if (nxt_slow_path(increment == 0)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        if (nxt_slow_path((int64_t) h2p->send_window + increment
+                          > NXT_H2P_MAX_WINDOW))
+        {
+            return NXT_H2P_FLOW_CONTROL_ERROR;
+        }
+
+        h2p->send_window += increment;
+
+        nxt_queue_each(stream, &h2p->streams, nxt_h2p_stream_t, link) {
+            nxt_h2p_stream_send(task, stream);
+        } nxt_queue_loop;
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream = nxt_h2p_stream_find(h2p, frame->stream);
+
+    if (stream == NULL) {
+        if (nxt_slow_path(frame->stream > h2p->last_stream)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(increment == 0
+                      || (int64_t) stream->send_window + increment
+                         > NXT_H2P_MAX_WINDOW))
+    {
+        (void) nxt_h2p_rst_stream_send(task, h2p, stream->id,
+                                       (increment == 0)
+                                       ? NXT_H2P_PROTOCOL_ERROR
+                                       : NXT_H2P_FLOW_CONTROL_ERROR);
+        nxt_h2p_stream_abort(task, stream);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream->send_window += increment;
+
+    nxt_h2p_stream_send(task, stream);
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_continuation(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    if (nxt_slow_path(h2p->header_stream == 0
+                      || frame->stream != h2p->header_stream))
+    {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length > h2p->header_size - h2p->header_length)) {
+        return NXT_H2P_ENHANCE_YOUR_CALM;
+    }
+
+    nxt_memcpy(h2p->header_block + h2p->header_length, frame->pos,
+               frame->length);
+
+    h2p->header_length += frame->length;
+
+    if (!(frame->flags & NXT_H2P_END_HEADERS)) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    h2p->header_stream = 0;
+
+    return nxt_h2p_header_block(task, h2p, frame->stream, h2p->header_flags,
+                                h2p->header_block,
+                                h2p->header_block + h2p->header_length);
+}
+
+
+static nxt_int_t
+nxt_h2p_header_block(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, u_char *end)
+{
+    nxt_uint_t               code;
+    nxt_h2p_stream_t         *stream;
+    nxt_socket_conf_joint_t  *joint;
+
+    if (id <= h2p->last_stream) {
+        /* Trailers are decoded to keep the dynamic table and ignored. */
+
+        if (nxt_slow_path(nxt_h2p_header_block_skip(h2p, pos, end)
+                          != NXT_OK))
+        {
+            return NXT_H2P_COMPRESSION_ERROR;
+        }
+
+        stream = nxt_h2p_stream_find(h2p, id);
+
+        if (stream == NULL) {
+            return NXT_H2P_NO_ERROR;
+        }
+
+        if (nxt_slow_path(stream->in_closed
+                          || !(flags & NXT_H2P_END_STREAM)))
+        {
+            code = stream->in_closed ? NXT_H2P_STREAM_CLOSED
+                                     : NXT_H2P_PROTOCOL_ERROR;
+
+            (void) nxt_h2p_rst_stream_send(task, h2p, id, code);
+            nxt_h2p_stream_abort(task, stream);
+
+            return NXT_H2P_NO_ERROR;
+        }
+
+        stream->in_closed = 1;
+
+        nxt_h2p_body(task, stream, NULL, 0);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    h2p->last_stream = id;
+
+    joint = h2p->conn->listen->socket.data;
+
+    if (h2p->goaway || joint == NULL
+        || h2p->nstreams >= NXT_H2P_MAX_STREAMS)
+    {
+        if (nxt_slow_path(nxt_h2p_header_block_skip(h2p, pos, end)
+                          != NXT_OK))
+        {
+            return NXT_H2P_COMPRESSION_ERROR;
+        }
+
+        if (nxt_slow_path(nxt_h2p_rst_stream_send(task, h2p, id,
+                                                  NXT_H2P_REFUSED_STREAM)
+                          != NXT_OK))
+        {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    h2p->opened++;
+
+    return nxt_h2p_stream_create(task, h2p, id, flags, pos, end);
+}
+
+
+static nxt_int_t
+nxt_h2p_header_block_skip(nxt_h2proto_t *h2p, u_char *pos, u_char *end)
+{
+    nxt_mp_t           *mp;
+    nxt_int_t          ret;
+    nxt_hpack_field_t  field;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    do {
+        ret = nxt_hpack_decode(&h2p->hpack, mp, &pos, end, &field);
+    } while (ret == NXT_OK);
+
+    nxt_mp_destroy(mp);
+
+    return (ret == NXT_DONE) ? NXT_OK : NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_stream_create(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, u_char *end)
+{
+    nxt_int_t                ret, n;
+    nxt_str_t                pseudo[NXT_H2P_PSEUDO_FIELDS];
+    nxt_uint_t               seen;
+    nxt_bool_t               regular, malformed;
+    nxt_conn_t               *c;
+    nxt_array_t              *fields;
+    nxt_h2p_stream_t         *stream;
+    nxt_hpack_field_t        field, *f;
+    nxt_socket_conf_t        *skcf;
+    nxt_http_request_t       *r;
+    nxt_socket_conf_joint_t  *joint;
+
+    nxt_debug(task, "h2p stream %uD create", id);
+
+    c = h2p->conn;
+
+    r = nxt_http_request_create(task);
+    if (nxt_slow_path(r == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    stream = nxt_mp_zget(r->mem_pool, sizeof(nxt_h2p_stream_t));
+    if (nxt_slow_path(stream == NULL)) {
+        goto fail;
+    }
+
+    fields = nxt_array_create(r->mem_pool, 16, sizeof(nxt_hpack_field_t));
+    if (nxt_slow_path(fields == NULL)) {
+        goto fail;
+    }
+
+    ret = nxt_http_parse_request_init(&stream->parser, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        goto fail;
+    }
+
+    nxt_memzero(pseudo, sizeof(pseudo));
+
+    seen = 0;
+    regular = 0;
+    malformed = 0;
+
+    /*
+     * All fields are decoded even in a malformed request to keep
+     * the dynamic table in sync.  The decoded fields are copied since
+     * they can reference dynamic table entries evicted by next fields.
+     */
+
+    for ( ;; ) {
+        ret = nxt_hpack_decode(&h2p->hpack, r->mem_pool, &pos, end, &field);
+
+        if (ret != NXT_OK) {
+            break;
+        }
+
+        if (malformed) {
+            continue;
+        }
+
+        n = nxt_h2p_field_test(&field);
+
+        if (n == NXT_H2P_PSEUDO_FIELDS) {
+            regular = 1;
+
+            f = nxt_array_add(fields);
+            if (nxt_slow_path(f == NULL)) {
+                goto fail;
+            }
+
+            if (nxt_slow_path(nxt_str_dup(r->mem_pool, &f->name, &field.name)
+                              == NULL
+                              || nxt_str_dup(r->mem_pool, &f->value,
+                                             &field.value)
+                                 == NULL))
+            {
+                goto fail;
+            }
+
+            continue;
+        }
+
+        if (n == NXT_ERROR || regular || (seen & (1 << n))) {
+            malformed = 1;
+            continue;
+        }
+
+        seen |= 1 << n;
+
+        if (nxt_slow_path(nxt_str_dup(r->mem_pool, &pseudo[n], &field.value)
+                          == NULL))
+        {
+            goto fail;
+        }
+    }
+
+    if (nxt_slow_path(ret != NXT_DONE)) {
+        nxt_mp_release(r->mem_pool);
+        return NXT_H2P_COMPRESSION_ERROR;
+    }
+
+    if (nxt_slow_path(malformed
+                      || pseudo[NXT_H2P_PSEUDO_METHOD].length == 0
+                      || pseudo[NXT_H2P_PSEUDO_SCHEME].length == 0
+                      || pseudo[NXT_H2P_PSEUDO_PATH].length == 0))
+    {
+        nxt_log(task, NXT_LOG_INFO, "h2p malformed request in stream %uD",
+                id);
+
+        nxt_mp_release(r->mem_pool);
+
+        if (nxt_slow_path(nxt_h2p_rst_stream_send(task, h2p, id,
+                                                  NXT_H2P_PROTOCOL_ERROR)
+                          != NXT_OK))
+        {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream->h2p = h2p;
+    stream->request = r;
+    stream->id = id;
+    stream->send_window = h2p->init_window;
+    stream->recv_window = NXT_H2P_WINDOW;
+    stream->in_closed = ((flags & NXT_H2P_END_STREAM) != 0);
+
+    r->proto.h2 = stream;
+    r->protocol = NXT_HTTP_PROTO_H2;
+    r->remote = c->remote;
+
+#if (NXT_TLS)
+    r->tls = (c->u.tls != NULL);
+    r->tls_early_data = c->tls_early_data;
+#endif
+
+    r->task = c->task;
+    task = &r->task;
+
+    joint = c->listen->socket.data;
+    joint->count++;
+
+    r->conf = joint;
+    skcf = joint->socket_conf;
+    r->log_route = skcf->log_route;
+
+    if (c->local == NULL) {
+        c->local = skcf->sockaddr;
+    }
+
+    stream->parser.discard_unsafe_fields = skcf->discard_unsafe_fields;
+
+    nxt_queue_insert_tail(&h2p->streams, &stream->link);
+    h2p->nstreams++;
+
+    nxt_h2p_conn_active(task, h2p);
+
+    ret = nxt_h2p_request_line(stream, fields, pseudo);
+
+    if (nxt_fast_path(ret == NXT_OK)) {
+        if (nxt_slow_path(r->log_route)) {
+            nxt_log(task, NXT_LOG_NOTICE, "http request line \"%V\"",
+                    &r->request_line);
+        }
+
+        ret = nxt_h2p_header_process(task, stream, r);
+
+        if (nxt_fast_path(ret == NXT_OK)) {
+            r->state->ready_handler(task, r, NULL);
+            return NXT_H2P_NO_ERROR;
+        }
+
+    } else {
+        (void) nxt_h2p_header_process(task, stream, r);
+    }
+
+    nxt_http_request_error(task, r, ret);
+
+    return NXT_H2P_NO_ERROR;
+
+fail:
+
+    nxt_mp_release(r->mem_pool);
+
+    return NXT_H2P_INTERNAL_ERROR;
+}
+
+
+/*
+ * The request is converted to HTTP/1.1 request line and header fields to
+ * reuse the HTTP/1 parser for the target normalization and fields hashing.
+ */
+
+static nxt_int_t
+nxt_h2p_request_line(nxt_h2p_stream_t *stream, nxt_array_t *fields,
+    nxt_str_t *pseudo)
+{
+    u_char              *p, *start;
+    size_t              size;
+    nxt_int_t           ret;
+    nxt_str_t           *authority;
+    nxt_uint_t          i, ncookies;
+    nxt_bool_t          host;
+    nxt_buf_mem_t       mem;
+    nxt_hpack_field_t   *f;
+    nxt_http_request_t  *r;
+
+    static const nxt_str_t  version = nxt_string("HTTP/2.0");
+
+    r = stream->request;
+
+    if (nxt_slow_path(nxt_h2p_target_test(&pseudo[NXT_H2P_PSEUDO_METHOD])
+                      != NXT_OK
+                      || nxt_h2p_target_test(&pseudo[NXT_H2P_PSEUDO_PATH])
+                         != NXT_OK))
+    {
+        return NXT_HTTP_BAD_REQUEST;
+    }
+
+    size = pseudo[NXT_H2P_PSEUDO_METHOD].length
+           + pseudo[NXT_H2P_PSEUDO_PATH].length
+           + nxt_length("  HTTP/1.1\r\n\r\n");
+
+    host = 0;
+    f = fields->elts;
+
+    for (i = 0; i < fields->nelts; i++) {
+        /* Cookie fields joined with "; " take less than separate fields. */
+        size += f[i].name.length + f[i].value.length + nxt_length(": \r\n");
+
+        host |= nxt_str_eq(&f[i].name, "host", 4);
+    }
+
+    authority = &pseudo[NXT_H2P_PSEUDO_AUTHORITY];
+
+    if (!host && authority->length != 0) {
+        size += nxt_length("host: \r\n") + authority->length;
+    }
+
+    start = nxt_mp_nget(r->mem_pool, size);
+    if (nxt_slow_path(start == NULL)) {
+        return NXT_HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    p = nxt_cpymem(start, pseudo[NXT_H2P_PSEUDO_METHOD].start,
+                   pseudo[NXT_H2P_PSEUDO_METHOD].length);
+    *p++ = ' ';
+    p = nxt_cpymem(p, pseudo[NXT_H2P_PSEUDO_PATH].start,
+                   pseudo[NXT_H2P_PSEUDO_PATH].length);
+    p = nxt_cpymem(p, " HTTP/1.1\r\n", 11);
+
+    if (!host && authority->length != 0) {
+        p = nxt_cpymem(p, "host: ", 6);
+        p = nxt_cpymem(p, authority->start, authority->length);
+        *p++ = '\r'; *p++ = '\n';
+    }
+
+    ncookies = 0;
+
+    for (i = 0; i < fields->nelts; i++) {
+
+        if (nxt_str_eq(&f[i].name, "cookie", 6)) {
+            ncookies++;
+            continue;
+        }
+
+        p = nxt_cpymem(p, f[i].name.start, f[i].name.length);
+        *p++ = ':'; *p++ = ' ';
+        p = nxt_cpymem(p, f[i].value.start, f[i].value.length);
+        *p++ = '\r'; *p++ = '\n';
+    }
+
+    if (ncookies != 0) {
+        p = nxt_cpymem(p, "cookie: ", 8);
+
+        for (i = 0; i < fields->nelts; i++) {
+
+            if (nxt_str_eq(&f[i].name, "cookie", 6)) {
+                p = nxt_cpymem(p, f[i].value.start, f[i].value.length);
+
+                if (--ncookies != 0) {
+                    *p++ = ';'; *p++ = ' ';
+                }
+            }
+        }
+
+        *p++ = '\r'; *p++ = '\n';
+    }
+
+    *p++ = '\r'; *p++ = '\n';
+
+    mem.start = start;
+    mem.pos = start;
+    mem.free = p;
+    mem.end = p;
+
+    ret = nxt_http_parse_request(&stream->parser, &mem);
+
+    switch (ret) {
+
+    case NXT_DONE:
+        p = stream->parser.request_line_end - version.length;
+
+        nxt_memcpy(p, version.start, version.length);
+        nxt_memcpy(stream->parser.version.str, version.start, version.length);
+
+        r->request_line.start = stream->parser.method.start;
+        r->request_line.length = stream->parser.request_line_end
+                                 - r->request_line.start;
+        return NXT_OK;
+
+    case NXT_HTTP_PARSE_TOO_LARGE_FIELD:
+        return NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE;
+
+    case NXT_ERROR:
+        return NXT_HTTP_INTERNAL_SERVER_ERROR;
+
+    default:
+        return NXT_HTTP_BAD_REQUEST;
+    }
+}
+
+
+static nxt_int_t
+nxt_h2p_target_test(nxt_str_t *str)
+{
+    u_char  *p, *end;
+
+    end = str->start + str->length;
+
+    for (p = str->start; p < end; p++) {
+        if (*p <= 0x20 || *p == 0x7f) {
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_header_process(nxt_task_t *task, nxt_h2p_stream_t *stream,
+    nxt_http_request_t *r)
+{
+    r->target.start = stream->parser.target_start;
+    r->target.length = stream->parser.target_end - stream->parser.target_start;
+
+    if (stream->parser.version.ui64 != 0) {
+        r->version.start = stream->parser.version.str;
+        r->version.length = sizeof(stream->parser.version.str);
+    }
+
+    r->method = &stream->parser.method;
+    r->path = &stream->parser.path;
+    r->args = &stream->parser.args;
+
+    r->fields = stream->parser.fields;
+
+    return nxt_http_fields_process(r->fields, &nxt_h2p_fields_hash, r);
+}
+
+
+/*
+ * Returns a pseudo field index, NXT_H2P_PSEUDO_FIELDS for
+ * a regular field, or NXT_ERROR for a malformed field.
+ */
+
+static nxt_int_t
+nxt_h2p_field_test(nxt_hpack_field_t *field)
+{
+    u_char      c, *p, *end;
+    nxt_int_t   n;
+    nxt_uint_t  i;
+
+    if (nxt_slow_path(field->name.length == 0)) {
+        return NXT_ERROR;
+    }
+
+    p = field->name.start;
+    end = p + field->name.length;
+
+    if (*p == ':') {
+        for (n = 0; n < NXT_H2P_PSEUDO_FIELDS; n++) {
+            if (nxt_strstr_eq(&field->name, &nxt_h2p_pseudo_fields[n])) {
+                goto value;
+            }
+        }
+
+        return NXT_ERROR;
+    }
+
+    while (p < end) {
+        c = *p++;
+
+        if (nxt_slow_path((c >= 'A' && c <= 'Z') || c <= 0x20 || c == 0x7f
+                          || c == ':'))
+        {
+            return NXT_ERROR;
+        }
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_h2p_connection_fields); i++) {
+        if (nxt_strstr_eq(&field->name, &nxt_h2p_connection_fields[i])) {
+            return NXT_ERROR;
+        }
+    }
+
+    if (nxt_str_eq(&field->name, "te", 2)
+        && !nxt_str_eq(&field->value, "trailers", 8))
+    {
+        return NXT_ERROR;
+    }
+
+    n = NXT_H2P_PSEUDO_FIELDS;
+
+value:
+
+    p = field->value.start;
+    end = p + field->value.length;
+
+    while (p < end) {
+        c = *p++;
+
+        if (nxt_slow_path(c == '\0' || c == '\r' || c == '\n')) {
+            return NXT_ERROR;
+        }
+    }
+
+    return n;
+}
+
+
+static nxt_h2p_stream_t *
+nxt_h2p_stream_find(nxt_h2proto_t *h2p, uint32_t id)
+{
+    nxt_h2p_stream_t  *stream;
+
+    nxt_queue_each(stream, &h2p->streams, nxt_h2p_stream_t, link) {
+
+        if (stream->id == id) {
+            return stream;
+        }
+
+    } nxt_queue_loop;
+
+    return NULL;
+}
+
+
+static void
+nxt_h2p_stream_abort(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    nxt_buf_t           *out;
+    nxt_http_request_t  *r;
+
+    if (stream->aborted) {
+        return;
+    }
+
+    nxt_debug(task, "h2p stream %uD abort", stream->id);
+
+    stream->aborted = 1;
+    stream->reset = 1;
+
+    if (stream->body_wait) {
+        stream->body_wait = 0;
+        stream->h2p->body_waits--;
+    }
+
+    out = stream->out;
+    stream->out = NULL;
+
+    if (out != NULL) {
+        nxt_h2p_stream_drop(task, stream, out);
+    }
+
+    if (!stream->out_closed) {
+        r = stream->request;
+
+        /* The stream can be freed by the error handler. */
+        r->state->error_handler(&r->task, r, stream);
+    }
+}
+
+
+void
+nxt_h2p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
+{
+    size_t             size;
+    nxt_buf_t          *b;
+    nxt_h2p_stream_t   *stream;
+    nxt_http_status_t  status;
+
+    stream = r->proto.h2;
+
+    nxt_debug(task, "h2p request body read %O", r->content_length_n);
+
+    if (stream->in_closed) {
+        if (nxt_slow_path(r->content_length_n > 0)) {
+            status = NXT_HTTP_BAD_REQUEST;
+            goto error;
+        }
+
+        goto ready;
+    }
+
+    if (r->content_length_n == 0) {
+        goto ready;
+    }
+
+    size = r->conf->socket_conf->body_buffer_size;
+
+    if (r->content_length_n > 0 && (nxt_off_t) size > r->content_length_n) {
+        size = r->content_length_n;
+    }
+
+    if (r->content_length_n > (nxt_off_t) size) {
+        b = nxt_h2p_body_file(task, r);
+
+    } else {
+        b = nxt_buf_mem_alloc(r->mem_pool, size, 0);
+        r->body = b;
+    }
+
+    if (nxt_slow_path(b == NULL)) {
+        status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+        goto error;
+    }
+
+    stream->body_wait = 1;
+    stream->h2p->body_waits++;
+
+    return;
+
+ready:
+
+    r->state->ready_handler(task, r, NULL);
+
+    return;
+
+error:
+
+    nxt_http_request_error(task, r, status);
+}
+
+
+static void
+nxt_h2p_body(nxt_task_t *task, nxt_h2p_stream_t *stream, u_char *pos,
+    size_t size)
+{
+    size_t              used;
+    nxt_buf_t           *b, *fb;
+    nxt_http_status_t   status;
+    nxt_http_request_t  *r;
+
+    if (!stream->body_wait) {
+        return;
+    }
+
+    r = stream->request;
+    task = &r->task;
+
+    stream->received += size;
+
+    if (r->content_length_n >= 0) {
+        if (nxt_slow_path(stream->received > r->content_length_n)) {
+            status = NXT_HTTP_BAD_REQUEST;
+            goto error;
+        }
+
+    } else if (nxt_slow_path(stream->received
+                             > (nxt_off_t) r->conf->socket_conf->max_body_size))
+    {
+        status = NXT_HTTP_PAYLOAD_TOO_LARGE;
+        goto error;
+    }
+
+    b = r->body;
+
+    if (size != 0) {
+
+        if (!nxt_buf_is_file(b)
+            && size > (size_t) nxt_buf_mem_free_size(&b->mem))
+        {
+            /* A body without "Content-Length" exceeds the buffer. */
+
+            fb = nxt_h2p_body_file(task, r);
+            if (nxt_slow_path(fb == NULL)) {
+                status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+                goto error;
+            }
+
+            used = nxt_buf_mem_used_size(&b->mem);
+
+            if (nxt_slow_path(nxt_fd_write(fb->file->fd, b->mem.pos, used)
+                              != (ssize_t) used))
+            {
+                status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+                goto error;
+            }
+
+            fb->file_end = used;
+
+            nxt_mp_free(r->mem_pool, b);
+            b = fb;
+        }
+
+        if (nxt_buf_is_file(b)) {
+            if (nxt_slow_path(nxt_fd_write(b->file->fd, pos, size)
+                              != (ssize_t) size))
+            {
+                status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+                goto error;
+            }
+
+            b->file_end += size;
+
+        } else {
+            b->mem.free = nxt_cpymem(b->mem.free, pos, size);
+        }
+    }
+
+    if (!stream->in_closed) {
+        return;
+    }
+
+    if (r->content_length_n >= 0) {
+        if (nxt_slow_path(stream->received != r->content_length_n)) {
+            status = NXT_HTTP_BAD_REQUEST;
+            goto error;
+        }
+
+    } else if (nxt_slow_path(nxt_h2p_content_length(r, stream->received)
+                             != NXT_OK))
+    {
+        status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+        goto error;
+    }
+
+    if (nxt_buf_is_file(b)) {
+        b->file->size = b->file_end;
+    }
+
+    stream->body_wait = 0;
+    stream->h2p->body_waits--;
+
+    r->state->ready_handler(task, r, NULL);
+
+    return;
+
+error:
+
+    stream->body_wait = 0;
+    stream->h2p->body_waits--;
+
+    nxt_http_request_error(task, r, status);
+}
+
+
+static nxt_buf_t *
+nxt_h2p_body_file(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_str_t  *tmp_path, tmp_name;
+    nxt_buf_t  *b;
+
+    static const nxt_str_t tmp_name_pattern = nxt_string("/req-XXXXXXXX");
+
+    tmp_path = &r->conf->socket_conf->body_temp_path;
+
+    tmp_name.length = tmp_path->length + tmp_name_pattern.length;
+
+    b = nxt_buf_file_alloc(r->mem_pool,
+                           sizeof(nxt_file_t) + tmp_name.length + 1, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NULL;
+    }
+
+    tmp_name.start = nxt_pointer_to(b->mem.start, sizeof(nxt_file_t));
+
+    memcpy(tmp_name.start, tmp_path->start, tmp_path->length);
+    memcpy(tmp_name.start + tmp_path->length, tmp_name_pattern.start,
+           tmp_name_pattern.length);
+    tmp_name.start[tmp_name.length] = '\0';
+
+    b->file = (nxt_file_t *) b->mem.start;
+    nxt_memzero(b->file, sizeof(nxt_file_t));
+
+    b->mem.start = NULL;
+    b->mem.end = NULL;
+    b->mem.pos = NULL;
+    b->mem.free = NULL;
+
+    /* The file descriptor is closed by nxt_http_request_close_handler(). */
+    r->body = b;
+
+    b->file->fd = mkstemp((char *) tmp_name.start);
+    if (nxt_slow_path(b->file->fd == -1)) {
+        nxt_alert(task, "mkstemp(%s) failed %E", tmp_name.start, nxt_errno);
+        return NULL;
+    }
+
+    nxt_debug(task, "create body tmp file \"%V\", %d",
+              &tmp_name, b->file->fd);
+
+    unlink((char *) tmp_name.start);
+
+    return b;
+}
+
+
+/*
+ * A body without "Content-Length" is passed to applications
+ * with the field added after the body has been received.
+ */
+
+static nxt_int_t
+nxt_h2p_content_length(nxt_http_request_t *r, nxt_off_t n)
+{
+    u_char            *p;
+    uint32_t          hash;
+    nxt_uint_t        i;
+    nxt_http_field_t  *field;
+
+    field = nxt_list_zero_add(r->fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, NXT_OFF_T_LEN);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Content-Length");
+
+    hash = NXT_HTTP_FIELD_HASH_INIT;
+
+    for (i = 0; i < field->name_length; i++) {
+        hash = nxt_http_field_hash_char(hash, nxt_lowcase(field->name[i]));
+    }
+
+    field->hash = nxt_http_field_hash_end(hash) & 0xFFFF;
+
+    field->value = p;
+    field->value_length = nxt_sprintf(p, p + NXT_OFF_T_LEN, "%O", n) - p;
+
+    r->content_length = field;
+    r->content_length_n = n;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_h2p_request_local_addr(nxt_task_t *task, nxt_http_request_t *r)
+{
+    r->local = nxt_conn_local_addr(task, r->proto.h2->h2p->conn);
+}
+
+
+void
+nxt_h2p_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_work_handler_t body_handler, void *data)
+{
+    u_char            *p, *pos, *block;
+    size_t            size, length, frames;
+    nxt_buf_t         *b;
+    nxt_uint_t        n, type, flags;
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *stream;
+    nxt_http_field_t  *field;
+
+    nxt_debug(task, "h2p request header send");
+
+    r->header_sent = 1;
+    stream = r->proto.h2;
+    h2p = stream->h2p;
+
+    n = r->status;
+
+    if (n < NXT_HTTP_OK || n > NXT_HTTP_STATUS_MAX) {
+        /* Informational responses are not supported. */
+        n = NXT_HTTP_INTERNAL_SERVER_ERROR;
+
+    } else if (n == NXT_HTTP_TO_HTTPS) {
+        n = NXT_HTTP_BAD_REQUEST;
+    }
+
+    size = NXT_HPACK_STATUS_SIZE;
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (!field->skip && !nxt_h2p_hop_by_hop(field)) {
+            size += nxt_hpack_field_size(field->name_length,
+                                         field->value_length);
+        }
+
+    } nxt_list_loop;
+
+    frames = size / NXT_H2P_DEFAULT_FRAME + 1;
+
+    b = nxt_h2p_frame_alloc(task, h2p,
+                            size + frames * NXT_H2P_FRAME_HEADER_SIZE);
+    if (nxt_slow_path(b == NULL)) {
+        r->state->error_handler(task, r, stream);
+        return;
+    }
+
+    /*
+     * The header block is encoded after the room for frame headers
+     * and then is moved to split it into HEADERS and CONTINUATION frames.
+     */
+
+    block = b->mem.start + frames * NXT_H2P_FRAME_HEADER_SIZE;
+
+    p = nxt_hpack_encode_status(block, n);
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (!field->skip && !nxt_h2p_hop_by_hop(field)) {
+            p = nxt_hpack_encode_field(p, field->name, field->name_length,
+                                       field->value, field->value_length);
+        }
+
+    } nxt_list_loop;
+
+    length = p - block;
+    pos = block;
+    p = b->mem.start;
+
+    type = NXT_H2P_HEADERS;
+    flags = (body_handler == NULL) ? NXT_H2P_END_STREAM : 0;
+
+    do {
+        size = nxt_min(length, NXT_H2P_DEFAULT_FRAME);
+        length -= size;
+
+        if (length == 0) {
+            flags |= NXT_H2P_END_HEADERS;
+        }
+
+        p = nxt_h2p_frame_header(p, size, type, flags, stream->id);
+
+        nxt_memmove(p, pos, size);
+        p += size;
+        pos += size;
+
+        type = NXT_H2P_CONTINUATION;
+        flags = 0;
+
+    } while (length != 0);
+
+    b->mem.free = p;
+
+    if (body_handler != NULL) {
+        nxt_work_queue_add(&task->thread->engine->fast_work_queue,
+                           body_handler, task, r, data);
+
+    } else {
+        stream->out_closed = 1;
+        b->next = nxt_http_buf_last(r);
+    }
+
+    if (nxt_slow_path(stream->reset)) {
+        nxt_h2p_stream_drop(task, stream, b);
+        return;
+    }
+
+    nxt_h2p_conn_send(task, h2p, b);
+}
+
+
+void
+nxt_h2p_request_send(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
+{
+    nxt_h2p_stream_t  *stream;
+
+    nxt_debug(task, "h2p request send");
+
+    stream = r->proto.h2;
+
+    if (nxt_slow_path(stream->reset)) {
+        nxt_h2p_stream_drop(task, stream, out);
+        return;
+    }
+
+    nxt_buf_chain_add(&stream->out, out);
+
+    nxt_h2p_stream_send(task, stream);
+}
+
+
+/*
+ * Response data are copied to DATA frames limited by the flow control
+ * windows.  The copied buffers follow the frames in the connection output
+ * to be completed after the frames have been sent.
+ */
+
+static void
+nxt_h2p_stream_send(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    u_char         *p;
+    size_t         n, size, rest;
+    int32_t        window;
+    nxt_buf_t      *b, *frame, **tail;
+    nxt_uint_t     flags;
+    nxt_h2proto_t  *h2p;
+
+    h2p = stream->h2p;
+
+    while (stream->out != NULL) {
+        b = stream->out;
+
+        if (nxt_h2p_buf_used_size(b) == 0) {
+            stream->out = b->next;
+            b->next = NULL;
+
+            if (nxt_buf_is_last(b) && !stream->out_closed) {
+                frame = nxt_h2p_frame_alloc(task, h2p,
+                                            NXT_H2P_FRAME_HEADER_SIZE);
+                if (nxt_slow_path(frame == NULL)) {
+                    b->next = stream->out;
+                    stream->out = b;
+                    goto fail;
+                }
+
+                frame->mem.free = nxt_h2p_frame_header(frame->mem.free, 0,
+                                                       NXT_H2P_DATA,
+                                                       NXT_H2P_END_STREAM,
+                                                       stream->id);
+                frame->next = b;
+                b = frame;
+
+                stream->out_closed = 1;
+            }
+
+            nxt_h2p_conn_send(task, h2p, b);
+            continue;
+        }
+
+        window = nxt_min(stream->send_window, h2p->send_window);
+
+        if (window <= 0) {
+            nxt_debug(task, "h2p stream %uD is blocked by flow control",
+                      stream->id);
+            return;
+        }
+
+        rest = 0;
+
+        for (b = stream->out; b != NULL && !nxt_buf_is_sync(b); b = b->next) {
+            rest += nxt_buf_mem_used_size(&b->mem);
+        }
+
+        n = nxt_min(rest, NXT_H2P_DEFAULT_FRAME);
+        n = nxt_min(n, (size_t) window);
+
+        frame = nxt_h2p_frame_alloc(task, h2p, NXT_H2P_FRAME_HEADER_SIZE + n);
+        if (nxt_slow_path(frame == NULL)) {
+            goto fail;
+        }
+
+        p = frame->mem.free + NXT_H2P_FRAME_HEADER_SIZE;
+        tail = &frame->next;
+        flags = 0;
+
+        for (rest = n; rest != 0; /* void */) {
+            b = stream->out;
+
+            size = nxt_min(rest, (size_t) nxt_buf_mem_used_size(&b->mem));
+
+            p = nxt_cpymem(p, b->mem.pos, size);
+            b->mem.pos += size;
+            rest -= size;
+
+            if (b->mem.pos == b->mem.free) {
+                stream->out = b->next;
+                b->next = NULL;
+
+                *tail = b;
+                tail = &b->next;
+
+                if (nxt_buf_is_last(b)) {
+                    flags = NXT_H2P_END_STREAM;
+                }
+            }
+        }
+
+        while (stream->out != NULL && nxt_h2p_buf_used_size(stream->out) == 0) {
+            b = stream->out;
+            stream->out = b->next;
+            b->next = NULL;
+
+            *tail = b;
+            tail = &b->next;
+
+            if (nxt_buf_is_last(b)) {
+                flags = NXT_H2P_END_STREAM;
+            }
+        }
+
+        if (flags != 0) {
+            stream->out_closed = 1;
+        }
+
+        (void) nxt_h2p_frame_header(frame->mem.free, n, NXT_H2P_DATA, flags,
+                                    stream->id);
+        frame->mem.free = p;
+
+        stream->send_window -= n;
+        h2p->send_window -= n;
+        stream->sent += n;
+
+        nxt_h2p_conn_send(task, h2p, frame);
+    }
+
+    return;
+
+fail:
+
+    (void) nxt_h2p_rst_stream_send(task, h2p, stream->id,
+                                   NXT_H2P_INTERNAL_ERROR);
+    nxt_h2p_stream_abort(task, stream);
+}
+
+
+static void
+nxt_h2p_stream_drop(nxt_task_t *task, nxt_h2p_stream_t *stream, nxt_buf_t *b)
+{
+    nxt_buf_t  *next;
+
+    if (b == NULL) {
+        return;
+    }
+
+    /*
+     * The buffers are completed in order with the
+     * stream buffers already queued to the connection.
+     */
+
+    for (next = b; next != NULL; next = next->next) {
+        if (!nxt_buf_is_sync(next)) {
+            next->mem.pos = next->mem.free;
+        }
+    }
+
+    nxt_h2p_conn_send(task, stream->h2p, b);
+}
+
+
+static nxt_bool_t
+nxt_h2p_hop_by_hop(nxt_http_field_t *field)
+{
+    nxt_str_t   name;
+    nxt_uint_t  i;
+
+    name.length = field->name_length;
+    name.start = field->name;
+
+    for (i = 0; i < nxt_nitems(nxt_h2p_connection_fields); i++) {
+        if (nxt_strcasestr_eq(&name, &nxt_h2p_connection_fields[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+nxt_off_t
+nxt_h2p_request_body_bytes_sent(nxt_task_t *task, nxt_http_proto_t proto)
+{
+    return proto.h2->sent;
+}
+
+
+void
+nxt_h2p_request_discard(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *last)
+{
+    nxt_buf_t         *out;
+    nxt_h2p_stream_t  *stream;
+
+    nxt_debug(task, "h2p request discard");
+
+    stream = r->proto.h2;
+
+    if (!stream->reset) {
+        stream->reset = 1;
+
+        if (!stream->out_closed) {
+            (void) nxt_h2p_rst_stream_send(task, stream->h2p, stream->id,
+                                           NXT_H2P_INTERNAL_ERROR);
+        }
+    }
+
+    out = stream->out;
+    stream->out = NULL;
+
+    nxt_buf_chain_add(&out, last);
+
+    nxt_h2p_stream_drop(task, stream, out);
+}
+
+
+void
+nxt_h2p_request_close(nxt_task_t *task, nxt_http_proto_t proto,
+    nxt_socket_conf_joint_t *joint)
+{
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *stream;
+
+    nxt_debug(task, "h2p request close");
+
+    stream = proto.h2;
+    h2p = stream->h2p;
+
+    nxt_router_conf_release(task, joint);
+
+    task = &h2p->conn->task;
+
+    if (stream->body_wait) {
+        stream->body_wait = 0;
+        h2p->body_waits--;
+    }
+
+    if (!stream->in_closed && !stream->reset && !h2p->error) {
+        /* The request body is not needed anymore. */
+        (void) nxt_h2p_rst_stream_send(task, h2p, stream->id,
+                                       NXT_H2P_NO_ERROR);
+    }
+
+    nxt_queue_remove(&stream->link);
+    h2p->nstreams--;
+
+    if (h2p->nstreams != 0) {
+        return;
+    }
+
+    if (h2p->closing || h2p->goaway || h2p->error) {
+        nxt_h2p_conn_finalize(task, h2p);
+
+    } else {
+        nxt_h2p_conn_idle(task, h2p);
+    }
+}
+
+
+static nxt_int_t
+nxt_h2p_settings_send(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    u_char  *p, payload[12];
+
+    p = payload;
+
+    *p++ = 0;
+    *p++ = NXT_H2P_MAX_CONCURRENT_STREAMS;
+    p = nxt_h2p_uint32(p, NXT_H2P_MAX_STREAMS);
+
+    *p++ = 0;
+    *p++ = NXT_H2P_INITIAL_WINDOW_SIZE;
+    p = nxt_h2p_uint32(p, NXT_H2P_WINDOW);
+
+    if (nxt_slow_path(nxt_h2p_frame_send(task, h2p, NXT_H2P_SETTINGS, 0, 0,
+                                         payload, p - payload)
+                      != NXT_OK))
+    {
+        return NXT_ERROR;
+    }
+
+    h2p->recv_window = NXT_H2P_WINDOW;
+
+    return nxt_h2p_window_update_send(task, h2p, 0,
+                                      NXT_H2P_WINDOW - NXT_H2P_DEFAULT_WINDOW);
+}
+
+
+static nxt_int_t
+nxt_h2p_frame_send(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_uint_t type,
+    nxt_uint_t flags, uint32_t id, u_char *payload, size_t size)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    b = nxt_h2p_frame_alloc(task, h2p, NXT_H2P_FRAME_HEADER_SIZE + size);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, size, type, flags, id);
+
+    if (size != 0) {
+        p = nxt_cpymem(p, payload, size);
+    }
+
+    b->mem.free = p;
+
+    nxt_h2p_conn_send(task, h2p, b);
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_window_update_send(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, uint32_t increment)
+{
+    u_char  payload[4];
+
+    (void) nxt_h2p_uint32(payload, increment);
+
+    return nxt_h2p_frame_send(task, h2p, NXT_H2P_WINDOW_UPDATE, 0, id,
+                              payload, 4);
+}
+
+
+static nxt_int_t
+nxt_h2p_rst_stream_send(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    uint32_t code)
+{
+    u_char  payload[4];
+
+    nxt_debug(task, "h2p stream %uD reset: %uD", id, code);
+
+    (void) nxt_h2p_uint32(payload, code);
+
+    return nxt_h2p_frame_send(task, h2p, NXT_H2P_RST_STREAM, 0, id,
+                              payload, 4);
+}
+
+
+static nxt_buf_t *
+nxt_h2p_frame_alloc(nxt_task_t *task, nxt_h2proto_t *h2p, size_t size)
+{
+    nxt_mp_t   *mp;
+    nxt_buf_t  *b;
+
+    mp = h2p->conn->mem_pool;
+
+    b = nxt_buf_mem_alloc(mp, size, 0);
+
+    if (nxt_fast_path(b != NULL)) {
+        b->completion_handler = nxt_h2p_frame_completion;
+        b->parent = mp;
+        nxt_mp_retain(mp);
+    }
+
+    return b;
+}
+
+
+static u_char *
+nxt_h2p_uint32(u_char *p, uint32_t n)
+{
+    *p++ = (u_char) (n >> 24);
+    *p++ = (u_char) (n >> 16);
+    *p++ = (u_char) (n >> 8);
+    *p++ = (u_char) n;
+
+    return p;
+}
+
+
+static u_char *
+nxt_h2p_frame_header(u_char *p, size_t length, nxt_uint_t type,
+    nxt_uint_t flags, uint32_t id)
+{
+    *p++ = (u_char) (length >> 16);
+    *p++ = (u_char) (length >> 8);
+    *p++ = (u_char) length;
+    *p++ = (u_char) type;
+    *p++ = (u_char) flags;
+
+    return nxt_h2p_uint32(p, id);
+}
+
+
+static void
+nxt_h2p_frame_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_mp_t   *mp;
+    nxt_buf_t  *b;
+
+    b = obj;
+    mp = data;
+
+    nxt_mp_free(mp, b);
+    nxt_mp_release(mp);
+}
+
+
+static void
+nxt_h2p_conn_send(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_buf_t *out)
+{
+    nxt_conn_t  *c;
+
+    if (nxt_slow_path(h2p->error || h2p->closed)) {
+        (void) nxt_h2p_completion(task, out, 1);
+        return;
+    }
+
+    c = h2p->conn;
+
+    if (c->write == NULL) {
+        /* Empty buffers, e.g. dropped ones, need not be written. */
+        out = nxt_h2p_completion(task, out, 0);
+
+        if (out == NULL) {
+            return;
+        }
+
+        c->write = out;
+
+        nxt_conn_write(task->thread->engine, c);
+
+    } else {
+        *h2p->conn_write_tail = out;
+    }
+
+    while (out->next != NULL) {
+        out = out->next;
+    }
+
+    h2p->conn_write_tail = &out->next;
+}
+
+
+/*
+ * The buffers are completed one by one unlike nxt_sendbuf_completion(),
+ * since adjacent buffers with the same completion handler can belong
+ * to different streams.
+ */
+
+static nxt_buf_t *
+nxt_h2p_completion(nxt_task_t *task, nxt_buf_t *b, nxt_bool_t all)
+{
+    nxt_buf_t         *next;
+    nxt_work_queue_t  *wq;
+
+    wq = &task->thread->engine->fast_work_queue;
+
+    while (b != NULL) {
+
+        if (!all && nxt_h2p_buf_used_size(b) != 0) {
+            break;
+        }
+
+        next = b->next;
+        b->next = NULL;
+
+        nxt_work_queue_add(wq, b->completion_handler, task, b, b->parent);
+
+        b = next;
+    }
+
+    return b;
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_send_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_sent,
+    .error_handler = nxt_h2p_conn_error,
+
+    .timer_handler = nxt_h2p_conn_send_timeout,
+    .timer_value = nxt_h2p_conn_send_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, send_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h2p_conn_sent(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t     *c;
+    nxt_h2proto_t  *h2p;
+
+    c = obj;
+    h2p = c->socket.data;
+
+    nxt_debug(task, "h2p conn sent");
+
+    c->write = nxt_h2p_completion(task, c->write, 0);
+
+    if (c->write != NULL) {
+        nxt_conn_write(task->thread->engine, c);
+        return;
+    }
+
+    if (h2p != NULL && h2p->closing) {
+        nxt_h2p_conn_finalize(task, h2p);
+    }
+}
+
+
+static void
+nxt_h2p_conn_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t     *c;
+    nxt_h2proto_t  *h2p;
+
+    c = obj;
+    h2p = c->socket.data;
+
+    nxt_debug(task, "h2p conn error");
+
+    if (nxt_slow_path(h2p == NULL || h2p->error)) {
+        return;
+    }
+
+    h2p->error = 1;
+
+    (void) nxt_h2p_completion(task, c->write, 1);
+    c->write = NULL;
+
+    nxt_h2p_conn_abort(task, h2p);
+    nxt_h2p_conn_finalize(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t          *c;
+    nxt_timer_t         *timer;
+    nxt_h2proto_t       *h2p;
+    nxt_h2p_stream_t    *stream;
+    nxt_http_request_t  *r;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p conn timeout");
+
+    c = nxt_read_timer_conn(timer);
+    h2p = c->socket.data;
+
+    if (h2p->nstreams == 0) {
+        nxt_h2p_goaway_send(task, h2p, NXT_H2P_NO_ERROR);
+        return;
+    }
+
+    nxt_queue_each(stream, &h2p->streams, nxt_h2p_stream_t, link) {
+
+        if (stream->body_wait) {
+            stream->body_wait = 0;
+            h2p->body_waits--;
+
+            r = stream->request;
+
+            nxt_http_request_error(&r->task, r, NXT_HTTP_REQUEST_TIMEOUT);
+        }
+
+    } nxt_queue_loop;
+}
+
+
+static void
+nxt_h2p_conn_send_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p conn send timeout");
+
+    c = nxt_write_timer_conn(timer);
+    c->block_write = 1;
+
+    nxt_h2p_conn_error(task, c, c->socket.data);
+}
+
+
+static nxt_msec_t
+nxt_h2p_conn_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_h2proto_t            *h2p;
+    nxt_socket_conf_joint_t  *joint;
+
+    h2p = c->socket.data;
+    joint = c->listen->socket.data;
+
+    if (nxt_slow_path(joint == NULL)) {
+        /*
+         * Listening socket had been closed while
+         * connection was in keep-alive state.
+         */
+        return (h2p->nstreams == 0) ? 1 : 0;
+    }
+
+    if (h2p->nstreams == 0) {
+        return nxt_value_at(nxt_msec_t, joint->socket_conf, data);
+    }
+
+    if (h2p->body_waits != 0) {
+        return joint->socket_conf->body_read_timeout;
+    }
+
+    return 0;
+}
+
+
+static nxt_msec_t
+nxt_h2p_conn_send_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_socket_conf_joint_t  *joint;
+
+    joint = c->listen->socket.data;
+
+    if (nxt_fast_path(joint != NULL)) {
+        return nxt_value_at(nxt_msec_t, joint->socket_conf, data);
+    }
+
+    return 10 * 1000;
+}
+
+
+static void
+nxt_h2p_goaway_send(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_uint_t code)
+{
+    u_char  *p, payload[8];
+
+    nxt_debug(task, "h2p goaway send: %ui", code);
+
+    if (!h2p->closing && !h2p->error) {
+        p = nxt_h2p_uint32(payload, h2p->last_stream);
+        (void) nxt_h2p_uint32(p, code);
+
+        (void) nxt_h2p_frame_send(task, h2p, NXT_H2P_GOAWAY, 0, 0,
+                                  payload, 8);
+    }
+
+    h2p->goaway = 1;
+
+    if (code != NXT_H2P_NO_ERROR) {
+        nxt_h2p_conn_abort(task, h2p);
+    }
+
+    nxt_h2p_conn_finalize(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_abort(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_h2p_stream_t  *stream;
+
+    nxt_queue_each(stream, &h2p->streams, nxt_h2p_stream_t, link) {
+        nxt_h2p_stream_abort(task, stream);
+    } nxt_queue_loop;
+}
+
+
+static void
+nxt_h2p_conn_active(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    if (h2p->idle) {
+        h2p->idle = 0;
+        nxt_conn_active(task->thread->engine, h2p->conn);
+    }
+}
+
+
+static void
+nxt_h2p_conn_idle(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_conn_t          *c;
+    nxt_event_engine_t  *engine;
+
+    c = h2p->conn;
+    engine = task->thread->engine;
+
+    if (!h2p->idle) {
+        h2p->idle = 1;
+        nxt_conn_idle(engine, c);
+    }
+
+    nxt_conn_timer(engine, c, c->read_state, &c->read_timer);
+}
+
+
+/*
+ * The connection is closed after all streams have been closed
+ * and all pending frames, in particular GOAWAY, have been sent.
+ */
+
+static void
+nxt_h2p_conn_finalize(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_conn_t  *c;
+
+    c = h2p->conn;
+
+    nxt_debug(task, "h2p conn finalize");
+
+    if (!h2p->closing) {
+        h2p->closing = 1;
+        c->block_read = 1;
+
+        nxt_timer_disable(task->thread->engine, &c->read_timer);
+    }
+
+    if (h2p->closed || h2p->nstreams != 0 || c->write != NULL) {
+        return;
+    }
+
+    h2p->closed = 1;
+
+    nxt_h2p_conn_active(task, h2p);
+
+    nxt_h2p_closing(task, c);
+}
+
+
+static void
+nxt_h2p_closing(nxt_task_t *task, nxt_conn_t *c)
+{
+    nxt_debug(task, "h2p closing");
+
+    c->socket.data = NULL;
+
+#if (NXT_TLS)
+
+    if (c->u.tls != NULL) {
+        c->write_state = &nxt_h2p_shutdown_state;
+
+        c->io->shutdown(task, c, NULL);
+        return;
+    }
+
+#endif
+
+    nxt_h2p_conn_closing(task, c, NULL);
+}
+
+
+#if (NXT_TLS)
+
+static const nxt_conn_state_t  nxt_h2p_shutdown_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_closing,
+    .close_handler = nxt_h2p_conn_closing,
+    .error_handler = nxt_h2p_conn_closing,
+};
+
+#endif
+
+
+static void
+nxt_h2p_conn_closing(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "h2p conn closing");
+
+    c->write_state = &nxt_h2p_close_state;
+
+    nxt_conn_close(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_close_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_free,
+};
+
+
+static void
+nxt_h2p_conn_free(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t          *c;
+    nxt_listen_event_t  *lev;
+    nxt_event_engine_t  *engine;
+
+    c = obj;
+
+    nxt_debug(task, "h2p conn free");
+
+    engine = task->thread->engine;
+
+    nxt_sockaddr_cache_free(engine, c);
+
+    lev = c->listen;
+
+    nxt_conn_free(task, c);
+
+    nxt_router_listen_event_release(&engine->task, lev, NULL);
+}
@@ -0,0 +1,97 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_H2PROTO_H_INCLUDED_
+#define _NXT_H2PROTO_H_INCLUDED_
+
+
+#include <nxt_main.h>
+#include <nxt_http_parse.h>
+#include <nxt_http.h>
+#include <nxt_router.h>
+#include <nxt_hpack.h>
+
+
+typedef struct nxt_h2proto_s  nxt_h2proto_t;
+
+
+struct nxt_h2p_stream_s {
+    nxt_queue_link_t          link;
+
+    nxt_h2proto_t             *h2p;
+    nxt_http_request_t        *request;
+    nxt_http_request_parse_t  parser;
+
+    /* Response data waiting for flow control windows. */
+    nxt_buf_t                 *out;
+
+    nxt_off_t                 received;
+    nxt_off_t                 sent;
+
+    uint32_t                  id;
+    int32_t                   send_window;
+    int32_t                   recv_window;
+
+    uint8_t                   in_closed;    /* 1 bit */
+    uint8_t                   out_closed;   /* 1 bit */
+    uint8_t                   reset;        /* 1 bit */
+    uint8_t                   aborted;      /* 1 bit */
+    uint8_t                   body_wait;    /* 1 bit */
+};
+
+
+struct nxt_h2proto_s {
+    nxt_conn_t                *conn;
+    nxt_queue_t               streams;
+    nxt_hpack_t               hpack;
+
+    nxt_buf_t                 **conn_write_tail;
+
+    /* A header block split into HEADERS and CONTINUATION frames. */
+    u_char                    *header_block;
+    size_t                    header_size;
+    size_t                    header_length;
+    uint32_t                  header_stream;
+    uint8_t                   header_flags;
+
+    uint32_t                  last_stream;
+    uint32_t                  nstreams;
+    uint32_t                  body_waits;
+
+    /* Streams opened and open streams reset by the client. */
+    uint32_t                  opened;
+    uint32_t                  resets;
+
+    int32_t                   send_window;
+    int32_t                   recv_window;
+
+    /* The client SETTINGS_INITIAL_WINDOW_SIZE. */
+    uint32_t                  init_window;
+
+    uint8_t                   preface;      /* 1 bit */
+    uint8_t                   idle;         /* 1 bit */
+    uint8_t                   goaway;       /* 1 bit */
+    uint8_t                   closing;      /* 1 bit */
+    uint8_t                   error;        /* 1 bit */
+    uint8_t                   closed;       /* 1 bit */
+};
+
+
+void nxt_h2p_conn_init(nxt_task_t *task, nxt_conn_t *c);
+
+void nxt_h2p_request_body_read(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_h2p_request_local_addr(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_h2p_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_work_handler_t body_handler, void *data);
+void nxt_h2p_request_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out);
+nxt_off_t nxt_h2p_request_body_bytes_sent(nxt_task_t *task,
+    nxt_http_proto_t proto);
+void nxt_h2p_request_discard(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *last);
+void nxt_h2p_request_close(nxt_task_t *task, nxt_http_proto_t proto,
+    nxt_socket_conf_joint_t *joint);
+
+#endif  /* _NXT_H2PROTO_H_INCLUDED_ */
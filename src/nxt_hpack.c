@@ -0,0 +1,651 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_hpack.h>
+
+
+struct nxt_hpack_entry_s {
+    uint32_t                  name_length;
+    uint32_t                  value_length;
+    u_char                    data[];
+};
+
+
+#define nxt_hpack_entry_size(e)                                               \
+    ((e)->name_length + (e)->value_length + 32)
+
+
+static nxt_int_t nxt_hpack_decode_int(u_char **pos, const u_char *end,
+    nxt_uint_t prefix, uint32_t *value);
+static nxt_int_t nxt_hpack_decode_string(nxt_mp_t *mp, u_char **pos,
+    const u_char *end, nxt_str_t *str);
+static nxt_int_t nxt_hpack_table_get(nxt_hpack_t *hp, uint32_t index,
+    nxt_hpack_field_t *field);
+static nxt_int_t nxt_hpack_table_add(nxt_hpack_t *hp, nxt_hpack_field_t *field);
+static void nxt_hpack_table_evict(nxt_hpack_t *hp, size_t size);
+
+
+static const nxt_hpack_field_t  nxt_hpack_static_table[] = {
+    { nxt_string(":authority"),                  nxt_null_string },
+    { nxt_string(":method"),                     nxt_string("GET") },
+    { nxt_string(":method"),                     nxt_string("POST") },
+    { nxt_string(":path"),                       nxt_string("/") },
+    { nxt_string(":path"),                       nxt_string("/index.html") },
+    { nxt_string(":scheme"),                     nxt_string("http") },
+    { nxt_string(":scheme"),                     nxt_string("https") },
+    { nxt_string(":status"),                     nxt_string("200") },
+    { nxt_string(":status"),                     nxt_string("204") },
+    { nxt_string(":status"),                     nxt_string("206") },
+    { nxt_string(":status"),                     nxt_string("304") },
+    { nxt_string(":status"),                     nxt_string("400") },
+    { nxt_string(":status"),                     nxt_string("404") },
+    { nxt_string(":status"),                     nxt_string("500") },
+    { nxt_string("accept-charset"),              nxt_null_string },
+    { nxt_string("accept-encoding"),             nxt_string("gzip, deflate") },
+    { nxt_string("accept-language"),             nxt_null_string },
+    { nxt_string("accept-ranges"),               nxt_null_string },
+    { nxt_string("accept"),                      nxt_null_string },
+    { nxt_string("access-control-allow-origin"), nxt_null_string },
+    { nxt_string("age"),                         nxt_null_string },
+    { nxt_string("allow"),                       nxt_null_string },
+    { nxt_string("authorization"),               nxt_null_string },
+    { nxt_string("cache-control"),               nxt_null_string },
+    { nxt_string("content-disposition"),         nxt_null_string },
+    { nxt_string("content-encoding"),            nxt_null_string },
+    { nxt_string("content-language"),            nxt_null_string },
+    { nxt_string("content-length"),              nxt_null_string },
+    { nxt_string("content-location"),            nxt_null_string },
+    { nxt_string("content-range"),               nxt_null_string },
+    { nxt_string("content-type"),                nxt_null_string },
+    { nxt_string("cookie"),                      nxt_null_string },
+    { nxt_string("date"),                        nxt_null_string },
+    { nxt_string("etag"),                        nxt_null_string },
+    { nxt_string("expect"),                      nxt_null_string },
+    { nxt_string("expires"),                     nxt_null_string },
+    { nxt_string("from"),                        nxt_null_string },
+    { nxt_string("host"),                        nxt_null_string },
+    { nxt_string("if-match"),                    nxt_null_string },
+    { nxt_string("if-modified-since"),           nxt_null_string },
+    { nxt_string("if-none-match"),               nxt_null_string },
+    { nxt_string("if-range"),                    nxt_null_string },
+    { nxt_string("if-unmodified-since"),         nxt_null_string },
+    { nxt_string("last-modified"),               nxt_null_string },
+    { nxt_string("link"),                        nxt_null_string },
+    { nxt_string("location"),                    nxt_null_string },
+    { nxt_string("max-forwards"),                nxt_null_string },
+    { nxt_string("proxy-authenticate"),          nxt_null_string },
+    { nxt_string("proxy-authorization"),         nxt_null_string },
+    { nxt_string("range"),                       nxt_null_string },
+    { nxt_string("referer"),                     nxt_null_string },
+    { nxt_string("refresh"),                     nxt_null_string },
+    { nxt_string("retry-after"),                 nxt_null_string },
+    { nxt_string("server"),                      nxt_null_string },
+    { nxt_string("set-cookie"),                  nxt_null_string },
+    { nxt_string("strict-transport-security"),   nxt_null_string },
+    { nxt_string("transfer-encoding"),           nxt_null_string },
+    { nxt_string("user-agent"),                  nxt_null_string },
+    { nxt_string("vary"),                        nxt_null_string },
+    { nxt_string("via"),                         nxt_null_string },
+    { nxt_string("www-authenticate"),            nxt_null_string },
+};
+
+
+/* The Huffman code, RFC 7541, Appendix B, without the EOS symbol. */
+
+static const uint32_t  nxt_hpack_huff_codes[256] = {
+    0x00001ff8, 0x007fffd8, 0x0fffffe2, 0x0fffffe3, 0x0fffffe4, 0x0fffffe5,
+    0x0fffffe6, 0x0fffffe7, 0x0fffffe8, 0x00ffffea, 0x3ffffffc, 0x0fffffe9,
+    0x0fffffea, 0x3ffffffd, 0x0fffffeb, 0x0fffffec, 0x0fffffed, 0x0fffffee,
+    0x0fffffef, 0x0ffffff0, 0x0ffffff1, 0x0ffffff2, 0x3ffffffe, 0x0ffffff3,
+    0x0ffffff4, 0x0ffffff5, 0x0ffffff6, 0x0ffffff7, 0x0ffffff8, 0x0ffffff9,
+    0x0ffffffa, 0x0ffffffb, 0x00000014, 0x000003f8, 0x000003f9, 0x00000ffa,
+    0x00001ff9, 0x00000015, 0x000000f8, 0x000007fa, 0x000003fa, 0x000003fb,
+    0x000000f9, 0x000007fb, 0x000000fa, 0x00000016, 0x00000017, 0x00000018,
+    0x00000000, 0x00000001, 0x00000002, 0x00000019, 0x0000001a, 0x0000001b,
+    0x0000001c, 0x0000001d, 0x0000001e, 0x0000001f, 0x0000005c, 0x000000fb,
+    0x00007ffc, 0x00000020, 0x00000ffb, 0x000003fc, 0x00001ffa, 0x00000021,
+    0x0000005d, 0x0000005e, 0x0000005f, 0x00000060, 0x00000061, 0x00000062,
+    0x00000063, 0x00000064, 0x00000065, 0x00000066, 0x00000067, 0x00000068,
+    0x00000069, 0x0000006a, 0x0000006b, 0x0000006c, 0x0000006d, 0x0000006e,
+    0x0000006f, 0x00000070, 0x00000071, 0x00000072, 0x000000fc, 0x00000073,
+    0x000000fd, 0x00001ffb, 0x0007fff0, 0x00001ffc, 0x00003ffc, 0x00000022,
+    0x00007ffd, 0x00000003, 0x00000023, 0x00000004, 0x00000024, 0x00000005,
+    0x00000025, 0x00000026, 0x00000027, 0x00000006, 0x00000074, 0x00000075,
+    0x00000028, 0x00000029, 0x0000002a, 0x00000007, 0x0000002b, 0x00000076,
+    0x0000002c, 0x00000008, 0x00000009, 0x0000002d, 0x00000077, 0x00000078,
+    0x00000079, 0x0000007a, 0x0000007b, 0x00007ffe, 0x000007fc, 0x00003ffd,
+    0x00001ffd, 0x0ffffffc, 0x000fffe6, 0x003fffd2, 0x000fffe7, 0x000fffe8,
+    0x003fffd3, 0x003fffd4, 0x003fffd5, 0x007fffd9, 0x003fffd6, 0x007fffda,
+    0x007fffdb, 0x007fffdc, 0x007fffdd, 0x007fffde, 0x00ffffeb, 0x007fffdf,
+    0x00ffffec, 0x00ffffed, 0x003fffd7, 0x007fffe0, 0x00ffffee, 0x007fffe1,
+    0x007fffe2, 0x007fffe3, 0x007fffe4, 0x001fffdc, 0x003fffd8, 0x007fffe5,
+    0x003fffd9, 0x007fffe6, 0x007fffe7, 0x00ffffef, 0x003fffda, 0x001fffdd,
+    0x000fffe9, 0x003fffdb, 0x003fffdc, 0x007fffe8, 0x007fffe9, 0x001fffde,
+    0x007fffea, 0x003fffdd, 0x003fffde, 0x00fffff0, 0x001fffdf, 0x003fffdf,
+    0x007fffeb, 0x007fffec, 0x001fffe0, 0x001fffe1, 0x003fffe0, 0x001fffe2,
+    0x007fffed, 0x003fffe1, 0x007fffee, 0x007fffef, 0x000fffea, 0x003fffe2,
+    0x003fffe3, 0x003fffe4, 0x007ffff0, 0x003fffe5, 0x003fffe6, 0x007ffff1,
+    0x03ffffe0, 0x03ffffe1, 0x000fffeb, 0x0007fff1, 0x003fffe7, 0x007ffff2,
+    0x003fffe8, 0x01ffffec, 0x03ffffe2, 0x03ffffe3, 0x03ffffe4, 0x07ffffde,
+    0x07ffffdf, 0x03ffffe5, 0x00fffff1, 0x01ffffed, 0x0007fff2, 0x001fffe3,
+    0x03ffffe6, 0x07ffffe0, 0x07ffffe1, 0x03ffffe7, 0x07ffffe2, 0x00fffff2,
+    0x001fffe4, 0x001fffe5, 0x03ffffe8, 0x03ffffe9, 0x0ffffffd, 0x07ffffe3,
+    0x07ffffe4, 0x07ffffe5, 0x000fffec, 0x00fffff3, 0x000fffed, 0x001fffe6,
+    0x003fffe9, 0x001fffe7, 0x001fffe8, 0x007ffff3, 0x003fffea, 0x003fffeb,
+    0x01ffffee, 0x01ffffef, 0x00fffff4, 0x00fffff5, 0x03ffffea, 0x007ffff4,
+    0x03ffffeb, 0x07ffffe6, 0x03ffffec, 0x03ffffed, 0x07ffffe7, 0x07ffffe8,
+    0x07ffffe9, 0x07ffffea, 0x07ffffeb, 0x0ffffffe, 0x07ffffec, 0x07ffffed,
+    0x07ffffee, 0x07ffffef, 0x07fffff0, 0x03ffffee,
+};
+
+
+static const uint8_t  nxt_hpack_huff_lengths[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+
+#define NXT_HPACK_HUFF_EOS        256
+#define NXT_HPACK_HUFF_EOS_CODE   0x3fffffff
+#define NXT_HPACK_HUFF_EOS_LENGTH 30
+
+/*
+ * The decoding tree.  A positive value is an index of the next node,
+ * a negative value is a decoded symbol, and zero is an invalid code.
+ */
+static int16_t  nxt_hpack_huff_tree[256][2];
+
+
+nxt_int_t
+nxt_hpack_init(void)
+{
+    uint32_t    code;
+    nxt_int_t   next, bit;
+    nxt_uint_t  sym, length, node, nodes;
+
+    if (nxt_hpack_huff_tree[0][0] != 0) {
+        return NXT_OK;
+    }
+
+    nodes = 1;
+
+    for (sym = 0; sym <= NXT_HPACK_HUFF_EOS; sym++) {
+
+        if (sym == NXT_HPACK_HUFF_EOS) {
+            code = NXT_HPACK_HUFF_EOS_CODE;
+            length = NXT_HPACK_HUFF_EOS_LENGTH;
+
+        } else {
+            code = nxt_hpack_huff_codes[sym];
+            length = nxt_hpack_huff_lengths[sym];
+        }
+
+        node = 0;
+
+        while (length > 1) {
+            length--;
+            bit = (code >> length) & 1;
+            next = nxt_hpack_huff_tree[node][bit];
+
+            if (next == 0) {
+                if (nxt_slow_path(nodes == nxt_nitems(nxt_hpack_huff_tree))) {
+                    return NXT_ERROR;
+                }
+
+                next = nodes++;
+                nxt_hpack_huff_tree[node][bit] = next;
+
+            } else if (nxt_slow_path(next < 0)) {
+                return NXT_ERROR;
+            }
+
+            node = next;
+        }
+
+        nxt_hpack_huff_tree[node][code & 1] = -1 - (nxt_int_t) sym;
+    }
+
+    return NXT_OK;
+}
+
+
+void
+nxt_hpack_table_init(nxt_hpack_t *hp, nxt_mp_t *mp)
+{
+    nxt_memzero(hp, sizeof(nxt_hpack_t));
+
+    hp->mem_pool = mp;
+    hp->max_size = NXT_HPACK_TABLE_SIZE;
+    hp->limit = NXT_HPACK_TABLE_SIZE;
+}
+
+
+void
+nxt_hpack_table_free(nxt_hpack_t *hp)
+{
+    nxt_hpack_table_evict(hp, hp->size);
+}
+
+
+nxt_int_t
+nxt_hpack_decode(nxt_hpack_t *hp, nxt_mp_t *mp, u_char **pos,
+    const u_char *end, nxt_hpack_field_t *field)
+{
+    u_char      ch;
+    uint32_t    index;
+    nxt_int_t   ret;
+    nxt_bool_t  add;
+
+    for ( ;; ) {
+        if (*pos == end) {
+            return NXT_DONE;
+        }
+
+        ch = **pos;
+
+        if (ch & 0x80) {
+            /* Indexed header field representation. */
+
+            ret = nxt_hpack_decode_int(pos, end, 7, &index);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            return nxt_hpack_table_get(hp, index, field);
+        }
+
+        if ((ch & 0xe0) != 0x20) {
+            break;
+        }
+
+        /* Dynamic table size update. */
+
+        ret = nxt_hpack_decode_int(pos, end, 5, &index);
+        if (nxt_slow_path(ret != NXT_OK || index > hp->limit)) {
+            return NXT_ERROR;
+        }
+
+        hp->max_size = index;
+
+        if (hp->size > hp->max_size) {
+            nxt_hpack_table_evict(hp, hp->size - hp->max_size);
+        }
+    }
+
+    add = ((ch & 0xc0) == 0x40);
+
+    ret = nxt_hpack_decode_int(pos, end, add ? 6 : 4, &index);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (index != 0) {
+        ret = nxt_hpack_table_get(hp, index, field);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+    } else {
+        ret = nxt_hpack_decode_string(mp, pos, end, &field->name);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
+    ret = nxt_hpack_decode_string(mp, pos, end, &field->value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (add) {
+        return nxt_hpack_table_add(hp, field);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_hpack_decode_int(u_char **pos, const u_char *end, nxt_uint_t prefix,
+    uint32_t *value)
+{
+    u_char      *p, ch;
+    uint32_t    mask, n;
+    nxt_uint_t  shift;
+
+    p = *pos;
+    mask = (1 << prefix) - 1;
+
+    n = *p++ & mask;
+
+    if (n == mask) {
+        shift = 0;
+
+        do {
+            /* The integers longer than 28 bits are not used by HTTP/2. */
+            if (nxt_slow_path(p == end || shift > 21)) {
+                return NXT_ERROR;
+            }
+
+            ch = *p++;
+
+            n += (uint32_t) (ch & 0x7f) << shift;
+            shift += 7;
+
+        } while (ch & 0x80);
+    }
+
+    *pos = p;
+    *value = n;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_hpack_decode_string(nxt_mp_t *mp, u_char **pos, const u_char *end,
+    nxt_str_t *str)
+{
+    u_char      *p;
+    ssize_t     n;
+    uint32_t    length;
+    nxt_int_t   ret;
+    nxt_bool_t  huff;
+
+    p = *pos;
+
+    if (nxt_slow_path(p == end)) {
+        return NXT_ERROR;
+    }
+
+    huff = ((*p & 0x80) != 0);
+
+    ret = nxt_hpack_decode_int(&p, end, 7, &length);
+    if (nxt_slow_path(ret != NXT_OK || length > (size_t) (end - p))) {
+        return NXT_ERROR;
+    }
+
+    if (huff) {
+        /* The shortest Huffman code is 5 bits long. */
+        str->start = nxt_mp_nget(mp, length * 8 / 5 + 1);
+        if (nxt_slow_path(str->start == NULL)) {
+            return NXT_ERROR;
+        }
+
+        n = nxt_hpack_huff_decode(str->start, p, length);
+        if (nxt_slow_path(n < 0)) {
+            return NXT_ERROR;
+        }
+
+        str->length = n;
+
+    } else {
+        str->start = nxt_mp_nget(mp, length + 1);
+        if (nxt_slow_path(str->start == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_memcpy(str->start, p, length);
+        str->length = length;
+    }
+
+    *pos = p + length;
+
+    return NXT_OK;
+}
+
+
+ssize_t
+nxt_hpack_huff_decode(u_char *dst, const u_char *src, size_t size)
+{
+    u_char        *d;
+    nxt_int_t     next;
+    nxt_uint_t    bit, node, pad, ones;
+    const u_char  *end;
+
+    d = dst;
+    end = src + size;
+
+    node = 0;
+    pad = 0;
+    ones = 1;
+
+    while (src < end) {
+
+        for (bit = 8; bit != 0; /* void */) {
+            bit--;
+
+            next = nxt_hpack_huff_tree[node][(*src >> bit) & 1];
+
+            if (next > 0) {
+                node = next;
+                pad++;
+                ones &= (*src >> bit) & 1;
+                continue;
+            }
+
+            if (nxt_slow_path(next == 0 || next == -1 - NXT_HPACK_HUFF_EOS)) {
+                return NXT_ERROR;
+            }
+
+            *d++ = (u_char) (-1 - next);
+
+            node = 0;
+            pad = 0;
+            ones = 1;
+        }
+
+        src++;
+    }
+
+    /* The padding is the most significant bits of the EOS code. */
+
+    if (nxt_slow_path(pad > 7 || !ones)) {
+        return NXT_ERROR;
+    }
+
+    return d - dst;
+}
+
+
+static nxt_int_t
+nxt_hpack_table_get(nxt_hpack_t *hp, uint32_t index, nxt_hpack_field_t *field)
+{
+    nxt_hpack_entry_t  *e;
+
+    if (nxt_slow_path(index == 0)) {
+        return NXT_ERROR;
+    }
+
+    if (index <= NXT_HPACK_STATIC_ENTRIES) {
+        *field = nxt_hpack_static_table[index - 1];
+        return NXT_OK;
+    }
+
+    index -= NXT_HPACK_STATIC_ENTRIES + 1;
+
+    if (nxt_slow_path(index >= hp->count)) {
+        return NXT_ERROR;
+    }
+
+    e = hp->entries[(hp->last - index) % NXT_HPACK_TABLE_ENTRIES];
+
+    field->name.length = e->name_length;
+    field->name.start = e->data;
+    field->value.length = e->value_length;
+    field->value.start = e->data + e->name_length;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_hpack_table_add(nxt_hpack_t *hp, nxt_hpack_field_t *field)
+{
+    size_t             size;
+    nxt_hpack_entry_t  *e;
+
+    size = field->name.length + field->value.length + 32;
+
+    if (size > hp->max_size) {
+        /* An entry larger than the table empties the table. */
+        nxt_hpack_table_evict(hp, hp->size);
+        return NXT_OK;
+    }
+
+    /*
+     * The entry is copied before eviction, since the name
+     * can reference an entry which is about to be evicted.
+     */
+
+    e = nxt_mp_alloc(hp->mem_pool, sizeof(nxt_hpack_entry_t)
+                                   + field->name.length + field->value.length);
+    if (nxt_slow_path(e == NULL)) {
+        return NXT_ERROR;
+    }
+
+    e->name_length = field->name.length;
+    e->value_length = field->value.length;
+
+    nxt_memcpy(e->data, field->name.start, field->name.length);
+    nxt_memcpy(e->data + e->name_length, field->value.start,
+               field->value.length);
+
+    if (hp->size + size > hp->max_size) {
+        nxt_hpack_table_evict(hp, hp->size + size - hp->max_size);
+    }
+
+    hp->last = (hp->last + 1) % NXT_HPACK_TABLE_ENTRIES;
+    hp->entries[hp->last] = e;
+    hp->count++;
+    hp->size += size;
+
+    field->name.start = e->data;
+    field->value.start = e->data + e->name_length;
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_hpack_table_evict(nxt_hpack_t *hp, size_t size)
+{
+    size_t             freed;
+    uint32_t           first;
+    nxt_hpack_entry_t  *e;
+
+    freed = 0;
+
+    while (freed < size && hp->count != 0) {
+        first = (hp->last + NXT_HPACK_TABLE_ENTRIES - hp->count + 1)
+                % NXT_HPACK_TABLE_ENTRIES;
+
+        e = hp->entries[first];
+        hp->entries[first] = NULL;
+
+        freed += nxt_hpack_entry_size(e);
+        hp->count--;
+
+        nxt_mp_free(hp->mem_pool, e);
+    }
+
+    hp->size -= freed;
+}
+
+
+u_char *
+nxt_hpack_encode_int(u_char *p, uint32_t value, nxt_uint_t prefix,
+    u_char first)
+{
+    uint32_t  mask;
+
+    mask = (1 << prefix) - 1;
+
+    if (value < mask) {
+        *p++ = first | value;
+        return p;
+    }
+
+    *p++ = first | mask;
+    value -= mask;
+
+    while (value >= 0x80) {
+        *p++ = (u_char) (value | 0x80);
+        value >>= 7;
+    }
+
+    *p++ = (u_char) value;
+
+    return p;
+}
+
+
+u_char *
+nxt_hpack_encode_status(u_char *p, nxt_uint_t status)
+{
+    nxt_uint_t  i;
+
+    static const uint16_t  indexed[] = { 200, 204, 206, 304, 400, 404, 500 };
+
+    for (i = 0; i < nxt_nitems(indexed); i++) {
+        if (status == indexed[i]) {
+            /* The ":status" entries start at the static table index 8. */
+            *p++ = 0x80 | (8 + i);
+            return p;
+        }
+    }
+
+    /* A literal without indexing with the ":status" name index. */
+
+    *p++ = 0x08;
+    *p++ = 3;
+
+    return nxt_sprintf(p, p + 3, "%03d", (int) status);
+}
+
+
+u_char *
+nxt_hpack_encode_field(u_char *p, const u_char *name, size_t name_len,
+    const u_char *value, size_t value_len)
+{
+    nxt_uint_t  i;
+
+    for (i = 15; i <= NXT_HPACK_STATIC_ENTRIES; i++) {
+        if (nxt_hpack_static_table[i - 1].name.length == name_len
+            && nxt_strncasecmp(nxt_hpack_static_table[i - 1].name.start,
+                               name, name_len) == 0)
+        {
+            p = nxt_hpack_encode_int(p, i, 4, 0x00);
+            goto value;
+        }
+    }
+
+    *p++ = 0x00;
+    p = nxt_hpack_encode_int(p, name_len, 7, 0x00);
+
+    for (i = 0; i < name_len; i++) {
+        *p++ = nxt_lowcase(name[i]);
+    }
+
+value:
+
+    p = nxt_hpack_encode_int(p, value_len, 7, 0x00);
+
+    return nxt_cpymem(p, value, value_len);
+}
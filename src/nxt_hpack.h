@@ -0,0 +1,64 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_HPACK_H_INCLUDED_
+#define _NXT_HPACK_H_INCLUDED_
+
+
+/* The default SETTINGS_HEADER_TABLE_SIZE, RFC 7541, Section 4.2. */
+#define NXT_HPACK_TABLE_SIZE     4096
+
+/* Each entry takes at least 32 bytes of the table size. */
+#define NXT_HPACK_TABLE_ENTRIES  (NXT_HPACK_TABLE_SIZE / 32)
+
+#define NXT_HPACK_STATIC_ENTRIES 61
+
+
+typedef struct nxt_hpack_entry_s  nxt_hpack_entry_t;
+
+
+typedef struct {
+    nxt_str_t                 name;
+    nxt_str_t                 value;
+} nxt_hpack_field_t;
+
+
+typedef struct {
+    nxt_mp_t                  *mem_pool;
+
+    /* A ring of dynamic table entries, "last" is the newest entry. */
+    nxt_hpack_entry_t         *entries[NXT_HPACK_TABLE_ENTRIES];
+    uint32_t                  last;
+    uint32_t                  count;
+
+    size_t                    size;
+    size_t                    max_size;
+    size_t                    limit;
+} nxt_hpack_t;
+
+
+nxt_int_t nxt_hpack_init(void);
+void nxt_hpack_table_init(nxt_hpack_t *hp, nxt_mp_t *mp);
+void nxt_hpack_table_free(nxt_hpack_t *hp);
+
+nxt_int_t nxt_hpack_decode(nxt_hpack_t *hp, nxt_mp_t *mp, u_char **pos,
+    const u_char *end, nxt_hpack_field_t *field);
+ssize_t nxt_hpack_huff_decode(u_char *dst, const u_char *src, size_t size);
+
+u_char *nxt_hpack_encode_int(u_char *p, uint32_t value, nxt_uint_t prefix,
+    u_char first);
+u_char *nxt_hpack_encode_status(u_char *p, nxt_uint_t status);
+u_char *nxt_hpack_encode_field(u_char *p, const u_char *name, size_t name_len,
+    const u_char *value, size_t value_len);
+
+
+/* The maximum size of a literal field representation without indexing. */
+#define nxt_hpack_field_size(name_len, value_len)                             \
+    (1 + 5 + (name_len) + 5 + (value_len))
+
+#define NXT_HPACK_STATUS_SIZE    5
+
+
+#endif /* _NXT_HPACK_H_INCLUDED_ */
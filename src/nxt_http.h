@@ -19,6 +19,7 @@ typedef enum {
 
     NXT_HTTP_OK = 200,
     NXT_HTTP_NO_CONTENT = 204,
+    NXT_HTTP_PARTIAL_CONTENT = 206,
 
     NXT_HTTP_MULTIPLE_CHOICES = 300,
     NXT_HTTP_MOVED_PERMANENTLY = 301,
@@ -36,6 +37,7 @@ typedef enum {
     NXT_HTTP_LENGTH_REQUIRED = 411,
     NXT_HTTP_PAYLOAD_TOO_LARGE = 413,
     NXT_HTTP_URI_TOO_LONG = 414,
+    NXT_HTTP_RANGE_NOT_SATISFIABLE = 416,
     NXT_HTTP_UPGRADE_REQUIRED = 426,
     NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
 
@@ -74,6 +76,7 @@ typedef struct {
 
 
 typedef struct nxt_h1proto_s        nxt_h1proto_t;
+typedef struct nxt_h2p_stream_s     nxt_h2p_stream_t;
 
 struct nxt_h1p_websocket_timer_s {
     nxt_timer_t                     timer;
@@ -85,6 +88,7 @@ struct nxt_h1p_websocket_timer_s {
 typedef union {
     void                            *any;
     nxt_h1proto_t                   *h1;
+    nxt_h2p_stream_t                *h2;
 } nxt_http_proto_t;
 
 
@@ -115,6 +119,12 @@ typedef struct {
 
 typedef struct nxt_upstream_server_s  nxt_upstream_server_t;
 
+typedef struct nxt_http_compress_conf_s  nxt_http_compress_conf_t;
+typedef struct nxt_http_compress_s       nxt_http_compress_t;
+
+typedef struct nxt_http_cache_s          nxt_http_cache_t;
+typedef struct nxt_http_cache_ctx_s      nxt_http_cache_ctx_t;
+
 typedef struct {
     nxt_http_proto_t                proto;
     nxt_http_request_t              *request;
@@ -126,6 +136,8 @@ typedef struct {
     nxt_http_protocol_t             protocol:8;       /* 2 bits */
     uint8_t                         header_received;  /* 1 bit  */
     uint8_t                         closed;           /* 1 bit  */
+    uint8_t                         reused;           /* 1 bit  */
+    uint8_t                         retried;          /* 1 bit  */
 } nxt_http_peer_t;
 
 
@@ -161,6 +173,10 @@ struct nxt_http_request_s {
     nxt_http_field_t                *referer;
     nxt_http_field_t                *user_agent;
     nxt_http_field_t                *authorization;
+    nxt_http_field_t                *range;
+    nxt_http_field_t                *if_range;
+    nxt_http_field_t                *if_none_match;
+    nxt_http_field_t                *if_modified_since;
     nxt_off_t                       content_length_n;
 
     nxt_sockaddr_t                  *remote;
@@ -174,13 +190,12 @@ struct nxt_http_request_s {
     nxt_tstr_cache_t                tstr_cache;
 
     nxt_http_action_t               *action;
+    nxt_status_latency_t            *latency;
     void                            *req_rpc_data;
 
-#if (NXT_HAVE_REGEX)
-    nxt_regex_match_t               *regex_match;
-#endif
-
     nxt_http_peer_t                 *peer;
+    nxt_http_compress_t             *compress;
+    nxt_http_cache_ctx_t            *cache;
     nxt_buf_t                       *last;
 
     nxt_queue_link_t                app_link;   /* nxt_app_t.ack_waiting_req */
@@ -197,6 +212,8 @@ struct nxt_http_request_s {
     uint8_t                         app_target;
     nxt_http_protocol_t             protocol:8;   /* 2 bits */
     uint8_t                         tls;          /* 1 bit  */
+    uint8_t                         tls_early_data;  /* 1 bit */
+    uint8_t                         sendfile;     /* 1 bit  */
     uint8_t                         logged;       /* 1 bit  */
     uint8_t                         header_sent;  /* 1 bit  */
     uint8_t                         inconsistent; /* 1 bit  */
@@ -229,6 +246,9 @@ typedef struct nxt_http_route_addr_rule_s  nxt_http_route_addr_rule_t;
 typedef struct {
     nxt_conf_value_t                *rewrite;
     nxt_conf_value_t                *set_headers;
+    nxt_conf_value_t                *compress;
+    nxt_conf_value_t                *cache;
+    nxt_conf_value_t                *access_log;
     nxt_conf_value_t                *pass;
     nxt_conf_value_t                *ret;
     nxt_conf_value_t                *location;
@@ -239,6 +259,8 @@ typedef struct {
     nxt_conf_value_t                *follow_symlinks;
     nxt_conf_value_t                *traverse_mounts;
     nxt_conf_value_t                *types;
+    nxt_conf_value_t                *precompressed;
+    nxt_conf_value_t                *open_file_cache;
     nxt_conf_value_t                *fallback;
 } nxt_http_action_conf_t;
 
@@ -258,6 +280,10 @@ struct nxt_http_action_s {
 
     nxt_tstr_t                      *rewrite;
     nxt_array_t                     *set_headers;  /* of nxt_http_field_t */
+    nxt_http_compress_conf_t        *compress;
+    nxt_http_cache_t                *cache;
+    nxt_router_access_log_filter_t  *log_filter;
+    nxt_status_latency_t            *latency;
     nxt_http_action_t               *fallback;
 };
 
@@ -298,7 +324,8 @@ struct nxt_http_forward_s {
 };
 
 
-#define NXT_HTTP_DATE_LEN  nxt_length("Wed, 31 Dec 1986 16:40:00 GMT")
+#define NXT_HTTP_DATE_LEN        nxt_length("Wed, 31 Dec 1986 16:40:00 GMT")
+#define NXT_HTTP_TIME_LOCAL_LEN  nxt_length("31/Dec/1986:19:40:00 +0300")
 
 nxt_inline u_char *
 nxt_http_date(u_char *buf, struct tm *tm)
@@ -319,6 +346,7 @@ nxt_http_date(u_char *buf, struct tm *tm)
 
 nxt_int_t nxt_http_init(nxt_task_t *task);
 nxt_int_t nxt_h1p_init(nxt_task_t *task);
+nxt_int_t nxt_h2p_init(nxt_task_t *task);
 nxt_int_t nxt_http_response_hash_init(nxt_task_t *task);
 
 void nxt_http_conn_init(nxt_task_t *task, void *obj, void *data);
@@ -347,6 +375,7 @@ nxt_int_t nxt_http_request_content_length(void *ctx, nxt_http_field_t *field,
 
 nxt_array_t *nxt_http_arguments_parse(nxt_http_request_t *r);
 nxt_array_t *nxt_http_cookies_parse(nxt_http_request_t *r);
+u_char *nxt_http_time_local(nxt_task_t *task, u_char *buf);
 
 int64_t nxt_http_field_hash(nxt_mp_t *mp, nxt_str_t *name,
     nxt_bool_t case_sensitive, uint8_t encoding);
@@ -391,6 +420,24 @@ nxt_int_t nxt_http_set_headers_init(nxt_router_conf_t *rtcf,
     nxt_http_action_t *action, nxt_http_action_conf_t *acf);
 nxt_int_t nxt_http_set_headers(nxt_http_request_t *r);
 
+nxt_int_t nxt_http_compress_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf);
+nxt_int_t nxt_http_compress_header(nxt_task_t *task, nxt_http_request_t *r);
+nxt_buf_t *nxt_http_compress_filter(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *in);
+void nxt_http_compress_release(nxt_task_t *task, nxt_http_request_t *r);
+nxt_bool_t nxt_http_compress_accepted(nxt_http_request_t *r,
+    const nxt_str_t *token);
+
+nxt_int_t nxt_http_cache_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf);
+nxt_int_t nxt_http_cache_lookup(nxt_task_t *task, nxt_http_request_t *r);
+nxt_int_t nxt_http_cache_header(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_http_cache_body(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out);
+void nxt_http_cache_release(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_http_compress_cache_free(nxt_event_engine_t *engine);
+
 nxt_int_t nxt_http_return_init(nxt_router_conf_t *rtcf,
     nxt_http_action_t *action, nxt_http_action_conf_t *acf);
 
@@ -399,6 +446,7 @@ nxt_int_t nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 nxt_int_t nxt_http_static_mtypes_init(nxt_mp_t *mp, nxt_lvlhsh_t *hash);
 nxt_int_t nxt_http_static_mtypes_hash_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
     const nxt_str_t *exten, nxt_str_t *type);
+nxt_int_t nxt_http_static_encoding_index(nxt_str_t *token);
 nxt_str_t *nxt_http_static_mtype_get(nxt_lvlhsh_t *hash,
     const nxt_str_t *exten);
 
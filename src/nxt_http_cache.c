@@ -0,0 +1,1027 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+
+/*
+ * The response cache of an action is shared by all router engine threads
+ * and is protected by a mutex.  A response is cached if it has the 200
+ * status, has no "Set-Cookie" header, and its "Cache-Control" header does
+ * not forbid caching by a shared cache.  The freshness lifetime is taken
+ * from "s-maxage" or "max-age", otherwise the "valid" option is used.
+ *
+ * Once a response becomes stale but is still within its
+ * "stale-while-revalidate" period, the first request is passed to the
+ * action to update the cached response, while other requests are served
+ * with the stale response meanwhile.
+ *
+ * The least recently used responses are evicted to keep the total size
+ * of cached responses within "max_size".
+ *
+ * A cached response is referenced by the cache and by each request it
+ * is being sent to, so the mutex is held only for the lookup and the
+ * response is sent without copying.  The last reference frees it even if
+ * the cache has already been destroyed with its configuration.
+ *
+ * Only responses to GET requests are stored.  The default key does not
+ * include the method, so HEAD requests are answered from a response to
+ * GET; with "$method" in the key HEAD requests are never cached.
+ */
+
+struct nxt_http_cache_s {
+    nxt_tstr_t                 *key;
+    nxt_thread_mutex_t         mutex;
+    nxt_lvlhsh_t               hash;
+    nxt_queue_t                lru;
+    size_t                     size;
+
+    size_t                     max_size;
+    uint32_t                   valid;
+    uint32_t                   stale_while_revalidate;
+};
+
+
+typedef struct {
+    nxt_queue_link_t           link;
+    nxt_str_t                  key;
+    nxt_http_field_t           *fields;
+    nxt_uint_t                 nfields;
+    u_char                     *body;
+    size_t                     body_length;
+    size_t                     size;
+
+    nxt_time_t                 date;
+    nxt_time_t                 expires;
+    nxt_time_t                 stale;
+
+    nxt_atomic_t               use_count;
+
+    nxt_http_status_t          status:16;
+    uint8_t                    updating;  /* 1 bit */
+} nxt_http_cache_entry_t;
+
+
+struct nxt_http_cache_ctx_s {
+    nxt_http_cache_t           *cache;
+    nxt_str_t                  key;
+
+    /* A response being stored. */
+    nxt_http_cache_entry_t     *entry;
+    size_t                     body_size;
+
+    /* A cached response being sent. */
+    nxt_http_cache_entry_t     *sent;
+
+    uint8_t                    updating;  /* 1 bit */
+    uint8_t                    done;      /* 1 bit */
+};
+
+
+typedef struct {
+    nxt_str_t                  key;
+    size_t                     max_size;
+    uint32_t                   valid;
+    uint32_t                   stale_while_revalidate;
+} nxt_http_cache_conf_t;
+
+
+#define NXT_HTTP_CACHE_MAX_SIZE  (10 * 1024 * 1024)
+
+
+static nxt_http_cache_ctx_t *nxt_http_cache_ctx(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_cache_t *cache);
+static nxt_int_t nxt_http_cache_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *hc, nxt_http_cache_entry_t *entry, nxt_time_t now);
+static void nxt_http_cache_sent(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_cache_body_handler(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_int_t nxt_http_cache_control(nxt_http_request_t *r,
+    nxt_http_cache_t *cache, nxt_time_t *max_age, nxt_time_t *swr);
+static nxt_int_t nxt_http_cache_directive(nxt_str_t *name, nxt_str_t *value,
+    nxt_time_t *max_age, nxt_time_t *s_maxage, nxt_time_t *swr);
+static nxt_bool_t nxt_http_cache_field_stored(nxt_http_field_t *f);
+static void nxt_http_cache_store(nxt_task_t *task, nxt_http_cache_ctx_t *hc);
+static void nxt_http_cache_abort(nxt_task_t *task, nxt_http_cache_ctx_t *hc);
+static nxt_int_t nxt_http_cache_test(nxt_lvlhsh_query_t *lhq, void *data);
+static nxt_http_cache_entry_t *nxt_http_cache_find(nxt_http_cache_t *cache,
+    nxt_str_t *key);
+static void nxt_http_cache_remove(nxt_http_cache_t *cache,
+    nxt_http_cache_entry_t *entry);
+static void nxt_http_cache_entry_use(nxt_http_cache_entry_t *entry, int i);
+static void nxt_http_cache_free(nxt_http_cache_entry_t *entry);
+static void nxt_http_cache_destroy(nxt_task_t *task, void *obj, void *data);
+
+
+static const nxt_http_request_state_t  nxt_http_cache_send_state;
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_cache_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_cache_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+static nxt_conf_map_t  nxt_http_cache_conf[] = {
+    {
+        nxt_string("key"),
+        NXT_CONF_MAP_STR,
+        offsetof(nxt_http_cache_conf_t, key),
+    },
+
+    {
+        nxt_string("max_size"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_http_cache_conf_t, max_size),
+    },
+
+    {
+        nxt_string("valid"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_http_cache_conf_t, valid),
+    },
+
+    {
+        nxt_string("stale_while_revalidate"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_http_cache_conf_t, stale_while_revalidate),
+    },
+};
+
+
+nxt_int_t
+nxt_http_cache_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf)
+{
+    nxt_mp_t               *mp;
+    nxt_int_t              ret;
+    nxt_http_cache_t       *cache;
+    nxt_http_cache_conf_t  conf;
+
+    mp = rtcf->mem_pool;
+
+    nxt_str_set(&conf.key, "$host$request_uri");
+    conf.max_size = NXT_HTTP_CACHE_MAX_SIZE;
+    conf.valid = 0;
+    conf.stale_while_revalidate = 0;
+
+    ret = nxt_conf_map_object(mp, acf->cache, nxt_http_cache_conf,
+                              nxt_nitems(nxt_http_cache_conf), &conf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    cache = nxt_mp_zget(mp, sizeof(nxt_http_cache_t));
+    if (nxt_slow_path(cache == NULL)) {
+        return NXT_ERROR;
+    }
+
+    cache->key = nxt_tstr_compile(rtcf->tstr_state, &conf.key, 0);
+    if (nxt_slow_path(cache->key == NULL)) {
+        return NXT_ERROR;
+    }
+
+    cache->max_size = conf.max_size;
+    cache->valid = conf.valid;
+    cache->stale_while_revalidate = conf.stale_while_revalidate;
+
+    if (nxt_slow_path(nxt_thread_mutex_create(&cache->mutex) != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    nxt_lvlhsh_init(&cache->hash);
+    nxt_queue_init(&cache->lru);
+
+    ret = nxt_mp_cleanup(mp, nxt_http_cache_destroy, task, cache, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_thread_mutex_destroy(&cache->mutex);
+        return NXT_ERROR;
+    }
+
+    action->cache = cache;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Returns NXT_DONE if the request has been answered with a cached
+ * response, NXT_OK if the request should be processed by the action.
+ */
+
+nxt_int_t
+nxt_http_cache_lookup(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_int_t               ret;
+    nxt_time_t              now;
+    nxt_http_cache_t        *cache;
+    nxt_http_action_t       *action;
+    nxt_http_cache_ctx_t    *hc;
+    nxt_http_cache_entry_t  *entry, *hit;
+
+    action = r->action;
+
+    if (action == NULL || action->cache == NULL || r->cache != NULL) {
+        return NXT_OK;
+    }
+
+    if (!nxt_str_eq(r->method, "GET", 3) && !nxt_str_eq(r->method, "HEAD", 4))
+    {
+        return NXT_OK;
+    }
+
+    if (r->authorization != NULL) {
+        return NXT_OK;
+    }
+
+    cache = action->cache;
+
+    hc = nxt_http_cache_ctx(task, r, cache);
+    if (nxt_slow_path(hc == NULL)) {
+        return NXT_ERROR;
+    }
+
+    r->cache = hc;
+
+    now = nxt_thread_time(task->thread);
+
+    hit = NULL;
+
+    nxt_thread_mutex_lock(&cache->mutex);
+
+    entry = nxt_http_cache_find(cache, &hc->key);
+
+    if (entry != NULL) {
+
+        if (now < entry->expires || (now < entry->stale && entry->updating)) {
+            nxt_http_cache_entry_use(entry, 1);
+
+            nxt_queue_remove(&entry->link);
+            nxt_queue_insert_head(&cache->lru, &entry->link);
+
+            hit = entry;
+
+        } else if (now < entry->stale) {
+            entry->updating = 1;
+            hc->updating = 1;
+
+        } else {
+            nxt_http_cache_remove(cache, entry);
+        }
+    }
+
+    nxt_thread_mutex_unlock(&cache->mutex);
+
+    nxt_debug(task, "http cache %s \"%V\"",
+              (hit == NULL) ? "miss" : "hit", &hc->key);
+
+    if (hit == NULL) {
+        return NXT_OK;
+    }
+
+    ret = nxt_mp_cleanup(r->mem_pool, nxt_http_cache_sent, task, hit, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_http_cache_entry_use(hit, -1);
+        return NXT_ERROR;
+    }
+
+    hc->sent = hit;
+
+    ret = nxt_http_cache_send(task, r, hc, hit, now);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    r->state = &nxt_http_cache_send_state;
+
+    nxt_http_request_header_send(task, r,
+                                 (hit->body_length > 0
+                                  && !nxt_str_eq(r->method, "HEAD", 4))
+                                 ? nxt_http_cache_body_handler : NULL,
+                                 hc);
+
+    return NXT_DONE;
+}
+
+
+static nxt_http_cache_ctx_t *
+nxt_http_cache_ctx(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_t *cache)
+{
+    nxt_int_t             ret;
+    nxt_router_conf_t     *rtcf;
+    nxt_http_cache_ctx_t  *hc;
+
+    hc = nxt_mp_zget(r->mem_pool, sizeof(nxt_http_cache_ctx_t));
+    if (nxt_slow_path(hc == NULL)) {
+        return NULL;
+    }
+
+    hc->cache = cache;
+
+    if (nxt_tstr_is_const(cache->key)) {
+        nxt_tstr_str(cache->key, &hc->key);
+
+    } else {
+        rtcf = r->conf->socket_conf->router_conf;
+
+        ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                                  &r->tstr_cache, r, r->mem_pool);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+
+        nxt_tstr_query(task, r->tstr_query, cache->key, &hc->key);
+
+        if (nxt_slow_path(nxt_tstr_query_failed(r->tstr_query))) {
+            return NULL;
+        }
+    }
+
+    return hc;
+}
+
+
+/*
+ * The entry is referenced by the request, its fields and body are not
+ * changed while it is cached, so they are sent without copying.
+ */
+
+static nxt_int_t
+nxt_http_cache_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *hc, nxt_http_cache_entry_t *entry, nxt_time_t now)
+{
+    u_char            *p;
+    nxt_uint_t        i;
+    nxt_http_field_t  *f, *field;
+
+    for (i = 0; i < entry->nfields; i++) {
+        f = &entry->fields[i];
+
+        field = nxt_list_zero_add(r->resp.fields);
+        if (nxt_slow_path(field == NULL)) {
+            return NXT_ERROR;
+        }
+
+        field->name = f->name;
+        field->name_length = f->name_length;
+        field->value = f->value;
+        field->value_length = f->value_length;
+    }
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Age");
+
+    p = nxt_mp_nget(r->mem_pool, NXT_TIME_T_LEN);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    field->value = p;
+    field->value_length = nxt_sprintf(p, p + NXT_TIME_T_LEN, "%T",
+                                      nxt_max(now - entry->date, 0))
+                          - p;
+
+    hc->done = 1;
+
+    r->status = entry->status;
+    r->resp.content_length_n = entry->body_length;
+
+    return NXT_OK;
+}
+
+
+/*
+ * The cleanup handler of the request memory pool: the pool is destroyed
+ * after all its buffers have been sent, so the body is not used anymore.
+ */
+
+static void
+nxt_http_cache_sent(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_cache_entry_use(obj, -1);
+}
+
+
+static void
+nxt_http_cache_body_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t             *out;
+    nxt_http_request_t    *r;
+    nxt_http_cache_ctx_t  *hc;
+
+    r = obj;
+    hc = data;
+
+    out = nxt_http_buf_mem(task, r, 0);
+    if (nxt_slow_path(out == NULL)) {
+        return;
+    }
+
+    nxt_buf_mem_init(out, hc->sent->body, hc->sent->body_length);
+    out->mem.free = out->mem.end;
+
+    out->next = nxt_http_buf_last(r);
+
+    nxt_http_request_send(task, r, out);
+}
+
+
+static const nxt_http_request_state_t  nxt_http_cache_send_state
+    nxt_aligned(64) =
+{
+    .error_handler = nxt_http_request_error_handler,
+};
+
+
+/*
+ * Starts storing of a response if it is cacheable.  Called before the
+ * response header is sent and before the action response headers are
+ * set, so the cached response is processed again when it is sent.
+ */
+
+nxt_int_t
+nxt_http_cache_header(nxt_task_t *task, nxt_http_request_t *r)
+{
+    u_char                  *p;
+    size_t                  size;
+    nxt_int_t               ret;
+    nxt_time_t              now, max_age, swr;
+    nxt_uint_t              n;
+    nxt_http_field_t        *f, *field;
+    nxt_http_cache_t        *cache;
+    nxt_http_cache_ctx_t    *hc;
+    nxt_http_cache_entry_t  *entry;
+
+    hc = r->cache;
+
+    if (hc->done) {
+        /* The header is being sent again with an error response. */
+        nxt_http_cache_abort(task, hc);
+        return NXT_OK;
+    }
+
+    hc->done = 1;
+
+    cache = hc->cache;
+
+    if (r->status != NXT_HTTP_OK || !nxt_str_eq(r->method, "GET", 3)) {
+        goto uncacheable;
+    }
+
+    ret = nxt_http_cache_control(r, cache, &max_age, &swr);
+    if (ret != NXT_OK) {
+        goto uncacheable;
+    }
+
+    size = sizeof(nxt_http_cache_entry_t) + hc->key.length;
+    n = 0;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (nxt_http_cache_field_stored(f)) {
+            size += sizeof(nxt_http_field_t) + f->name_length
+                    + f->value_length;
+            n++;
+        }
+
+    } nxt_list_loop;
+
+    if (size + nxt_max(r->resp.content_length_n, 0) > cache->max_size) {
+        goto uncacheable;
+    }
+
+    entry = nxt_malloc(size);
+    if (nxt_slow_path(entry == NULL)) {
+        goto uncacheable;
+    }
+
+    nxt_memzero(entry, sizeof(nxt_http_cache_entry_t));
+
+    entry->fields = nxt_pointer_to(entry, sizeof(nxt_http_cache_entry_t));
+    entry->nfields = n;
+
+    p = (u_char *) &entry->fields[n];
+
+    entry->key.length = hc->key.length;
+    entry->key.start = p;
+    p = nxt_cpymem(p, hc->key.start, hc->key.length);
+
+    field = entry->fields;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (nxt_http_cache_field_stored(f)) {
+            *field = *f;
+
+            field->name = p;
+            p = nxt_cpymem(p, f->name, f->name_length);
+
+            field->value = p;
+            p = nxt_cpymem(p, f->value, f->value_length);
+
+            field++;
+        }
+
+    } nxt_list_loop;
+
+    entry->size = p - (u_char *) entry;
+    entry->status = r->status;
+
+    now = nxt_thread_time(task->thread);
+
+    entry->date = now;
+    entry->expires = now + max_age;
+    entry->stale = entry->expires + swr;
+
+    hc->entry = entry;
+
+    nxt_debug(task, "http cache store \"%V\" max-age:%T swr:%T",
+              &hc->key, max_age, swr);
+
+    return NXT_OK;
+
+uncacheable:
+
+    nxt_http_cache_abort(task, hc);
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_cache_control(nxt_http_request_t *r, nxt_http_cache_t *cache,
+    nxt_time_t *max_age, nxt_time_t *swr)
+{
+    u_char            *p, *end, *start;
+    nxt_int_t         ret;
+    nxt_str_t         name, value;
+    nxt_time_t        age, s_maxage;
+    nxt_http_field_t  *f;
+
+    age = -1;
+    s_maxage = -1;
+    *swr = -1;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (f->skip) {
+            continue;
+        }
+
+        if (f->name_length == nxt_length("Set-Cookie")
+            && nxt_memcasecmp(f->name, "Set-Cookie",
+                              nxt_length("Set-Cookie")) == 0)
+        {
+            return NXT_DECLINED;
+        }
+
+        /*
+         * The cache key does not include the request header values
+         * a response varies on, so such responses are not stored.
+         */
+
+        if (f->name_length == nxt_length("Vary")
+            && nxt_memcasecmp(f->name, "Vary", nxt_length("Vary")) == 0)
+        {
+            return NXT_DECLINED;
+        }
+
+        if (f->name_length != nxt_length("Cache-Control")
+            || nxt_memcasecmp(f->name, "Cache-Control",
+                              nxt_length("Cache-Control")) != 0)
+        {
+            continue;
+        }
+
+        p = f->value;
+        end = p + f->value_length;
+
+        while (p < end) {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+                p++;
+            }
+
+            start = p;
+
+            while (p < end && *p != '=' && *p != ',' && *p != ' ') {
+                p++;
+            }
+
+            name.start = start;
+            name.length = p - start;
+
+            nxt_str_null(&value);
+
+            if (p < end && *p == '=') {
+                p++;
+
+                if (p < end && *p == '"') {
+                    p++;
+                }
+
+                start = p;
+
+                while (p < end && *p != ',' && *p != '"' && *p != ' ') {
+                    p++;
+                }
+
+                value.start = start;
+                value.length = p - start;
+            }
+
+            while (p < end && *p != ',') {
+                p++;
+            }
+
+            if (name.length == 0) {
+                continue;
+            }
+
+            ret = nxt_http_cache_directive(&name, &value, &age, &s_maxage,
+                                           swr);
+            if (ret != NXT_OK) {
+                return ret;
+            }
+        }
+
+    } nxt_list_loop;
+
+    if (s_maxage >= 0) {
+        age = s_maxage;
+
+    } else if (age < 0) {
+        age = cache->valid;
+    }
+
+    if (age <= 0) {
+        return NXT_DECLINED;
+    }
+
+    if (*swr < 0) {
+        *swr = cache->stale_while_revalidate;
+    }
+
+    *max_age = age;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_cache_directive(nxt_str_t *name, nxt_str_t *value,
+    nxt_time_t *max_age, nxt_time_t *s_maxage, nxt_time_t *swr)
+{
+    nxt_int_t  n;
+
+    static const nxt_str_t  no_store = nxt_string("no-store");
+    static const nxt_str_t  no_cache = nxt_string("no-cache");
+    static const nxt_str_t  private = nxt_string("private");
+    static const nxt_str_t  max_age_name = nxt_string("max-age");
+    static const nxt_str_t  s_maxage_name = nxt_string("s-maxage");
+    static const nxt_str_t  swr_name = nxt_string("stale-while-revalidate");
+
+    if (nxt_strcasestr_eq(name, &no_store)
+        || nxt_strcasestr_eq(name, &no_cache)
+        || nxt_strcasestr_eq(name, &private))
+    {
+        return NXT_DECLINED;
+    }
+
+    if (value->length == 0) {
+        return NXT_OK;
+    }
+
+    n = nxt_int_parse(value->start, value->length);
+
+    if (n < 0) {
+        return NXT_DECLINED;
+    }
+
+    if (nxt_strcasestr_eq(name, &max_age_name)) {
+        *max_age = n;
+
+    } else if (nxt_strcasestr_eq(name, &s_maxage_name)) {
+        *s_maxage = n;
+
+    } else if (nxt_strcasestr_eq(name, &swr_name)) {
+        *swr = n;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_bool_t
+nxt_http_cache_field_stored(nxt_http_field_t *f)
+{
+    nxt_uint_t  i;
+
+    static const nxt_str_t  skipped[] = {
+        nxt_string("Content-Length"),
+        nxt_string("Transfer-Encoding"),
+        nxt_string("Connection"),
+        nxt_string("Keep-Alive"),
+        nxt_string("Date"),
+        nxt_string("Server"),
+        nxt_string("Age"),
+    };
+
+    if (f->skip || f->hopbyhop) {
+        return 0;
+    }
+
+    for (i = 0; i < nxt_nitems(skipped); i++) {
+        if (f->name_length == skipped[i].length
+            && nxt_memcasecmp(f->name, skipped[i].start, f->name_length) == 0)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/*
+ * Copies the response body being sent to the response being stored;
+ * the response is added to the cache with the last buffer.
+ */
+
+void
+nxt_http_cache_body(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
+{
+    u_char                  *body;
+    size_t                  size, length;
+    nxt_buf_t               *b;
+    nxt_http_cache_ctx_t    *hc;
+    nxt_http_cache_entry_t  *entry;
+
+    hc = r->cache;
+    entry = hc->entry;
+
+    if (entry == NULL) {
+        return;
+    }
+
+    for (b = out; b != NULL; b = b->next) {
+
+        if (nxt_buf_is_file(b)) {
+            nxt_http_cache_abort(task, hc);
+            return;
+        }
+
+        if (nxt_buf_is_mem(b)) {
+            length = nxt_buf_mem_used_size(&b->mem);
+
+            if (length > 0) {
+                size = entry->body_length + length;
+
+                if (entry->size + size > hc->cache->max_size) {
+                    nxt_http_cache_abort(task, hc);
+                    return;
+                }
+
+                if (size > hc->body_size) {
+                    size = nxt_max(size, hc->body_size * 2);
+                    size = nxt_min(size, hc->cache->max_size - entry->size);
+
+                    body = nxt_realloc(entry->body, size);
+                    if (nxt_slow_path(body == NULL)) {
+                        nxt_http_cache_abort(task, hc);
+                        return;
+                    }
+
+                    entry->body = body;
+                    hc->body_size = size;
+                }
+
+                nxt_memcpy(entry->body + entry->body_length, b->mem.pos,
+                           length);
+                entry->body_length += length;
+            }
+        }
+
+        if (nxt_buf_is_last(b)) {
+            nxt_http_cache_store(task, hc);
+            return;
+        }
+    }
+}
+
+
+static void
+nxt_http_cache_store(nxt_task_t *task, nxt_http_cache_ctx_t *hc)
+{
+    nxt_int_t               ret;
+    nxt_queue_link_t        *link;
+    nxt_http_cache_t        *cache;
+    nxt_lvlhsh_query_t      lhq;
+    nxt_http_cache_entry_t  *entry, *old;
+
+    cache = hc->cache;
+    entry = hc->entry;
+
+    hc->entry = NULL;
+    hc->updating = 0;
+
+    entry->size += entry->body_length;
+
+    lhq.key_hash = nxt_djb_hash(entry->key.start, entry->key.length);
+    lhq.key = entry->key;
+    lhq.replace = 0;
+    lhq.value = entry;
+    lhq.proto = &nxt_http_cache_proto;
+    lhq.pool = NULL;
+
+    nxt_thread_mutex_lock(&cache->mutex);
+
+    old = nxt_http_cache_find(cache, &entry->key);
+
+    if (old != NULL) {
+        nxt_http_cache_remove(cache, old);
+    }
+
+    while (cache->size + entry->size > cache->max_size
+           && !nxt_queue_is_empty(&cache->lru))
+    {
+        link = nxt_queue_last(&cache->lru);
+        old = nxt_queue_link_data(link, nxt_http_cache_entry_t, link);
+
+        nxt_http_cache_remove(cache, old);
+    }
+
+    ret = nxt_lvlhsh_insert(&cache->hash, &lhq);
+
+    if (nxt_fast_path(ret == NXT_OK)) {
+        nxt_queue_insert_head(&cache->lru, &entry->link);
+        cache->size += entry->size;
+
+        entry->use_count = 1;
+    }
+
+    nxt_thread_mutex_unlock(&cache->mutex);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_http_cache_free(entry);
+        return;
+    }
+
+    /* The entry may be already evicted by another thread. */
+
+    nxt_debug(task, "http cache stored \"%V\"", &hc->key);
+}
+
+
+/*
+ * Drops the response being stored and allows other requests to update
+ * the stale response if this request has not done it.
+ */
+
+static void
+nxt_http_cache_abort(nxt_task_t *task, nxt_http_cache_ctx_t *hc)
+{
+    nxt_http_cache_t        *cache;
+    nxt_http_cache_entry_t  *entry;
+
+    if (hc->entry != NULL) {
+        nxt_http_cache_free(hc->entry);
+        hc->entry = NULL;
+    }
+
+    if (hc->updating) {
+        hc->updating = 0;
+
+        cache = hc->cache;
+
+        nxt_thread_mutex_lock(&cache->mutex);
+
+        entry = nxt_http_cache_find(cache, &hc->key);
+
+        if (entry != NULL) {
+            entry->updating = 0;
+        }
+
+        nxt_thread_mutex_unlock(&cache->mutex);
+    }
+}
+
+
+void
+nxt_http_cache_release(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_http_cache_ctx_t  *hc;
+
+    hc = r->cache;
+    r->cache = NULL;
+
+    nxt_http_cache_abort(task, hc);
+}
+
+
+static nxt_int_t
+nxt_http_cache_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_cache_entry_t  *entry;
+
+    entry = data;
+
+    if (nxt_strstr_eq(&lhq->key, &entry->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+/* The cache mutex must be locked. */
+
+static nxt_http_cache_entry_t *
+nxt_http_cache_find(nxt_http_cache_t *cache, nxt_str_t *key)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.key = *key;
+    lhq.proto = &nxt_http_cache_proto;
+
+    if (nxt_lvlhsh_find(&cache->hash, &lhq) != NXT_OK) {
+        return NULL;
+    }
+
+    return lhq.value;
+}
+
+
+/* The cache mutex must be locked. */
+
+static void
+nxt_http_cache_remove(nxt_http_cache_t *cache, nxt_http_cache_entry_t *entry)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = nxt_djb_hash(entry->key.start, entry->key.length);
+    lhq.key = entry->key;
+    lhq.proto = &nxt_http_cache_proto;
+    lhq.pool = NULL;
+
+    (void) nxt_lvlhsh_delete(&cache->hash, &lhq);
+
+    nxt_queue_remove(&entry->link);
+    cache->size -= entry->size;
+
+    nxt_http_cache_entry_use(entry, -1);
+}
+
+
+static void
+nxt_http_cache_entry_use(nxt_http_cache_entry_t *entry, int i)
+{
+    int  c;
+
+    c = nxt_atomic_fetch_add(&entry->use_count, i);
+
+    if (i < 0 && c == -i) {
+        nxt_http_cache_free(entry);
+    }
+}
+
+
+static void
+nxt_http_cache_free(nxt_http_cache_entry_t *entry)
+{
+    if (entry->body != NULL) {
+        nxt_free(entry->body);
+    }
+
+    nxt_free(entry);
+}
+
+
+static void
+nxt_http_cache_destroy(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_queue_link_t        *link;
+    nxt_http_cache_t        *cache;
+    nxt_http_cache_entry_t  *entry;
+
+    cache = obj;
+
+    while (!nxt_queue_is_empty(&cache->lru)) {
+        link = nxt_queue_first(&cache->lru);
+        entry = nxt_queue_link_data(link, nxt_http_cache_entry_t, link);
+
+        nxt_http_cache_remove(cache, entry);
+    }
+
+    nxt_thread_mutex_destroy(&cache->mutex);
+}
@@ -0,0 +1,834 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_http_compress.h>
+
+
+#define NXT_HTTP_COMPRESS_BUF_SIZE    8192
+#define NXT_HTTP_COMPRESS_MIN_LENGTH  20
+
+/* The maximum number of idle compressor contexts kept per engine. */
+#define NXT_HTTP_COMPRESS_CACHE       16
+
+
+typedef struct {
+    const nxt_http_compressor_t    *compressor;
+    nxt_int_t                      level;
+} nxt_http_compress_encoding_t;
+
+
+struct nxt_http_compress_conf_s {
+    nxt_http_compress_encoding_t   *encodings;
+    nxt_uint_t                     nencodings;
+    nxt_http_route_rule_t          *types;
+    nxt_off_t                      min_length;
+};
+
+
+/*
+ * Compressor contexts are expensive to create, so they are kept in the
+ * per-engine cache when a response has been compressed and are reused
+ * with a new compression level by the next responses.
+ */
+
+struct nxt_http_compress_s {
+    nxt_queue_link_t               link;
+    const nxt_http_compressor_t    *compressor;
+    void                           *ctx;
+    nxt_buf_t                      *out;
+};
+
+
+typedef struct {
+    nxt_conf_value_t               *encodings;
+    nxt_conf_value_t               *types;
+    nxt_conf_value_t               *level;
+    nxt_off_t                      min_length;
+} nxt_http_compress_conf_map_t;
+
+
+static nxt_int_t nxt_http_compress_etag(nxt_http_request_t *r,
+    nxt_http_field_t *etag);
+static nxt_http_compress_t *nxt_http_compress_get(nxt_task_t *task,
+    nxt_http_compress_encoding_t *enc);
+static nxt_http_field_t *nxt_http_compress_field_add(nxt_http_request_t *r,
+    const char *name, size_t name_length, u_char *value, size_t value_length);
+static nxt_bool_t nxt_http_compress_type(nxt_http_request_t *r,
+    nxt_http_compress_conf_t *conf, nxt_http_field_t *content_type);
+static nxt_http_compress_encoding_t *nxt_http_compress_negotiate(
+    nxt_http_request_t *r, nxt_http_compress_conf_t *conf);
+static nxt_int_t nxt_http_compress_accept(u_char *p, u_char *end,
+    const nxt_str_t *token, nxt_int_t *star);
+static nxt_int_t nxt_http_compress_qvalue(u_char *p, u_char *end);
+static nxt_int_t nxt_http_compress_run(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_compress_t *hc, nxt_buf_mem_t *in, nxt_uint_t flush,
+    nxt_buf_t ***tail);
+static void nxt_http_compress_complete(nxt_task_t *task, nxt_buf_t *b);
+
+
+static const nxt_http_compressor_t  *nxt_http_compressors[] = {
+#if (NXT_HAVE_ZSTD)
+    &nxt_http_compress_zstd,
+#endif
+#if (NXT_HAVE_ZLIB)
+    &nxt_http_compress_gzip,
+#endif
+    NULL
+};
+
+
+static nxt_conf_map_t  nxt_http_compress_conf[] = {
+    {
+        nxt_string("encodings"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_compress_conf_map_t, encodings),
+    },
+
+    {
+        nxt_string("types"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_compress_conf_map_t, types),
+    },
+
+    {
+        nxt_string("level"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_compress_conf_map_t, level),
+    },
+
+    {
+        nxt_string("min_length"),
+        NXT_CONF_MAP_OFF,
+        offsetof(nxt_http_compress_conf_map_t, min_length),
+    },
+};
+
+
+const nxt_http_compressor_t *
+nxt_http_compressor_find(nxt_str_t *token)
+{
+    const nxt_http_compressor_t  **compressor;
+
+    for (compressor = nxt_http_compressors; *compressor != NULL; compressor++)
+    {
+        if (nxt_strcasestr_eq(token, &(*compressor)->token)) {
+            return *compressor;
+        }
+    }
+
+    return NULL;
+}
+
+
+nxt_uint_t
+nxt_http_compressors_count(void)
+{
+    return nxt_nitems(nxt_http_compressors) - 1;
+}
+
+
+nxt_int_t
+nxt_http_compress_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf)
+{
+    int64_t                       level;
+    uint32_t                      i, n;
+    nxt_mp_t                      *mp;
+    nxt_int_t                     ret;
+    nxt_str_t                     token;
+    nxt_conf_value_t              *value;
+    nxt_http_compress_conf_t      *conf;
+    nxt_http_compress_encoding_t  *enc;
+    nxt_http_compress_conf_map_t  map;
+
+    mp = rtcf->mem_pool;
+
+    nxt_memzero(&map, sizeof(map));
+    map.min_length = NXT_HTTP_COMPRESS_MIN_LENGTH;
+
+    ret = nxt_conf_map_object(mp, acf->compress, nxt_http_compress_conf,
+                              nxt_nitems(nxt_http_compress_conf), &map);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    conf = nxt_mp_zget(mp, sizeof(nxt_http_compress_conf_t));
+    if (nxt_slow_path(conf == NULL)) {
+        return NXT_ERROR;
+    }
+
+    conf->min_length = map.min_length;
+
+    n = (map.encodings != NULL)
+        ? nxt_conf_array_elements_count_or_1(map.encodings)
+        : nxt_http_compressors_count();
+
+    conf->encodings = nxt_mp_get(mp, n * sizeof(nxt_http_compress_encoding_t));
+    if (nxt_slow_path(conf->encodings == NULL)) {
+        return NXT_ERROR;
+    }
+
+    level = (map.level != NULL) ? nxt_conf_get_number(map.level) : 0;
+
+    for (i = 0; i < n; i++) {
+        enc = &conf->encodings[i];
+
+        if (map.encodings != NULL) {
+            value = nxt_conf_get_array_element_or_itself(map.encodings, i);
+            nxt_conf_get_string(value, &token);
+
+            enc->compressor = nxt_http_compressor_find(&token);
+            if (nxt_slow_path(enc->compressor == NULL)) {
+                return NXT_ERROR;
+            }
+
+        } else {
+            enc->compressor = nxt_http_compressors[i];
+        }
+
+        if (level == 0) {
+            enc->level = enc->compressor->default_level;
+
+        } else {
+            enc->level = nxt_min(level, enc->compressor->max_level);
+        }
+    }
+
+    conf->nencodings = n;
+
+    if (map.types != NULL) {
+        conf->types = nxt_http_route_types_rule_create(task, mp, map.types);
+        if (nxt_slow_path(conf->types == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    action->compress = conf;
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+nxt_http_compress_header(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_off_t                     length;
+    nxt_http_field_t              *f, *content_type, *etag;
+    nxt_http_compress_t           *hc;
+    nxt_http_action_t             *action;
+    nxt_http_compress_conf_t      *conf;
+    nxt_http_compress_encoding_t  *enc;
+
+    if (r->compress != NULL) {
+        /* The header is being sent again with an error response. */
+        nxt_http_compress_release(task, r);
+    }
+
+    action = r->action;
+
+    if (action == NULL || action->compress == NULL) {
+        return NXT_OK;
+    }
+
+    if (r->status < NXT_HTTP_OK
+        || (r->status >= NXT_HTTP_MULTIPLE_CHOICES
+            && r->status != NXT_HTTP_NOT_MODIFIED)
+        || r->status == NXT_HTTP_NO_CONTENT
+        || r->status == NXT_HTTP_PARTIAL_CONTENT)
+    {
+        return NXT_OK;
+    }
+
+    conf = action->compress;
+
+    length = r->resp.content_length_n;
+
+    if (length == -1
+        && r->resp.content_length != NULL
+        && !r->resp.content_length->skip)
+    {
+        length = nxt_off_t_parse(r->resp.content_length->value,
+                                 r->resp.content_length->value_length);
+    }
+
+    if (length >= 0 && length < conf->min_length) {
+        return NXT_OK;
+    }
+
+    content_type = NULL;
+    etag = NULL;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (f->skip) {
+            continue;
+        }
+
+        if (f->name_length == nxt_length("Content-Encoding")
+            && nxt_memcasecmp(f->name, "Content-Encoding",
+                              nxt_length("Content-Encoding")) == 0)
+        {
+            return NXT_OK;
+        }
+
+        if (f->name_length == nxt_length("Content-Type")
+            && nxt_memcasecmp(f->name, "Content-Type",
+                              nxt_length("Content-Type")) == 0)
+        {
+            content_type = f;
+
+        } else if (f->name_length == nxt_length("ETag")
+                   && nxt_memcasecmp(f->name, "ETag",
+                                     nxt_length("ETag")) == 0)
+        {
+            etag = f;
+        }
+
+    } nxt_list_loop;
+
+    if (!nxt_http_compress_type(r, conf, content_type)) {
+        return NXT_OK;
+    }
+
+    f = nxt_http_compress_field_add(r, "Vary", nxt_length("Vary"),
+                                    (u_char *) "Accept-Encoding",
+                                    nxt_length("Accept-Encoding"));
+    if (nxt_slow_path(f == NULL)) {
+        return NXT_ERROR;
+    }
+
+    enc = nxt_http_compress_negotiate(r, conf);
+
+    if (enc == NULL) {
+        return NXT_OK;
+    }
+
+    if (nxt_slow_path(nxt_http_compress_etag(r, etag) != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (r->status == NXT_HTTP_NOT_MODIFIED) {
+        return NXT_OK;
+    }
+
+    hc = nxt_http_compress_get(task, enc);
+    if (nxt_slow_path(hc == NULL)) {
+        return NXT_ERROR;
+    }
+
+    r->compress = hc;
+
+    f = nxt_http_compress_field_add(r, "Content-Encoding",
+                                    nxt_length("Content-Encoding"),
+                                    enc->compressor->token.start,
+                                    enc->compressor->token.length);
+    if (nxt_slow_path(f == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (r->resp.content_length != NULL) {
+        r->resp.content_length->skip = 1;
+    }
+
+    r->resp.content_length_n = -1;
+
+    nxt_debug(task, "http compress: %V level:%i",
+              &enc->compressor->token, enc->level);
+
+    return NXT_OK;
+}
+
+
+/*
+ * A strong validator does not match the compressed representation.
+ * The same weak validator is sent with "304 Not Modified" responses.
+ */
+
+static nxt_int_t
+nxt_http_compress_etag(nxt_http_request_t *r, nxt_http_field_t *etag)
+{
+    u_char  *p;
+
+    if (etag == NULL || etag->value_length == 0 || etag->value[0] != '"') {
+        return NXT_OK;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, etag->value_length + 2);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p[0] = 'W';
+    p[1] = '/';
+    nxt_memcpy(p + 2, etag->value, etag->value_length);
+
+    etag->value = p;
+    etag->value_length += 2;
+
+    return NXT_OK;
+}
+
+
+static nxt_http_compress_t *
+nxt_http_compress_get(nxt_task_t *task, nxt_http_compress_encoding_t *enc)
+{
+    nxt_event_engine_t   *engine;
+    nxt_http_compress_t  *hc;
+
+    engine = task->thread->engine;
+
+    nxt_queue_each(hc, &engine->compress_cache, nxt_http_compress_t, link) {
+
+        if (hc->compressor == enc->compressor) {
+            nxt_queue_remove(&hc->link);
+            engine->compress_cached--;
+
+            if (nxt_slow_path(hc->compressor->reset(hc->ctx, enc->level)
+                              != NXT_OK))
+            {
+                hc->compressor->free(hc->ctx);
+                nxt_free(hc);
+                return NULL;
+            }
+
+            return hc;
+        }
+
+    } nxt_queue_loop;
+
+    hc = nxt_zalloc(sizeof(nxt_http_compress_t));
+    if (nxt_slow_path(hc == NULL)) {
+        return NULL;
+    }
+
+    hc->compressor = enc->compressor;
+
+    hc->ctx = hc->compressor->create(enc->level);
+    if (nxt_slow_path(hc->ctx == NULL)) {
+        nxt_free(hc);
+        return NULL;
+    }
+
+    return hc;
+}
+
+
+void
+nxt_http_compress_release(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_buf_t            *b;
+    nxt_event_engine_t   *engine;
+    nxt_http_compress_t  *hc;
+
+    hc = r->compress;
+    r->compress = NULL;
+
+    engine = task->thread->engine;
+
+    b = hc->out;
+
+    if (b != NULL) {
+        /* The request has been closed before the end of the response. */
+
+        hc->out = NULL;
+
+        nxt_work_queue_add(&engine->fast_work_queue, b->completion_handler,
+                           task, b, b->parent);
+    }
+
+    if (engine->shutdown
+        || engine->compress_cached >= NXT_HTTP_COMPRESS_CACHE)
+    {
+        hc->compressor->free(hc->ctx);
+        nxt_free(hc);
+        return;
+    }
+
+    nxt_queue_insert_head(&engine->compress_cache, &hc->link);
+    engine->compress_cached++;
+}
+
+
+void
+nxt_http_compress_cache_free(nxt_event_engine_t *engine)
+{
+    nxt_http_compress_t  *hc;
+
+    nxt_queue_each(hc, &engine->compress_cache, nxt_http_compress_t, link) {
+
+        nxt_queue_remove(&hc->link);
+
+        hc->compressor->free(hc->ctx);
+        nxt_free(hc);
+
+    } nxt_queue_loop;
+
+    engine->compress_cached = 0;
+}
+
+
+static nxt_http_field_t *
+nxt_http_compress_field_add(nxt_http_request_t *r, const char *name,
+    size_t name_length, u_char *value, size_t value_length)
+{
+    nxt_http_field_t  *f;
+
+    f = nxt_list_zero_add(r->resp.fields);
+
+    if (nxt_fast_path(f != NULL)) {
+        f->name = (u_char *) name;
+        f->name_length = name_length;
+        f->value = value;
+        f->value_length = value_length;
+    }
+
+    return f;
+}
+
+
+static nxt_bool_t
+nxt_http_compress_type(nxt_http_request_t *r, nxt_http_compress_conf_t *conf,
+    nxt_http_field_t *content_type)
+{
+    u_char  *p, *end;
+
+    if (content_type == NULL) {
+        return 0;
+    }
+
+    p = content_type->value;
+    end = p + content_type->value_length;
+
+    /* Media type parameters, such as "charset", are ignored. */
+
+    while (p < end && *p != ';' && *p != ' ' && *p != '\t') {
+        p++;
+    }
+
+    if (conf->types == NULL) {
+        return (p - content_type->value == nxt_length("text/html")
+                && nxt_memcasecmp(content_type->value, "text/html",
+                                  nxt_length("text/html")) == 0);
+    }
+
+    return (nxt_http_route_test_rule(r, conf->types, content_type->value,
+                                     p - content_type->value)
+            == 1);
+}
+
+
+/*
+ * The first configured encoding acceptable by the client is used,
+ * so the configuration sets the server preference.
+ */
+
+static nxt_http_compress_encoding_t *
+nxt_http_compress_negotiate(nxt_http_request_t *r,
+    nxt_http_compress_conf_t *conf)
+{
+    nxt_uint_t                    i;
+    nxt_http_compress_encoding_t  *enc;
+
+    for (i = 0; i < conf->nencodings; i++) {
+        enc = &conf->encodings[i];
+
+        if (nxt_http_compress_accepted(r, &enc->compressor->token)) {
+            return enc;
+        }
+    }
+
+    return NULL;
+}
+
+
+nxt_bool_t
+nxt_http_compress_accepted(nxt_http_request_t *r, const nxt_str_t *token)
+{
+    nxt_int_t         q, star;
+    nxt_http_field_t  *f;
+
+    q = -1;
+    star = -1;
+
+    nxt_list_each(f, r->fields) {
+
+        if (f->name_length != nxt_length("Accept-Encoding")
+            || nxt_memcasecmp(f->name, "Accept-Encoding",
+                              nxt_length("Accept-Encoding")) != 0)
+        {
+            continue;
+        }
+
+        q = nxt_http_compress_accept(f->value, f->value + f->value_length,
+                                     token, &star);
+        if (q >= 0) {
+            break;
+        }
+
+    } nxt_list_loop;
+
+    return (q > 0 || (q < 0 && star > 0));
+}
+
+
+/*
+ * Returns the quality value of the coding in thousandths, or -1 if
+ * the coding is not listed.  The "*" quality value is stored separately.
+ */
+
+static nxt_int_t
+nxt_http_compress_accept(u_char *p, u_char *end, const nxt_str_t *token,
+    nxt_int_t *star)
+{
+    u_char     *name;
+    size_t     length;
+    nxt_int_t  q;
+
+    while (p < end) {
+
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+
+        name = p;
+
+        while (p < end && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+
+        length = p - name;
+        q = 1000;
+
+        while (p < end && *p != ',') {
+
+            if (*p == ';') {
+                p++;
+
+                while (p < end && (*p == ' ' || *p == '\t')) {
+                    p++;
+                }
+
+                if (end - p > 2 && (p[0] == 'q' || p[0] == 'Q')
+                    && p[1] == '=')
+                {
+                    q = nxt_http_compress_qvalue(p + 2, end);
+                }
+
+                continue;
+            }
+
+            p++;
+        }
+
+        if (length == 0) {
+            continue;
+        }
+
+        if (length == token->length
+            && nxt_memcasecmp(name, token->start, length) == 0)
+        {
+            return q;
+        }
+
+        if (length == 1 && name[0] == '*') {
+            *star = q;
+        }
+    }
+
+    return -1;
+}
+
+
+static nxt_int_t
+nxt_http_compress_qvalue(u_char *p, u_char *end)
+{
+    nxt_int_t   q, scale;
+
+    if (*p == '1') {
+        return 1000;
+    }
+
+    if (*p != '0') {
+        return 0;
+    }
+
+    p++;
+
+    if (p == end || *p != '.') {
+        return 0;
+    }
+
+    p++;
+
+    q = 0;
+
+    for (scale = 100; scale != 0 && p < end; scale /= 10, p++) {
+        if (*p < '0' || *p > '9') {
+            break;
+        }
+
+        q += (*p - '0') * scale;
+    }
+
+    return q;
+}
+
+
+/*
+ * The input buffers are consumed and follow the compressed data,
+ * so they are completed only after the compressed data have been sent.
+ * The compressor is flushed at the end of each input chain, so streamed
+ * responses are not held back until the compressor buffer fills up.
+ */
+
+nxt_buf_t *
+nxt_http_compress_filter(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *in)
+{
+    nxt_int_t            ret;
+    nxt_buf_t            *b, *next, *out, **tail, **prev;
+    nxt_bool_t           empty;
+    nxt_buf_mem_t        mem;
+    nxt_http_compress_t  *hc;
+
+    hc = r->compress;
+
+    out = NULL;
+    tail = &out;
+    empty = 1;
+
+    for (b = in; b != NULL; b = next) {
+        next = b->next;
+        b->next = NULL;
+
+        prev = tail;
+
+        if (!nxt_buf_is_sync(b) && nxt_buf_is_mem(b)) {
+            ret = nxt_http_compress_run(task, r, hc, &b->mem,
+                                        NXT_HTTP_COMPRESS_NO_FLUSH, &tail);
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                goto fail;
+            }
+        }
+
+        if (nxt_buf_is_last(b)) {
+            nxt_memzero(&mem, sizeof(nxt_buf_mem_t));
+
+            ret = nxt_http_compress_run(task, r, hc, &mem,
+                                        NXT_HTTP_COMPRESS_FINISH, &tail);
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                goto fail;
+            }
+
+            nxt_http_compress_release(task, r);
+
+        } else if (next == NULL) {
+            nxt_memzero(&mem, sizeof(nxt_buf_mem_t));
+
+            ret = nxt_http_compress_run(task, r, hc, &mem,
+                                        NXT_HTTP_COMPRESS_FLUSH, &tail);
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                goto fail;
+            }
+        }
+
+        if (tail != prev || nxt_buf_is_sync(b)) {
+            empty = 0;
+        }
+
+        *tail = b;
+        tail = &b->next;
+    }
+
+    if (!empty) {
+        return out;
+    }
+
+    /* All input has been buffered by the compressor. */
+
+    nxt_http_compress_complete(task, out);
+
+    return NULL;
+
+fail:
+
+    /* The compressed data and the rest of the input are not sent. */
+
+    *tail = b;
+    b->next = next;
+
+    nxt_http_compress_complete(task, out);
+
+    return NULL;
+}
+
+
+static nxt_int_t
+nxt_http_compress_run(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_compress_t *hc, nxt_buf_mem_t *in, nxt_uint_t flush,
+    nxt_buf_t ***tail)
+{
+    nxt_int_t  ret;
+    nxt_buf_t  *b;
+
+    for ( ;; ) {
+        b = hc->out;
+
+        if (b == NULL) {
+            b = nxt_http_buf_mem(task, r, NXT_HTTP_COMPRESS_BUF_SIZE);
+            if (nxt_slow_path(b == NULL)) {
+                return NXT_ERROR;
+            }
+
+            hc->out = b;
+        }
+
+        ret = hc->compressor->compress(hc->ctx, in, &b->mem, flush);
+
+        if (nxt_slow_path(ret == NXT_ERROR)) {
+            nxt_log(task, NXT_LOG_ERR, "%V compression failed",
+                    &hc->compressor->token);
+
+            nxt_http_request_error_handler(task, r, r->proto.any);
+            return NXT_ERROR;
+        }
+
+        if (b->mem.free == b->mem.end
+            || ret == NXT_DONE
+            || (flush == NXT_HTTP_COMPRESS_FLUSH
+                && ret == NXT_OK
+                && b->mem.free != b->mem.pos))
+        {
+            hc->out = NULL;
+
+            **tail = b;
+            *tail = &b->next;
+        }
+
+        if (ret != NXT_AGAIN) {
+            return ret;
+        }
+    }
+}
+
+
+static void
+nxt_http_compress_complete(nxt_task_t *task, nxt_buf_t *b)
+{
+    nxt_buf_t         *next;
+    nxt_work_queue_t  *wq;
+
+    wq = &task->thread->engine->fast_work_queue;
+
+    for ( /* void */ ; b != NULL; b = next) {
+        next = b->next;
+        b->next = NULL;
+
+        nxt_work_queue_add(wq, b->completion_handler, task, b, b->parent);
+    }
+}
@@ -0,0 +1,51 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_HTTP_COMPRESS_H_INCLUDED_
+#define _NXT_HTTP_COMPRESS_H_INCLUDED_
+
+
+#define NXT_HTTP_COMPRESS_NO_FLUSH  0
+#define NXT_HTTP_COMPRESS_FLUSH     1
+#define NXT_HTTP_COMPRESS_FINISH    2
+
+
+typedef struct {
+    nxt_str_t                  token;
+
+    nxt_int_t                  default_level;
+    nxt_int_t                  max_level;
+
+    void                       *(*create)(nxt_int_t level);
+    nxt_int_t                  (*reset)(void *ctx, nxt_int_t level);
+
+    /*
+     * Compresses data from the "in" buffer to the "out" buffer.
+     * Returns NXT_OK if all input data have been consumed and, with
+     * NXT_HTTP_COMPRESS_FLUSH, all pending output has been flushed,
+     * NXT_AGAIN if the "out" buffer is full, NXT_DONE if the stream
+     * has been finished, and NXT_ERROR on failure.
+     */
+    nxt_int_t                  (*compress)(void *ctx, nxt_buf_mem_t *in,
+                                   nxt_buf_mem_t *out, nxt_uint_t flush);
+
+    void                       (*free)(void *ctx);
+} nxt_http_compressor_t;
+
+
+#if (NXT_HAVE_ZLIB)
+extern const nxt_http_compressor_t  nxt_http_compress_gzip;
+#endif
+
+#if (NXT_HAVE_ZSTD)
+extern const nxt_http_compressor_t  nxt_http_compress_zstd;
+#endif
+
+
+const nxt_http_compressor_t *nxt_http_compressor_find(nxt_str_t *token);
+nxt_uint_t nxt_http_compressors_count(void);
+
+
+#endif  /* _NXT_HTTP_COMPRESS_H_INCLUDED_ */
@@ -0,0 +1,133 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_http_compress.h>
+
+#include <zlib.h>
+
+
+/* The window bits value to produce a gzip header and trailer. */
+#define NXT_GZIP_WINDOW_BITS  (MAX_WBITS + 16)
+#define NXT_GZIP_MEM_LEVEL    8
+
+
+static void *nxt_http_compress_gzip_create(nxt_int_t level);
+static nxt_int_t nxt_http_compress_gzip_reset(void *ctx, nxt_int_t level);
+static nxt_int_t nxt_http_compress_gzip_compress(void *ctx, nxt_buf_mem_t *in,
+    nxt_buf_mem_t *out, nxt_uint_t flush);
+static void nxt_http_compress_gzip_free(void *ctx);
+
+
+const nxt_http_compressor_t  nxt_http_compress_gzip = {
+    .token          = nxt_string("gzip"),
+    .default_level  = 6,
+    .max_level      = 9,
+    .create         = nxt_http_compress_gzip_create,
+    .reset          = nxt_http_compress_gzip_reset,
+    .compress       = nxt_http_compress_gzip_compress,
+    .free           = nxt_http_compress_gzip_free,
+};
+
+
+static void *
+nxt_http_compress_gzip_create(nxt_int_t level)
+{
+    int       ret;
+    z_stream  *zs;
+
+    zs = nxt_zalloc(sizeof(z_stream));
+    if (nxt_slow_path(zs == NULL)) {
+        return NULL;
+    }
+
+    ret = deflateInit2(zs, level, Z_DEFLATED, NXT_GZIP_WINDOW_BITS,
+                       NXT_GZIP_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+
+    if (nxt_slow_path(ret != Z_OK)) {
+        nxt_free(zs);
+        return NULL;
+    }
+
+    return zs;
+}
+
+
+static nxt_int_t
+nxt_http_compress_gzip_reset(void *ctx, nxt_int_t level)
+{
+    z_stream  *zs;
+
+    zs = ctx;
+
+    if (nxt_slow_path(deflateReset(zs) != Z_OK)) {
+        return NXT_ERROR;
+    }
+
+    /* No data have been compressed yet, so the call just sets the level. */
+
+    if (nxt_slow_path(deflateParams(zs, level, Z_DEFAULT_STRATEGY) != Z_OK)) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_compress_gzip_compress(void *ctx, nxt_buf_mem_t *in,
+    nxt_buf_mem_t *out, nxt_uint_t flush)
+{
+    int       ret;
+    z_stream  *zs;
+
+    static const int  mode[] = {
+        [NXT_HTTP_COMPRESS_NO_FLUSH] = Z_NO_FLUSH,
+        [NXT_HTTP_COMPRESS_FLUSH] = Z_SYNC_FLUSH,
+        [NXT_HTTP_COMPRESS_FINISH] = Z_FINISH,
+    };
+
+    zs = ctx;
+
+    zs->next_in = in->pos;
+    zs->avail_in = in->free - in->pos;
+    zs->next_out = out->free;
+    zs->avail_out = out->end - out->free;
+
+    ret = deflate(zs, mode[flush]);
+
+    in->pos = zs->next_in;
+    out->free = zs->next_out;
+
+    switch (ret) {
+
+    case Z_STREAM_END:
+        return NXT_DONE;
+
+    case Z_OK:
+    case Z_BUF_ERROR:
+        /* Z_BUF_ERROR means no progress was possible, it is not fatal. */
+
+        /* A flush may have more output pending if the buffer is full. */
+
+        if (zs->avail_out == 0) {
+            return NXT_AGAIN;
+        }
+
+        return (flush == NXT_HTTP_COMPRESS_FINISH) ? NXT_AGAIN : NXT_OK;
+
+    default:
+        return NXT_ERROR;
+    }
+}
+
+
+static void
+nxt_http_compress_gzip_free(void *ctx)
+{
+    (void) deflateEnd(ctx);
+
+    nxt_free(ctx);
+}
@@ -0,0 +1,121 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_http_compress.h>
+
+#include <zstd.h>
+
+
+static void *nxt_http_compress_zstd_create(nxt_int_t level);
+static nxt_int_t nxt_http_compress_zstd_reset(void *ctx, nxt_int_t level);
+static nxt_int_t nxt_http_compress_zstd_compress(void *ctx, nxt_buf_mem_t *in,
+    nxt_buf_mem_t *out, nxt_uint_t flush);
+static void nxt_http_compress_zstd_free(void *ctx);
+
+
+const nxt_http_compressor_t  nxt_http_compress_zstd = {
+    .token          = nxt_string("zstd"),
+    .default_level  = 3,
+    .max_level      = 19,
+    .create         = nxt_http_compress_zstd_create,
+    .reset          = nxt_http_compress_zstd_reset,
+    .compress       = nxt_http_compress_zstd_compress,
+    .free           = nxt_http_compress_zstd_free,
+};
+
+
+static void *
+nxt_http_compress_zstd_create(nxt_int_t level)
+{
+    ZSTD_CCtx  *cctx;
+
+    cctx = ZSTD_createCCtx();
+    if (nxt_slow_path(cctx == NULL)) {
+        return NULL;
+    }
+
+    if (nxt_slow_path(nxt_http_compress_zstd_reset(cctx, level) != NXT_OK)) {
+        ZSTD_freeCCtx(cctx);
+        return NULL;
+    }
+
+    return cctx;
+}
+
+
+static nxt_int_t
+nxt_http_compress_zstd_reset(void *ctx, nxt_int_t level)
+{
+    size_t  ret;
+
+    ret = ZSTD_CCtx_reset(ctx, ZSTD_reset_session_only);
+    if (nxt_slow_path(ZSTD_isError(ret))) {
+        return NXT_ERROR;
+    }
+
+    ret = ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+    if (nxt_slow_path(ZSTD_isError(ret))) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_compress_zstd_compress(void *ctx, nxt_buf_mem_t *in,
+    nxt_buf_mem_t *out, nxt_uint_t flush)
+{
+    size_t          ret;
+    ZSTD_inBuffer   input;
+    ZSTD_outBuffer  output;
+
+    static const ZSTD_EndDirective  mode[] = {
+        [NXT_HTTP_COMPRESS_NO_FLUSH] = ZSTD_e_continue,
+        [NXT_HTTP_COMPRESS_FLUSH] = ZSTD_e_flush,
+        [NXT_HTTP_COMPRESS_FINISH] = ZSTD_e_end,
+    };
+
+    input.src = in->pos;
+    input.size = in->free - in->pos;
+    input.pos = 0;
+
+    output.dst = out->free;
+    output.size = out->end - out->free;
+    output.pos = 0;
+
+    ret = ZSTD_compressStream2(ctx, &output, &input, mode[flush]);
+
+    in->pos += input.pos;
+    out->free += output.pos;
+
+    if (nxt_slow_path(ZSTD_isError(ret))) {
+        return NXT_ERROR;
+    }
+
+    /* The return value is the amount of data still to be flushed. */
+
+    if (flush == NXT_HTTP_COMPRESS_FINISH) {
+        return (ret == 0) ? NXT_DONE : NXT_AGAIN;
+    }
+
+    if (flush == NXT_HTTP_COMPRESS_FLUSH) {
+        return (ret == 0) ? NXT_OK : NXT_AGAIN;
+    }
+
+    if (out->free == out->end) {
+        return NXT_AGAIN;
+    }
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_http_compress_zstd_free(void *ctx)
+{
+    ZSTD_freeCCtx(ctx);
+}
@@ -82,6 +82,7 @@ nxt_http_proxy_init(nxt_mp_t *mp, nxt_http_action_t *action,
         up->name.length = sa->length;
         up->name.start = nxt_sockaddr_start(sa);
         up->proto = &nxt_upstream_simple_proto;
+        up->keepalive = NULL;
 
         proxy = nxt_mp_alloc(mp, sizeof(nxt_upstream_proxy_t));
         if (nxt_slow_path(proxy == NULL)) {
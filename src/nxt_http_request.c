@@ -24,6 +24,8 @@ static void nxt_http_request_proto_info(nxt_task_t *task,
 static void nxt_http_request_mem_buf_completion(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_http_request_done(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_request_latency_add(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_uint_t metric);
 
 static u_char *nxt_http_date_cache_handler(u_char *buf, nxt_realtime_t *now,
     struct tm *tm, size_t size, const char *format);
@@ -73,6 +75,12 @@ nxt_http_init(nxt_task_t *task)
         return ret;
     }
 
+    ret = nxt_h2p_init(task);
+
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
     return nxt_http_response_hash_init(task);
 }
 
@@ -565,6 +573,16 @@ nxt_http_request_action(nxt_task_t *task, nxt_http_request_t *r,
                 break;
             }
 
+            ret = nxt_http_cache_lookup(task, r);
+
+            if (ret == NXT_DONE) {
+                return;
+            }
+
+            if (nxt_slow_path(ret != NXT_OK)) {
+                break;
+            }
+
             action = action->handler(task, r, action);
 
             if (action == NULL) {
@@ -634,11 +652,27 @@ nxt_http_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_field_t   *server, *date, *content_length;
     nxt_socket_conf_t  *skcf;
 
+    if (r->latency != NULL) {
+        nxt_http_request_latency_add(task, r, NXT_STATUS_LATENCY_TTFB);
+    }
+
+    if (r->cache != NULL) {
+        ret = nxt_http_cache_header(task, r);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
+    }
+
     ret = nxt_http_set_headers(r);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto fail;
     }
 
+    ret = nxt_http_compress_header(task, r);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        goto fail;
+    }
+
     /*
      * TODO: "Server", "Date", and "Content-Length" processing should be moved
      * to the last header filter.
@@ -725,6 +759,18 @@ void
 nxt_http_request_send(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
 {
     if (nxt_fast_path(r->proto.any != NULL)) {
+
+        if (r->cache != NULL) {
+            nxt_http_cache_body(task, r, out);
+        }
+
+        if (r->compress != NULL) {
+            out = nxt_http_compress_filter(task, r, out);
+            if (out == NULL) {
+                return;
+            }
+        }
+
         nxt_http_proto[r->protocol].send(task, r, out);
     }
 }
@@ -816,12 +862,12 @@ nxt_http_request_error_handler(nxt_task_t *task, void *obj, void *data)
 void
 nxt_http_request_close_handler(nxt_task_t *task, void *obj, void *data)
 {
-    nxt_tstr_t               *log_format;
-    nxt_http_proto_t         proto;
-    nxt_http_request_t       *r;
-    nxt_http_protocol_t      protocol;
-    nxt_socket_conf_joint_t  *conf;
-    nxt_router_access_log_t  *access_log;
+    nxt_http_proto_t                proto;
+    nxt_http_request_t              *r;
+    nxt_http_protocol_t             protocol;
+    nxt_socket_conf_joint_t         *conf;
+    nxt_router_access_log_t         *access_log;
+    nxt_router_access_log_format_t  *log_format;
 
     r = obj;
     proto.any = data;
@@ -831,6 +877,10 @@ nxt_http_request_close_handler(nxt_task_t *task, void *obj, void *data)
     if (!r->logged) {
         r->logged = 1;
 
+        if (r->latency != NULL) {
+            nxt_http_request_latency_add(task, r, NXT_STATUS_LATENCY_TOTAL);
+        }
+
         access_log = conf->socket_conf->router_conf->access_log;
         log_format = conf->socket_conf->router_conf->log_format;
 
@@ -856,6 +906,14 @@ nxt_http_request_close_handler(nxt_task_t *task, void *obj, void *data)
         nxt_tstr_query_release(r->tstr_query);
     }
 
+    if (r->compress != NULL) {
+        nxt_http_compress_release(task, r);
+    }
+
+    if (r->cache != NULL) {
+        nxt_http_cache_release(task, r);
+    }
+
     if (nxt_fast_path(proto.any != NULL)) {
         protocol = r->protocol;
 
@@ -866,6 +924,21 @@ nxt_http_request_close_handler(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static void
+nxt_http_request_latency_add(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_uint_t metric)
+{
+    nxt_nsec_t    now;
+    nxt_thread_t  *thr;
+
+    thr = task->thread;
+    now = nxt_thread_monotonic_time(thr);
+
+    nxt_status_latency_add(r->latency, thr->engine->status_index, metric,
+                           now - r->start_time);
+}
+
+
 static u_char *
 nxt_http_date_cache_handler(u_char *buf, nxt_realtime_t *now, struct tm *tm,
     size_t size, const char *format)
@@ -22,6 +22,7 @@ typedef enum {
     NXT_HTTP_ROUTE_QUERY,
     NXT_HTTP_ROUTE_SOURCE,
     NXT_HTTP_ROUTE_DESTINATION,
+    NXT_HTTP_ROUTE_TLS_EARLY_DATA,
 } nxt_http_route_object_t;
 
 
@@ -51,6 +52,7 @@ typedef struct {
     nxt_conf_value_t               *query;
     nxt_conf_value_t               *source;
     nxt_conf_value_t               *destination;
+    nxt_conf_value_t               *tls_early_data;
 } nxt_http_route_match_conf_t;
 
 
@@ -73,6 +75,7 @@ typedef struct {
     uint8_t                        case_sensitive;  /* 1 bit */
     uint8_t                        negative;        /* 1 bit */
     uint8_t                        any;             /* 1 bit */
+    uint8_t                        set;             /* 1 bit */
 #if (NXT_HAVE_REGEX)
     uint8_t                        regex;           /* 1 bit */
 #endif
@@ -103,6 +106,11 @@ struct nxt_http_route_rule_s {
         } name;
     } u;
 
+    nxt_aho_corasick_t             *set;
+#if (NXT_HAVE_REGEX)
+    /* The negative and positive regex sets. */
+    nxt_regex_t                    *regex[2];
+#endif
     nxt_http_route_pattern_t       pattern[0];
 };
 
@@ -125,14 +133,23 @@ struct nxt_http_route_addr_rule_s {
     /* The object must be the first field. */
     nxt_http_route_object_t        object:8;
     uint32_t                       items;
+    nxt_http_route_addr_tree_t     *tree;
     nxt_http_route_addr_pattern_t  addr_pattern[0];
 };
 
 
+typedef struct {
+    /* The object must be the first field. */
+    nxt_http_route_object_t        object:8;
+    uint8_t                        value;  /* 1 bit */
+} nxt_http_route_flag_t;
+
+
 typedef union {
     nxt_http_route_rule_t          *rule;
     nxt_http_route_table_t         *table;
     nxt_http_route_addr_rule_t     *addr_rule;
+    nxt_http_route_flag_t          *flag;
 } nxt_http_route_test_t;
 
 
@@ -143,8 +160,42 @@ typedef struct {
 } nxt_http_route_match_t;
 
 
+/*
+ * The route index is built when a route has matches which can be selected
+ * only by an exact "host", an exact "uri" or a "uri" prefix ending in '*'.
+ * Such matches are added to the hashes by their patterns, and the prefixes
+ * hash is looked up for all prefix lengths of the request path at once with
+ * the incremental hash.  The prefix entry keeps also the matches of all its
+ * shorter prefixes.  The found candidates are merged in the configuration
+ * order with the matches which cannot be indexed, so the first match still
+ * wins.
+ */
+
+typedef struct {
+    nxt_str_t                      key;
+    nxt_array_t                    *matches;   /* of uint32_t */
+    nxt_array_t                    *merged;    /* of uint32_t */
+} nxt_http_route_index_entry_t;
+
+
+typedef struct {
+    nxt_array_t                    *unindexed; /* of uint32_t */
+    nxt_array_t                    *lengths;   /* of uint32_t */
+    nxt_lvlhsh_t                   hosts;
+    nxt_lvlhsh_t                   uris;
+    nxt_lvlhsh_t                   prefixes;
+} nxt_http_route_index_t;
+
+
+#define NXT_HTTP_ROUTE_INDEX_LISTS    4
+#define NXT_HTTP_ROUTE_SET_MIN        8
+#define NXT_HTTP_ROUTE_REGEX_SET_MIN  2
+#define NXT_HTTP_ROUTE_ADDR_TREE_MIN  8
+
+
 struct nxt_http_route_s {
     nxt_str_t                      name;
+    nxt_http_route_index_t         *index;
     uint32_t                       items;
     nxt_http_route_match_t         *match[0];
 };
@@ -158,8 +209,24 @@ struct nxt_http_routes_s {
 
 static nxt_http_route_t *nxt_http_route_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *cv);
+static nxt_int_t nxt_http_route_latency_create(nxt_router_temp_conf_t *tmcf,
+    nxt_http_route_t *route);
 static nxt_http_route_match_t *nxt_http_route_match_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *cv);
+static nxt_int_t nxt_http_route_index_create(nxt_router_temp_conf_t *tmcf,
+    nxt_http_route_t *route);
+static nxt_http_route_rule_t *nxt_http_route_index_rule(
+    nxt_http_route_match_t *match, uintptr_t offset);
+static nxt_http_route_pattern_slice_t *nxt_http_route_index_slice(
+    nxt_http_route_pattern_t *pattern);
+static nxt_int_t nxt_http_route_index_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
+    nxt_str_t *key, uint32_t n, nxt_http_route_index_entry_t **entryp);
+static nxt_int_t nxt_http_route_index_insert(nxt_array_t *array,
+    uint32_t n);
+static nxt_array_t *nxt_http_route_index_union(nxt_mp_t *mp, nxt_array_t *one,
+    nxt_array_t *two);
+static nxt_int_t nxt_http_route_index_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
 static nxt_http_route_table_t *nxt_http_route_table_create(nxt_task_t *task,
     nxt_mp_t *mp, nxt_conf_value_t *table_cv, nxt_http_route_object_t object,
     nxt_bool_t case_sensitive, nxt_http_uri_encoding_t encoding);
@@ -173,6 +240,16 @@ static nxt_http_route_rule_t *nxt_http_route_rule_create(nxt_task_t *task,
     nxt_mp_t *mp, nxt_conf_value_t *cv, nxt_bool_t case_sensitive,
     nxt_http_route_pattern_case_t pattern_case,
     nxt_http_uri_encoding_t encoding);
+static nxt_int_t nxt_http_route_set_create(nxt_mp_t *mp,
+    nxt_http_route_rule_t *rule);
+static nxt_http_route_pattern_slice_t *nxt_http_route_set_slice(
+    nxt_http_route_pattern_t *pattern);
+#if (NXT_HAVE_REGEX)
+static nxt_int_t nxt_http_route_regex_set_create(nxt_task_t *task,
+    nxt_mp_t *mp, nxt_http_route_rule_t *rule, nxt_conf_value_t *cv,
+    nxt_bool_t negative);
+static nxt_bool_t nxt_http_route_regex_mergeable(nxt_str_t *source);
+#endif
 static int nxt_http_pattern_compare(const void *one, const void *two);
 static int nxt_http_addr_pattern_compare(const void *one, const void *two);
 static nxt_int_t nxt_http_route_pattern_create(nxt_task_t *task, nxt_mp_t *mp,
@@ -202,6 +279,14 @@ static nxt_int_t nxt_http_route_find(nxt_http_routes_t *routes, nxt_str_t *name,
 
 static nxt_http_action_t *nxt_http_route_handler(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *start);
+static nxt_http_action_t *nxt_http_route_index_match(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_route_t *route);
+static nxt_http_route_index_entry_t *nxt_http_route_index_find(
+    nxt_lvlhsh_t *hash, nxt_str_t *key);
+static nxt_http_route_index_entry_t *nxt_http_route_index_prefix(
+    nxt_http_route_index_t *index, nxt_str_t *path);
+static nxt_http_action_t *nxt_http_route_test_match(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_route_t *route, uint32_t n);
 static nxt_http_action_t *nxt_http_route_match(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_route_match_t *match);
 static nxt_int_t nxt_http_route_table(nxt_http_request_t *r,
@@ -224,8 +309,14 @@ static nxt_int_t nxt_http_route_cookies(nxt_http_request_t *r,
     nxt_http_route_rule_t *rule);
 static nxt_int_t nxt_http_route_test_cookie(nxt_http_request_t *r,
     nxt_http_route_rule_t *rule, nxt_array_t *array);
+static nxt_int_t nxt_http_route_test_set(nxt_http_request_t *r,
+    nxt_http_route_rule_t *rule, nxt_http_route_pattern_t *pattern,
+    u_char *start, size_t length);
 static nxt_int_t nxt_http_route_pattern(nxt_http_request_t *r,
     nxt_http_route_pattern_t *pattern, u_char *start, size_t length);
+#if (NXT_HAVE_REGEX)
+static nxt_regex_match_t *nxt_http_route_regex_match(nxt_http_request_t *r);
+#endif
 static nxt_int_t nxt_http_route_memcmp(u_char *start, u_char *test,
     size_t length, nxt_bool_t case_sensitive);
 
@@ -273,6 +364,12 @@ nxt_http_routes_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             if (nxt_slow_path(string == NULL)) {
                 return NULL;
             }
+
+            if (nxt_slow_path(nxt_http_route_latency_create(tmcf, route)
+                              != NXT_OK))
+            {
+                return NULL;
+            }
         }
 
     } else {
@@ -285,12 +382,65 @@ nxt_http_routes_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
         route->name.length = 0;
         route->name.start = NULL;
+
+        if (nxt_slow_path(nxt_http_route_latency_create(tmcf, route)
+                          != NXT_OK))
+        {
+            return NULL;
+        }
     }
 
     return routes;
 }
 
 
+/*
+ * Each route step action counts latencies of the requests it has matched,
+ * the latency name is the route name which is empty for the routes array.
+ */
+
+static nxt_int_t
+nxt_http_route_latency_create(nxt_router_temp_conf_t *tmcf,
+    nxt_http_route_t *route)
+{
+    uint32_t              i;
+    nxt_router_conf_t     *rtcf;
+    nxt_status_latency_t  *latency, **lp;
+
+    rtcf = tmcf->router_conf;
+
+    if (rtcf->latencies == NULL) {
+        rtcf->latencies = nxt_array_create(rtcf->mem_pool, 4,
+                                           sizeof(nxt_status_latency_t *));
+        if (nxt_slow_path(rtcf->latencies == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    for (i = 0; i < route->items; i++) {
+        latency = nxt_status_latency_create(rtcf->mem_pool, rtcf->threads,
+                                            NXT_STATUS_LATENCY_QUEUE);
+        if (nxt_slow_path(latency == NULL)) {
+            return NXT_ERROR;
+        }
+
+        latency->name = route->name;
+        latency->step = i;
+
+        lp = nxt_array_add(rtcf->latencies);
+        if (nxt_slow_path(lp == NULL)) {
+            return NXT_ERROR;
+        }
+
+        *lp = latency;
+
+        route->match[i]->action.latency = latency;
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_conf_map_t  nxt_http_route_match_conf[] = {
     {
         nxt_string("scheme"),
@@ -350,6 +500,12 @@ static nxt_conf_map_t  nxt_http_route_match_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_route_match_conf_t, destination),
     },
+
+    {
+        nxt_string("tls_early_data"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_route_match_conf_t, tls_early_data),
+    },
 };
 
 
@@ -385,208 +541,610 @@ nxt_http_route_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         *m++ = match;
     }
 
+    if (nxt_slow_path(nxt_http_route_index_create(tmcf, route) != NXT_OK)) {
+        return NULL;
+    }
+
     return route;
 }
 
 
-static nxt_http_route_match_t *
-nxt_http_route_match_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
-    nxt_conf_value_t *cv)
-{
-    size_t                       size;
-    uint32_t                     n;
-    nxt_mp_t                     *mp;
-    nxt_int_t                    ret;
-    nxt_conf_value_t             *match_conf, *action_conf;
-    nxt_http_route_test_t        *test;
-    nxt_http_route_rule_t        *rule;
-    nxt_http_route_table_t       *table;
-    nxt_http_route_match_t       *match;
-    nxt_http_route_addr_rule_t   *addr_rule;
-    nxt_http_route_match_conf_t  mtcf;
+static const nxt_lvlhsh_proto_t  nxt_http_route_index_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_route_index_test,
+    nxt_mp_lvlhsh_alloc,
+    nxt_mp_lvlhsh_free,
+};
 
-    static nxt_str_t  match_path = nxt_string("/match");
-    static nxt_str_t  action_path = nxt_string("/action");
 
-    match_conf = nxt_conf_get_path(cv, &match_path);
+static nxt_int_t
+nxt_http_route_index_create(nxt_router_temp_conf_t *tmcf,
+    nxt_http_route_t *route)
+{
+    uint32_t                        i, j, *length, *end;
+    nxt_mp_t                        *mp;
+    nxt_int_t                       ret;
+    nxt_str_t                       key;
+    nxt_bool_t                      indexed;
+    nxt_array_t                     *prefixes, *merged;
+    nxt_lvlhsh_t                    *hash;
+    nxt_http_route_rule_t           *rule;
+    nxt_http_route_index_t          *index;
+    nxt_http_route_pattern_slice_t  *slice;
+    nxt_http_route_index_entry_t    *entry, *prefix, **e;
 
-    n = (match_conf != NULL) ? nxt_conf_object_members_count(match_conf) : 0;
-    size = sizeof(nxt_http_route_match_t) + n * sizeof(nxt_http_route_test_t *);
+    route->index = NULL;
 
     mp = tmcf->router_conf->mem_pool;
 
-    match = nxt_mp_alloc(mp, size);
-    if (nxt_slow_path(match == NULL)) {
-        return NULL;
+    index = nxt_mp_zget(mp, sizeof(nxt_http_route_index_t));
+    if (nxt_slow_path(index == NULL)) {
+        return NXT_ERROR;
     }
 
-    match->items = n;
-
-    action_conf = nxt_conf_get_path(cv, &action_path);
-    if (nxt_slow_path(action_conf == NULL)) {
-        return NULL;
+    index->unindexed = nxt_array_create(mp, 4, sizeof(uint32_t));
+    if (nxt_slow_path(index->unindexed == NULL)) {
+        return NXT_ERROR;
     }
 
-    ret = nxt_http_action_init(task, tmcf, action_conf, &match->action);
-    if (nxt_slow_path(ret != NXT_OK)) {
-        return NULL;
+    index->lengths = nxt_array_create(mp, 4, sizeof(uint32_t));
+    if (nxt_slow_path(index->lengths == NULL)) {
+        return NXT_ERROR;
     }
 
-    if (n == 0) {
-        return match;
+    prefixes = nxt_array_create(tmcf->mem_pool, 4,
+                                sizeof(nxt_http_route_index_entry_t *));
+    if (nxt_slow_path(prefixes == NULL)) {
+        return NXT_ERROR;
     }
 
-    nxt_memzero(&mtcf, sizeof(mtcf));
+    indexed = 0;
 
-    ret = nxt_conf_map_object(tmcf->mem_pool,
-                              match_conf, nxt_http_route_match_conf,
-                              nxt_nitems(nxt_http_route_match_conf), &mtcf);
-    if (ret != NXT_OK) {
-        return NULL;
-    }
+    for (i = 0; i < route->items; i++) {
+        rule = nxt_http_route_index_rule(route->match[i],
+                                         offsetof(nxt_http_request_t, host));
 
-    test = &match->test[0];
+        if (rule != NULL) {
+            for (j = 0; j < rule->items; j++) {
+                slice = nxt_http_route_index_slice(&rule->pattern[j]);
 
-    if (mtcf.scheme != NULL) {
-        rule = nxt_http_route_rule_create(task, mp, mtcf.scheme, 1,
-                                          NXT_HTTP_ROUTE_PATTERN_NOCASE,
-                                          NXT_HTTP_URI_ENCODING_NONE);
-        if (rule == NULL) {
-            return NULL;
+                if (slice->type != NXT_HTTP_ROUTE_PATTERN_EXACT) {
+                    break;
+                }
+            }
+
+            if (j < rule->items) {
+                rule = NULL;
+            }
         }
 
-        rule->object = NXT_HTTP_ROUTE_SCHEME;
-        test->rule = rule;
-        test++;
-    }
+        if (rule != NULL) {
+            hash = &index->hosts;
 
-    if (mtcf.host != NULL) {
-        rule = nxt_http_route_rule_create(task, mp, mtcf.host, 1,
-                                          NXT_HTTP_ROUTE_PATTERN_LOWCASE,
-                                          NXT_HTTP_URI_ENCODING_NONE);
-        if (rule == NULL) {
-            return NULL;
+        } else {
+            rule = nxt_http_route_index_rule(route->match[i],
+                                             offsetof(nxt_http_request_t,
+                                                      path));
+            hash = NULL;
         }
 
-        rule->u.offset = offsetof(nxt_http_request_t, host);
-        rule->object = NXT_HTTP_ROUTE_STRING;
-        test->rule = rule;
-        test++;
-    }
-
-    if (mtcf.uri != NULL) {
-        rule = nxt_http_route_rule_create(task, mp, mtcf.uri, 1,
-                                          NXT_HTTP_ROUTE_PATTERN_NOCASE,
-                                          NXT_HTTP_URI_ENCODING);
         if (rule == NULL) {
-            return NULL;
+            ret = nxt_http_route_index_insert(index->unindexed, i);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            continue;
         }
 
-        rule->u.offset = offsetof(nxt_http_request_t, path);
-        rule->object = NXT_HTTP_ROUTE_STRING_PTR;
-        test->rule = rule;
-        test++;
-    }
+        for (j = 0; j < rule->items; j++) {
+            slice = nxt_http_route_index_slice(&rule->pattern[j]);
 
-    if (mtcf.method != NULL) {
-        rule = nxt_http_route_rule_create(task, mp, mtcf.method, 1,
-                                          NXT_HTTP_ROUTE_PATTERN_UPCASE,
-                                          NXT_HTTP_URI_ENCODING_NONE);
-        if (rule == NULL) {
-            return NULL;
-        }
+            key.start = slice->start;
+            key.length = slice->length;
 
-        rule->u.offset = offsetof(nxt_http_request_t, method);
-        rule->object = NXT_HTTP_ROUTE_STRING_PTR;
-        test->rule = rule;
-        test++;
-    }
+            if (hash != NULL) {
+                ret = nxt_http_route_index_add(mp, hash, &key, i, NULL);
 
-    if (mtcf.headers != NULL) {
-        table = nxt_http_route_table_create(task, mp, mtcf.headers,
-                                            NXT_HTTP_ROUTE_HEADER, 0,
-                                            NXT_HTTP_URI_ENCODING_NONE);
-        if (table == NULL) {
-            return NULL;
-        }
+            } else if (slice->type == NXT_HTTP_ROUTE_PATTERN_EXACT) {
+                ret = nxt_http_route_index_add(mp, &index->uris, &key, i,
+                                               NULL);
 
-        test->table = table;
-        test++;
-    }
+            } else {
+                entry = NULL;
 
-    if (mtcf.arguments != NULL) {
-        table = nxt_http_route_table_create(task, mp, mtcf.arguments,
-                                            NXT_HTTP_ROUTE_ARGUMENT, 1,
-                                            NXT_HTTP_URI_ENCODING_PLUS);
-        if (table == NULL) {
-            return NULL;
-        }
+                ret = nxt_http_route_index_add(mp, &index->prefixes, &key, i,
+                                               &entry);
 
-        test->table = table;
-        test++;
-    }
+                if (ret == NXT_OK && entry != NULL) {
+                    e = nxt_array_add(prefixes);
+                    if (nxt_slow_path(e == NULL)) {
+                        return NXT_ERROR;
+                    }
 
-    if (mtcf.cookies != NULL) {
-        table = nxt_http_route_table_create(task, mp, mtcf.cookies,
-                                            NXT_HTTP_ROUTE_COOKIE, 1,
-                                            NXT_HTTP_URI_ENCODING_NONE);
-        if (table == NULL) {
-            return NULL;
-        }
+                    *e = entry;
 
-        test->table = table;
-        test++;
-    }
+                    ret = nxt_http_route_index_insert(index->lengths,
+                                                          key.length);
+                }
+            }
 
-    if (mtcf.query != NULL) {
-        rule = nxt_http_route_rule_create(task, mp, mtcf.query, 1,
-                                          NXT_HTTP_ROUTE_PATTERN_NOCASE,
-                                          NXT_HTTP_URI_ENCODING_PLUS);
-        if (rule == NULL) {
-            return NULL;
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
         }
 
-        rule->object = NXT_HTTP_ROUTE_QUERY;
-        test->rule = rule;
-        test++;
+        indexed = 1;
     }
 
-    if (mtcf.source != NULL) {
-        addr_rule = nxt_http_route_addr_rule_create(task, mp, mtcf.source);
-        if (addr_rule == NULL) {
-            return NULL;
-        }
-
-        addr_rule->object = NXT_HTTP_ROUTE_SOURCE;
-        test->addr_rule = addr_rule;
-        test++;
+    if (!indexed) {
+        return NXT_OK;
     }
 
-    if (mtcf.destination != NULL) {
-        addr_rule = nxt_http_route_addr_rule_create(task, mp, mtcf.destination);
-        if (addr_rule == NULL) {
-            return NULL;
+    e = prefixes->elts;
+
+    for (i = 0; i < prefixes->nelts; i++) {
+        entry = e[i];
+        merged = entry->matches;
+
+        length = index->lengths->elts;
+        end = length + index->lengths->nelts;
+
+        while (length < end && *length < entry->key.length) {
+            key.start = entry->key.start;
+            key.length = *length;
+
+            prefix = nxt_http_route_index_find(&index->prefixes, &key);
+
+            if (prefix != NULL) {
+                merged = nxt_http_route_index_union(mp, merged,
+                                                    prefix->matches);
+                if (nxt_slow_path(merged == NULL)) {
+                    return NXT_ERROR;
+                }
+            }
+
+            length++;
         }
 
-        addr_rule->object = NXT_HTTP_ROUTE_DESTINATION;
-        test->addr_rule = addr_rule;
-        test++;
+        entry->merged = merged;
     }
 
-    return match;
+    route->index = index;
+
+    return NXT_OK;
 }
 
 
-static nxt_conf_map_t  nxt_http_route_action_conf[] = {
-    {
-        nxt_string("rewrite"),
-        NXT_CONF_MAP_PTR,
-        offsetof(nxt_http_action_conf_t, rewrite)
-    },
-    {
-        nxt_string("response_headers"),
-        NXT_CONF_MAP_PTR,
-        offsetof(nxt_http_action_conf_t, set_headers)
+/*
+ * Returns the "host" or "uri" rule of the match if it has patterns and all
+ * of them are positive and consist of a single exact or prefix slice.
+ */
+
+static nxt_http_route_rule_t *
+nxt_http_route_index_rule(nxt_http_route_match_t *match, uintptr_t offset)
+{
+    uint32_t               i, j;
+    nxt_http_route_rule_t  *rule;
+
+    for (i = 0; i < match->items; i++) {
+        rule = match->test[i].rule;
+
+        if ((rule->object == NXT_HTTP_ROUTE_STRING
+             || rule->object == NXT_HTTP_ROUTE_STRING_PTR)
+            && rule->u.offset == offset)
+        {
+            if (rule->items == 0) {
+                return NULL;
+            }
+
+            for (j = 0; j < rule->items; j++) {
+                if (nxt_http_route_index_slice(&rule->pattern[j]) == NULL) {
+                    return NULL;
+                }
+            }
+
+            return rule;
+        }
+    }
+
+    return NULL;
+}
+
+
+static nxt_http_route_pattern_slice_t *
+nxt_http_route_index_slice(nxt_http_route_pattern_t *pattern)
+{
+    nxt_http_route_pattern_slice_t  *slice;
+
+    if (pattern->negative || !pattern->case_sensitive) {
+        return NULL;
+    }
+
+#if (NXT_HAVE_REGEX)
+    if (pattern->regex) {
+        return NULL;
+    }
+#endif
+
+    if (pattern->u.pattern_slices->nelts != 1) {
+        return NULL;
+    }
+
+    slice = pattern->u.pattern_slices->elts;
+
+    if (slice->type == NXT_HTTP_ROUTE_PATTERN_EXACT
+        || slice->type == NXT_HTTP_ROUTE_PATTERN_BEGIN)
+    {
+        return slice;
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Adds the match number to the entry of the key.  The matches are added
+ * in the ascending order, so the entry lists remain sorted.  A new entry
+ * is returned in "entryp".
+ */
+
+static nxt_int_t
+nxt_http_route_index_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash, nxt_str_t *key,
+    uint32_t n, nxt_http_route_index_entry_t **entryp)
+{
+    nxt_int_t                     ret;
+    nxt_lvlhsh_query_t            lhq;
+    nxt_http_route_index_entry_t  *entry;
+
+    entry = nxt_http_route_index_find(hash, key);
+
+    if (entry == NULL) {
+        entry = nxt_mp_zget(mp, sizeof(nxt_http_route_index_entry_t));
+        if (nxt_slow_path(entry == NULL)) {
+            return NXT_ERROR;
+        }
+
+        entry->key = *key;
+
+        entry->matches = nxt_array_create(mp, 1, sizeof(uint32_t));
+        if (nxt_slow_path(entry->matches == NULL)) {
+            return NXT_ERROR;
+        }
+
+        entry->merged = entry->matches;
+
+        lhq.key_hash = nxt_djb_hash(key->start, key->length);
+        lhq.key = *key;
+        lhq.replace = 0;
+        lhq.value = entry;
+        lhq.proto = &nxt_http_route_index_proto;
+        lhq.pool = mp;
+
+        ret = nxt_lvlhsh_insert(hash, &lhq);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        if (entryp != NULL) {
+            *entryp = entry;
+        }
+    }
+
+    return nxt_http_route_index_insert(entry->matches, n);
+}
+
+
+/* Inserts a number into the sorted array unless it is already present. */
+
+static nxt_int_t
+nxt_http_route_index_insert(nxt_array_t *array, uint32_t n)
+{
+    uint32_t  i, *p;
+
+    p = array->elts;
+
+    for (i = array->nelts; i > 0; i--) {
+        if (p[i - 1] == n) {
+            return NXT_OK;
+        }
+
+        if (p[i - 1] < n) {
+            break;
+        }
+    }
+
+    if (nxt_slow_path(nxt_array_add(array) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = array->elts;
+
+    nxt_memmove(&p[i + 1], &p[i], (array->nelts - 1 - i) * sizeof(uint32_t));
+    p[i] = n;
+
+    return NXT_OK;
+}
+
+
+static nxt_array_t *
+nxt_http_route_index_union(nxt_mp_t *mp, nxt_array_t *one, nxt_array_t *two)
+{
+    uint32_t     *p1, *end1, *p2, *end2, *p;
+    nxt_array_t  *array;
+
+    array = nxt_array_create(mp, one->nelts + two->nelts, sizeof(uint32_t));
+    if (nxt_slow_path(array == NULL)) {
+        return NULL;
+    }
+
+    p1 = one->elts;
+    end1 = p1 + one->nelts;
+    p2 = two->elts;
+    end2 = p2 + two->nelts;
+
+    p = array->elts;
+
+    while (p1 < end1 || p2 < end2) {
+        if (p2 == end2 || (p1 < end1 && *p1 < *p2)) {
+            *p++ = *p1++;
+
+        } else if (p1 == end1 || *p2 < *p1) {
+            *p++ = *p2++;
+
+        } else {
+            *p++ = *p1++;
+            p2++;
+        }
+    }
+
+    array->nelts = p - (uint32_t *) array->elts;
+
+    return array;
+}
+
+
+static nxt_int_t
+nxt_http_route_index_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_route_index_entry_t  *entry;
+
+    entry = data;
+
+    if (nxt_strstr_eq(&lhq->key, &entry->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static nxt_http_route_match_t *
+nxt_http_route_match_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *cv)
+{
+    size_t                       size;
+    uint32_t                     n;
+    nxt_mp_t                     *mp;
+    nxt_int_t                    ret;
+    nxt_conf_value_t             *match_conf, *action_conf;
+    nxt_http_route_test_t        *test;
+    nxt_http_route_rule_t        *rule;
+    nxt_http_route_table_t       *table;
+    nxt_http_route_match_t       *match;
+    nxt_http_route_flag_t        *flag;
+    nxt_http_route_addr_rule_t   *addr_rule;
+    nxt_http_route_match_conf_t  mtcf;
+
+    static nxt_str_t  match_path = nxt_string("/match");
+    static nxt_str_t  action_path = nxt_string("/action");
+
+    match_conf = nxt_conf_get_path(cv, &match_path);
+
+    n = (match_conf != NULL) ? nxt_conf_object_members_count(match_conf) : 0;
+    size = sizeof(nxt_http_route_match_t) + n * sizeof(nxt_http_route_test_t *);
+
+    mp = tmcf->router_conf->mem_pool;
+
+    match = nxt_mp_alloc(mp, size);
+    if (nxt_slow_path(match == NULL)) {
+        return NULL;
+    }
+
+    match->items = n;
+
+    action_conf = nxt_conf_get_path(cv, &action_path);
+    if (nxt_slow_path(action_conf == NULL)) {
+        return NULL;
+    }
+
+    ret = nxt_http_action_init(task, tmcf, action_conf, &match->action);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    if (n == 0) {
+        return match;
+    }
+
+    nxt_memzero(&mtcf, sizeof(mtcf));
+
+    ret = nxt_conf_map_object(tmcf->mem_pool,
+                              match_conf, nxt_http_route_match_conf,
+                              nxt_nitems(nxt_http_route_match_conf), &mtcf);
+    if (ret != NXT_OK) {
+        return NULL;
+    }
+
+    test = &match->test[0];
+
+    if (mtcf.scheme != NULL) {
+        rule = nxt_http_route_rule_create(task, mp, mtcf.scheme, 1,
+                                          NXT_HTTP_ROUTE_PATTERN_NOCASE,
+                                          NXT_HTTP_URI_ENCODING_NONE);
+        if (rule == NULL) {
+            return NULL;
+        }
+
+        rule->object = NXT_HTTP_ROUTE_SCHEME;
+        test->rule = rule;
+        test++;
+    }
+
+    if (mtcf.host != NULL) {
+        rule = nxt_http_route_rule_create(task, mp, mtcf.host, 1,
+                                          NXT_HTTP_ROUTE_PATTERN_LOWCASE,
+                                          NXT_HTTP_URI_ENCODING_NONE);
+        if (rule == NULL) {
+            return NULL;
+        }
+
+        rule->u.offset = offsetof(nxt_http_request_t, host);
+        rule->object = NXT_HTTP_ROUTE_STRING;
+        test->rule = rule;
+        test++;
+    }
+
+    if (mtcf.uri != NULL) {
+        rule = nxt_http_route_rule_create(task, mp, mtcf.uri, 1,
+                                          NXT_HTTP_ROUTE_PATTERN_NOCASE,
+                                          NXT_HTTP_URI_ENCODING);
+        if (rule == NULL) {
+            return NULL;
+        }
+
+        rule->u.offset = offsetof(nxt_http_request_t, path);
+        rule->object = NXT_HTTP_ROUTE_STRING_PTR;
+        test->rule = rule;
+        test++;
+    }
+
+    if (mtcf.method != NULL) {
+        rule = nxt_http_route_rule_create(task, mp, mtcf.method, 1,
+                                          NXT_HTTP_ROUTE_PATTERN_UPCASE,
+                                          NXT_HTTP_URI_ENCODING_NONE);
+        if (rule == NULL) {
+            return NULL;
+        }
+
+        rule->u.offset = offsetof(nxt_http_request_t, method);
+        rule->object = NXT_HTTP_ROUTE_STRING_PTR;
+        test->rule = rule;
+        test++;
+    }
+
+    if (mtcf.headers != NULL) {
+        table = nxt_http_route_table_create(task, mp, mtcf.headers,
+                                            NXT_HTTP_ROUTE_HEADER, 0,
+                                            NXT_HTTP_URI_ENCODING_NONE);
+        if (table == NULL) {
+            return NULL;
+        }
+
+        test->table = table;
+        test++;
+    }
+
+    if (mtcf.arguments != NULL) {
+        table = nxt_http_route_table_create(task, mp, mtcf.arguments,
+                                            NXT_HTTP_ROUTE_ARGUMENT, 1,
+                                            NXT_HTTP_URI_ENCODING_PLUS);
+        if (table == NULL) {
+            return NULL;
+        }
+
+        test->table = table;
+        test++;
+    }
+
+    if (mtcf.cookies != NULL) {
+        table = nxt_http_route_table_create(task, mp, mtcf.cookies,
+                                            NXT_HTTP_ROUTE_COOKIE, 1,
+                                            NXT_HTTP_URI_ENCODING_NONE);
+        if (table == NULL) {
+            return NULL;
+        }
+
+        test->table = table;
+        test++;
+    }
+
+    if (mtcf.query != NULL) {
+        rule = nxt_http_route_rule_create(task, mp, mtcf.query, 1,
+                                          NXT_HTTP_ROUTE_PATTERN_NOCASE,
+                                          NXT_HTTP_URI_ENCODING_PLUS);
+        if (rule == NULL) {
+            return NULL;
+        }
+
+        rule->object = NXT_HTTP_ROUTE_QUERY;
+        test->rule = rule;
+        test++;
+    }
+
+    if (mtcf.source != NULL) {
+        addr_rule = nxt_http_route_addr_rule_create(task, mp, mtcf.source);
+        if (addr_rule == NULL) {
+            return NULL;
+        }
+
+        addr_rule->object = NXT_HTTP_ROUTE_SOURCE;
+        test->addr_rule = addr_rule;
+        test++;
+    }
+
+    if (mtcf.destination != NULL) {
+        addr_rule = nxt_http_route_addr_rule_create(task, mp, mtcf.destination);
+        if (addr_rule == NULL) {
+            return NULL;
+        }
+
+        addr_rule->object = NXT_HTTP_ROUTE_DESTINATION;
+        test->addr_rule = addr_rule;
+        test++;
+    }
+
+    if (mtcf.tls_early_data != NULL) {
+        flag = nxt_mp_alloc(mp, sizeof(nxt_http_route_flag_t));
+        if (nxt_slow_path(flag == NULL)) {
+            return NULL;
+        }
+
+        flag->object = NXT_HTTP_ROUTE_TLS_EARLY_DATA;
+        flag->value = nxt_conf_get_boolean(mtcf.tls_early_data);
+        test->flag = flag;
+        test++;
+    }
+
+    return match;
+}
+
+
+static nxt_conf_map_t  nxt_http_route_action_conf[] = {
+    {
+        nxt_string("rewrite"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, rewrite)
+    },
+    {
+        nxt_string("response_headers"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, set_headers)
+    },
+    {
+        nxt_string("compress"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, compress)
+    },
+    {
+        nxt_string("cache"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, cache)
+    },
+    {
+        nxt_string("access_log"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, access_log)
     },
     {
         nxt_string("pass"),
@@ -638,6 +1196,16 @@ static nxt_conf_map_t  nxt_http_route_action_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_action_conf_t, types)
     },
+    {
+        nxt_string("precompressed"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, precompressed)
+    },
+    {
+        nxt_string("open_file_cache"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, open_file_cache)
+    },
     {
         nxt_string("fallback"),
         NXT_CONF_MAP_PTR,
@@ -683,6 +1251,28 @@ nxt_http_action_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         }
     }
 
+    if (acf.compress != NULL) {
+        ret = nxt_http_compress_init(task, rtcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (acf.cache != NULL) {
+        ret = nxt_http_cache_init(task, rtcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (acf.access_log != NULL) {
+        action->log_filter = nxt_router_access_log_filter_create(task, mp,
+                                                               acf.access_log);
+        if (nxt_slow_path(action->log_filter == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
     if (acf.ret != NULL) {
         return nxt_http_return_init(rtcf, action, &acf);
     }
@@ -757,109 +1347,375 @@ nxt_http_route_ruleset_create(nxt_task_t *task, nxt_mp_t *mp,
     nxt_http_route_rule_t     *rule;
     nxt_http_route_ruleset_t  *ruleset;
 
-    n = nxt_conf_object_members_count(ruleset_cv);
-    size = sizeof(nxt_http_route_ruleset_t)
-           + n * sizeof(nxt_http_route_rule_t *);
+    n = nxt_conf_object_members_count(ruleset_cv);
+    size = sizeof(nxt_http_route_ruleset_t)
+           + n * sizeof(nxt_http_route_rule_t *);
+
+    ruleset = nxt_mp_alloc(mp, size);
+    if (nxt_slow_path(ruleset == NULL)) {
+        return NULL;
+    }
+
+    ruleset->items = n;
+
+    next = 0;
+
+    /*
+     * A workaround for GCC 10 with -flto -O2 flags that warns about "name"
+     * may be uninitialized in nxt_http_route_rule_name_create().
+     */
+    nxt_str_null(&name);
+
+    for (i = 0; i < n; i++) {
+        rule_cv = nxt_conf_next_object_member(ruleset_cv, &name, &next);
+
+        rule = nxt_http_route_rule_name_create(task, mp, rule_cv, &name,
+                                               case_sensitive, encoding);
+        if (nxt_slow_path(rule == NULL)) {
+            return NULL;
+        }
+
+        rule->object = object;
+        ruleset->rule[i] = rule;
+    }
+
+    return ruleset;
+}
+
+
+static nxt_http_route_rule_t *
+nxt_http_route_rule_name_create(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *rule_cv, nxt_str_t *name, nxt_bool_t case_sensitive,
+    nxt_http_uri_encoding_t encoding)
+{
+    int64_t                hash;
+    nxt_http_route_rule_t  *rule;
+
+    rule = nxt_http_route_rule_create(task, mp, rule_cv, case_sensitive,
+                                      NXT_HTTP_ROUTE_PATTERN_NOCASE,
+                                      encoding);
+    if (nxt_slow_path(rule == NULL)) {
+        return NULL;
+    }
+
+    hash = nxt_http_field_hash(mp, name, case_sensitive, encoding);
+    if (nxt_slow_path(hash == -1)) {
+        return NULL;
+    }
+
+    rule->u.name.hash = hash;
+    rule->u.name.start = name->start;
+    rule->u.name.length = name->length;
+
+    return rule;
+}
+
+
+static nxt_http_route_rule_t *
+nxt_http_route_rule_create(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *cv, nxt_bool_t case_sensitive,
+    nxt_http_route_pattern_case_t pattern_case,
+    nxt_http_uri_encoding_t encoding)
+{
+    size_t                    size;
+    uint32_t                  i, n;
+    nxt_int_t                 ret;
+    nxt_conf_value_t          *value;
+    nxt_http_route_rule_t     *rule;
+    nxt_http_route_pattern_t  *pattern;
+
+    n = nxt_conf_array_elements_count_or_1(cv);
+    size = sizeof(nxt_http_route_rule_t) + n * sizeof(nxt_http_route_pattern_t);
+
+    rule = nxt_mp_alloc(mp, size);
+    if (nxt_slow_path(rule == NULL)) {
+        return NULL;
+    }
+
+    rule->items = n;
+
+    pattern = &rule->pattern[0];
+
+    nxt_conf_array_qsort(cv, nxt_http_pattern_compare);
+
+    for (i = 0; i < n; i++) {
+        pattern[i].case_sensitive = case_sensitive;
+        value = nxt_conf_get_array_element_or_itself(cv, i);
+
+        ret = nxt_http_route_pattern_create(task, mp, value, &pattern[i],
+                                            pattern_case, encoding);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+    }
+
+    rule->set = NULL;
+
+    if (n >= NXT_HTTP_ROUTE_SET_MIN) {
+        ret = nxt_http_route_set_create(mp, rule);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+    }
+
+#if (NXT_HAVE_REGEX)
+    rule->regex[0] = NULL;
+    rule->regex[1] = NULL;
+
+    if (n >= NXT_HTTP_ROUTE_REGEX_SET_MIN) {
+        for (i = 0; i < 2; i++) {
+            ret = nxt_http_route_regex_set_create(task, mp, rule, cv, i);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NULL;
+            }
+        }
+    }
+#endif
+
+    return rule;
+}
+
+
+/*
+ * Many positive patterns consisting of a single exact, prefix, suffix,
+ * or substring slice are compiled into the Aho-Corasick automaton which
+ * tests all of them in a single pass over the string.
+ */
+
+static nxt_int_t
+nxt_http_route_set_create(nxt_mp_t *mp, nxt_http_route_rule_t *rule)
+{
+    uint32_t                        i, n;
+    nxt_int_t                       ret;
+    nxt_uint_t                      anchor;
+    nxt_aho_corasick_t              *ac;
+    nxt_http_route_pattern_t        *pattern;
+    nxt_http_route_pattern_slice_t  *slice;
+
+    pattern = &rule->pattern[0];
+    n = 0;
+
+    for (i = 0; i < rule->items; i++) {
+        if (nxt_http_route_set_slice(&pattern[i]) != NULL) {
+            n++;
+        }
+    }
+
+    if (n < NXT_HTTP_ROUTE_SET_MIN) {
+        return NXT_OK;
+    }
+
+    ac = nxt_aho_corasick_create(mp, !pattern[0].case_sensitive);
+    if (nxt_slow_path(ac == NULL)) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < rule->items; i++) {
+        slice = nxt_http_route_set_slice(&pattern[i]);
+        if (slice == NULL) {
+            continue;
+        }
+
+        switch (slice->type) {
+
+        case NXT_HTTP_ROUTE_PATTERN_EXACT:
+            anchor = NXT_AHO_CORASICK_BEGIN | NXT_AHO_CORASICK_END;
+            break;
+
+        case NXT_HTTP_ROUTE_PATTERN_BEGIN:
+            anchor = NXT_AHO_CORASICK_BEGIN;
+            break;
+
+        case NXT_HTTP_ROUTE_PATTERN_END:
+            anchor = NXT_AHO_CORASICK_END;
+            break;
+
+        default: /* NXT_HTTP_ROUTE_PATTERN_SUBSTRING */
+            anchor = 0;
+            break;
+        }
+
+        ret = nxt_aho_corasick_add(ac, slice->start, slice->length, anchor);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        pattern[i].set = 1;
+    }
+
+    if (nxt_slow_path(nxt_aho_corasick_compile(ac) != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    rule->set = ac;
+
+    return NXT_OK;
+}
+
+
+#if (NXT_HAVE_REGEX)
+
+/*
+ * Regex patterns of the same sign are compiled into a single alternation
+ * which tests all of them in a single match.  The patterns which cannot
+ * be merged or the set which fails to compile are matched separately.
+ */
+
+static nxt_int_t
+nxt_http_route_regex_set_create(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_http_route_rule_t *rule, nxt_conf_value_t *cv, nxt_bool_t negative)
+{
+    uint32_t                  i, n;
+    nxt_str_t                 *sources;
+    nxt_regex_t               *re;
+    nxt_regex_err_t           err;
+    nxt_conf_value_t          *value;
+    nxt_http_route_pattern_t  *pattern;
+
+    sources = nxt_mp_alloc(mp, rule->items * sizeof(nxt_str_t));
+    if (nxt_slow_path(sources == NULL)) {
+        return NXT_ERROR;
+    }
+
+    pattern = &rule->pattern[0];
+    n = 0;
+
+    for (i = 0; i < rule->items; i++) {
+        if (!pattern[i].regex || pattern[i].negative != negative) {
+            continue;
+        }
+
+        value = nxt_conf_get_array_element(cv, i);
+        nxt_conf_get_string(value, &sources[n]);
+
+        /* Skip "!" and "~". */
+        sources[n].start += 1 + negative;
+        sources[n].length -= 1 + negative;
+
+        if (nxt_http_route_regex_mergeable(&sources[n])) {
+            pattern[i].set = 1;
+            n++;
+        }
+    }
+
+    re = NULL;
+
+    if (n >= NXT_HTTP_ROUTE_REGEX_SET_MIN) {
+        re = nxt_regex_compile_set(mp, sources, n, &err);
+
+        if (re == NULL) {
+            nxt_debug(task, "nxt_regex_compile_set(%uD) failed: %s",
+                      n, err.msg);
+        }
+    }
+
+    nxt_mp_free(mp, sources);
+
+    if (re == NULL) {
+        for (i = 0; i < rule->items; i++) {
+            if (pattern[i].regex && pattern[i].negative == negative) {
+                pattern[i].set = 0;
+            }
+        }
+
+        return NXT_OK;
+    }
+
+    rule->regex[negative] = re;
+
+    return NXT_OK;
+}
+
+
+/*
+ * A regex can be merged if it does not depend on the group numbers,
+ * which are shifted in the alternation, and does not use backtracking
+ * control verbs, option settings, or quoting, which could affect the
+ * other alternatives.  The check is conservative and ignores the context.
+ */
+
+static nxt_bool_t
+nxt_http_route_regex_mergeable(nxt_str_t *source)
+{
+    u_char  c, *p, *end;
+
+    p = source->start;
+    end = p + source->length;
+
+    while (p < end) {
+        c = *p++;
+
+        if (c == '\\') {
+            if (p == end) {
+                return 0;
+            }
+
+            c = *p++;
+
+            if ((c >= '0' && c <= '9') || c == 'g' || c == 'k' || c == 'Q') {
+                return 0;
+            }
+
+            continue;
+        }
+
+        if (c != '(' || p == end) {
+            continue;
+        }
 
-    ruleset = nxt_mp_alloc(mp, size);
-    if (nxt_slow_path(ruleset == NULL)) {
-        return NULL;
-    }
+        if (*p == '*') {
+            return 0;
+        }
 
-    ruleset->items = n;
+        if (*p != '?') {
+            continue;
+        }
 
-    next = 0;
+        if (end - p < 2) {
+            return 0;
+        }
 
-    /*
-     * A workaround for GCC 10 with -flto -O2 flags that warns about "name"
-     * may be uninitialized in nxt_http_route_rule_name_create().
-     */
-    nxt_str_null(&name);
+        c = p[1];
 
-    for (i = 0; i < n; i++) {
-        rule_cv = nxt_conf_next_object_member(ruleset_cv, &name, &next);
+        if (c == ':' || c == '=' || c == '!' || c == '>') {
+            continue;
+        }
 
-        rule = nxt_http_route_rule_name_create(task, mp, rule_cv, &name,
-                                               case_sensitive, encoding);
-        if (nxt_slow_path(rule == NULL)) {
-            return NULL;
+        if (c == '<' && end - p > 2 && (p[2] == '=' || p[2] == '!')) {
+            continue;
         }
 
-        rule->object = object;
-        ruleset->rule[i] = rule;
+        return 0;
     }
 
-    return ruleset;
+    return 1;
 }
 
+#endif
 
-static nxt_http_route_rule_t *
-nxt_http_route_rule_name_create(nxt_task_t *task, nxt_mp_t *mp,
-    nxt_conf_value_t *rule_cv, nxt_str_t *name, nxt_bool_t case_sensitive,
-    nxt_http_uri_encoding_t encoding)
+
+static nxt_http_route_pattern_slice_t *
+nxt_http_route_set_slice(nxt_http_route_pattern_t *pattern)
 {
-    int64_t                hash;
-    nxt_http_route_rule_t  *rule;
+    nxt_http_route_pattern_slice_t  *slice;
 
-    rule = nxt_http_route_rule_create(task, mp, rule_cv, case_sensitive,
-                                      NXT_HTTP_ROUTE_PATTERN_NOCASE,
-                                      encoding);
-    if (nxt_slow_path(rule == NULL)) {
+    if (pattern->negative) {
         return NULL;
     }
 
-    hash = nxt_http_field_hash(mp, name, case_sensitive, encoding);
-    if (nxt_slow_path(hash == -1)) {
+#if (NXT_HAVE_REGEX)
+    if (pattern->regex) {
         return NULL;
     }
+#endif
 
-    rule->u.name.hash = hash;
-    rule->u.name.start = name->start;
-    rule->u.name.length = name->length;
-
-    return rule;
-}
-
-
-static nxt_http_route_rule_t *
-nxt_http_route_rule_create(nxt_task_t *task, nxt_mp_t *mp,
-    nxt_conf_value_t *cv, nxt_bool_t case_sensitive,
-    nxt_http_route_pattern_case_t pattern_case,
-    nxt_http_uri_encoding_t encoding)
-{
-    size_t                    size;
-    uint32_t                  i, n;
-    nxt_int_t                 ret;
-    nxt_conf_value_t          *value;
-    nxt_http_route_rule_t     *rule;
-    nxt_http_route_pattern_t  *pattern;
-
-    n = nxt_conf_array_elements_count_or_1(cv);
-    size = sizeof(nxt_http_route_rule_t) + n * sizeof(nxt_http_route_pattern_t);
-
-    rule = nxt_mp_alloc(mp, size);
-    if (nxt_slow_path(rule == NULL)) {
+    if (pattern->u.pattern_slices->nelts != 1) {
         return NULL;
     }
 
-    rule->items = n;
-
-    pattern = &rule->pattern[0];
-
-    nxt_conf_array_qsort(cv, nxt_http_pattern_compare);
-
-    for (i = 0; i < n; i++) {
-        pattern[i].case_sensitive = case_sensitive;
-        value = nxt_conf_get_array_element_or_itself(cv, i);
-
-        ret = nxt_http_route_pattern_create(task, mp, value, &pattern[i],
-                                            pattern_case, encoding);
-        if (nxt_slow_path(ret != NXT_OK)) {
-            return NULL;
-        }
-    }
+    slice = pattern->u.pattern_slices->elts;
 
-    return rule;
+    return (slice->length != 0) ? slice : NULL;
 }
 
 
@@ -900,6 +1756,23 @@ nxt_http_route_addr_rule_create(nxt_task_t *task, nxt_mp_t *mp,
             nxt_http_addr_pattern_compare);
     }
 
+    addr_rule->tree = NULL;
+
+    for (i = 0; i < n; i++) {
+        if (!addr_rule->addr_pattern[i].base.negative) {
+            break;
+        }
+    }
+
+    if (n - i >= NXT_HTTP_ROUTE_ADDR_TREE_MIN) {
+        addr_rule->tree = nxt_http_route_addr_tree_create(mp,
+                                                &addr_rule->addr_pattern[i],
+                                                n - i);
+        if (nxt_slow_path(addr_rule->tree == NULL)) {
+            return NULL;
+        }
+    }
+
     return addr_rule;
 }
 
@@ -969,6 +1842,7 @@ nxt_http_route_pattern_create(nxt_task_t *task, nxt_mp_t *mp,
     pattern->u.pattern_slices = NULL;
     pattern->negative = 0;
     pattern->any = 1;
+    pattern->set = 0;
     pattern->min_length = 0;
 #if (NXT_HAVE_REGEX)
     pattern->regex = 0;
@@ -1564,42 +2438,194 @@ static nxt_http_action_t *
 nxt_http_route_handler(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_action_t *start)
 {
-    size_t                  i;
-    nxt_http_route_t        *route;
-    nxt_http_action_t       *action;
+    uint32_t           i;
+    nxt_http_route_t   *route;
+    nxt_http_action_t  *action;
 
     route = start->u.route;
 
-    for (i = 0; i < route->items; i++) {
-        action = nxt_http_route_match(task, r, route->match[i]);
+    /* The route log reports every match, so the index is not used. */
 
-        if (nxt_slow_path(r->log_route)) {
-            uint32_t    lvl = (action == NULL) ? NXT_LOG_INFO : NXT_LOG_NOTICE;
-            const char  *sel = (action == NULL) ? "discarded" : "selected";
+    if (route->index != NULL && !r->log_route) {
+        action = nxt_http_route_index_match(task, r, route);
 
-            if (route->name.length == 0) {
-                nxt_log(task, lvl, "\"routes/%z\" %s", i, sel);
-            } else {
-                nxt_log(task, lvl, "\"routes/%V/%z\" %s", &route->name, i, sel);
+    } else {
+        action = NULL;
+
+        for (i = 0; i < route->items; i++) {
+            action = nxt_http_route_test_match(task, r, route, i);
+
+            if (action != NULL) {
+                break;
             }
         }
+    }
 
-        if (action != NULL) {
+    if (action != NULL) {
+
+        if (action != NXT_HTTP_ACTION_ERROR) {
+            r->action = action;
+            r->latency = action->latency;
+        }
+
+        return action;
+    }
+
+    nxt_http_request_error(task, r, NXT_HTTP_NOT_FOUND);
+
+    return NULL;
+}
 
-            if (action != NXT_HTTP_ACTION_ERROR) {
-                r->action = action;
+
+static nxt_http_action_t *
+nxt_http_route_index_match(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_route_t *route)
+{
+    uint32_t                      i, n, next;
+    uint32_t                      *p[NXT_HTTP_ROUTE_INDEX_LISTS];
+    uint32_t                      *end[NXT_HTTP_ROUTE_INDEX_LISTS];
+    nxt_array_t                   *list[NXT_HTTP_ROUTE_INDEX_LISTS];
+    nxt_http_action_t             *action;
+    nxt_http_route_index_t        *index;
+    nxt_http_route_index_entry_t  *entry;
+
+    index = route->index;
+
+    n = 0;
+    list[n++] = index->unindexed;
+
+    entry = nxt_http_route_index_find(&index->hosts, &r->host);
+    if (entry != NULL) {
+        list[n++] = entry->matches;
+    }
+
+    if (r->path != NULL) {
+        entry = nxt_http_route_index_find(&index->uris, r->path);
+        if (entry != NULL) {
+            list[n++] = entry->matches;
+        }
+
+        entry = nxt_http_route_index_prefix(index, r->path);
+        if (entry != NULL) {
+            list[n++] = entry->merged;
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        p[i] = list[i]->elts;
+        end[i] = p[i] + list[i]->nelts;
+    }
+
+    for ( ;; ) {
+        next = route->items;
+
+        for (i = 0; i < n; i++) {
+            if (p[i] < end[i] && *p[i] < next) {
+                next = *p[i];
+            }
+        }
+
+        if (next == route->items) {
+            return NULL;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (p[i] < end[i] && *p[i] == next) {
+                p[i]++;
             }
+        }
+
+        action = nxt_http_route_test_match(task, r, route, next);
 
+        if (action != NULL) {
             return action;
         }
     }
+}
 
-    nxt_http_request_error(task, r, NXT_HTTP_NOT_FOUND);
+
+static nxt_http_route_index_entry_t *
+nxt_http_route_index_find(nxt_lvlhsh_t *hash, nxt_str_t *key)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.key = *key;
+    lhq.proto = &nxt_http_route_index_proto;
+
+    if (nxt_lvlhsh_find(hash, &lhq) == NXT_OK) {
+        return lhq.value;
+    }
 
     return NULL;
 }
 
 
+/* Returns the entry of the longest configured prefix of the path. */
+
+static nxt_http_route_index_entry_t *
+nxt_http_route_index_prefix(nxt_http_route_index_t *index, nxt_str_t *path)
+{
+    size_t                        i;
+    uint32_t                      hash, *length, *end;
+    nxt_lvlhsh_query_t            lhq;
+    nxt_http_route_index_entry_t  *entry;
+
+    entry = NULL;
+
+    length = index->lengths->elts;
+    end = length + index->lengths->nelts;
+
+    hash = NXT_DJB_HASH_INIT;
+    i = 0;
+
+    lhq.key.start = path->start;
+    lhq.proto = &nxt_http_route_index_proto;
+
+    while (length < end && *length <= path->length) {
+
+        while (i < *length) {
+            hash = nxt_djb_hash_add(hash, path->start[i]);
+            i++;
+        }
+
+        lhq.key_hash = hash;
+        lhq.key.length = *length;
+
+        if (nxt_lvlhsh_find(&index->prefixes, &lhq) == NXT_OK) {
+            entry = lhq.value;
+        }
+
+        length++;
+    }
+
+    return entry;
+}
+
+
+static nxt_http_action_t *
+nxt_http_route_test_match(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_route_t *route, uint32_t n)
+{
+    nxt_http_action_t  *action;
+
+    action = nxt_http_route_match(task, r, route->match[n]);
+
+    if (nxt_slow_path(r->log_route)) {
+        uint32_t    lvl = (action == NULL) ? NXT_LOG_INFO : NXT_LOG_NOTICE;
+        const char  *sel = (action == NULL) ? "discarded" : "selected";
+
+        if (route->name.length == 0) {
+            nxt_log(task, lvl, "\"routes/%uD\" %s", n, sel);
+        } else {
+            nxt_log(task, lvl, "\"routes/%V/%uD\" %s", &route->name, n, sel);
+        }
+    }
+
+    return action;
+}
+
+
 static nxt_http_action_t *
 nxt_http_route_match(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_route_match_t *match)
@@ -1625,6 +2651,9 @@ nxt_http_route_match(nxt_task_t *task, nxt_http_request_t *r,
 
             ret = nxt_http_route_addr_rule(r, test->addr_rule, r->local);
             break;
+        case NXT_HTTP_ROUTE_TLS_EARLY_DATA:
+            ret = (r->tls_early_data == test->flag->value);
+            break;
         default:
             ret = nxt_http_route_rule(r, test->rule);
             break;
@@ -1895,6 +2924,11 @@ nxt_http_route_addr_rule(nxt_http_request_t *r,
         p++;
         n--;
 
+        if (addr_rule->tree != NULL && !p->base.negative) {
+            /* The tree contains all positive patterns. */
+            return nxt_http_route_addr_tree_match(addr_rule->tree, sa);
+        }
+
         matches = nxt_http_route_addr_pattern_match(p, sa);
 
         if (p->base.negative) {
@@ -2081,13 +3115,45 @@ nxt_http_route_test_rule(nxt_http_request_t *r, nxt_http_route_rule_t *rule,
     u_char *start, size_t length)
 {
     nxt_int_t                 ret;
+    nxt_uint_t                set, tested;
     nxt_http_route_pattern_t  *pattern, *end;
 
     ret = 1;
+    tested = 0;
     pattern = &rule->pattern[0];
     end = pattern + rule->items;
 
     while (pattern < end) {
+
+        if (pattern->set) {
+            /* All patterns of a set are tested once. */
+
+            set = 1;
+#if (NXT_HAVE_REGEX)
+            if (pattern->regex) {
+                set <<= 1 + pattern->negative;
+            }
+#endif
+
+            if ((tested & set) == 0) {
+                tested |= set;
+
+                ret = nxt_http_route_test_set(r, rule, pattern, start, length);
+                if (nxt_slow_path(ret == NXT_ERROR)) {
+                    return NXT_ERROR;
+                }
+
+                ret ^= pattern->negative;
+
+                if (pattern->any == ret) {
+                    return ret;
+                }
+            }
+
+            pattern++;
+            continue;
+        }
+
         ret = nxt_http_route_pattern(r, pattern, start, length);
         if (nxt_slow_path(ret == NXT_ERROR)) {
             return NXT_ERROR;
@@ -2107,6 +3173,41 @@ nxt_http_route_test_rule(nxt_http_request_t *r, nxt_http_route_rule_t *rule,
 }
 
 
+static nxt_int_t
+nxt_http_route_test_set(nxt_http_request_t *r, nxt_http_route_rule_t *rule,
+    nxt_http_route_pattern_t *pattern, u_char *start, size_t length)
+{
+#if (NXT_HAVE_REGEX)
+    nxt_int_t          ret;
+    nxt_regex_match_t  *match;
+
+    if (pattern->regex) {
+        match = nxt_http_route_regex_match(r);
+        if (nxt_slow_path(match == NULL)) {
+            return NXT_ERROR;
+        }
+
+        ret = nxt_regex_match_set(rule->regex[pattern->negative], start,
+                                  length, match);
+
+        if (ret == NXT_DECLINED) {
+            return 0;
+        }
+
+        if (nxt_slow_path(ret == NXT_ERROR)) {
+            return NXT_ERROR;
+        }
+
+        nxt_debug(&r->task, "http route regex set matched pattern %i", ret);
+
+        return 1;
+    }
+#endif
+
+    return nxt_aho_corasick_match(rule->set, start, length);
+}
+
+
 static nxt_int_t
 nxt_http_route_pattern(nxt_http_request_t *r, nxt_http_route_pattern_t *pattern,
     u_char *start, size_t length)
@@ -2115,18 +3216,19 @@ nxt_http_route_pattern(nxt_http_request_t *r, nxt_http_route_pattern_t *pattern,
     size_t                          test_length;
     uint32_t                        i;
     nxt_array_t                     *pattern_slices;
+#if (NXT_HAVE_REGEX)
+    nxt_regex_match_t               *match;
+#endif
     nxt_http_route_pattern_slice_t  *pattern_slice;
 
 #if (NXT_HAVE_REGEX)
     if (pattern->regex) {
-        if (r->regex_match == NULL) {
-            r->regex_match = nxt_regex_match_create(r->mem_pool, 0);
-            if (nxt_slow_path(r->regex_match == NULL)) {
-                return NXT_ERROR;
-            }
+        match = nxt_http_route_regex_match(r);
+        if (nxt_slow_path(match == NULL)) {
+            return NXT_ERROR;
         }
 
-        return nxt_regex_match(pattern->u.regex, start, length, r->regex_match);
+        return nxt_regex_match(pattern->u.regex, start, length, match);
     }
 #endif
 
@@ -2192,6 +3294,25 @@ nxt_http_route_pattern(nxt_http_request_t *r, nxt_http_route_pattern_t *pattern,
 }
 
 
+#if (NXT_HAVE_REGEX)
+
+static nxt_regex_match_t *
+nxt_http_route_regex_match(nxt_http_request_t *r)
+{
+    nxt_event_engine_t  *engine;
+
+    engine = r->task.thread->engine;
+
+    if (engine->regex_match == NULL) {
+        engine->regex_match = nxt_regex_match_create(engine->mem_pool, 0);
+    }
+
+    return engine->regex_match;
+}
+
+#endif
+
+
 static nxt_int_t
 nxt_http_route_memcmp(u_char *start, u_char *test, size_t test_length,
     nxt_bool_t case_sensitive)
@@ -8,9 +8,61 @@
 #include <nxt_http_route_addr.h>
 
 
+/*
+ * The address tree is a path-compressed binary radix tree of address
+ * prefixes with the lists of port ranges.  Address ranges are split into
+ * prefixes.  A lookup walks the tree along the address bits and tests the
+ * ports of each node which prefix matches the address, so it costs at most
+ * the number of address bits.
+ */
+
+typedef struct nxt_http_route_addr_ports_s  nxt_http_route_addr_ports_t;
+typedef struct nxt_http_route_addr_node_s   nxt_http_route_addr_node_t;
+
+
+struct nxt_http_route_addr_ports_s {
+    nxt_http_route_addr_ports_t  *next;
+    uint16_t                     start;
+    uint16_t                     end;
+};
+
+
+struct nxt_http_route_addr_node_s {
+    nxt_http_route_addr_node_t   *child[2];
+    nxt_http_route_addr_ports_t  *ports;
+    uint8_t                      bits;
+    u_char                       key[16];
+};
+
+
+struct nxt_http_route_addr_tree_s {
+    nxt_mp_t                     *mem_pool;
+    nxt_http_route_addr_node_t   v4;
+#if (NXT_INET6)
+    nxt_http_route_addr_node_t   v6;
+#endif
+    uint8_t                      unix_domain;  /* 1 bit */
+};
+
+
+#define nxt_http_route_addr_bit(key, n)                                       \
+    (((key)[(n) / 8] >> (7 - (n) % 8)) & 1)
+
+
 #if (NXT_INET6)
 static nxt_bool_t nxt_valid_ipv6_blocks(u_char *c, size_t len);
 #endif
+static nxt_int_t nxt_http_route_addr_tree_add(nxt_http_route_addr_tree_t *tree,
+    nxt_http_route_addr_node_t *root, nxt_http_route_addr_pattern_t *pattern,
+    u_char *start, u_char *end, size_t size);
+static nxt_int_t nxt_http_route_addr_tree_insert(nxt_mp_t *mp,
+    nxt_http_route_addr_node_t *root, u_char *key, uint8_t bits,
+    nxt_http_route_addr_base_t *base);
+static nxt_bool_t nxt_http_route_addr_prefix_match(u_char *key1, u_char *key2,
+    uint8_t bits);
+static nxt_bool_t nxt_http_route_addr_tree_lookup(
+    nxt_http_route_addr_node_t *root, u_char *key, uint8_t bits,
+    in_port_t port);
 
 
 nxt_int_t
@@ -344,3 +396,346 @@ nxt_valid_ipv6_blocks(u_char *c, size_t len)
 }
 
 #endif
+
+
+nxt_http_route_addr_tree_t *
+nxt_http_route_addr_tree_create(nxt_mp_t *mp,
+    nxt_http_route_addr_pattern_t *pattern, nxt_uint_t n)
+{
+    u_char                      zero[16], ones[16];
+    nxt_int_t                   ret;
+    nxt_uint_t                  i;
+    nxt_http_route_addr_tree_t  *tree;
+
+    tree = nxt_mp_zget(mp, sizeof(nxt_http_route_addr_tree_t));
+    if (nxt_slow_path(tree == NULL)) {
+        return NULL;
+    }
+
+    tree->mem_pool = mp;
+
+    nxt_memzero(zero, sizeof(zero));
+    nxt_memset(ones, 0xFF, sizeof(ones));
+
+    for (i = 0; i < n; i++, pattern++) {
+
+        if (pattern->base.negative) {
+            continue;
+        }
+
+        switch (pattern->base.addr_family) {
+
+        case AF_UNSPEC:
+            ret = nxt_http_route_addr_tree_add(tree, &tree->v4, pattern,
+                                               zero, ones, 4);
+#if (NXT_INET6)
+            if (ret == NXT_OK) {
+                ret = nxt_http_route_addr_tree_add(tree, &tree->v6, pattern,
+                                                   zero, ones, 16);
+            }
+#endif
+            break;
+
+        case AF_INET:
+            ret = nxt_http_route_addr_tree_add(tree, &tree->v4, pattern,
+                                       (u_char *) &pattern->addr.v4.start,
+                                       (u_char *) &pattern->addr.v4.end, 4);
+            break;
+
+#if (NXT_INET6)
+        case AF_INET6:
+            ret = nxt_http_route_addr_tree_add(tree, &tree->v6, pattern,
+                                               pattern->addr.v6.start.s6_addr,
+                                               pattern->addr.v6.end.s6_addr,
+                                               16);
+            break;
+#endif
+
+        default:
+            /* AF_UNIX */
+            tree->unix_domain = 1;
+            ret = NXT_OK;
+            break;
+        }
+
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+    }
+
+    return tree;
+}
+
+
+/*
+ * The start and end keys are interpreted according to the pattern match
+ * type: the CIDR pattern keeps the network and the mask, the range pattern
+ * keeps the first and the last addresses.  The range is split into the
+ * largest aligned prefixes.
+ */
+
+static nxt_int_t
+nxt_http_route_addr_tree_add(nxt_http_route_addr_tree_t *tree,
+    nxt_http_route_addr_node_t *root, nxt_http_route_addr_pattern_t *pattern,
+    u_char *start, u_char *end, size_t size)
+{
+    u_char                      key[16], last[16];
+    uint8_t                     bits, max;
+    nxt_int_t                   i;
+    nxt_http_route_addr_base_t  *base;
+
+    base = &pattern->base;
+    max = size * 8;
+
+    switch (base->match_type) {
+
+    case NXT_HTTP_ROUTE_ADDR_ANY:
+        return nxt_http_route_addr_tree_insert(tree->mem_pool, root, start, 0,
+                                               base);
+
+    case NXT_HTTP_ROUTE_ADDR_EXACT:
+        return nxt_http_route_addr_tree_insert(tree->mem_pool, root, start,
+                                               max, base);
+
+    case NXT_HTTP_ROUTE_ADDR_CIDR:
+        for (bits = 0; bits < max; bits++) {
+            if (!nxt_http_route_addr_bit(end, bits)) {
+                break;
+            }
+        }
+
+        return nxt_http_route_addr_tree_insert(tree->mem_pool, root, start,
+                                               bits, base);
+
+    default:
+        /* NXT_HTTP_ROUTE_ADDR_RANGE */
+        break;
+    }
+
+    nxt_memcpy(key, start, size);
+
+    for ( ;; ) {
+
+        /* The largest prefix starting at the key and fitting the range. */
+
+        for (bits = max; bits > 0; bits--) {
+            if (nxt_http_route_addr_bit(key, bits - 1)) {
+                break;
+            }
+        }
+
+        for ( /* void */ ; bits < max; bits++) {
+            nxt_memcpy(last, key, size);
+
+            for (i = bits; i < max; i++) {
+                last[i / 8] |= 1 << (7 - i % 8);
+            }
+
+            if (memcmp(last, end, size) <= 0) {
+                break;
+            }
+        }
+
+        if (bits == max) {
+            nxt_memcpy(last, key, size);
+        }
+
+        if (nxt_slow_path(nxt_http_route_addr_tree_insert(tree->mem_pool,
+                                                          root, key, bits,
+                                                          base)
+                          != NXT_OK))
+        {
+            return NXT_ERROR;
+        }
+
+        if (memcmp(last, end, size) >= 0) {
+            return NXT_OK;
+        }
+
+        /* The next key is the last address plus one. */
+
+        nxt_memcpy(key, last, size);
+
+        for (i = size - 1; i >= 0; i--) {
+            if (++key[i] != 0) {
+                break;
+            }
+        }
+    }
+}
+
+
+static nxt_int_t
+nxt_http_route_addr_tree_insert(nxt_mp_t *mp, nxt_http_route_addr_node_t *root,
+    u_char *key, uint8_t bits, nxt_http_route_addr_base_t *base)
+{
+    uint8_t                      common, n, bit;
+    nxt_http_route_addr_node_t   *node, *child, *new, *glue;
+    nxt_http_route_addr_ports_t  *ports;
+
+    node = root;
+
+    for ( ;; ) {
+        if (node->bits == bits) {
+            break;
+        }
+
+        bit = nxt_http_route_addr_bit(key, node->bits);
+        child = node->child[bit];
+
+        new = NULL;
+
+        if (child != NULL) {
+            n = nxt_min(bits, child->bits);
+
+            for (common = node->bits + 1; common < n; common++) {
+                if (nxt_http_route_addr_bit(key, common)
+                    != nxt_http_route_addr_bit(child->key, common))
+                {
+                    break;
+                }
+            }
+
+            if (common == child->bits) {
+                node = child;
+                continue;
+            }
+
+            if (common != bits) {
+                /* The key and the child differ below both prefixes. */
+
+                glue = nxt_mp_zget(mp, sizeof(nxt_http_route_addr_node_t));
+                if (nxt_slow_path(glue == NULL)) {
+                    return NXT_ERROR;
+                }
+
+                nxt_memcpy(glue->key, key, sizeof(glue->key));
+                glue->bits = common;
+
+                bit = nxt_http_route_addr_bit(child->key, common);
+                glue->child[bit] = child;
+
+                node->child[nxt_http_route_addr_bit(key, node->bits)] = glue;
+
+                node = glue;
+                bit = !bit;
+                child = NULL;
+
+            } else {
+                new = child;
+            }
+        }
+
+        child = nxt_mp_zget(mp, sizeof(nxt_http_route_addr_node_t));
+        if (nxt_slow_path(child == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_memcpy(child->key, key, sizeof(child->key));
+        child->bits = bits;
+
+        if (new != NULL) {
+            /* The key is a prefix of the child. */
+            child->child[nxt_http_route_addr_bit(new->key, bits)] = new;
+        }
+
+        node->child[bit] = child;
+        node = child;
+
+        break;
+    }
+
+    ports = nxt_mp_get(mp, sizeof(nxt_http_route_addr_ports_t));
+    if (nxt_slow_path(ports == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ports->start = base->port.start;
+    ports->end = base->port.end;
+    ports->next = node->ports;
+    node->ports = ports;
+
+    return NXT_OK;
+}
+
+
+nxt_bool_t
+nxt_http_route_addr_tree_match(nxt_http_route_addr_tree_t *tree,
+    nxt_sockaddr_t *sa)
+{
+    switch (sa->u.sockaddr.sa_family) {
+
+    case AF_INET:
+        return nxt_http_route_addr_tree_lookup(&tree->v4,
+                                  (u_char *) &sa->u.sockaddr_in.sin_addr, 32,
+                                  ntohs(sa->u.sockaddr_in.sin_port));
+
+#if (NXT_INET6)
+    case AF_INET6:
+        return nxt_http_route_addr_tree_lookup(&tree->v6,
+                                  sa->u.sockaddr_in6.sin6_addr.s6_addr, 128,
+                                  ntohs(sa->u.sockaddr_in6.sin6_port));
+#endif
+
+#if (NXT_HAVE_UNIX_DOMAIN)
+    case AF_UNIX:
+        return tree->unix_domain;
+#endif
+
+    default:
+        return 0;
+    }
+}
+
+
+static nxt_bool_t
+nxt_http_route_addr_tree_lookup(nxt_http_route_addr_node_t *root, u_char *key,
+    uint8_t bits, in_port_t port)
+{
+    nxt_http_route_addr_node_t   *node;
+    nxt_http_route_addr_ports_t  *ports;
+
+    node = root;
+
+    do {
+        if (!nxt_http_route_addr_prefix_match(key, node->key, node->bits)) {
+            return 0;
+        }
+
+        for (ports = node->ports; ports != NULL; ports = ports->next) {
+            if (port >= ports->start && port <= ports->end) {
+                return 1;
+            }
+        }
+
+        if (node->bits == bits) {
+            return 0;
+        }
+
+        node = node->child[nxt_http_route_addr_bit(key, node->bits)];
+
+    } while (node != NULL);
+
+    return 0;
+}
+
+
+static nxt_bool_t
+nxt_http_route_addr_prefix_match(u_char *key1, u_char *key2, uint8_t bits)
+{
+    size_t  n;
+
+    n = bits / 8;
+
+    if (memcmp(key1, key2, n) != 0) {
+        return 0;
+    }
+
+    bits %= 8;
+
+    if (bits == 0) {
+        return 1;
+    }
+
+    return ((key1[n] ^ key2[n]) >> (8 - bits)) == 0;
+}
@@ -68,7 +68,14 @@ typedef struct {
 } nxt_http_route_addr_pattern_t;
 
 
+typedef struct nxt_http_route_addr_tree_s  nxt_http_route_addr_tree_t;
+
+
 NXT_EXPORT nxt_int_t nxt_http_route_addr_pattern_parse(nxt_mp_t *mp,
     nxt_http_route_addr_pattern_t *pattern, nxt_conf_value_t *cv);
+NXT_EXPORT nxt_http_route_addr_tree_t *nxt_http_route_addr_tree_create(
+    nxt_mp_t *mp, nxt_http_route_addr_pattern_t *pattern, nxt_uint_t n);
+NXT_EXPORT nxt_bool_t nxt_http_route_addr_tree_match(
+    nxt_http_route_addr_tree_t *tree, nxt_sockaddr_t *sa);
 
 #endif /* _NXT_HTTP_ROUTE_ADDR_H_INCLUDED_ */
@@ -5,6 +5,7 @@
 
 #include <nxt_router.h>
 #include <nxt_http.h>
+#include <nxt_http_static_cache.h>
 
 
 typedef struct {
@@ -16,6 +17,12 @@ typedef struct {
 } nxt_http_static_share_t;
 
 
+typedef struct {
+    nxt_str_t                   token;
+    nxt_str_t                   extension;
+} nxt_http_static_encoding_t;
+
+
 typedef struct {
     nxt_uint_t                  nshares;
     nxt_http_static_share_t     *shares;
@@ -25,20 +32,74 @@ typedef struct {
     nxt_uint_t                  resolve;
 #endif
     nxt_http_route_rule_t       *types;
+    nxt_uint_t                  nprecompressed;
+    nxt_http_static_encoding_t  **precompressed;
+    nxt_http_static_cache_t     *cache;
+    nxt_thread_pool_t           *thread_pool;
 } nxt_http_static_conf_t;
 
 
+typedef struct {
+    nxt_file_t                     file;
+    nxt_http_static_cache_entry_t  *entry;
+} nxt_http_static_file_t;
+
+
+typedef struct {
+    nxt_job_t                   job;
+    nxt_task_t                  task;
+    nxt_http_request_t          *r;
+    nxt_work_handler_t          ready;
+    nxt_http_static_file_t      file;
+    nxt_file_info_t             fi;
+    u_char                      *fname;
+    nxt_str_t                   key;
+    nxt_int_t                   ret;
+    uint8_t                     sidecar;  /* 1 bit */
+} nxt_http_static_open_t;
+
+
 typedef struct {
     nxt_http_action_t           *action;
     nxt_str_t                   share;
 #if (NXT_HAVE_OPENAT2)
     nxt_str_t                   chroot;
 #endif
+    u_char                      *path;
+    u_char                      *sidecar;
+    nxt_str_t                   exten;
+    nxt_str_t                   *mtype;
+    nxt_http_static_file_t      file;
+    nxt_file_info_t             fi;
+    nxt_http_static_encoding_t  *encoding;
+    nxt_http_static_open_t      open;
     uint32_t                    share_idx;
+    uint32_t                    next_encoding;
     uint8_t                     need_body;  /* 1 bit */
 } nxt_http_static_ctx_t;
 
 
+#define NXT_HTTP_STATIC_MAX_RANGES    16
+#define NXT_HTTP_STATIC_BOUNDARY_LEN  20
+
+
+typedef struct {
+    nxt_off_t                   start;
+    nxt_off_t                   end;
+} nxt_http_static_range_t;
+
+
+typedef struct {
+    nxt_uint_t                  nranges;
+    nxt_uint_t                  current;
+    nxt_off_t                   size;
+    nxt_off_t                   total;
+    nxt_str_t                   *mtype;
+    nxt_http_static_range_t     *range;
+    u_char                      boundary[NXT_HTTP_STATIC_BOUNDARY_LEN];
+} nxt_http_static_ranges_t;
+
+
 #define NXT_HTTP_STATIC_BUF_COUNT  2
 #define NXT_HTTP_STATIC_BUF_SIZE   (128 * 1024)
 
@@ -48,6 +109,39 @@ static nxt_http_action_t *nxt_http_static(nxt_task_t *task,
 static void nxt_http_static_iterate(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_static_ctx_t *ctx);
 static void nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data);
+static nxt_http_static_encoding_t **nxt_http_static_encodings_create(
+    nxt_mp_t *mp, nxt_conf_value_t *cv, nxt_uint_t *n);
+static void nxt_http_static_opened(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_static_precompressed(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_static_ctx_t *ctx);
+static void nxt_http_static_sidecar_opened(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_static_send_file(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx);
+static void nxt_http_static_open(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx, u_char *name, nxt_bool_t sidecar,
+    nxt_work_handler_t ready);
+static void nxt_http_static_open_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_static_open_done(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_http_static_openat(nxt_task_t *task,
+    nxt_http_static_ctx_t *ctx, nxt_file_t *file, u_char **fname,
+    nxt_bool_t sidecar);
+static void nxt_http_static_close(nxt_task_t *task, nxt_file_t *file);
+static nxt_bool_t nxt_http_static_not_modified(nxt_http_request_t *r,
+    nxt_http_field_t *etag, nxt_time_t mtime);
+static nxt_bool_t nxt_http_static_etag_match(nxt_http_field_t *f,
+    nxt_http_field_t *etag);
+static nxt_bool_t nxt_http_static_if_range(nxt_http_request_t *r,
+    nxt_http_field_t *etag, nxt_time_t mtime);
+static nxt_int_t nxt_http_static_range_parse(nxt_http_request_t *r,
+    nxt_off_t size, nxt_http_static_ranges_t **rangesp);
+static nxt_int_t nxt_http_static_range_header(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_static_ranges_t *ranges, nxt_str_t *mtype);
+static size_t nxt_http_static_part_length(nxt_http_static_ranges_t *ranges,
+    nxt_uint_t i);
+static nxt_buf_t *nxt_http_static_part(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ranges_t *ranges, nxt_uint_t i);
 static void nxt_http_static_send_error(nxt_task_t *task, void *obj, void *data);
 static void nxt_http_static_next(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_static_ctx_t *ctx, nxt_http_status_t status);
@@ -60,6 +154,8 @@ static void nxt_http_static_body_handler(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_http_static_buf_completion(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_http_static_file_completion(nxt_task_t *task, void *obj,
+    void *data);
 
 static nxt_int_t nxt_http_static_mtypes_hash_test(nxt_lvlhsh_query_t *lhq,
     void *data);
@@ -70,6 +166,15 @@ static void nxt_http_static_mtypes_hash_free(void *data, void *p);
 static const nxt_http_request_state_t  nxt_http_static_send_state;
 
 
+/* The order sets the preference if the encodings are not configured. */
+
+static nxt_http_static_encoding_t  nxt_http_static_encodings[] = {
+    { nxt_string("br"),   nxt_string(".br") },
+    { nxt_string("zstd"), nxt_string(".zst") },
+    { nxt_string("gzip"), nxt_string(".gz") },
+};
+
+
 nxt_int_t
 nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_http_action_t *action, nxt_http_action_conf_t *acf)
@@ -171,6 +276,27 @@ nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         }
     }
 
+    if (acf->precompressed != NULL) {
+        conf->precompressed = nxt_http_static_encodings_create(mp,
+                                  acf->precompressed, &conf->nprecompressed);
+        if (nxt_slow_path(conf->precompressed == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    if (acf->open_file_cache != NULL) {
+        conf->cache = nxt_http_static_cache_create(task, mp,
+                                                   acf->open_file_cache);
+        if (nxt_slow_path(conf->cache == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    conf->thread_pool = nxt_router_static_thread_pool(task, rtcf);
+    if (nxt_slow_path(conf->thread_pool == NULL)) {
+        return NXT_ERROR;
+    }
+
     if (acf->fallback != NULL) {
         action->fallback = nxt_mp_alloc(mp, sizeof(nxt_http_action_t));
         if (nxt_slow_path(action->fallback == NULL)) {
@@ -185,6 +311,77 @@ nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 }
 
 
+static nxt_http_static_encoding_t **
+nxt_http_static_encodings_create(nxt_mp_t *mp, nxt_conf_value_t *cv,
+    nxt_uint_t *n)
+{
+    uint32_t                    i, k, count;
+    nxt_int_t                   idx;
+    nxt_str_t                   token;
+    nxt_conf_value_t            *value;
+    nxt_http_static_encoding_t  **encodings;
+
+    encodings = nxt_mp_get(mp, nxt_nitems(nxt_http_static_encodings)
+                               * sizeof(nxt_http_static_encoding_t *));
+    if (nxt_slow_path(encodings == NULL)) {
+        return NULL;
+    }
+
+    *n = 0;
+
+    if (nxt_conf_type(cv) == NXT_CONF_BOOLEAN) {
+        if (nxt_conf_get_boolean(cv)) {
+            for (k = 0; k < nxt_nitems(nxt_http_static_encodings); k++) {
+                encodings[k] = &nxt_http_static_encodings[k];
+            }
+
+            *n = k;
+        }
+
+        return encodings;
+    }
+
+    count = nxt_conf_array_elements_count_or_1(cv);
+
+    for (i = 0; i < count; i++) {
+        value = nxt_conf_get_array_element_or_itself(cv, i);
+        nxt_conf_get_string(value, &token);
+
+        idx = nxt_http_static_encoding_index(&token);
+        if (nxt_slow_path(idx < 0)) {
+            return NULL;
+        }
+
+        for (k = 0; k < *n; k++) {
+            if (encodings[k] == &nxt_http_static_encodings[idx]) {
+                break;
+            }
+        }
+
+        if (k == *n) {
+            encodings[(*n)++] = &nxt_http_static_encodings[idx];
+        }
+    }
+
+    return encodings;
+}
+
+
+nxt_int_t
+nxt_http_static_encoding_index(nxt_str_t *token)
+{
+    nxt_uint_t  i;
+
+    for (i = 0; i < nxt_nitems(nxt_http_static_encodings); i++) {
+        if (nxt_strcasestr_eq(token, &nxt_http_static_encodings[i].token)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
 static nxt_http_action_t *
 nxt_http_static(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_action_t *action)
@@ -303,38 +500,27 @@ nxt_http_static_iterate(nxt_task_t *task, nxt_http_request_t *r,
 static void
 nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 {
-    size_t                  length, encode;
+    size_t                  length;
     u_char                  *p, *fname;
-    struct tm               tm;
-    nxt_buf_t               *fb;
     nxt_int_t               ret;
-    nxt_str_t               *shr, *index, exten, *mtype;
-    nxt_uint_t              level;
-    nxt_file_t              *f, file;
-    nxt_file_info_t         fi;
-    nxt_http_field_t        *field;
-    nxt_http_status_t       status;
+    nxt_str_t               *shr, *index, *mtype;
     nxt_router_conf_t       *rtcf;
-    nxt_http_action_t       *action;
     nxt_http_request_t      *r;
-    nxt_work_handler_t      body_handler;
     nxt_http_static_ctx_t   *ctx;
     nxt_http_static_conf_t  *conf;
 
     r = obj;
     ctx = data;
-    action = ctx->action;
-    conf = action->u.conf;
+    conf = ctx->action->u.conf;
     rtcf = r->conf->socket_conf->router_conf;
 
-    f = NULL;
     mtype = NULL;
 
     shr = &ctx->share;
     index = &conf->index;
 
     if (shr->start[shr->length - 1] == '/') {
-        nxt_http_static_extract_extension(index, &exten);
+        nxt_http_static_extract_extension(index, &ctx->exten);
 
         length = shr->length + index->length;
 
@@ -350,11 +536,11 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 
     } else {
         if (conf->types == NULL) {
-            nxt_str_null(&exten);
+            nxt_str_null(&ctx->exten);
 
         } else {
-            nxt_http_static_extract_extension(shr, &exten);
-            mtype = nxt_http_static_mtype_get(&rtcf->mtypes_hash, &exten);
+            nxt_http_static_extract_extension(shr, &ctx->exten);
+            mtype = nxt_http_static_mtype_get(&rtcf->mtypes_hash, &ctx->exten);
 
             ret = nxt_http_route_test_rule(r, conf->types, mtype->start,
                                            mtype->length);
@@ -371,74 +557,37 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         fname = ctx->share.start;
     }
 
-    nxt_memzero(&file, sizeof(nxt_file_t));
-
-    file.name = fname;
-
-#if (NXT_HAVE_OPENAT2)
-    if (conf->resolve != 0 || ctx->chroot.length > 0) {
-        nxt_str_t                *chr;
-        nxt_uint_t               resolve;
-        nxt_http_static_share_t  *share;
-
-        share = &conf->shares[ctx->share_idx];
-
-        resolve = conf->resolve;
-        chr = &ctx->chroot;
-
-        if (chr->length > 0) {
-            resolve |= RESOLVE_IN_ROOT;
-
-            fname = share->is_const
-                    ? share->fname
-                    : nxt_http_static_chroot_match(chr->start, file.name);
-
-            if (fname != NULL) {
-                file.name = chr->start;
-                ret = nxt_file_open(task, &file, NXT_FILE_SEARCH, NXT_FILE_OPEN,
-                                    0);
-
-            } else {
-                file.error = NXT_EACCES;
-                ret = NXT_ERROR;
-            }
-
-        } else if (fname[0] == '/') {
-            file.name = (u_char *) "/";
-            ret = nxt_file_open(task, &file, NXT_FILE_SEARCH, NXT_FILE_OPEN, 0);
-
-        } else {
-            file.name = (u_char *) ".";
-            file.fd = AT_FDCWD;
-            ret = NXT_OK;
-        }
+    ctx->path = fname;
+    ctx->mtype = mtype;
+    ctx->encoding = NULL;
 
-        if (nxt_fast_path(ret == NXT_OK)) {
-            nxt_file_t  af;
+    nxt_http_static_open(task, r, ctx, fname, 0, nxt_http_static_opened);
+    return;
 
-            af = file;
-            nxt_memzero(&file, sizeof(nxt_file_t));
-            file.name = fname;
+fail:
 
-            ret = nxt_file_openat2(task, &file, NXT_FILE_RDONLY,
-                                   NXT_FILE_OPEN, 0, af.fd, resolve);
+    nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+}
 
-            if (af.fd != AT_FDCWD) {
-                nxt_file_close(task, &af);
-            }
-        }
 
-    } else {
-        ret = nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
-    }
+static void
+nxt_http_static_opened(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_uint_t              level;
+    nxt_http_status_t       status;
+    nxt_http_request_t      *r;
+    nxt_http_static_ctx_t   *ctx;
+    nxt_http_static_conf_t  *conf;
+    nxt_http_static_open_t  *op;
 
-#else
-    ret = nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
-#endif
+    r = obj;
+    ctx = data;
+    conf = ctx->action->u.conf;
+    op = &ctx->open;
 
-    if (nxt_slow_path(ret != NXT_OK)) {
+    if (nxt_slow_path(op->ret != NXT_OK)) {
 
-        switch (file.error) {
+        switch (op->file.file.error) {
 
         /*
          * For Unix domain sockets "errno" is set to:
@@ -479,15 +628,16 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 
             if (chr->length > 0) {
                 nxt_log(task, level, "opening \"%s\" at \"%V\" failed %E",
-                        fname, chr, file.error);
+                        op->fname, chr, op->file.file.error);
 
             } else {
                 nxt_log(task, level, "opening \"%s\" failed %E",
-                        fname, file.error);
+                        op->fname, op->file.file.error);
             }
 
 #else
-            nxt_log(task, level, "opening \"%s\" failed %E", fname, file.error);
+            nxt_log(task, level, "opening \"%s\" failed %E",
+                    op->fname, op->file.file.error);
 #endif
         }
 
@@ -496,25 +646,177 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             return;
         }
 
-        goto fail;
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+        return;
+    }
+
+    ctx->file = op->file;
+    ctx->fi = op->fi;
+
+    if (conf->nprecompressed != 0 && nxt_is_file(&ctx->fi)) {
+        ctx->sidecar = NULL;
+        ctx->next_encoding = 0;
+
+        nxt_http_static_precompressed(task, r, ctx);
+        return;
+    }
+
+    nxt_http_static_send_file(task, r, ctx);
+}
+
+
+/*
+ * Looks for a precompressed "file.br", "file.zst", or "file.gz" sidecar
+ * file next to the requested one in the order of configured encodings.
+ * If an acceptable sidecar is found, it replaces the requested file.
+ */
+
+static void
+nxt_http_static_precompressed(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx)
+{
+    size_t                      length;
+    u_char                      *p;
+    nxt_http_static_conf_t      *conf;
+    nxt_http_static_encoding_t  *enc;
+
+    conf = ctx->action->u.conf;
+
+    length = nxt_strlen(ctx->path);
+
+    while (ctx->next_encoding < conf->nprecompressed) {
+        enc = conf->precompressed[ctx->next_encoding++];
+
+        if (!nxt_http_compress_accepted(r, &enc->token)) {
+            continue;
+        }
+
+        if (ctx->sidecar == NULL) {
+            /* All extensions are no longer than 4 characters. */
+            ctx->sidecar = nxt_mp_nget(r->mem_pool, length + 5);
+            if (nxt_slow_path(ctx->sidecar == NULL)) {
+                break;
+            }
+
+            nxt_memcpy(ctx->sidecar, ctx->path, length);
+        }
+
+        p = nxt_cpymem(ctx->sidecar + length, enc->extension.start,
+                       enc->extension.length);
+        *p = '\0';
+
+        nxt_http_static_open(task, r, ctx, ctx->sidecar, 1,
+                             nxt_http_static_sidecar_opened);
+        return;
     }
 
-    f = nxt_mp_get(r->mem_pool, sizeof(nxt_file_t));
-    if (nxt_slow_path(f == NULL)) {
-        nxt_file_close(task, &file);
-        goto fail;
+    nxt_http_static_send_file(task, r, ctx);
+}
+
+
+static void
+nxt_http_static_sidecar_opened(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_request_t      *r;
+    nxt_http_static_ctx_t   *ctx;
+    nxt_http_static_conf_t  *conf;
+    nxt_http_static_open_t  *op;
+
+    r = obj;
+    ctx = data;
+    conf = ctx->action->u.conf;
+    op = &ctx->open;
+
+    if (op->ret != NXT_OK) {
+        switch (op->file.file.error) {
+        case NXT_ENOENT:
+        case NXT_ENOTDIR:
+        case NXT_ENAMETOOLONG:
+            break;
+
+        default:
+            nxt_log(task, NXT_LOG_ERR, "opening \"%s\" failed %E",
+                    op->fname, op->file.file.error);
+        }
+
+        nxt_http_static_precompressed(task, r, ctx);
+        return;
     }
 
-    *f = file;
+    if (!nxt_is_file(&op->fi)) {
+        nxt_http_static_close(task, &op->file.file);
 
-    ret = nxt_file_info(f, &fi);
-    if (nxt_slow_path(ret != NXT_OK)) {
-        goto fail;
+        nxt_http_static_precompressed(task, r, ctx);
+        return;
     }
 
-    if (nxt_fast_path(nxt_is_file(&fi))) {
+    nxt_debug(task, "http static: precompressed \"%s\"", ctx->sidecar);
+
+    nxt_http_static_close(task, &ctx->file.file);
+
+    ctx->file = op->file;
+    ctx->fi = op->fi;
+    ctx->encoding = conf->precompressed[ctx->next_encoding - 1];
+
+    nxt_http_static_send_file(task, r, ctx);
+}
+
+
+static void
+nxt_http_static_send_file(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx)
+{
+    size_t                      length, encode;
+    u_char                      *p;
+    struct tm                   tm;
+    nxt_buf_t                   *fb;
+    nxt_int_t                   ret;
+    nxt_str_t                   *shr, *mtype;
+    nxt_file_info_t             *fi;
+    nxt_http_field_t            *field, *etag;
+    nxt_router_conf_t           *rtcf;
+    nxt_work_handler_t          body_handler;
+    nxt_http_static_conf_t      *conf;
+    nxt_http_static_file_t      *f;
+    nxt_http_static_ranges_t    *ranges;
+    nxt_http_static_encoding_t  *enc;
+
+    conf = ctx->action->u.conf;
+    rtcf = r->conf->socket_conf->router_conf;
+
+    shr = &ctx->share;
+    mtype = ctx->mtype;
+
+    f = &ctx->file;
+    fi = &ctx->fi;
+
+    if (nxt_fast_path(nxt_is_file(fi))) {
+
+        if (conf->nprecompressed != 0) {
+            enc = ctx->encoding;
+
+            if (enc != NULL) {
+                field = nxt_list_zero_add(r->resp.fields);
+                if (nxt_slow_path(field == NULL)) {
+                    goto fail;
+                }
+
+                nxt_http_field_name_set(field, "Content-Encoding");
+
+                field->value = enc->token.start;
+                field->value_length = enc->token.length;
+            }
+
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            nxt_http_field_set(field, "Vary", "Accept-Encoding");
+        }
+
         r->status = NXT_HTTP_OK;
-        r->resp.content_length_n = nxt_file_size(&fi);
+        r->resp.content_length_n = nxt_file_size(fi);
 
         field = nxt_list_zero_add(r->resp.fields);
         if (nxt_slow_path(field == NULL)) {
@@ -528,7 +830,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             goto fail;
         }
 
-        nxt_localtime(nxt_file_mtime(&fi), &tm);
+        nxt_localtime(nxt_file_mtime(fi), &tm);
 
         field->value = p;
         field->value_length = nxt_http_date(p, &tm) - p;
@@ -549,19 +851,59 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 
         field->value = p;
         field->value_length = nxt_sprintf(p, p + length, "\"%xT-%xO\"",
-                                          nxt_file_mtime(&fi),
-                                          nxt_file_size(&fi))
+                                          nxt_file_mtime(fi),
+                                          nxt_file_size(fi))
                               - p;
 
-        if (exten.start == NULL) {
-            nxt_http_static_extract_extension(shr, &exten);
+        etag = field;
+
+        if (nxt_http_static_not_modified(r, etag, nxt_file_mtime(fi))) {
+            r->status = NXT_HTTP_NOT_MODIFIED;
+            r->resp.content_length_n = -1;
+        }
+
+        if (ctx->exten.start == NULL) {
+            nxt_http_static_extract_extension(shr, &ctx->exten);
         }
 
         if (mtype == NULL) {
-            mtype = nxt_http_static_mtype_get(&rtcf->mtypes_hash, &exten);
+            mtype = nxt_http_static_mtype_get(&rtcf->mtypes_hash, &ctx->exten);
+        }
+
+        ranges = NULL;
+
+        if (r->range != NULL
+            && ctx->need_body
+            && r->status == NXT_HTTP_OK
+            && nxt_http_static_if_range(r, etag, nxt_file_mtime(fi)))
+        {
+            ret = nxt_http_static_range_parse(r, nxt_file_size(fi), &ranges);
+
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                goto fail;
+            }
+
+            if (ret == NXT_OK) {
+                ret = nxt_http_static_range_header(task, r, ranges, mtype);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    goto fail;
+                }
+
+            } else {
+                ranges = NULL;
+            }
+        }
+
+        if (ranges == NULL && r->status == NXT_HTTP_OK) {
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            nxt_http_field_set(field, "Accept-Ranges", "bytes");
         }
 
-        if (mtype->length != 0) {
+        if (mtype->length != 0 && (ranges == NULL || ranges->nranges == 1)) {
             field = nxt_list_zero_add(r->resp.fields);
             if (nxt_slow_path(field == NULL)) {
                 goto fail;
@@ -573,33 +915,48 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             field->value_length = mtype->length;
         }
 
-        if (ctx->need_body && nxt_file_size(&fi) > 0) {
+        if (ctx->need_body
+            && nxt_file_size(fi) > 0
+            && (r->status == NXT_HTTP_OK
+                || r->status == NXT_HTTP_PARTIAL_CONTENT))
+        {
             fb = nxt_mp_zget(r->mem_pool, NXT_BUF_FILE_SIZE);
             if (nxt_slow_path(fb == NULL)) {
                 goto fail;
             }
 
-            fb->file = f;
-            fb->file_end = nxt_file_size(&fi);
+            fb->file = &f->file;
+
+            if (ranges != NULL) {
+                fb->file_pos = ranges->range[0].start;
+                fb->file_end = ranges->range[0].end;
+
+                if (ranges->nranges > 1) {
+                    fb->data = ranges;
+                }
+
+            } else {
+                fb->file_end = nxt_file_size(fi);
+            }
 
             r->out = fb;
 
             body_handler = &nxt_http_static_body_handler;
 
         } else {
-            nxt_file_close(task, f);
+            nxt_http_static_close(task, &f->file);
             body_handler = NULL;
         }
 
     } else {
         /* Not a file. */
-        nxt_file_close(task, f);
+        nxt_http_static_close(task, &f->file);
 
-        if (nxt_slow_path(!nxt_is_dir(&fi)
+        if (nxt_slow_path(!nxt_is_dir(fi)
                           || shr->start[shr->length - 1] == '/'))
         {
             nxt_log(task, NXT_LOG_ERR, "\"%FN\" is not a regular file",
-                    f->name);
+                    f->file.name);
 
             nxt_http_static_next(task, r, ctx, NXT_HTTP_NOT_FOUND);
             return;
@@ -657,29 +1014,726 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 fail:
 
     if (f != NULL) {
-        nxt_file_close(task, f);
+        nxt_http_static_close(task, &f->file);
     }
 
     nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
 }
 
 
+/*
+ * Opens the file and gets its information, either from the open file
+ * cache or from the file system, and calls the "ready" handler with the
+ * result in ctx->open.  The file system is accessed in a thread pool job
+ * to not block the event engine; the request memory pool is retained
+ * until the job returns.  A cached descriptor is released with
+ * nxt_http_static_close().
+ */
+
 static void
-nxt_http_static_send_error(nxt_task_t *task, void *obj, void *data)
+nxt_http_static_open(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx, u_char *name, nxt_bool_t sidecar,
+    nxt_work_handler_t ready)
 {
-    nxt_http_request_t  *r;
+    nxt_event_engine_t             *engine;
+    nxt_http_static_conf_t         *conf;
+    nxt_http_static_open_t         *op;
+    nxt_http_static_cache_entry_t  *entry;
 
-    r = obj;
+    conf = ctx->action->u.conf;
+    op = &ctx->open;
 
-    nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
-}
+    nxt_memzero(&op->file, sizeof(nxt_http_static_file_t));
 
+    op->file.file.name = name;
+    op->fname = name;
+    op->sidecar = sidecar;
+    op->ready = ready;
+    op->r = r;
 
-static void
-nxt_http_static_next(nxt_task_t *task, nxt_http_request_t *r,
-    nxt_http_static_ctx_t *ctx, nxt_http_status_t status)
-{
-    nxt_http_action_t       *action;
+    if (conf->cache != NULL) {
+        op->key.length = nxt_strlen(name);
+        op->key.start = name;
+
+#if (NXT_HAVE_OPENAT2)
+        if (ctx->chroot.length > 0) {
+            u_char  *p;
+
+            /* The chroot and the path are separated by zero byte. */
+            op->key.length += ctx->chroot.length + 1;
+
+            op->key.start = nxt_mp_nget(r->mem_pool, op->key.length);
+            if (nxt_slow_path(op->key.start == NULL)) {
+                op->file.file.error = NXT_ENOMEM;
+                op->ret = NXT_ERROR;
+
+                ready(task, r, ctx);
+                return;
+            }
+
+            p = nxt_cpymem(op->key.start, ctx->chroot.start,
+                           ctx->chroot.length);
+            *p++ = '\0';
+            nxt_memcpy(p, name, op->key.length - (p - op->key.start));
+        }
+#endif
+
+        engine = task->thread->engine;
+
+        entry = nxt_http_static_cache_find(task, conf->cache, &op->key);
+
+        if (entry != NULL) {
+            engine->static_cache_hits_cnt++;
+
+            if (entry->error != 0) {
+                op->file.file.error = entry->error;
+                op->ret = NXT_ERROR;
+
+                nxt_http_static_cache_release(task, entry);
+
+            } else {
+                op->file.file.fd = entry->fd;
+                op->file.entry = entry;
+                op->fi = entry->info;
+                op->ret = NXT_OK;
+            }
+
+            ready(task, r, ctx);
+            return;
+        }
+
+        engine->static_cache_misses_cnt++;
+    }
+
+    nxt_job_init(&op->job, sizeof(nxt_job_t));
+    nxt_job_set_name(&op->job, "job static open");
+
+    op->task = *task;
+
+    op->job.task = &op->task;
+    op->job.data = ctx;
+    op->job.abort_handler = nxt_http_static_open_handler;
+    op->job.thread_pool = conf->thread_pool;
+
+    nxt_mp_retain(r->mem_pool);
+
+    nxt_job_start(task, &op->job, nxt_http_static_open_handler);
+}
+
+
+/*
+ * Runs in a thread pool thread, or in the engine thread if the job
+ * cannot be posted.  The request memory pool must not be used here.
+ */
+
+static void
+nxt_http_static_open_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_static_ctx_t   *ctx;
+    nxt_http_static_open_t  *op;
+
+    ctx = data;
+    op = &ctx->open;
+
+    op->ret = nxt_http_static_openat(task, ctx, &op->file.file, &op->fname,
+                                     op->sidecar);
+
+    if (op->ret == NXT_OK) {
+        op->ret = nxt_file_info(&op->file.file, &op->fi);
+
+        if (nxt_slow_path(op->ret != NXT_OK)) {
+            nxt_file_close(task, &op->file.file);
+        }
+    }
+
+    nxt_job_return(task, &op->job, nxt_http_static_open_done);
+}
+
+
+static void
+nxt_http_static_open_done(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_mp_t                *mp;
+    nxt_http_request_t      *r;
+    nxt_http_static_ctx_t   *ctx;
+    nxt_http_static_conf_t  *conf;
+    nxt_http_static_open_t  *op;
+
+    ctx = data;
+    conf = ctx->action->u.conf;
+    op = &ctx->open;
+    r = op->r;
+    mp = r->mem_pool;
+
+    if (nxt_slow_path(r->error)) {
+        if (op->ret == NXT_OK) {
+            nxt_file_close(task, &op->file.file);
+        }
+
+        nxt_mp_release(mp);
+        return;
+    }
+
+    if (conf->cache != NULL) {
+        if (op->ret == NXT_OK) {
+            op->file.entry = nxt_http_static_cache_add(task, conf->cache,
+                                                       &op->key,
+                                                       op->file.file.fd,
+                                                       &op->fi, 0);
+        } else {
+            switch (op->file.file.error) {
+
+            case NXT_ENOENT:
+            case NXT_ENOTDIR:
+            case NXT_ENAMETOOLONG:
+                (void) nxt_http_static_cache_add(task, conf->cache, &op->key,
+                                                 -1, NULL,
+                                                 op->file.file.error);
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    op->ready(&r->task, r, ctx);
+
+    nxt_mp_release(mp);
+}
+
+
+static nxt_int_t
+nxt_http_static_openat(nxt_task_t *task, nxt_http_static_ctx_t *ctx,
+    nxt_file_t *file, u_char **fname, nxt_bool_t sidecar)
+{
+#if (NXT_HAVE_OPENAT2)
+    nxt_int_t                ret;
+    nxt_str_t                *chr;
+    nxt_file_t               af;
+    nxt_uint_t               resolve;
+    nxt_http_static_conf_t   *conf;
+    nxt_http_static_share_t  *share;
+
+    conf = ctx->action->u.conf;
+
+    if (conf->resolve != 0 || ctx->chroot.length > 0) {
+        share = &conf->shares[ctx->share_idx];
+
+        resolve = conf->resolve;
+        chr = &ctx->chroot;
+
+        if (chr->length > 0) {
+            resolve |= RESOLVE_IN_ROOT;
+
+            *fname = (share->is_const && !sidecar)
+                     ? share->fname
+                     : nxt_http_static_chroot_match(chr->start, file->name);
+
+            if (*fname != NULL) {
+                file->name = chr->start;
+                ret = nxt_file_open(task, file, NXT_FILE_SEARCH, NXT_FILE_OPEN,
+                                    0);
+
+            } else {
+                file->error = NXT_EACCES;
+                ret = NXT_ERROR;
+            }
+
+        } else if ((*fname)[0] == '/') {
+            file->name = (u_char *) "/";
+            ret = nxt_file_open(task, file, NXT_FILE_SEARCH, NXT_FILE_OPEN, 0);
+
+        } else {
+            file->name = (u_char *) ".";
+            file->fd = AT_FDCWD;
+            ret = NXT_OK;
+        }
+
+        if (nxt_fast_path(ret == NXT_OK)) {
+            af = *file;
+            nxt_memzero(file, sizeof(nxt_file_t));
+            file->name = *fname;
+
+            ret = nxt_file_openat2(task, file, NXT_FILE_RDONLY,
+                                   NXT_FILE_OPEN, 0, af.fd, resolve);
+
+            if (af.fd != AT_FDCWD) {
+                nxt_file_close(task, &af);
+            }
+        }
+
+        return ret;
+    }
+#endif
+
+    return nxt_file_open(task, file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
+}
+
+
+static void
+nxt_http_static_close(nxt_task_t *task, nxt_file_t *file)
+{
+    nxt_http_static_file_t  *sf;
+
+    sf = nxt_container_of(file, nxt_http_static_file_t, file);
+
+    if (sf->entry != NULL) {
+        nxt_http_static_cache_release(task, sf->entry);
+        sf->entry = NULL;
+
+    } else {
+        nxt_file_close(task, file);
+    }
+}
+
+
+/*
+ * "If-None-Match" takes precedence over "If-Modified-Since", entity tags
+ * are compared with the weak comparison function.
+ */
+
+static nxt_bool_t
+nxt_http_static_not_modified(nxt_http_request_t *r, nxt_http_field_t *etag,
+    nxt_time_t mtime)
+{
+    nxt_time_t        since;
+    nxt_http_field_t  *f;
+
+    f = r->if_none_match;
+
+    if (f != NULL) {
+        return nxt_http_static_etag_match(f, etag);
+    }
+
+    f = r->if_modified_since;
+
+    if (f == NULL) {
+        return 0;
+    }
+
+    since = nxt_time_parse(f->value, f->value_length);
+
+    return (since >= 0 && mtime <= since);
+}
+
+
+static nxt_bool_t
+nxt_http_static_etag_match(nxt_http_field_t *f, nxt_http_field_t *etag)
+{
+    u_char  *p, *end, *tag;
+
+    p = f->value;
+    end = p + f->value_length;
+
+    while (p < end) {
+
+        if (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+            continue;
+        }
+
+        if (*p == '*') {
+            return 1;
+        }
+
+        if (end - p > 2 && p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
+
+        if (*p != '"') {
+            return 0;
+        }
+
+        tag = p++;
+
+        p = memchr(p, '"', end - p);
+        if (p == NULL) {
+            return 0;
+        }
+
+        p++;
+
+        if ((size_t) (p - tag) == etag->value_length
+            && memcmp(tag, etag->value, etag->value_length) == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * The range is applied only if the "If-Range" entity tag strongly matches
+ * the current one or the date matches the file modification time.
+ */
+
+static nxt_bool_t
+nxt_http_static_if_range(nxt_http_request_t *r, nxt_http_field_t *etag,
+    nxt_time_t mtime)
+{
+    nxt_http_field_t  *f;
+
+    f = r->if_range;
+
+    if (f == NULL) {
+        return 1;
+    }
+
+    if (f->value_length > 0 && f->value[0] == '"') {
+        return (f->value_length == etag->value_length
+                && memcmp(f->value, etag->value, f->value_length) == 0);
+    }
+
+    if (f->value_length > 1 && f->value[0] == 'W' && f->value[1] == '/') {
+        return 0;
+    }
+
+    return (nxt_time_parse(f->value, f->value_length) == mtime);
+}
+
+
+/*
+ * Returns NXT_OK if the ranges are valid, the ranges list is empty if none
+ * of them is satisfiable.  NXT_DECLINED means the "Range" header field is
+ * malformed or contains too many ranges, so it should be ignored.  It is
+ * also ignored if overlapping ranges request more data than the file has.
+ */
+
+static nxt_int_t
+nxt_http_static_range_parse(nxt_http_request_t *r, nxt_off_t size,
+    nxt_http_static_ranges_t **rangesp)
+{
+    u_char                    *p, *end, *num;
+    nxt_off_t                 start, last;
+    nxt_uint_t                n;
+    nxt_http_static_range_t   *range;
+    nxt_http_static_ranges_t  *ranges;
+
+    p = r->range->value;
+    end = p + r->range->value_length;
+
+    if (end - p < 6 || nxt_memcasecmp(p, "bytes=", 6) != 0) {
+        return NXT_DECLINED;
+    }
+
+    p += 6;
+
+    ranges = nxt_mp_zget(r->mem_pool, sizeof(nxt_http_static_ranges_t)
+                                      + NXT_HTTP_STATIC_MAX_RANGES
+                                        * sizeof(nxt_http_static_range_t));
+    if (nxt_slow_path(ranges == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ranges->range = (nxt_http_static_range_t *) (ranges + 1);
+    ranges->size = size;
+
+    n = 0;
+
+    for ( ;; ) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        num = p;
+
+        while (p < end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+
+        if (p == end || *p != '-') {
+            return NXT_DECLINED;
+        }
+
+        if (p != num) {
+            start = nxt_off_t_parse(num, p - num);
+            if (start < 0) {
+                return NXT_DECLINED;
+            }
+
+        } else {
+            start = -1;
+        }
+
+        num = ++p;
+
+        while (p < end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+
+        if (p != num) {
+            last = nxt_off_t_parse(num, p - num);
+            if (last < 0) {
+                return NXT_DECLINED;
+            }
+
+        } else if (start == -1) {
+            return NXT_DECLINED;
+
+        } else {
+            last = -1;
+        }
+
+        if (start == -1) {
+            /* A suffix range "-N". */
+
+            if (last != 0) {
+                start = (last < size) ? size - last : 0;
+                last = size - 1;
+
+            } else {
+                start = size;
+            }
+
+        } else if (last == -1 || last >= size) {
+            if (last != -1 && last < start) {
+                return NXT_DECLINED;
+            }
+
+            last = size - 1;
+
+        } else if (last < start) {
+            return NXT_DECLINED;
+        }
+
+        if (start < size) {
+            if (n == NXT_HTTP_STATIC_MAX_RANGES) {
+                return NXT_DECLINED;
+            }
+
+            range = &ranges->range[n++];
+
+            range->start = start;
+            range->end = last + 1;
+
+            ranges->total += range->end - range->start;
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        if (*p != ',') {
+            return NXT_DECLINED;
+        }
+
+        p++;
+    }
+
+    if (ranges->total > size) {
+        return NXT_DECLINED;
+    }
+
+    ranges->nranges = n;
+
+    *rangesp = ranges;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_static_range_header(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ranges_t *ranges, nxt_str_t *mtype)
+{
+    u_char                   *p;
+    size_t                   length;
+    uint32_t                 rnd1, rnd2;
+    nxt_uint_t               i;
+    nxt_http_field_t         *field;
+    nxt_http_static_range_t  *range;
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (ranges->nranges == 0) {
+        r->status = NXT_HTTP_RANGE_NOT_SATISFIABLE;
+        r->resp.content_length_n = 0;
+
+        nxt_http_field_name_set(field, "Content-Range");
+
+        length = nxt_length("bytes */") + NXT_OFF_T_LEN;
+
+        p = nxt_mp_nget(r->mem_pool, length);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        field->value = p;
+        field->value_length = nxt_sprintf(p, p + length, "bytes */%O",
+                                          ranges->size)
+                              - p;
+        return NXT_OK;
+    }
+
+    r->status = NXT_HTTP_PARTIAL_CONTENT;
+
+    if (ranges->nranges == 1) {
+        range = &ranges->range[0];
+
+        r->resp.content_length_n = range->end - range->start;
+
+        nxt_http_field_name_set(field, "Content-Range");
+
+        length = nxt_length("bytes -/") + 3 * NXT_OFF_T_LEN;
+
+        p = nxt_mp_nget(r->mem_pool, length);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        field->value = p;
+        field->value_length = nxt_sprintf(p, p + length, "bytes %O-%O/%O",
+                                          range->start, range->end - 1,
+                                          ranges->size)
+                              - p;
+        return NXT_OK;
+    }
+
+    ranges->mtype = mtype;
+
+    rnd1 = nxt_random(&task->thread->random);
+    rnd2 = nxt_random(&task->thread->random);
+
+    (void) nxt_sprintf(ranges->boundary,
+                       ranges->boundary + NXT_HTTP_STATIC_BOUNDARY_LEN,
+                       "%010uD%010uD", rnd1, rnd2);
+
+    nxt_http_field_name_set(field, "Content-Type");
+
+    length = nxt_length("multipart/byteranges; boundary=")
+             + NXT_HTTP_STATIC_BOUNDARY_LEN;
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    field->value = p;
+    field->value_length = length;
+
+    p = nxt_cpymem(p, "multipart/byteranges; boundary=",
+                   nxt_length("multipart/byteranges; boundary="));
+    nxt_memcpy(p, ranges->boundary, NXT_HTTP_STATIC_BOUNDARY_LEN);
+
+    length = ranges->total
+             + nxt_length("\r\n--") + NXT_HTTP_STATIC_BOUNDARY_LEN
+             + nxt_length("--\r\n");
+
+    for (i = 0; i < ranges->nranges; i++) {
+        length += nxt_http_static_part_length(ranges, i);
+    }
+
+    r->resp.content_length_n = length;
+
+    return NXT_OK;
+}
+
+
+static size_t
+nxt_http_static_part_length(nxt_http_static_ranges_t *ranges, nxt_uint_t i)
+{
+    u_char                   buf[3 * NXT_OFF_T_LEN + 2];
+    size_t                   length;
+    nxt_http_static_range_t  *range;
+
+    range = &ranges->range[i];
+
+    length = nxt_length("\r\n--") + NXT_HTTP_STATIC_BOUNDARY_LEN
+             + nxt_length("\r\nContent-Range: bytes ")
+             + (nxt_sprintf(buf, buf + sizeof(buf), "%O-%O/%O",
+                            range->start, range->end - 1, ranges->size)
+                - buf)
+             + nxt_length("\r\n\r\n");
+
+    if (ranges->mtype->length != 0) {
+        length += nxt_length("\r\nContent-Type: ") + ranges->mtype->length;
+    }
+
+    return length;
+}
+
+
+/*
+ * Creates a multipart part header buffer for the range "i", or the closing
+ * boundary buffer if "i" is equal to the number of ranges.
+ */
+
+static nxt_buf_t *
+nxt_http_static_part(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ranges_t *ranges, nxt_uint_t i)
+{
+    u_char                   *p;
+    size_t                   length;
+    nxt_buf_t                *b;
+    nxt_http_static_range_t  *range;
+
+    if (i == ranges->nranges) {
+        length = nxt_length("\r\n--") + NXT_HTTP_STATIC_BOUNDARY_LEN
+                 + nxt_length("--\r\n");
+
+    } else {
+        length = nxt_http_static_part_length(ranges, i);
+    }
+
+    b = nxt_http_buf_mem(task, r, length);
+    if (nxt_slow_path(b == NULL)) {
+        return NULL;
+    }
+
+    p = b->mem.free;
+
+    p = nxt_cpymem(p, "\r\n--", nxt_length("\r\n--"));
+    p = nxt_cpymem(p, ranges->boundary, NXT_HTTP_STATIC_BOUNDARY_LEN);
+
+    if (i == ranges->nranges) {
+        p = nxt_cpymem(p, "--\r\n", nxt_length("--\r\n"));
+
+    } else {
+        if (ranges->mtype->length != 0) {
+            p = nxt_cpymem(p, "\r\nContent-Type: ",
+                           nxt_length("\r\nContent-Type: "));
+            p = nxt_cpymem(p, ranges->mtype->start, ranges->mtype->length);
+        }
+
+        range = &ranges->range[i];
+
+        p = nxt_sprintf(p, b->mem.end,
+                        "\r\nContent-Range: bytes %O-%O/%O\r\n\r\n",
+                        range->start, range->end - 1, ranges->size);
+    }
+
+    b->mem.free = p;
+
+    return b;
+}
+
+
+static void
+nxt_http_static_send_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_request_t  *r;
+
+    r = obj;
+
+    nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+}
+
+
+static void
+nxt_http_static_next(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx, nxt_http_status_t status)
+{
+    nxt_http_action_t       *action;
     nxt_http_static_conf_t  *conf;
 
     action = ctx->action;
@@ -794,17 +1848,54 @@ nxt_http_static_extract_extension(nxt_str_t *path, nxt_str_t *exten)
 static void
 nxt_http_static_body_handler(nxt_task_t *task, void *obj, void *data)
 {
-    size_t              alloc;
-    nxt_buf_t           *fb, *b, **next, *out;
-    nxt_off_t           rest;
-    nxt_int_t           n;
-    nxt_work_queue_t    *wq;
-    nxt_http_request_t  *r;
+    size_t                    alloc;
+    nxt_buf_t                 *fb, *b, **next, *out;
+    nxt_off_t                 rest;
+    nxt_int_t                 n;
+    nxt_work_queue_t          *wq;
+    nxt_http_request_t        *r;
+    nxt_http_static_ranges_t  *ranges;
 
     r = obj;
     fb = r->out;
+    ranges = fb->data;
+
+    /*
+     * A connection with kernel TLS send offload can send the file
+     * as is, unless its content has to pass through body filters.
+     */
+
+    if (r->sendfile
+        && ranges == NULL
+        && r->compress == NULL
+        && r->cache == NULL)
+    {
+        nxt_buf_set_file(fb);
+
+        fb->completion_handler = nxt_http_static_file_completion;
+        fb->parent = r;
+        fb->next = nxt_http_buf_last(r);
+
+        nxt_mp_retain(r->mem_pool);
+
+        nxt_http_request_send(task, r, fb);
+        return;
+    }
+
+    if (ranges != NULL) {
+        b = nxt_http_static_part(task, r, ranges, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return;
+        }
+
+        nxt_http_request_send(task, r, b);
+
+        rest = ranges->total;
+
+    } else {
+        rest = fb->file_end - fb->file_pos;
+    }
 
-    rest = fb->file_end - fb->file_pos;
     out = NULL;
     next = &out;
     n = 0;
@@ -856,10 +1947,12 @@ static const nxt_http_request_state_t  nxt_http_static_send_state
 static void
 nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
 {
-    ssize_t             n, size;
-    nxt_buf_t           *b, *fb, *next;
-    nxt_off_t           rest;
-    nxt_http_request_t  *r;
+    ssize_t                   n, size;
+    nxt_buf_t                 *b, *fb, *next, *part;
+    nxt_off_t                 rest;
+    nxt_http_request_t        *r;
+    nxt_http_static_range_t   *range;
+    nxt_http_static_ranges_t  *ranges;
 
     b = obj;
     r = data;
@@ -890,9 +1983,33 @@ nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
     }
 
     next = b->next;
+    ranges = fb->data;
+
+    if (n == rest && ranges != NULL) {
+        /* The next multipart part header or the closing boundary. */
+
+        part = nxt_http_static_part(task, r, ranges, ++ranges->current);
+        if (nxt_slow_path(part == NULL)) {
+            goto clean;
+        }
+
+        b->next = part;
+
+        if (ranges->current < ranges->nranges) {
+            range = &ranges->range[ranges->current];
+
+            fb->file_pos = range->start;
+            fb->file_end = range->end;
+
+        } else {
+            nxt_http_static_close(task, fb->file);
+            r->out = NULL;
 
-    if (n == rest) {
-        nxt_file_close(task, fb->file);
+            part->next = nxt_http_buf_last(r);
+        }
+
+    } else if (n == rest) {
+        nxt_http_static_close(task, fb->file);
         r->out = NULL;
 
         b->next = nxt_http_buf_last(r);
@@ -926,12 +2043,28 @@ nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
     } while (b != NULL);
 
     if (fb != NULL) {
-        nxt_file_close(task, fb->file);
+        nxt_http_static_close(task, fb->file);
         r->out = NULL;
     }
 }
 
 
+static void
+nxt_http_static_file_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *fb;
+    nxt_http_request_t  *r;
+
+    fb = obj;
+    r = data;
+
+    nxt_http_static_close(task, fb->file);
+    r->out = NULL;
+
+    nxt_mp_release(r->mem_pool);
+}
+
+
 nxt_int_t
 nxt_http_static_mtypes_init(nxt_mp_t *mp, nxt_lvlhsh_t *hash)
 {
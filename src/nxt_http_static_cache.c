@@ -0,0 +1,335 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_http_static_cache.h>
+
+
+/*
+ * The open file cache is shared by all router engine threads which serve
+ * the same "share" action, so it is protected by a mutex.  Entries keep
+ * the file descriptor and the file information of a resolved path, or
+ * the error if the path was not found.  An entry is valid for "valid"
+ * seconds after it has been added, the least recently used entries are
+ * evicted once the number of entries reaches "max".  A removed entry
+ * keeps its descriptor open until the last request using it releases it.
+ */
+
+struct nxt_http_static_cache_s {
+    nxt_thread_mutex_t         mutex;
+    nxt_lvlhsh_t               hash;
+    nxt_queue_t                lru;
+    uint32_t                   entries;
+
+    uint32_t                   max;
+    uint32_t                   valid;
+    uint8_t                    errors;  /* 1 bit */
+};
+
+
+#define NXT_HTTP_STATIC_CACHE_MAX    1000
+#define NXT_HTTP_STATIC_CACHE_VALID  60
+
+
+static nxt_int_t nxt_http_static_cache_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+static void nxt_http_static_cache_remove(nxt_http_static_cache_t *cache,
+    nxt_http_static_cache_entry_t *entry);
+static void nxt_http_static_cache_free(nxt_http_static_cache_entry_t *entry);
+static void nxt_http_static_cache_destroy(nxt_task_t *task, void *obj,
+    void *data);
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_static_cache_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_static_cache_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+static nxt_conf_map_t  nxt_http_static_cache_conf[] = {
+    {
+        nxt_string("max"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_http_static_cache_t, max),
+    },
+
+    {
+        nxt_string("valid"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_http_static_cache_t, valid),
+    },
+
+    {
+        nxt_string("errors"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_http_static_cache_t, errors),
+    },
+};
+
+
+nxt_http_static_cache_t *
+nxt_http_static_cache_create(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *cv)
+{
+    nxt_int_t                ret;
+    nxt_http_static_cache_t  *cache;
+
+    cache = nxt_mp_zget(mp, sizeof(nxt_http_static_cache_t));
+    if (nxt_slow_path(cache == NULL)) {
+        return NULL;
+    }
+
+    cache->max = NXT_HTTP_STATIC_CACHE_MAX;
+    cache->valid = NXT_HTTP_STATIC_CACHE_VALID;
+    cache->errors = 1;
+
+    ret = nxt_conf_map_object(mp, cv, nxt_http_static_cache_conf,
+                              nxt_nitems(nxt_http_static_cache_conf), cache);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    if (nxt_slow_path(nxt_thread_mutex_create(&cache->mutex) != NXT_OK)) {
+        return NULL;
+    }
+
+    nxt_lvlhsh_init(&cache->hash);
+    nxt_queue_init(&cache->lru);
+
+    ret = nxt_mp_cleanup(mp, nxt_http_static_cache_destroy, task, cache, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_thread_mutex_destroy(&cache->mutex);
+        return NULL;
+    }
+
+    return cache;
+}
+
+
+static nxt_int_t
+nxt_http_static_cache_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_static_cache_entry_t  *entry;
+
+    entry = data;
+
+    if (nxt_strstr_eq(&lhq->key, &entry->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+/*
+ * Returns a referenced entry which should be released after use,
+ * or NULL if the key is not cached or the entry has expired.
+ */
+
+nxt_http_static_cache_entry_t *
+nxt_http_static_cache_find(nxt_task_t *task, nxt_http_static_cache_t *cache,
+    nxt_str_t *key)
+{
+    nxt_int_t                      ret;
+    nxt_lvlhsh_query_t             lhq;
+    nxt_http_static_cache_entry_t  *entry;
+
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.key = *key;
+    lhq.proto = &nxt_http_static_cache_proto;
+
+    entry = NULL;
+
+    nxt_thread_mutex_lock(&cache->mutex);
+
+    ret = nxt_lvlhsh_find(&cache->hash, &lhq);
+
+    if (ret == NXT_OK) {
+        entry = lhq.value;
+
+        if (entry->expires > nxt_thread_time(task->thread)) {
+            entry->count++;
+
+            nxt_queue_remove(&entry->link);
+            nxt_queue_insert_head(&cache->lru, &entry->link);
+
+        } else {
+            nxt_http_static_cache_remove(cache, entry);
+            entry = NULL;
+        }
+    }
+
+    nxt_thread_mutex_unlock(&cache->mutex);
+
+    nxt_debug(task, "http static cache %s \"%V\"",
+              (entry != NULL) ? "hit" : "miss", key);
+
+    return entry;
+}
+
+
+/*
+ * Adds an open file or a lookup error to the cache.  For an open file
+ * the referenced entry which now owns the descriptor is returned; NULL
+ * means the descriptor is not cached and remains owned by the caller.
+ */
+
+nxt_http_static_cache_entry_t *
+nxt_http_static_cache_add(nxt_task_t *task, nxt_http_static_cache_t *cache,
+    nxt_str_t *key, nxt_fd_t fd, nxt_file_info_t *fi, nxt_err_t error)
+{
+    nxt_int_t                      ret;
+    nxt_queue_link_t               *link;
+    nxt_lvlhsh_query_t             lhq;
+    nxt_http_static_cache_entry_t  *entry, *old;
+
+    if (error != 0 && !cache->errors) {
+        return NULL;
+    }
+
+    entry = nxt_malloc(sizeof(nxt_http_static_cache_entry_t) + key->length);
+    if (nxt_slow_path(entry == NULL)) {
+        return NULL;
+    }
+
+    entry->cache = cache;
+    entry->key.length = key->length;
+    entry->key.start = (u_char *) entry + sizeof(nxt_http_static_cache_entry_t);
+    nxt_memcpy(entry->key.start, key->start, key->length);
+
+    entry->fd = fd;
+    entry->error = error;
+
+    if (fi != NULL) {
+        entry->info = *fi;
+    }
+
+    entry->expires = nxt_thread_time(task->thread) + cache->valid;
+    entry->count = (error == 0);
+    entry->removed = 0;
+
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.key = entry->key;
+    lhq.replace = 0;
+    lhq.value = entry;
+    lhq.proto = &nxt_http_static_cache_proto;
+    lhq.pool = NULL;
+
+    nxt_thread_mutex_lock(&cache->mutex);
+
+    while (cache->entries >= cache->max) {
+        link = nxt_queue_last(&cache->lru);
+        old = nxt_queue_link_data(link, nxt_http_static_cache_entry_t, link);
+
+        nxt_http_static_cache_remove(cache, old);
+    }
+
+    ret = nxt_lvlhsh_insert(&cache->hash, &lhq);
+
+    if (nxt_fast_path(ret == NXT_OK)) {
+        nxt_queue_insert_head(&cache->lru, &entry->link);
+        cache->entries++;
+    }
+
+    nxt_thread_mutex_unlock(&cache->mutex);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        /* The path has been added by another thread meanwhile. */
+        nxt_free(entry);
+        return NULL;
+    }
+
+    return (error == 0) ? entry : NULL;
+}
+
+
+void
+nxt_http_static_cache_release(nxt_task_t *task,
+    nxt_http_static_cache_entry_t *entry)
+{
+    nxt_bool_t               last;
+    nxt_http_static_cache_t  *cache;
+
+    cache = entry->cache;
+
+    nxt_thread_mutex_lock(&cache->mutex);
+
+    entry->count--;
+    last = (entry->count == 0 && entry->removed);
+
+    nxt_thread_mutex_unlock(&cache->mutex);
+
+    if (last) {
+        nxt_http_static_cache_free(entry);
+    }
+}
+
+
+/* The cache mutex must be locked. */
+
+static void
+nxt_http_static_cache_remove(nxt_http_static_cache_t *cache,
+    nxt_http_static_cache_entry_t *entry)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = nxt_djb_hash(entry->key.start, entry->key.length);
+    lhq.key = entry->key;
+    lhq.proto = &nxt_http_static_cache_proto;
+    lhq.pool = NULL;
+
+    (void) nxt_lvlhsh_delete(&cache->hash, &lhq);
+
+    nxt_queue_remove(&entry->link);
+    cache->entries--;
+
+    entry->removed = 1;
+
+    if (entry->count == 0) {
+        nxt_http_static_cache_free(entry);
+    }
+}
+
+
+static void
+nxt_http_static_cache_free(nxt_http_static_cache_entry_t *entry)
+{
+    if (entry->error == 0) {
+        nxt_fd_close(entry->fd);
+    }
+
+    nxt_free(entry);
+}
+
+
+/*
+ * The cache is destroyed with the router configuration memory pool after
+ * all requests which used the configuration have been finished.
+ */
+
+static void
+nxt_http_static_cache_destroy(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_queue_link_t               *link;
+    nxt_http_static_cache_t        *cache;
+    nxt_http_static_cache_entry_t  *entry;
+
+    cache = obj;
+
+    while (!nxt_queue_is_empty(&cache->lru)) {
+        link = nxt_queue_first(&cache->lru);
+        entry = nxt_queue_link_data(link, nxt_http_static_cache_entry_t, link);
+
+        entry->count = 0;
+        nxt_http_static_cache_remove(cache, entry);
+    }
+
+    nxt_thread_mutex_destroy(&cache->mutex);
+}
@@ -0,0 +1,39 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_HTTP_STATIC_CACHE_H_INCLUDED_
+#define _NXT_HTTP_STATIC_CACHE_H_INCLUDED_
+
+
+typedef struct nxt_http_static_cache_s  nxt_http_static_cache_t;
+
+
+typedef struct {
+    nxt_queue_link_t           link;
+    nxt_http_static_cache_t    *cache;
+    nxt_str_t                  key;
+
+    nxt_fd_t                   fd;
+    nxt_err_t                  error;
+    nxt_file_info_t            info;
+
+    nxt_time_t                 expires;
+    uint32_t                   count;
+    uint8_t                    removed;  /* 1 bit */
+} nxt_http_static_cache_entry_t;
+
+
+nxt_http_static_cache_t *nxt_http_static_cache_create(nxt_task_t *task,
+    nxt_mp_t *mp, nxt_conf_value_t *cv);
+nxt_http_static_cache_entry_t *nxt_http_static_cache_find(nxt_task_t *task,
+    nxt_http_static_cache_t *cache, nxt_str_t *key);
+nxt_http_static_cache_entry_t *nxt_http_static_cache_add(nxt_task_t *task,
+    nxt_http_static_cache_t *cache, nxt_str_t *key, nxt_fd_t fd,
+    nxt_file_info_t *fi, nxt_err_t error);
+void nxt_http_static_cache_release(nxt_task_t *task,
+    nxt_http_static_cache_entry_t *entry);
+
+
+#endif  /* _NXT_HTTP_STATIC_CACHE_H_INCLUDED_ */
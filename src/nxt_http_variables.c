@@ -32,6 +32,8 @@ static nxt_int_t nxt_http_var_request_id(nxt_task_t *task, nxt_str_t *str,
     void *ctx, void *data);
 static nxt_int_t nxt_http_var_status(nxt_task_t *task, nxt_str_t *str,
     void *ctx, void *data);
+static nxt_int_t nxt_http_var_tls_early_data(nxt_task_t *task, nxt_str_t *str,
+    void *ctx, void *data);
 static nxt_int_t nxt_http_var_body_bytes_sent(nxt_task_t *task, nxt_str_t *str,
     void *ctx, void *data);
 static nxt_int_t nxt_http_var_referer(nxt_task_t *task, nxt_str_t *str,
@@ -95,6 +97,10 @@ static nxt_var_decl_t  nxt_http_vars[] = {
         .name = nxt_string("request_id"),
         .handler = nxt_http_var_request_id,
         .cacheable = 1,
+    }, {
+        .name = nxt_string("tls_early_data"),
+        .handler = nxt_http_var_tls_early_data,
+        .cacheable = 1,
     }, {
         .name = nxt_string("status"),
         .handler = nxt_http_var_status,
@@ -335,31 +341,35 @@ nxt_http_var_time_local(nxt_task_t *task, nxt_str_t *str, void *ctx, void *data)
 {
     nxt_http_request_t  *r;
 
-    static nxt_time_string_t  date_cache = {
-        (nxt_atomic_uint_t) -1,
-        nxt_http_log_date,
-        "%02d/%s/%4d:%02d:%02d:%02d %c%02d%02d",
-        nxt_length("31/Dec/1986:19:40:00 +0300"),
-        NXT_THREAD_TIME_LOCAL,
-        NXT_THREAD_TIME_SEC,
-    };
-
     r = ctx;
 
-    str->length = date_cache.size;
-
-    str->start = nxt_mp_nget(r->mem_pool, str->length);
+    str->start = nxt_mp_nget(r->mem_pool, NXT_HTTP_TIME_LOCAL_LEN);
     if (nxt_slow_path(str->start == NULL)) {
         return NXT_ERROR;
     }
 
-    str->length = nxt_thread_time_string(task->thread, &date_cache, str->start)
-                  - str->start;
+    str->length = nxt_http_time_local(task, str->start) - str->start;
 
     return NXT_OK;
 }
 
 
+u_char *
+nxt_http_time_local(nxt_task_t *task, u_char *buf)
+{
+    static nxt_time_string_t  date_cache = {
+        (nxt_atomic_uint_t) -1,
+        nxt_http_log_date,
+        "%02d/%s/%4d:%02d:%02d:%02d %c%02d%02d",
+        NXT_HTTP_TIME_LOCAL_LEN,
+        NXT_THREAD_TIME_LOCAL,
+        NXT_THREAD_TIME_SEC,
+    };
+
+    return nxt_thread_time_string(task->thread, &date_cache, buf);
+}
+
+
 static u_char *
 nxt_http_log_date(u_char *buf, nxt_realtime_t *now, struct tm *tm,
     size_t size, const char *format)
@@ -427,6 +437,25 @@ nxt_http_var_request_id(nxt_task_t *task, nxt_str_t *str, void *ctx,
 }
 
 
+static nxt_int_t
+nxt_http_var_tls_early_data(nxt_task_t *task, nxt_str_t *str, void *ctx,
+    void *data)
+{
+    nxt_http_request_t  *r;
+
+    r = ctx;
+
+    if (r->tls_early_data) {
+        nxt_str_set(str, "1");
+
+    } else {
+        nxt_str_null(str);
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_http_var_body_bytes_sent(nxt_task_t *task, nxt_str_t *str, void *ctx,
     void *data)
@@ -530,7 +559,12 @@ nxt_http_var_response_connection(nxt_task_t *task, nxt_str_t *str, void *ctx,
 
     conn = -1;
 
-    if (r->websocket_handshake && r->status == NXT_HTTP_SWITCHING_PROTOCOLS) {
+    if (r->protocol != NXT_HTTP_PROTO_H1) {
+        /* Connection-specific fields are not used in HTTP/2. */
+
+    } else if (r->websocket_handshake
+               && r->status == NXT_HTTP_SWITCHING_PROTOCOLS)
+    {
         conn = 2;
 
     } else {
@@ -596,7 +630,7 @@ nxt_http_var_response_transfer_encoding(nxt_task_t *task, nxt_str_t *str,
 
     r = ctx;
 
-    if (r->proto.h1->chunked) {
+    if (r->protocol == NXT_HTTP_PROTO_H1 && r->proto.h1->chunked) {
         nxt_str_set(str, "chunked");
 
     } else {
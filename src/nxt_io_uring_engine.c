@@ -0,0 +1,1662 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <linux/io_uring.h>
+
+
+/*
+ * The io_uring engine is the edge-triggered epoll engine which waits for
+ * events in io_uring_enter() instead of epoll_wait().  The epoll descriptor
+ * is polled by a multishot poll request, so ports, eventfd, signalfd, and
+ * other descriptors are still handled by epoll and may be closed without
+ * cancellation of io_uring requests which hold file references.
+ *
+ * Listening sockets are not added to the epoll set: connections are
+ * accepted by multishot accept requests and are queued until the listen
+ * event handler takes them.  Plain connections receive data by multishot
+ * recv requests to a ring of provided buffers after the first read has
+ * drained a socket.  Writes are still readiness-based, since sends are
+ * usually completed synchronously.
+ *
+ * Completions are posted only in io_uring_enter() called by the engine
+ * thread: otherwise the kernel interrupts sendfile() and splice() in
+ * the thread to run task work and they return short counts, which are
+ * treated as a full socket send buffer.  A ring is created disabled and
+ * is enabled by the engine thread on the first io_uring_enter(), since
+ * router engines are created in the main thread.
+ *
+ * Multishot accept, multishot recv, and provided buffer rings have been
+ * introduced in Linux 6.0, deferred task work has been introduced in 6.1.
+ */
+
+
+#define NXT_IO_URING_ENTRIES       256
+#define NXT_IO_URING_CQ_ENTRIES    4096
+
+/* The number of provided buffers must be a power of 2. */
+#define NXT_IO_URING_BUFS          256
+#define NXT_IO_URING_BUF_SIZE      4096
+#define NXT_IO_URING_BGID          0
+
+/*
+ * Requests are cancelled if a connection does not read received data
+ * or if a listen event handler does not take accepted connections.
+ */
+#define NXT_IO_URING_RECV_BUFS     4
+#define NXT_IO_URING_ACCEPT_QUEUE  64
+
+#define NXT_IO_URING_CANCEL        0
+#define NXT_IO_URING_EPOLL         1
+
+#define NXT_IO_URING_FEATURES                                                 \
+    (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG)
+
+#define NXT_IO_URING_SETUP                                                    \
+    (IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED                            \
+     | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN                \
+     | IORING_SETUP_TASKRUN_FLAG)
+
+
+typedef struct {
+    int32_t                   next;
+    uint32_t                  pos;
+    uint32_t                  end;
+} nxt_io_uring_buf_t;
+
+
+typedef struct {
+    /* The event is NULL if the request is being cancelled after delete. */
+    nxt_fd_event_t            *ev;
+    nxt_socket_t              fd;
+    nxt_queue_link_t          link;
+
+    uint8_t                   accept;  /* 1 bit */
+    uint8_t                   armed;   /* 1 bit */
+    uint8_t                   cancel;  /* 1 bit */
+    uint8_t                   rearm;   /* 1 bit */
+    uint8_t                   eof;     /* 1 bit */
+    nxt_err_t                 error;
+
+    /* A circular queue of accepted sockets. */
+    nxt_socket_t              *sockets;
+    uint32_t                  first;
+    uint32_t                  nsockets;
+    uint32_t                  size;
+
+    /* A list of received buffers. */
+    int32_t                   head;
+    int32_t                   tail;
+    uint32_t                  nbufs;
+} nxt_io_uring_req_t;
+
+
+struct nxt_io_uring_s {
+    int                       fd;
+
+    uint32_t                  sq_entries;
+    uint32_t                  sq_mask;
+    uint32_t                  sq_tail;
+    uint32_t                  *sq_khead;
+    uint32_t                  *sq_ktail;
+    uint32_t                  *sq_kflags;
+    struct io_uring_sqe       *sqes;
+
+    uint32_t                  cq_mask;
+    uint32_t                  *cq_khead;
+    uint32_t                  *cq_ktail;
+    struct io_uring_cqe       *cqes;
+
+    u_char                    *ring;
+    size_t                    ring_size;
+    size_t                    sqes_size;
+
+    uint8_t                   enabled;      /* 1 bit */
+    uint8_t                   epoll_armed;  /* 1 bit */
+    uint8_t                   epoll_ready;  /* 1 bit */
+    uint8_t                   bufs_failed;  /* 1 bit */
+
+    struct io_uring_buf_ring  *buf_ring;
+    u_char                    *bufs;
+    nxt_io_uring_buf_t        *buf_meta;
+    uint16_t                  buf_tail;
+
+    nxt_io_uring_req_t        **reqs;
+    nxt_uint_t                nreqs;
+    nxt_queue_t               requests;
+};
+
+
+static int nxt_io_uring_enter(nxt_io_uring_t *ring, nxt_uint_t wait,
+    nxt_uint_t flags, struct io_uring_getevents_arg *arg);
+static struct io_uring_sqe *nxt_io_uring_sqe(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring);
+static void nxt_io_uring_process(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring);
+static void nxt_io_uring_complete(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, struct io_uring_cqe *cqe);
+static void nxt_io_uring_accept_complete(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req, struct io_uring_cqe *cqe);
+static void nxt_io_uring_recv_complete(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req, struct io_uring_cqe *cqe);
+static void nxt_io_uring_ready(nxt_fd_event_t *ev);
+static nxt_io_uring_req_t *nxt_io_uring_req(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev, nxt_bool_t accept);
+static nxt_io_uring_req_t *nxt_io_uring_req_find(nxt_io_uring_t *ring,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_arm(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req);
+static void nxt_io_uring_cancel(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req);
+static void nxt_io_uring_release(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req);
+static void nxt_io_uring_req_clear(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req);
+static void nxt_io_uring_req_free(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req);
+static nxt_int_t nxt_io_uring_push_socket(nxt_io_uring_req_t *req,
+    nxt_socket_t s);
+static nxt_int_t nxt_io_uring_bufs_init(nxt_io_uring_t *ring);
+static void nxt_io_uring_buf_recycle(nxt_io_uring_t *ring, uint32_t bid);
+static size_t nxt_io_uring_copy(nxt_io_uring_t *ring, nxt_io_uring_req_t *req,
+    struct iovec *iov, nxt_uint_t niov, nxt_bool_t consume);
+static ssize_t nxt_io_uring_recv_empty(nxt_conn_t *c, nxt_io_uring_req_t *req);
+static void nxt_io_uring_recv_drained(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req, nxt_conn_t *c, ssize_t n);
+
+
+nxt_int_t
+nxt_io_uring_create(nxt_event_engine_t *engine)
+{
+    u_char                   *p;
+    size_t                   sq_size, cq_size;
+    uint32_t                 i, *array;
+    nxt_io_uring_t           *ring;
+    struct io_uring_params   params;
+    struct io_uring_buf_reg  reg;
+
+    ring = nxt_zalloc(sizeof(nxt_io_uring_t));
+    if (ring == NULL) {
+        return NXT_ERROR;
+    }
+
+    engine->u.epoll.io_uring = ring;
+
+    nxt_queue_init(&ring->requests);
+
+    nxt_memzero(&params, sizeof(struct io_uring_params));
+
+    params.flags = NXT_IO_URING_SETUP;
+    params.cq_entries = NXT_IO_URING_CQ_ENTRIES;
+
+    ring->fd = syscall(SYS_io_uring_setup, NXT_IO_URING_ENTRIES, &params);
+
+    nxt_debug(&engine->task, "io_uring_setup(): %d", ring->fd);
+
+    if (ring->fd == -1) {
+        nxt_alert(&engine->task, "io_uring_setup() failed %E", nxt_errno);
+        return NXT_ERROR;
+    }
+
+    if ((params.features & NXT_IO_URING_FEATURES) != NXT_IO_URING_FEATURES) {
+        nxt_alert(&engine->task, "io_uring features %08XD are not supported",
+                  (uint32_t) (NXT_IO_URING_FEATURES & ~params.features));
+        return NXT_ERROR;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_size = params.cq_off.cqes
+              + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    ring->ring_size = nxt_max(sq_size, cq_size);
+
+    p = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+
+    if (p == MAP_FAILED) {
+        nxt_alert(&engine->task, "mmap(%d) failed %E", ring->fd, nxt_errno);
+        return NXT_ERROR;
+    }
+
+    ring->ring = p;
+
+    ring->sq_entries = params.sq_entries;
+    ring->sq_mask = *(uint32_t *) (p + params.sq_off.ring_mask);
+    ring->sq_khead = (uint32_t *) (p + params.sq_off.head);
+    ring->sq_ktail = (uint32_t *) (p + params.sq_off.tail);
+    ring->sq_kflags = (uint32_t *) (p + params.sq_off.flags);
+    ring->sq_tail = *ring->sq_ktail;
+
+    array = (uint32_t *) (p + params.sq_off.array);
+
+    for (i = 0; i < params.sq_entries; i++) {
+        array[i] = i;
+    }
+
+    ring->cq_mask = *(uint32_t *) (p + params.cq_off.ring_mask);
+    ring->cq_khead = (uint32_t *) (p + params.cq_off.head);
+    ring->cq_ktail = (uint32_t *) (p + params.cq_off.tail);
+    ring->cqes = (struct io_uring_cqe *) (p + params.cq_off.cqes);
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    p = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (p == MAP_FAILED) {
+        nxt_alert(&engine->task, "mmap(%d) failed %E", ring->fd, nxt_errno);
+        return NXT_ERROR;
+    }
+
+    ring->sqes = (struct io_uring_sqe *) p;
+
+    p = mmap(NULL, NXT_IO_URING_BUFS * sizeof(struct io_uring_buf),
+             PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED) {
+        nxt_alert(&engine->task, "mmap(MAP_ANONYMOUS) failed %E", nxt_errno);
+        return NXT_ERROR;
+    }
+
+    ring->buf_ring = (struct io_uring_buf_ring *) p;
+
+    nxt_memzero(&reg, sizeof(struct io_uring_buf_reg));
+
+    reg.ring_addr = (uintptr_t) p;
+    reg.ring_entries = NXT_IO_URING_BUFS;
+    reg.bgid = NXT_IO_URING_BGID;
+
+    if (syscall(SYS_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING,
+                &reg, 1)
+        != 0)
+    {
+        nxt_alert(&engine->task, "io_uring_register(%d, PBUF_RING) failed %E",
+                  ring->fd, nxt_errno);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * The function does not submit requests, so it is safe
+ * to call it in a process forked from the engine process.
+ */
+
+void
+nxt_io_uring_free(nxt_event_engine_t *engine)
+{
+    nxt_io_uring_t      *ring;
+    nxt_queue_link_t    *link;
+    nxt_io_uring_req_t  *req;
+
+    ring = engine->u.epoll.io_uring;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    nxt_debug(&engine->task, "io_uring %d free", ring->fd);
+
+    while (!nxt_queue_is_empty(&ring->requests)) {
+        link = nxt_queue_first(&ring->requests);
+        req = nxt_queue_link_data(link, nxt_io_uring_req_t, link);
+
+        nxt_io_uring_req_free(engine, ring, req);
+    }
+
+    if (ring->fd != -1 && close(ring->fd) != 0) {
+        nxt_alert(&engine->task, "io_uring close(%d) failed %E",
+                  ring->fd, nxt_errno);
+    }
+
+    if (ring->ring != NULL) {
+        (void) munmap(ring->ring, ring->ring_size);
+    }
+
+    if (ring->sqes != NULL) {
+        (void) munmap(ring->sqes, ring->sqes_size);
+    }
+
+    if (ring->buf_ring != NULL) {
+        (void) munmap(ring->buf_ring,
+                      NXT_IO_URING_BUFS * sizeof(struct io_uring_buf));
+    }
+
+    nxt_free(ring->bufs);
+    nxt_free(ring->buf_meta);
+    nxt_free(ring->reqs);
+    nxt_free(ring);
+
+    engine->u.epoll.io_uring = NULL;
+}
+
+
+static int
+nxt_io_uring_enter(nxt_io_uring_t *ring, nxt_uint_t wait, nxt_uint_t flags,
+    struct io_uring_getevents_arg *arg)
+{
+    uint32_t  submit;
+
+    if (nxt_slow_path(!ring->enabled)) {
+        if (syscall(SYS_io_uring_register, ring->fd,
+                    IORING_REGISTER_ENABLE_RINGS, NULL, 0)
+            != 0)
+        {
+            return -1;
+        }
+
+        ring->enabled = 1;
+    }
+
+    submit = ring->sq_tail - __atomic_load_n(ring->sq_khead, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(ring->sq_ktail, ring->sq_tail, __ATOMIC_RELEASE);
+
+    return syscall(SYS_io_uring_enter, ring->fd, submit, wait, flags, arg,
+                   (arg != NULL) ? sizeof(struct io_uring_getevents_arg) : 0);
+}
+
+
+static struct io_uring_sqe *
+nxt_io_uring_sqe(nxt_event_engine_t *engine, nxt_io_uring_t *ring)
+{
+    uint32_t             head;
+    struct io_uring_sqe  *sqe;
+
+    head = __atomic_load_n(ring->sq_khead, __ATOMIC_ACQUIRE);
+
+    if (ring->sq_tail - head == ring->sq_entries) {
+
+        if (nxt_io_uring_enter(ring, 0, 0, NULL) == -1) {
+            nxt_alert(&engine->task, "io_uring_enter(%d) failed %E",
+                      ring->fd, nxt_errno);
+        }
+
+        head = __atomic_load_n(ring->sq_khead, __ATOMIC_ACQUIRE);
+
+        if (ring->sq_tail - head == ring->sq_entries) {
+            nxt_alert(&engine->task, "io_uring %d submission queue is full",
+                      ring->fd);
+            return NULL;
+        }
+    }
+
+    sqe = &ring->sqes[ring->sq_tail & ring->sq_mask];
+    ring->sq_tail++;
+
+    nxt_memzero(sqe, sizeof(struct io_uring_sqe));
+
+    return sqe;
+}
+
+
+nxt_bool_t
+nxt_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout)
+{
+    int                            n;
+    uint32_t                       events, head;
+    nxt_err_t                      err;
+    nxt_bool_t                     ready;
+    nxt_uint_t                     wait, level;
+    nxt_io_uring_t                 *ring;
+    struct timespec                ts;
+    struct io_uring_sqe            *sqe;
+    struct io_uring_getevents_arg  arg;
+
+    ring = engine->u.epoll.io_uring;
+
+    if (!ring->epoll_armed) {
+        sqe = nxt_io_uring_sqe(engine, ring);
+
+        if (sqe != NULL) {
+            events = POLLIN;
+
+#if (NXT_HAVE_BIG_ENDIAN)
+            events = (events << 16) | (events >> 16);
+#endif
+
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = engine->u.epoll.fd;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->poll32_events = events;
+            sqe->user_data = NXT_IO_URING_EPOLL;
+
+            ring->epoll_armed = 1;
+        }
+    }
+
+    head = __atomic_load_n(ring->sq_khead, __ATOMIC_ACQUIRE);
+
+    wait = (timeout != 0
+            && *ring->cq_khead == __atomic_load_n(ring->cq_ktail,
+                                                  __ATOMIC_ACQUIRE));
+
+    /* Deferred task work posts completions only in io_uring_enter(). */
+
+    if (wait
+        || ring->sq_tail != head
+        || (__atomic_load_n(ring->sq_kflags, __ATOMIC_RELAXED)
+            & IORING_SQ_TASKRUN))
+    {
+        nxt_memzero(&arg, sizeof(struct io_uring_getevents_arg));
+
+        if (wait && timeout != NXT_INFINITE_MSEC) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+            arg.ts = (uintptr_t) &ts;
+        }
+
+        nxt_debug(&engine->task, "io_uring_enter(%d) submit:%uD timeout:%M",
+                  ring->fd, ring->sq_tail - head, wait ? timeout : 0);
+
+        n = nxt_io_uring_enter(ring, wait,
+                               IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                               &arg);
+
+        err = (n == -1) ? nxt_errno : 0;
+
+        nxt_thread_time_update(engine->task.thread);
+
+        nxt_debug(&engine->task, "io_uring_enter(%d): %d", ring->fd, n);
+
+        if (n == -1 && err != ETIME) {
+            level = (err == NXT_EINTR || err == NXT_EBUSY) ? NXT_LOG_INFO
+                                                           : NXT_LOG_ALERT;
+
+            nxt_log(&engine->task, level, "io_uring_enter(%d) failed %E",
+                    ring->fd, err);
+        }
+
+    } else {
+        nxt_thread_time_update(engine->task.thread);
+    }
+
+    nxt_io_uring_process(engine, ring);
+
+    ready = ring->epoll_ready;
+    ring->epoll_ready = 0;
+
+    return ready;
+}
+
+
+static void
+nxt_io_uring_process(nxt_event_engine_t *engine, nxt_io_uring_t *ring)
+{
+    uint32_t             head, tail;
+    struct io_uring_cqe  cqe;
+
+    for ( ;; ) {
+        head = *ring->cq_khead;
+        tail = __atomic_load_n(ring->cq_ktail, __ATOMIC_ACQUIRE);
+
+        while (head != tail) {
+            cqe = ring->cqes[head & ring->cq_mask];
+            head++;
+
+            __atomic_store_n(ring->cq_khead, head, __ATOMIC_RELEASE);
+
+            nxt_io_uring_complete(engine, ring, &cqe);
+        }
+
+        /* Overflowed completions are flushed to the ring. */
+
+        if ((__atomic_load_n(ring->sq_kflags, __ATOMIC_ACQUIRE)
+             & IORING_SQ_CQ_OVERFLOW) == 0)
+        {
+            return;
+        }
+
+        if (nxt_io_uring_enter(ring, 0, IORING_ENTER_GETEVENTS, NULL) == -1) {
+            nxt_alert(&engine->task, "io_uring_enter(%d) failed %E",
+                      ring->fd, nxt_errno);
+            return;
+        }
+    }
+}
+
+
+static void
+nxt_io_uring_complete(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    struct io_uring_cqe *cqe)
+{
+    nxt_io_uring_req_t  *req;
+
+    switch (cqe->user_data) {
+
+    case NXT_IO_URING_CANCEL:
+        return;
+
+    case NXT_IO_URING_EPOLL:
+        nxt_debug(&engine->task, "io_uring epoll %d: %d fl:%XD",
+                  engine->u.epoll.fd, cqe->res, cqe->flags);
+
+        if (cqe->res < 0) {
+            nxt_alert(&engine->task, "io_uring poll(%d) failed %E",
+                      engine->u.epoll.fd, -cqe->res);
+        }
+
+        ring->epoll_ready = 1;
+
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+            ring->epoll_armed = 0;
+        }
+
+        return;
+
+    default:
+        req = (nxt_io_uring_req_t *) (uintptr_t) cqe->user_data;
+
+        nxt_debug(&engine->task, "io_uring %s(%d): %d fl:%XD",
+                  req->accept ? "accept" : "recv", req->fd,
+                  cqe->res, cqe->flags);
+
+        if (req->accept) {
+            nxt_io_uring_accept_complete(engine, ring, req, cqe);
+
+        } else {
+            nxt_io_uring_recv_complete(engine, ring, req, cqe);
+        }
+
+        return;
+    }
+}
+
+
+static void
+nxt_io_uring_accept_complete(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req, struct io_uring_cqe *cqe)
+{
+    nxt_err_t           err;
+    nxt_bool_t          rearm;
+    nxt_fd_event_t      *ev;
+    nxt_listen_event_t  *lev;
+
+    ev = req->ev;
+
+    if (cqe->res >= 0) {
+
+        if (ev == NULL || nxt_io_uring_push_socket(req, cqe->res) != NXT_OK) {
+            nxt_socket_close(&engine->task, cqe->res);
+
+        } else {
+            if (req->nsockets == NXT_IO_URING_ACCEPT_QUEUE) {
+                nxt_io_uring_cancel(engine, ring, req);
+            }
+
+            if (req->nsockets == 1) {
+                nxt_io_uring_ready(ev);
+            }
+        }
+    }
+
+    if ((cqe->flags & IORING_CQE_F_MORE) != 0) {
+        return;
+    }
+
+    req->armed = 0;
+    req->cancel = 0;
+
+    if (ev == NULL) {
+        nxt_io_uring_req_free(engine, ring, req);
+        return;
+    }
+
+    rearm = req->rearm;
+    req->rearm = 0;
+
+    if (cqe->res >= 0) {
+        /* The multishot request has been terminated by the kernel. */
+        rearm |= (req->nsockets < NXT_IO_URING_ACCEPT_QUEUE);
+
+    } else if (cqe->res != -ECANCELED) {
+        err = -cqe->res;
+        lev = nxt_container_of(ev, nxt_listen_event_t, socket);
+
+        nxt_conn_accept_error(ev->task, lev, "accept", err);
+
+        ev->read_ready = (req->nsockets != 0);
+
+        rearm = (err == NXT_EAGAIN || err == NXT_EINTR
+                 || err == NXT_ECONNABORTED);
+    }
+
+    if (rearm && nxt_fd_event_is_active(ev->read)) {
+        nxt_io_uring_arm(engine, ring, req);
+    }
+}
+
+
+static void
+nxt_io_uring_recv_complete(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req, struct io_uring_cqe *cqe)
+{
+    uint32_t            bid;
+    nxt_fd_event_t      *ev;
+    nxt_io_uring_buf_t  *buf;
+
+    ev = req->ev;
+
+    if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER) != 0) {
+        bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+        if (ev == NULL) {
+            nxt_io_uring_buf_recycle(ring, bid);
+
+        } else {
+            buf = &ring->buf_meta[bid];
+
+            buf->next = -1;
+            buf->pos = 0;
+            buf->end = cqe->res;
+
+            if (req->tail == -1) {
+                req->head = bid;
+
+            } else {
+                ring->buf_meta[req->tail].next = bid;
+            }
+
+            req->tail = bid;
+            req->nbufs++;
+
+            if (req->nbufs == NXT_IO_URING_RECV_BUFS) {
+                nxt_io_uring_cancel(engine, ring, req);
+            }
+
+            if (req->nbufs == 1) {
+                nxt_io_uring_ready(ev);
+            }
+        }
+    }
+
+    if ((cqe->flags & IORING_CQE_F_MORE) != 0) {
+        return;
+    }
+
+    req->armed = 0;
+    req->cancel = 0;
+
+    if (ev == NULL) {
+        nxt_io_uring_req_free(engine, ring, req);
+        return;
+    }
+
+    if (cqe->res == 0) {
+        req->eof = 1;
+
+    } else if (cqe->res < 0 && cqe->res != -ECANCELED
+               && cqe->res != -ENOBUFS)
+    {
+        req->error = -cqe->res;
+    }
+
+    if (req->rearm) {
+        req->rearm = 0;
+        nxt_io_uring_arm(engine, ring, req);
+    }
+
+    /*
+     * The rest of data is read with readv() if the request has been
+     * terminated due to lack of provided buffers or by cancellation.
+     */
+
+    if (req->head == -1) {
+        nxt_io_uring_ready(ev);
+    }
+}
+
+
+static void
+nxt_io_uring_ready(nxt_fd_event_t *ev)
+{
+    ev->read_ready = 1;
+
+    if (nxt_fd_event_is_active(ev->read)) {
+
+        if (ev->read == NXT_EVENT_ONESHOT) {
+            ev->read = NXT_EVENT_DISABLED;
+        }
+
+        nxt_work_queue_add(ev->read_work_queue, ev->read_handler,
+                           ev->task, ev, ev->data);
+    }
+}
+
+
+static nxt_io_uring_req_t *
+nxt_io_uring_req(nxt_event_engine_t *engine, nxt_fd_event_t *ev,
+    nxt_bool_t accept)
+{
+    size_t              size;
+    nxt_uint_t          n;
+    nxt_io_uring_t      *ring;
+    nxt_io_uring_req_t  *req, **reqs;
+
+    ring = engine->u.epoll.io_uring;
+
+    if ((nxt_uint_t) ev->fd < ring->nreqs) {
+        req = ring->reqs[ev->fd];
+
+        if (req != NULL) {
+            if (req->ev == ev) {
+                return req;
+            }
+
+            nxt_io_uring_release(engine, ring, req);
+        }
+
+    } else {
+        n = nxt_max(ring->nreqs * 2, (nxt_uint_t) ev->fd + 1);
+        n = nxt_max(n, 256);
+
+        reqs = nxt_realloc(ring->reqs, n * sizeof(nxt_io_uring_req_t *));
+        if (nxt_slow_path(reqs == NULL)) {
+            return NULL;
+        }
+
+        size = (n - ring->nreqs) * sizeof(nxt_io_uring_req_t *);
+        nxt_memzero(&reqs[ring->nreqs], size);
+
+        ring->reqs = reqs;
+        ring->nreqs = n;
+    }
+
+    req = nxt_zalloc(sizeof(nxt_io_uring_req_t));
+    if (nxt_slow_path(req == NULL)) {
+        return NULL;
+    }
+
+    if (accept) {
+        req->size = NXT_IO_URING_ACCEPT_QUEUE;
+        req->sockets = nxt_malloc(req->size * sizeof(nxt_socket_t));
+
+        if (nxt_slow_path(req->sockets == NULL)) {
+            nxt_free(req);
+            return NULL;
+        }
+    }
+
+    req->ev = ev;
+    req->fd = ev->fd;
+    req->accept = accept;
+    req->head = -1;
+    req->tail = -1;
+
+    nxt_queue_insert_tail(&ring->requests, &req->link);
+
+    ring->reqs[ev->fd] = req;
+
+    return req;
+}
+
+
+static nxt_io_uring_req_t *
+nxt_io_uring_req_find(nxt_io_uring_t *ring, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_req_t  *req;
+
+    if ((nxt_uint_t) ev->fd < ring->nreqs) {
+        req = ring->reqs[ev->fd];
+
+        if (req != NULL && req->ev == ev) {
+            return req;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+nxt_io_uring_arm(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req)
+{
+    struct io_uring_sqe  *sqe;
+
+    if (req->armed) {
+        /* The request is armed again after its cancellation. */
+        req->rearm = req->cancel;
+        return;
+    }
+
+    sqe = nxt_io_uring_sqe(engine, ring);
+    if (nxt_slow_path(sqe == NULL)) {
+        return;
+    }
+
+    if (req->accept) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK;
+
+    } else {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = NXT_IO_URING_BGID;
+    }
+
+    sqe->fd = req->fd;
+    sqe->user_data = (uintptr_t) req;
+
+    req->armed = 1;
+    req->eof = 0;
+    req->error = 0;
+
+    nxt_debug(&engine->task, "io_uring %s(%d) arm",
+              req->accept ? "accept" : "recv", req->fd);
+}
+
+
+static void
+nxt_io_uring_cancel(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req)
+{
+    struct io_uring_sqe  *sqe;
+
+    req->rearm = 0;
+
+    if (!req->armed || req->cancel) {
+        return;
+    }
+
+    sqe = nxt_io_uring_sqe(engine, ring);
+    if (nxt_slow_path(sqe == NULL)) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (uintptr_t) req;
+    sqe->user_data = NXT_IO_URING_CANCEL;
+
+    req->cancel = 1;
+
+    nxt_debug(&engine->task, "io_uring %s(%d) cancel",
+              req->accept ? "accept" : "recv", req->fd);
+}
+
+
+/*
+ * A request is released when its descriptor is going to be closed.
+ * An armed request is freed on its final completion after cancellation.
+ */
+
+static void
+nxt_io_uring_release(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req)
+{
+    nxt_io_uring_req_clear(engine, ring, req);
+
+    if (req->armed) {
+        nxt_io_uring_cancel(engine, ring, req);
+
+    } else {
+        nxt_io_uring_req_free(engine, ring, req);
+    }
+}
+
+
+static void
+nxt_io_uring_req_clear(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req)
+{
+    nxt_socket_t  s;
+
+    ring->reqs[req->fd] = NULL;
+
+    req->ev->io_uring = 0;
+    req->ev = NULL;
+
+    while (req->nsockets != 0) {
+        s = req->sockets[req->first];
+
+        req->first = (req->first + 1) % req->size;
+        req->nsockets--;
+
+        nxt_socket_close(&engine->task, s);
+    }
+
+    while (req->head != -1) {
+        nxt_io_uring_buf_recycle(ring, req->head);
+        req->head = ring->buf_meta[req->head].next;
+    }
+
+    req->tail = -1;
+    req->nbufs = 0;
+}
+
+
+static void
+nxt_io_uring_req_free(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req)
+{
+    if (req->ev != NULL) {
+        nxt_io_uring_req_clear(engine, ring, req);
+    }
+
+    nxt_queue_remove(&req->link);
+
+    nxt_free(req->sockets);
+    nxt_free(req);
+}
+
+
+static nxt_int_t
+nxt_io_uring_push_socket(nxt_io_uring_req_t *req, nxt_socket_t s)
+{
+    uint32_t      i, n;
+    nxt_socket_t  *sockets;
+
+    if (req->nsockets == req->size) {
+        sockets = nxt_malloc(req->size * 2 * sizeof(nxt_socket_t));
+        if (nxt_slow_path(sockets == NULL)) {
+            return NXT_ERROR;
+        }
+
+        for (i = 0; i < req->nsockets; i++) {
+            n = (req->first + i) % req->size;
+            sockets[i] = req->sockets[n];
+        }
+
+        nxt_free(req->sockets);
+
+        req->sockets = sockets;
+        req->first = 0;
+        req->size *= 2;
+    }
+
+    n = (req->first + req->nsockets) % req->size;
+
+    req->sockets[n] = s;
+    req->nsockets++;
+
+    return NXT_OK;
+}
+
+
+nxt_bool_t
+nxt_io_uring_is_listen(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_req_t  *req;
+
+    req = nxt_io_uring_req_find(engine->u.epoll.io_uring, ev);
+
+    return (req != NULL && req->accept);
+}
+
+
+void
+nxt_io_uring_enable_accept(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_req_t  *req;
+
+    ev->read = NXT_EVENT_ACTIVE;
+
+    req = nxt_io_uring_req(engine, ev, 1);
+    if (nxt_slow_path(req == NULL)) {
+        nxt_alert(ev->task, "io_uring accept(%d) cannot be enabled", ev->fd);
+        return;
+    }
+
+    ev->io_uring = 1;
+
+    /* Connections accepted while the event was disabled are processed. */
+    ev->read_ready = (req->nsockets != 0);
+
+    nxt_io_uring_arm(engine, engine->u.epoll.io_uring, req);
+}
+
+
+/* Already accepted connections are kept in the queue. */
+
+void
+nxt_io_uring_disable_accept(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_t      *ring;
+    nxt_io_uring_req_t  *req;
+
+    ev->read = NXT_EVENT_INACTIVE;
+
+    ring = engine->u.epoll.io_uring;
+
+    req = nxt_io_uring_req_find(ring, ev);
+
+    if (req != NULL) {
+        nxt_io_uring_cancel(engine, ring, req);
+    }
+}
+
+
+nxt_int_t
+nxt_io_uring_recv(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_t      *ring;
+    nxt_io_uring_req_t  *req;
+
+    ring = engine->u.epoll.io_uring;
+
+    if (nxt_io_uring_bufs_init(ring) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    req = nxt_io_uring_req(engine, ev, 0);
+    if (nxt_slow_path(req == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_io_uring_arm(engine, ring, req);
+
+    if (nxt_slow_path(!req->armed)) {
+        nxt_io_uring_release(engine, ring, req);
+        return NXT_ERROR;
+    }
+
+    ev->io_uring = 1;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_io_uring_delete(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_t      *ring;
+    nxt_io_uring_req_t  *req;
+
+    ring = engine->u.epoll.io_uring;
+
+    req = nxt_io_uring_req_find(ring, ev);
+
+    if (req != NULL) {
+        nxt_io_uring_release(engine, ring, req);
+    }
+
+    ev->io_uring = 0;
+}
+
+
+/* The buffers are allocated on the first recv request. */
+
+static nxt_int_t
+nxt_io_uring_bufs_init(nxt_io_uring_t *ring)
+{
+    uint32_t  bid;
+
+    if (nxt_fast_path(ring->bufs != NULL)) {
+        return NXT_OK;
+    }
+
+    if (ring->bufs_failed) {
+        return NXT_ERROR;
+    }
+
+    ring->bufs = nxt_malloc(NXT_IO_URING_BUFS * NXT_IO_URING_BUF_SIZE);
+    ring->buf_meta = nxt_malloc(NXT_IO_URING_BUFS
+                                * sizeof(nxt_io_uring_buf_t));
+
+    if (nxt_slow_path(ring->bufs == NULL || ring->buf_meta == NULL)) {
+        nxt_free(ring->bufs);
+        nxt_free(ring->buf_meta);
+
+        ring->bufs = NULL;
+        ring->buf_meta = NULL;
+        ring->bufs_failed = 1;
+
+        return NXT_ERROR;
+    }
+
+    for (bid = 0; bid < NXT_IO_URING_BUFS; bid++) {
+        nxt_io_uring_buf_recycle(ring, bid);
+    }
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_io_uring_buf_recycle(nxt_io_uring_t *ring, uint32_t bid)
+{
+    struct io_uring_buf  *buf;
+
+    buf = &ring->buf_ring->bufs[ring->buf_tail & (NXT_IO_URING_BUFS - 1)];
+
+    buf->addr = (uintptr_t) (ring->bufs + bid * NXT_IO_URING_BUF_SIZE);
+    buf->len = NXT_IO_URING_BUF_SIZE;
+    buf->bid = bid;
+
+    ring->buf_tail++;
+
+    __atomic_store_n(&ring->buf_ring->tail, ring->buf_tail, __ATOMIC_RELEASE);
+}
+
+
+void
+nxt_io_uring_conn_io_accept(nxt_task_t *task, void *obj, void *data)
+{
+    socklen_t           socklen;
+    nxt_err_t           err;
+    nxt_conn_t          *c;
+    nxt_socket_t        s;
+    nxt_fd_event_t      *ev;
+    nxt_io_uring_t      *ring;
+    struct sockaddr     *sa;
+    nxt_listen_event_t  *lev;
+    nxt_event_engine_t  *engine;
+    nxt_io_uring_req_t  *req;
+
+    lev = obj;
+    c = lev->next;
+    ev = &lev->socket;
+
+    engine = task->thread->engine;
+    ring = engine->u.epoll.io_uring;
+
+    /*
+     * The accept batch is not limited, since the next multishot
+     * completion would not schedule the listen event handler again
+     * while the queue of accepted connections is not empty.
+     */
+    lev->ready--;
+
+    req = nxt_io_uring_req_find(ring, ev);
+
+    for ( ;; ) {
+        if (req == NULL || req->nsockets == 0) {
+            ev->read_ready = 0;
+            return;
+        }
+
+        s = req->sockets[req->first];
+
+        req->first = (req->first + 1) % req->size;
+        req->nsockets--;
+
+        if (req->nsockets == 0 && nxt_fd_event_is_active(ev->read)) {
+            /* The request might be cancelled on queue overflow. */
+            nxt_io_uring_arm(engine, ring, req);
+        }
+
+        ev->read_ready = (req->nsockets != 0);
+
+        sa = &c->remote->u.sockaddr;
+        socklen = c->remote->socklen;
+
+        /*
+         * The returned socklen is ignored here,
+         * see comment in nxt_conn_io_accept().
+         */
+        if (nxt_fast_path(getpeername(s, sa, &socklen) == 0)) {
+            break;
+        }
+
+        err = nxt_socket_errno;
+
+        nxt_log(task, nxt_socket_error_level(err),
+                "getpeername(%d) failed %E", s, err);
+
+        nxt_socket_close(task, s);
+    }
+
+    c->socket.fd = s;
+
+    nxt_debug(task, "accept(%d): %d", ev->fd, s);
+
+    nxt_conn_accept(task, lev, c);
+}
+
+
+ssize_t
+nxt_io_uring_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
+{
+    ssize_t                 n;
+    nxt_uint_t              niov;
+    nxt_io_uring_t          *ring;
+    struct iovec            iov[NXT_IOBUF_MAX];
+    nxt_event_engine_t      *engine;
+    nxt_io_uring_req_t      *req;
+    nxt_recvbuf_coalesce_t  rb;
+
+    engine = c->socket.task->thread->engine;
+    ring = engine->u.epoll.io_uring;
+
+    req = nxt_io_uring_req_find(ring, &c->socket);
+
+    if (req != NULL && req->head != -1) {
+        rb.buf = b;
+        rb.iobuf = iov;
+        rb.nmax = NXT_IOBUF_MAX;
+        rb.size = 0;
+
+        niov = nxt_recvbuf_mem_coalesce(&rb);
+
+        n = nxt_io_uring_copy(ring, req, iov, niov, 1);
+
+        c->socket.read_ready = (req->head != -1 || !req->armed);
+
+        nxt_debug(c->socket.task, "io_uring recvbuf(%d): %z",
+                  c->socket.fd, n);
+
+        return n;
+    }
+
+    n = nxt_io_uring_recv_empty(c, req);
+
+    if (n != NXT_DECLINED) {
+        return n;
+    }
+
+    n = nxt_conn_io_recvbuf(c, b);
+
+    if (n > 0 && c->socket.epoll_eof) {
+        c->socket.read_ready = 1;
+    }
+
+    nxt_io_uring_recv_drained(engine, ring, req, c, n);
+
+    return n;
+}
+
+
+ssize_t
+nxt_io_uring_conn_io_recv(nxt_conn_t *c, void *buf, size_t size,
+    nxt_uint_t flags)
+{
+    ssize_t             n;
+    nxt_bool_t          peek;
+    struct iovec        iov;
+    nxt_io_uring_t      *ring;
+    nxt_event_engine_t  *engine;
+    nxt_io_uring_req_t  *req;
+
+    if (!c->socket.io_uring) {
+        return nxt_conn_io_recv(c, buf, size, flags);
+    }
+
+    engine = c->socket.task->thread->engine;
+    ring = engine->u.epoll.io_uring;
+
+    req = nxt_io_uring_req_find(ring, &c->socket);
+
+    peek = ((flags & MSG_PEEK) != 0);
+
+    if (req != NULL && req->head != -1) {
+        iov.iov_base = buf;
+        iov.iov_len = size;
+
+        n = nxt_io_uring_copy(ring, req, &iov, 1, !peek);
+
+        if (!peek) {
+            c->socket.read_ready = (req->head != -1 || !req->armed);
+        }
+
+        nxt_debug(c->socket.task, "io_uring recv(%d, %p, %uz, 0x%ui): %z",
+                  c->socket.fd, buf, size, flags, n);
+
+        return n;
+    }
+
+    n = nxt_io_uring_recv_empty(c, req);
+
+    if (n != NXT_DECLINED) {
+        return n;
+    }
+
+    n = nxt_conn_io_recv(c, buf, size, flags);
+
+    nxt_io_uring_recv_drained(engine, ring, req, c, n);
+
+    return n;
+}
+
+
+static size_t
+nxt_io_uring_copy(nxt_io_uring_t *ring, nxt_io_uring_req_t *req,
+    struct iovec *iov, nxt_uint_t niov, nxt_bool_t consume)
+{
+    u_char              *p;
+    size_t              n, size, offset;
+    int32_t             bid;
+    uint32_t            pos;
+    nxt_io_uring_buf_t  *buf;
+
+    n = 0;
+    offset = 0;
+    bid = req->head;
+    pos = ring->buf_meta[bid].pos;
+
+    while (niov != 0) {
+        buf = &ring->buf_meta[bid];
+        p = ring->bufs + bid * NXT_IO_URING_BUF_SIZE;
+
+        size = nxt_min(buf->end - pos, iov->iov_len - offset);
+
+        nxt_memcpy((u_char *) iov->iov_base + offset, p + pos, size);
+
+        n += size;
+        pos += size;
+        offset += size;
+
+        if (offset == iov->iov_len) {
+            iov++;
+            niov--;
+            offset = 0;
+        }
+
+        if (pos != buf->end) {
+            continue;
+        }
+
+        if (consume) {
+            req->head = buf->next;
+            req->nbufs--;
+
+            nxt_io_uring_buf_recycle(ring, bid);
+        }
+
+        bid = buf->next;
+
+        if (bid == -1) {
+            break;
+        }
+
+        pos = ring->buf_meta[bid].pos;
+    }
+
+    if (consume) {
+        if (req->head == -1) {
+            req->tail = -1;
+
+        } else {
+            ring->buf_meta[req->head].pos = pos;
+        }
+    }
+
+    return n;
+}
+
+
+static ssize_t
+nxt_io_uring_recv_empty(nxt_conn_t *c, nxt_io_uring_req_t *req)
+{
+    if (req == NULL) {
+        return NXT_DECLINED;
+    }
+
+    if (req->armed) {
+        c->socket.read_ready = 0;
+        return NXT_AGAIN;
+    }
+
+    if (req->eof) {
+        c->socket.closed = 1;
+        c->socket.read_ready = 0;
+        return 0;
+    }
+
+    if (req->error != 0) {
+        c->socket.error = req->error;
+
+        nxt_log(c->socket.task, nxt_socket_error_level(req->error),
+                "io_uring recv(%d) failed %E", c->socket.fd, req->error);
+
+        return NXT_ERROR;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+/*
+ * Read events of a connection are masked in the epoll set, so the recv
+ * request must be armed again once readv() or recv() has drained the
+ * socket, including the case when nothing has been left to read after
+ * the request has been cancelled or has run out of provided buffers.
+ */
+
+static void
+nxt_io_uring_recv_drained(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req, nxt_conn_t *c, ssize_t n)
+{
+    if (req != NULL && !c->socket.read_ready && (n > 0 || n == NXT_AGAIN)) {
+        nxt_io_uring_arm(engine, ring, req);
+    }
+}
+
+
+#if (NXT_TESTS)
+
+static nxt_int_t nxt_io_uring_test_wait(nxt_event_engine_t *engine,
+    nxt_io_uring_t *ring, nxt_io_uring_req_t *req);
+
+
+nxt_int_t
+nxt_io_uring_test(nxt_thread_t *thr)
+{
+    u_char              *p, buf[8192];
+    size_t              size, len;
+    ssize_t             n;
+    uint32_t            nbufs;
+    nxt_int_t           ret;
+    nxt_uint_t          i;
+    nxt_conn_t          c;
+    nxt_task_t          task;
+    nxt_socket_t        sv[2];
+    struct iovec        iov[2];
+    nxt_io_uring_t      *ring;
+    nxt_event_engine_t  engine, *prev;
+    nxt_io_uring_req_t  *req;
+
+    static u_char       data[5 * NXT_IO_URING_BUF_SIZE + 4000];
+
+    nxt_memzero(&engine, sizeof(nxt_event_engine_t));
+
+    engine.task.thread = thr;
+    engine.task.log = thr->log;
+
+    if (nxt_io_uring_create(&engine) != NXT_OK) {
+        nxt_io_uring_free(&engine);
+
+        nxt_log_error(NXT_LOG_NOTICE, thr->log, "io_uring test skipped");
+        return NXT_OK;
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) != 0) {
+        nxt_log_alert(thr->log, "socketpair() failed %E", nxt_errno);
+        nxt_io_uring_free(&engine);
+        return NXT_ERROR;
+    }
+
+    prev = thr->engine;
+    thr->engine = &engine;
+
+    task = engine.task;
+
+    nxt_memzero(&c, sizeof(nxt_conn_t));
+
+    c.socket.fd = sv[0];
+    c.socket.task = &task;
+    c.socket.log = thr->log;
+
+    ret = NXT_ERROR;
+    ring = engine.u.epoll.io_uring;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (u_char) (i * 7 + i / 251);
+    }
+
+    if (nxt_io_uring_recv(&engine, &c.socket) != NXT_OK) {
+        goto fail;
+    }
+
+    req = nxt_io_uring_req_find(ring, &c.socket);
+
+    /*
+     * The first part is received to provided buffers and the request
+     * is cancelled after NXT_IO_URING_RECV_BUFS buffers, so the second
+     * part is left in the socket.  The second part is a multiple of the
+     * read size below, so the socket is drained by a complete read.
+     */
+
+    size = 5 * NXT_IO_URING_BUF_SIZE;
+
+    if (write(sv[1], data, size) != (ssize_t) size) {
+        goto fail;
+    }
+
+    if (nxt_io_uring_test_wait(&engine, ring, req) != NXT_OK
+        || req->nbufs < NXT_IO_URING_RECV_BUFS)
+    {
+        nxt_log_alert(thr->log, "io_uring test: recv has not been cancelled");
+        goto fail;
+    }
+
+    len = sizeof(data) - size;
+
+    if (write(sv[1], data + size, len) != (ssize_t) len) {
+        goto fail;
+    }
+
+    nbufs = req->nbufs;
+
+    n = nxt_io_uring_conn_io_recv(&c, buf, 100, MSG_PEEK);
+
+    if (n != 100 || memcmp(buf, data, 100) != 0 || req->nbufs != nbufs) {
+        nxt_log_alert(thr->log, "io_uring test: peek failed");
+        goto fail;
+    }
+
+    /* The buffers are crossed by both iovecs. */
+
+    iov[0].iov_base = buf;
+    iov[0].iov_len = 777;
+    iov[1].iov_base = buf + 777;
+    iov[1].iov_len = 5000;
+
+    len = nxt_io_uring_copy(ring, req, iov, 2, 1);
+
+    if (len != 5777 || memcmp(buf, data, len) != 0) {
+        nxt_log_alert(thr->log, "io_uring test: copy failed");
+        goto fail;
+    }
+
+    /*
+     * The rest is read by 1000 bytes from the provided buffers, then from
+     * the socket, and the drained socket must have the request armed.
+     */
+
+    p = data + len;
+
+    for ( ;; ) {
+        c.socket.read_ready = 1;
+
+        n = nxt_io_uring_conn_io_recv(&c, buf, 1000, 0);
+
+        if (n <= 0) {
+            break;
+        }
+
+        if (p + n > data + sizeof(data) || memcmp(buf, p, n) != 0) {
+            nxt_log_alert(thr->log, "io_uring test: invalid data");
+            goto fail;
+        }
+
+        p += n;
+    }
+
+    if (n != NXT_AGAIN || p != data + sizeof(data)
+        || req->head != -1 || req->tail != -1 || req->nbufs != 0)
+    {
+        nxt_log_alert(thr->log, "io_uring test: recv returned %z", n);
+        goto fail;
+    }
+
+    if (!req->armed) {
+        nxt_log_alert(thr->log, "io_uring test: drained recv is not armed");
+        goto fail;
+    }
+
+    if (nxt_io_uring_enter(ring, 0, IORING_ENTER_GETEVENTS, NULL) == -1) {
+        goto fail;
+    }
+
+    nxt_io_uring_process(&engine, ring);
+
+    c.socket.read_ready = 1;
+
+    n = nxt_io_uring_conn_io_recv(&c, buf, 1000, 0);
+
+    if (n != NXT_AGAIN || c.socket.read_ready) {
+        nxt_log_alert(thr->log, "io_uring test: armed recv returned %z", n);
+        goto fail;
+    }
+
+    (void) shutdown(sv[1], SHUT_WR);
+
+    if (nxt_io_uring_test_wait(&engine, ring, req) != NXT_OK) {
+        goto fail;
+    }
+
+    n = nxt_io_uring_conn_io_recv(&c, buf, 1000, 0);
+
+    if (n != 0 || !c.socket.closed) {
+        nxt_log_alert(thr->log, "io_uring test: eof recv returned %z", n);
+        goto fail;
+    }
+
+    ret = NXT_OK;
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "io_uring test passed");
+
+fail:
+
+    if (ret != NXT_OK) {
+        nxt_log_error(NXT_LOG_NOTICE, thr->log, "io_uring test failed");
+    }
+
+    nxt_io_uring_free(&engine);
+
+    thr->engine = prev;
+
+    nxt_socket_close(&task, sv[0]);
+    nxt_socket_close(&task, sv[1]);
+
+    return ret;
+}
+
+
+static nxt_int_t
+nxt_io_uring_test_wait(nxt_event_engine_t *engine, nxt_io_uring_t *ring,
+    nxt_io_uring_req_t *req)
+{
+    nxt_uint_t                     i;
+    struct timespec                ts;
+    struct io_uring_getevents_arg  arg;
+
+    for (i = 0; i < 10 && req->armed; i++) {
+        nxt_memzero(&arg, sizeof(struct io_uring_getevents_arg));
+
+        ts.tv_sec = 1;
+        ts.tv_nsec = 0;
+        arg.ts = (uintptr_t) &ts;
+
+        if (nxt_io_uring_enter(ring, 1,
+                               IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                               &arg)
+            == -1
+            && nxt_errno != ETIME)
+        {
+            return NXT_ERROR;
+        }
+
+        nxt_io_uring_process(engine, ring);
+    }
+
+    return req->armed ? NXT_ERROR : NXT_OK;
+}
+
+#endif
@@ -13,6 +13,10 @@ typedef struct {
     nxt_socket_t              socket;
     int                       backlog;
 
+    /* SO_REUSEPORT sockets of router engines, the first one is "socket". */
+    nxt_socket_t              *sockets;
+    uint32_t                  nsockets;
+
     nxt_work_queue_t          *work_queue;
     nxt_work_handler_t        handler;
 
@@ -22,6 +26,7 @@ typedef struct {
 
     uint8_t                   flags;
     uint8_t                   read_after_accept;   /* 1 bit */
+    uint8_t                   reuseport;           /* 2 bits */
 
 #if (NXT_TLS)
     uint8_t                   tls;                 /* 1 bit */
@@ -35,6 +40,10 @@ typedef struct {
 } nxt_listen_socket_t;
 
 
+#define NXT_LISTEN_REUSEPORT      1
+#define NXT_LISTEN_REUSEPORT_CPU  2
+
+
 #if (NXT_FREEBSD || NXT_MACOSX || NXT_OPENBSD)
 /*
  * A backlog is limited by system-wide sysctl kern.ipc.somaxconn.
@@ -48,6 +48,7 @@ typedef uint16_t                     nxt_port_id_t;
 #include <nxt_random.h>
 #include <nxt_string.h>
 #include <nxt_lvlhsh.h>
+#include <nxt_aho_corasick.h>
 #include <nxt_atomic.h>
 #include <nxt_spinlock.h>
 #include <nxt_work_queue.h>
@@ -139,6 +140,7 @@ nxt_thread_extern_data(nxt_thread_t, nxt_thread_context);
 #include <nxt_port_memory.h>
 #include <nxt_port_rpc.h>
 #include <nxt_thread_pool.h>
+#include <nxt_cpuset.h>
 
 
 typedef void (*nxt_event_conn_handler_t)(nxt_thread_t *thr, nxt_conn_t *c);
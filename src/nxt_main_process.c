@@ -24,6 +24,7 @@
 typedef struct {
     nxt_socket_t        socket;
     nxt_socket_error_t  error;
+    nxt_uint_t          reuseport;
     u_char              *start;
     u_char              *end;
 } nxt_listening_socket_t;
@@ -159,6 +160,12 @@ static nxt_conf_map_t  nxt_common_app_conf[] = {
         offsetof(nxt_common_app_conf_t, limits),
     },
 
+    {
+        nxt_string("cpu_affinity"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_common_app_conf_t, cpu_affinity),
+    },
+
 };
 
 
@@ -1121,8 +1128,17 @@ nxt_main_port_socket_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 
     /* TODO check b size and make plain */
 
+    size = nxt_sockaddr_size(sa);
+
     ls.socket = -1;
     ls.error = NXT_SOCKET_ERROR_SYSTEM;
+    ls.reuseport = 0;
+
+    /* The sockaddr may be followed by the reuseport mode. */
+
+    if (nxt_buf_mem_used_size(&b->mem) > (ssize_t) size) {
+        ls.reuseport = b->mem.pos[size];
+    }
     ls.start = message;
     ls.end = message + sizeof(message);
 
@@ -1197,6 +1213,20 @@ nxt_main_listening_socket(nxt_sockaddr_t *sa, nxt_listening_socket_t *ls)
         goto fail;
     }
 
+#ifdef SO_REUSEPORT
+
+    if (ls->reuseport
+        && setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &enable, length) != 0)
+    {
+        ls->end = nxt_sprintf(ls->start, ls->end,
+                              "setsockopt(\\\"%*s\\\", SO_REUSEPORT) failed %E",
+                              (size_t) sa->length, nxt_sockaddr_start(sa),
+                              nxt_errno);
+        goto fail;
+    }
+
+#endif
+
 #if (NXT_INET6)
 
     if (sa->u.sockaddr.sa_family == AF_INET6) {
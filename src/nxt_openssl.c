@@ -18,19 +18,52 @@
 #include <openssl/evp.h>
 
 
+/*
+ * Serialized sessions with client certificates can be larger,
+ * such sessions are not stored in the shared session cache.
+ */
+
+#define NXT_TLS_SESSION_MAX_SIZE  4096
+
+/* The maximum DNS host name length. */
+
+#define NXT_TLS_SERVERNAME_MAX    255
+
+
 typedef struct {
     SSL               *session;
     nxt_conn_t        *conn;
 
     int               ssl_error;
-    uint8_t           times;      /* 2 bits */
-    uint8_t           handshake;  /* 1 bit  */
+    uint8_t           times;        /* 2 bits */
+    uint8_t           handshake;    /* 1 bit  */
+    uint8_t           offload;      /* 1 bit  */
+    uint8_t           write_again;  /* 1 bit  */
+    uint8_t           early_data;   /* 1 bit  */
+    uint8_t           early_done;   /* 1 bit  */
+    uint8_t           early_size;   /* 1 bit  */
+    u_char            early_byte;
+    uint8_t           records;
+
+    /* Session cache lookups of an offloaded handshake. */
+    uint8_t           session_hits;
+    uint8_t           session_misses;
+
+    nxt_msec_t        write_time;
 
     nxt_tls_conf_t    *conf;
     nxt_buf_mem_t     buffer;
 } nxt_openssl_conn_t;
 
 
+typedef struct {
+    nxt_job_t         job;
+    nxt_task_t        task;
+    nxt_int_t         ret;
+    uint8_t           timer;        /* 1 bit  */
+} nxt_openssl_handshake_job_t;
+
+
 struct nxt_tls_ticket_s {
     u_char            name[16];
     u_char            hmac_key[32];
@@ -75,8 +108,15 @@ static nxt_int_t nxt_tls_ticket_keys(nxt_task_t *task, SSL_CTX *ctx,
 static int nxt_tls_ticket_key_callback(SSL *s, unsigned char *name,
     unsigned char *iv, EVP_CIPHER_CTX *ectx,HMAC_CTX *hctx, int enc);
 #endif
-static void nxt_ssl_session_cache(SSL_CTX *ctx, size_t cache_size,
-    time_t timeout);
+static nxt_int_t nxt_ssl_session_cache(nxt_task_t *task, SSL_CTX *ctx,
+    nxt_tls_init_t *tls_init);
+static int nxt_ssl_session_new(SSL *s, SSL_SESSION *sess);
+static SSL_SESSION *nxt_ssl_session_get(SSL *s,
+#if OPENSSL_VERSION_NUMBER >= 0x10100003L
+    const
+#endif
+    unsigned char *id, int len, int *copy);
+static void nxt_ssl_session_remove(SSL_CTX *ctx, SSL_SESSION *sess);
 static nxt_uint_t nxt_openssl_cert_get_names(nxt_task_t *task, X509 *cert,
     nxt_tls_conf_t *conf, nxt_mp_t *mp);
 static nxt_int_t nxt_openssl_bundle_hash_test(nxt_lvlhsh_query_t *lhq,
@@ -84,16 +124,37 @@ static nxt_int_t nxt_openssl_bundle_hash_test(nxt_lvlhsh_query_t *lhq,
 static nxt_int_t nxt_openssl_bundle_hash_insert(nxt_task_t *task,
     nxt_lvlhsh_t *lvlhsh, nxt_tls_bundle_hash_item_t *item, nxt_mp_t * mp);
 static nxt_int_t nxt_openssl_servername(SSL *s, int *ad, void *arg);
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+static int nxt_openssl_alpn_select(SSL *s, const unsigned char **out,
+    unsigned char *outlen, const unsigned char *in, unsigned int inlen,
+    void *arg);
+#endif
 static nxt_tls_bundle_conf_t *nxt_openssl_find_ctx(nxt_tls_conf_t *conf,
     nxt_str_t *sn);
 static void nxt_openssl_server_free(nxt_task_t *task, nxt_tls_conf_t *conf);
 static void nxt_openssl_conn_init(nxt_task_t *task, nxt_tls_conf_t *conf,
     nxt_conn_t *c);
 static void nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data);
+static int nxt_openssl_handshake(nxt_openssl_conn_t *tls);
+static void nxt_openssl_conn_handshake_next(nxt_task_t *task, nxt_conn_t *c,
+    nxt_int_t n, void *data);
+static nxt_int_t nxt_openssl_conn_handshake_offload(nxt_task_t *task,
+    nxt_conn_t *c);
+static void nxt_openssl_conn_handshake_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_openssl_conn_handshake_done(nxt_task_t *task, void *obj,
+    void *data);
 static ssize_t nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b);
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+static ssize_t nxt_openssl_conn_io_recv_early(nxt_conn_t *c, nxt_buf_t *b);
+#endif
 static ssize_t nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb);
 static ssize_t nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb,
     void *buf, size_t size);
+#if (NXT_HAVE_OPENSSL_KTLS)
+static ssize_t nxt_openssl_conn_io_sendfile(nxt_task_t *task,
+    nxt_sendbuf_t *sb);
+#endif
 static void nxt_openssl_conn_io_shutdown(nxt_task_t *task, void *obj,
     void *data);
 static nxt_int_t nxt_openssl_conn_test_error(nxt_task_t *task, nxt_conn_t *c,
@@ -127,6 +188,7 @@ static nxt_conn_io_t  nxt_openssl_conn_io = {
 
 static long  nxt_openssl_version;
 static int   nxt_openssl_connection_index;
+static int   nxt_openssl_session_cache_index;
 
 
 static nxt_int_t
@@ -198,6 +260,16 @@ nxt_openssl_library_init(nxt_task_t *task)
 
     nxt_openssl_connection_index = index;
 
+    index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+
+    if (index == -1) {
+        nxt_openssl_log_error(task, NXT_LOG_ALERT,
+                              "SSL_CTX_get_ex_new_index() failed");
+        return NXT_ERROR;
+    }
+
+    nxt_openssl_session_cache_index = index;
+
     return NXT_OK;
 }
 
@@ -378,7 +450,9 @@ nxt_openssl_server_init(nxt_task_t *task, nxt_mp_t *mp,
     }
 #endif
 
-    nxt_ssl_session_cache(ctx, tls_init->cache_size, tls_init->timeout);
+    if (nxt_ssl_session_cache(task, ctx, tls_init) != NXT_OK) {
+        goto fail;
+    }
 
 #if (NXT_HAVE_OPENSSL_TLSEXT)
     if (nxt_tls_ticket_keys(task, ctx, tls_init, mp) != NXT_OK) {
@@ -388,6 +462,35 @@ nxt_openssl_server_init(nxt_task_t *task, nxt_mp_t *mp,
 
     SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+    if (tls_init->http2) {
+        SSL_CTX_set_alpn_select_cb(ctx, nxt_openssl_alpn_select, NULL);
+    }
+#endif
+
+#if (NXT_HAVE_OPENSSL_KTLS)
+    if (tls_init->ktls) {
+        /*
+         * OpenSSL falls back to user space records if the kernel
+         * does not support TLS offload for the negotiated cipher.
+         */
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+#endif
+
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+    if (tls_init->early_data) {
+        /*
+         * The OpenSSL anti-replay protection requires the internal session
+         * cache.  Instead, stateful TLSv1.3 tickets are kept in the shared
+         * session cache and are used only once, see nxt_ssl_session_get().
+         * Stateless tickets are disabled by the configuration validation.
+         */
+        SSL_CTX_set_max_early_data(ctx, NXT_TLS_EARLY_DATA_MAX);
+        SSL_CTX_set_options(ctx, SSL_OP_NO_ANTI_REPLAY);
+    }
+#endif
+
     if (conf->ca_certificate != NULL) {
 
         /* TODO: verify callback */
@@ -829,19 +932,181 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
 #endif /* NXT_HAVE_OPENSSL_TLSEXT */
 
 
-static void
-nxt_ssl_session_cache(SSL_CTX *ctx, size_t cache_size, time_t timeout)
+/*
+ * Sessions are stored only in the shared session cache of the listener,
+ * which outlives the context, so the OpenSSL internal cache is disabled.
+ */
+
+static nxt_int_t
+nxt_ssl_session_cache(nxt_task_t *task, SSL_CTX *ctx, nxt_tls_init_t *tls_init)
 {
-    if (cache_size == 0) {
+    if (tls_init->session_cache == NULL) {
         SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
-        return;
+        return NXT_OK;
+    }
+
+    if (SSL_CTX_set_ex_data(ctx, nxt_openssl_session_cache_index,
+                            tls_init->session_cache)
+        == 0)
+    {
+        nxt_openssl_log_error(task, NXT_LOG_ALERT,
+                              "SSL_CTX_set_ex_data() failed");
+        return NXT_ERROR;
+    }
+
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER
+                                        | SSL_SESS_CACHE_NO_INTERNAL);
+
+    SSL_CTX_sess_set_new_cb(ctx, nxt_ssl_session_new);
+    SSL_CTX_sess_set_get_cb(ctx, nxt_ssl_session_get);
+    SSL_CTX_sess_set_remove_cb(ctx, nxt_ssl_session_remove);
+
+    SSL_CTX_set_timeout(ctx, (long) tls_init->timeout);
+
+    return NXT_OK;
+}
+
+
+static int
+nxt_ssl_session_new(SSL *s, SSL_SESSION *sess)
+{
+    int                      len;
+    u_char                   *p, buf[NXT_TLS_SESSION_MAX_SIZE];
+    nxt_conn_t               *c;
+    unsigned int             id_len;
+    const unsigned char      *id;
+    nxt_tls_session_cache_t  *cache;
+
+    c = SSL_get_ex_data(s, nxt_openssl_connection_index);
+    cache = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(s),
+                                nxt_openssl_session_cache_index);
+
+    if (nxt_slow_path(c == NULL || cache == NULL)) {
+        return 0;
     }
 
-    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    len = i2d_SSL_SESSION(sess, NULL);
 
-    SSL_CTX_sess_set_cache_size(ctx, cache_size);
+    if (len <= 0 || len > NXT_TLS_SESSION_MAX_SIZE) {
+        nxt_debug(c->socket.task, "TLS session is not cached, size: %d", len);
+        return 0;
+    }
+
+    p = buf;
+    (void) i2d_SSL_SESSION(sess, &p);
+
+    id = SSL_SESSION_get_id(sess, &id_len);
+
+    nxt_debug(c->socket.task, "TLS session cache add, id length: %ud",
+              id_len);
+
+    (void) nxt_tls_session_cache_add(cache, (u_char *) id, id_len, buf, len,
+                                     SSL_SESSION_get_time(sess)
+                                     + SSL_SESSION_get_timeout(sess));
+
+    /* The session reference is not kept. */
 
-    SSL_CTX_set_timeout(ctx, (long) timeout);
+    return 0;
+}
+
+
+static SSL_SESSION *
+nxt_ssl_session_get(SSL *s,
+#if OPENSSL_VERSION_NUMBER >= 0x10100003L
+    const
+#endif
+    unsigned char *id, int len, int *copy)
+{
+    size_t                   size;
+    u_char                   buf[NXT_TLS_SESSION_MAX_SIZE];
+    nxt_conn_t               *c;
+    nxt_bool_t               remove;
+    nxt_time_t               now;
+    SSL_SESSION              *sess;
+    nxt_event_engine_t       *engine;
+    nxt_openssl_conn_t       *tls;
+    const unsigned char      *p;
+    nxt_tls_session_cache_t  *cache;
+
+    *copy = 0;
+
+    c = SSL_get_ex_data(s, nxt_openssl_connection_index);
+    cache = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(s),
+                                nxt_openssl_session_cache_index);
+
+    if (nxt_slow_path(c == NULL || cache == NULL)) {
+        return NULL;
+    }
+
+    tls = c->u.tls;
+
+    /* The handshake may be offloaded to a thread pool thread. */
+    now = nxt_thread_time(nxt_thread());
+
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+    /*
+     * TLSv1.3 sessions of a listener which accepts early data are used
+     * only once, so early data of a replayed ClientHello are rejected.
+     */
+    remove = (tls->conf->early_data && SSL_version(s) == TLS1_3_VERSION);
+#else
+    remove = 0;
+#endif
+
+    size = nxt_tls_session_cache_lookup(cache, (u_char *) id, len, buf,
+                                        sizeof(buf), now, remove);
+
+    nxt_debug(c->socket.task, "TLS session cache lookup: %uz", size);
+
+    sess = NULL;
+
+    if (size != 0) {
+        p = buf;
+        sess = d2i_SSL_SESSION(NULL, &p, size);
+    }
+
+    if (tls->offload) {
+        /* Counted by nxt_openssl_conn_handshake_done() in the engine. */
+
+        if (sess != NULL) {
+            tls->session_hits++;
+
+        } else {
+            tls->session_misses++;
+        }
+
+        return sess;
+    }
+
+    engine = c->socket.task->thread->engine;
+
+    if (sess != NULL) {
+        engine->tls_session_cache_hits_cnt++;
+
+    } else {
+        engine->tls_session_cache_misses_cnt++;
+    }
+
+    return sess;
+}
+
+
+static void
+nxt_ssl_session_remove(SSL_CTX *ctx, SSL_SESSION *sess)
+{
+    unsigned int             id_len;
+    const unsigned char      *id;
+    nxt_tls_session_cache_t  *cache;
+
+    cache = SSL_CTX_get_ex_data(ctx, nxt_openssl_session_cache_index);
+
+    if (nxt_slow_path(cache == NULL)) {
+        return;
+    }
+
+    id = SSL_SESSION_get_id(sess, &id_len);
+
+    nxt_tls_session_cache_delete(cache, (u_char *) id, id_len);
 }
 
 
@@ -1029,6 +1294,7 @@ nxt_openssl_bundle_hash_insert(nxt_task_t *task, nxt_lvlhsh_t *lvlhsh,
 static nxt_int_t
 nxt_openssl_servername(SSL *s, int *ad, void *arg)
 {
+    u_char                 name[NXT_TLS_SERVERNAME_MAX];
     nxt_str_t              str;
     nxt_uint_t             i;
     nxt_conn_t             *c;
@@ -1063,12 +1329,18 @@ nxt_openssl_servername(SSL *s, int *ad, void *arg)
         goto done;
     }
 
+    if (str.length > NXT_TLS_SERVERNAME_MAX) {
+        nxt_debug(c->socket.task, "ignored the server name: too long");
+        goto done;
+    }
+
     nxt_debug(c->socket.task, "tls with servername \"%s\"", servername);
 
-    str.start = nxt_mp_nget(c->mem_pool, str.length);
-    if (nxt_slow_path(str.start == NULL)) {
-        return SSL_TLSEXT_ERR_ALERT_FATAL;
-    }
+    /*
+     * The callback may be called in a thread pool thread during
+     * offloaded handshake, so the connection memory pool is not used.
+     */
+    str.start = name;
 
     nxt_memcpy_lowcase(str.start, (const u_char *) servername, str.length);
 
@@ -1110,6 +1382,29 @@ nxt_openssl_servername(SSL *s, int *ad, void *arg)
 }
 
 
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+
+static int
+nxt_openssl_alpn_select(SSL *s, const unsigned char **out,
+    unsigned char *outlen, const unsigned char *in, unsigned int inlen,
+    void *arg)
+{
+    int                  ret;
+    static const u_char  protos[] = "\x02h2\x08http/1.1";
+
+    ret = SSL_select_next_proto((unsigned char **) out, outlen, protos,
+                                sizeof(protos) - 1, in, inlen);
+
+    if (ret != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    return SSL_TLSEXT_ERR_OK;
+}
+
+#endif
+
+
 static nxt_tls_bundle_conf_t *
 nxt_openssl_find_ctx(nxt_tls_conf_t *conf, nxt_str_t *sn)
 {
@@ -1237,14 +1532,11 @@ nxt_openssl_conn_free(nxt_task_t *task, nxt_conn_t *c)
 static void
 nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
 {
-    int                     ret;
-    nxt_int_t               n;
-    nxt_err_t               err;
-    nxt_conn_t              *c;
-    nxt_work_queue_t        *wq;
-    nxt_work_handler_t      handler;
-    nxt_openssl_conn_t      *tls;
-    const nxt_conn_state_t  *state;
+    int                 ret;
+    nxt_int_t           n;
+    nxt_err_t           err;
+    nxt_conn_t          *c;
+    nxt_openssl_conn_t  *tls;
 
     c = obj;
 
@@ -1256,15 +1548,28 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
 
     tls = c->u.tls;
 
-    if (tls == NULL) {
+    if (tls == NULL || tls->offload) {
         return;
     }
 
     nxt_debug(task, "openssl conn handshake: %d times", tls->times);
 
-    /* "tls->times == 1" is suitable to run SSL_do_handshake() in job. */
+    /*
+     * The first handshake step is called when ClientHello has been
+     * already received, so the step includes the server private key
+     * operation and is worth to run in a thread pool.
+     */
 
-    ret = SSL_do_handshake(tls->session);
+    if (tls->times == 0
+        && tls->conf->thread_pool != NULL
+        && c->read_state != NULL)
+    {
+        if (nxt_openssl_conn_handshake_offload(task, c) == NXT_OK) {
+            return;
+        }
+    }
+
+    ret = nxt_openssl_handshake(tls);
 
     err = (ret <= 0) ? nxt_socket_errno : 0;
 
@@ -1272,26 +1577,9 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "SSL_do_handshake(%d): %d err:%d", c->socket.fd, ret, err);
 
-    state = (c->read_state != NULL) ? c->read_state : c->write_state;
-
     if (ret > 0) {
         /* ret == 1, the handshake was successfully completed. */
-        tls->handshake = 1;
-
-        if (c->read_state != NULL) {
-            if (state->io_read_handler != NULL || c->read != NULL) {
-                nxt_conn_read(task->thread->engine, c);
-                return;
-            }
-
-        } else {
-            if (c->write != NULL) {
-                nxt_conn_write(task->thread->engine, c);
-                return;
-            }
-        }
-
-        handler = state->ready_handler;
+        n = NXT_OK;
 
     } else {
         c->socket.read_handler = nxt_openssl_conn_handshake;
@@ -1309,18 +1597,125 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
             return;
 
         case 0:
-            handler = state->close_handler;
+            n = NXT_DECLINED;
             break;
 
         default:
         case NXT_ERROR:
             nxt_openssl_conn_error(task, err, "SSL_do_handshake(%d) failed",
                                    c->socket.fd);
+            n = NXT_ERROR;
+            break;
+        }
+    }
+
+    nxt_openssl_conn_handshake_next(task, c, n, data);
+}
+
+
+/*
+ * If the listener accepts TLSv1.3 early data, the handshake is driven by
+ * SSL_read_early_data(), which completes once the server has sent its
+ * Finished message and has read the first byte of early data.  The rest
+ * of early data is read by nxt_openssl_conn_io_recv_early() before the
+ * client Finished message, so requests are processed a round trip earlier.
+ * If the client has not sent early data or early data have been rejected,
+ * the handshake is completed by SSL_do_handshake() as usual.
+ */
+
+static int
+nxt_openssl_handshake(nxt_openssl_conn_t *tls)
+{
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+    int     ret;
+    size_t  n;
 
-            handler = state->error_handler;
+    if (tls->conf->early_data && !tls->early_done) {
+        ret = SSL_read_early_data(tls->session, &tls->early_byte, 1, &n);
+
+        switch (ret) {
+
+        case SSL_READ_EARLY_DATA_SUCCESS:
+            tls->early_data = 1;
+            tls->early_size = n;
+            return 1;
+
+        case SSL_READ_EARLY_DATA_FINISH:
+            tls->early_done = 1;
             break;
+
+        default: /* SSL_READ_EARLY_DATA_ERROR */
+            return 0;
         }
     }
+#endif
+
+    return SSL_do_handshake(tls->session);
+}
+
+
+static void
+nxt_openssl_conn_handshake_next(nxt_task_t *task, nxt_conn_t *c, nxt_int_t n,
+    void *data)
+{
+    nxt_work_queue_t        *wq;
+    nxt_work_handler_t      handler;
+    nxt_openssl_conn_t      *tls;
+    const nxt_conn_state_t  *state;
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+    unsigned int            len;
+    const unsigned char     *proto;
+#endif
+
+    tls = c->u.tls;
+
+    state = (c->read_state != NULL) ? c->read_state : c->write_state;
+
+    switch (n) {
+
+    case NXT_OK:
+        /* The handshake is completed later if early data are being read. */
+        tls->handshake = !tls->early_data;
+        c->tls_early_data = tls->early_data;
+
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+        SSL_get0_alpn_selected(tls->session, &proto, &len);
+
+        c->http2 = (len == 2 && proto[0] == 'h' && proto[1] == '2');
+#endif
+
+#if (NXT_HAVE_OPENSSL_KTLS)
+        if (tls->handshake && BIO_get_ktls_send(SSL_get_wbio(tls->session))) {
+            nxt_debug(task, "openssl kTLS send fd:%d", c->socket.fd);
+
+            c->sendfile = NXT_CONN_SENDFILE_ON;
+        }
+#endif
+
+        if (c->read_state != NULL) {
+            if (state->io_read_handler != NULL || c->read != NULL) {
+                nxt_conn_read(task->thread->engine, c);
+                return;
+            }
+
+        } else {
+            if (c->write != NULL) {
+                nxt_conn_write(task->thread->engine, c);
+                return;
+            }
+        }
+
+        handler = state->ready_handler;
+        break;
+
+    case NXT_DECLINED:
+        handler = state->close_handler;
+        break;
+
+    default:
+        handler = state->error_handler;
+        break;
+    }
 
     wq = (c->read_state != NULL) ? c->read_work_queue : c->write_work_queue;
 
@@ -1328,6 +1723,171 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static nxt_int_t
+nxt_openssl_conn_handshake_offload(nxt_task_t *task, nxt_conn_t *c)
+{
+    nxt_event_engine_t           *engine;
+    nxt_openssl_conn_t           *tls;
+    nxt_openssl_handshake_job_t  *hj;
+
+    hj = nxt_mp_get(c->mem_pool, sizeof(nxt_openssl_handshake_job_t));
+    if (nxt_slow_path(hj == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_job_init(&hj->job, sizeof(nxt_job_t));
+    nxt_job_set_name(&hj->job, "job tls handshake");
+
+    hj->task = c->task;
+
+    tls = c->u.tls;
+
+    hj->job.task = &hj->task;
+    hj->job.data = c;
+    hj->job.thread_pool = tls->conf->thread_pool;
+    hj->job.abort_handler = nxt_openssl_conn_handshake_handler;
+
+    engine = task->thread->engine;
+
+    /*
+     * The engine must not touch the connection until the job returns:
+     * the connection events are blocked, the idle timer is disabled,
+     * and the connection is hidden from the idle connections closing.
+     */
+
+    nxt_fd_event_block_read(engine, &c->socket);
+    nxt_fd_event_block_write(engine, &c->socket);
+
+    hj->timer = c->read_timer.enabled;
+    nxt_timer_disable(engine, &c->read_timer);
+
+    nxt_queue_remove(&c->link);
+
+    tls->offload = 1;
+
+    nxt_job_start(task, &hj->job, nxt_openssl_conn_handshake_handler);
+
+    return NXT_OK;
+}
+
+
+/*
+ * Runs in a thread pool thread, or in the engine thread if the job
+ * cannot be posted.  The engine is not touched here, so the session
+ * cache statistics are counted and the socket events are rearmed by
+ * nxt_openssl_conn_handshake_done().
+ */
+
+static void
+nxt_openssl_conn_handshake_handler(nxt_task_t *task, void *obj, void *data)
+{
+    int                          ret;
+    nxt_err_t                    err;
+    nxt_conn_t                   *c;
+    nxt_openssl_conn_t           *tls;
+    nxt_openssl_handshake_job_t  *hj;
+
+    hj = obj;
+    c = data;
+    tls = c->u.tls;
+
+    ret = nxt_openssl_handshake(tls);
+
+    err = (ret <= 0) ? nxt_socket_errno : 0;
+
+    nxt_debug(task, "SSL_do_handshake(%d) job: %d err:%d",
+              c->socket.fd, ret, err);
+
+    if (ret > 0) {
+        hj->ret = NXT_OK;
+
+    } else {
+        tls->ssl_error = SSL_get_error(tls->session, ret);
+
+        if (tls->ssl_error == SSL_ERROR_WANT_READ
+            || tls->ssl_error == SSL_ERROR_WANT_WRITE)
+        {
+            hj->ret = NXT_AGAIN;
+
+        } else {
+            /* OpenSSL error queue is per thread, so errors are logged here. */
+
+            hj->ret = NXT_DECLINED;
+
+            if (nxt_openssl_conn_test_error(task, c, ret, err,
+                                            NXT_OPENSSL_HANDSHAKE)
+                != 0)
+            {
+                nxt_openssl_conn_error(task, err,
+                                       "SSL_do_handshake(%d) failed",
+                                       c->socket.fd);
+                hj->ret = NXT_ERROR;
+            }
+        }
+    }
+
+    /* The work may still link the next work of the thread pool queue. */
+    hj->job.work.next = NULL;
+
+    nxt_job_return(task, &hj->job, nxt_openssl_conn_handshake_done);
+}
+
+
+static void
+nxt_openssl_conn_handshake_done(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t                   *c;
+    nxt_event_engine_t           *engine;
+    nxt_openssl_conn_t           *tls;
+    nxt_openssl_handshake_job_t  *hj;
+
+    hj = obj;
+    c = data;
+    tls = c->u.tls;
+
+    task = c->socket.task;
+    engine = task->thread->engine;
+
+    nxt_debug(task, "openssl conn handshake done fd:%d", c->socket.fd);
+
+    tls->offload = 0;
+
+    engine->tls_session_cache_hits_cnt += tls->session_hits;
+    engine->tls_session_cache_misses_cnt += tls->session_misses;
+
+    tls->session_hits = 0;
+    tls->session_misses = 0;
+
+    nxt_queue_insert_head(&engine->idle_connections, &c->link);
+
+    if (c->socket.read == NXT_EVENT_BLOCKED) {
+        nxt_fd_event_enable_read(engine, &c->socket);
+    }
+
+    if (c->socket.write == NXT_EVENT_BLOCKED) {
+        nxt_fd_event_enable_write(engine, &c->socket);
+    }
+
+    if (hj->timer) {
+        nxt_conn_timer(engine, c, c->read_state, &c->read_timer);
+    }
+
+    if (hj->ret == NXT_AGAIN) {
+        /*
+         * The socket readiness could change while the job was running,
+         * so the handshake step is repeated in the engine, it is cheap
+         * and it sets the socket events up as usual.
+         */
+        tls->times = 1;
+
+        nxt_openssl_conn_handshake(task, c, c->socket.data);
+        return;
+    }
+
+    nxt_openssl_conn_handshake_next(task, c, hj->ret, c->socket.data);
+}
+
+
 static ssize_t
 nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
 {
@@ -1338,6 +1898,13 @@ nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
     nxt_openssl_conn_t  *tls;
 
     tls = c->u.tls;
+
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+    if (nxt_slow_path(tls->early_data)) {
+        return nxt_openssl_conn_io_recv_early(c, b);
+    }
+#endif
+
     size = b->mem.end - b->mem.free;
 
     ret = SSL_read(tls->session, b->mem.free, size);
@@ -1348,6 +1915,13 @@ nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
               c->socket.fd, b->mem.free, size, ret, err);
 
     if (ret > 0) {
+
+        if (nxt_slow_path(!tls->handshake)) {
+            /* SSL_read() has completed the handshake after early data. */
+            tls->handshake = 1;
+            c->tls_early_data = 0;
+        }
+
         return ret;
     }
 
@@ -1363,6 +1937,84 @@ nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
 }
 
 
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+
+static ssize_t
+nxt_openssl_conn_io_recv_early(nxt_conn_t *c, nxt_buf_t *b)
+{
+    int                 ret;
+    u_char              *p;
+    size_t              size, n, nread;
+    nxt_int_t           rc;
+    nxt_err_t           err;
+    nxt_openssl_conn_t  *tls;
+
+    tls = c->u.tls;
+
+    p = b->mem.free;
+    size = b->mem.end - p;
+    n = 0;
+
+    if (tls->early_size != 0) {
+        /* The first byte of early data has been read by the handshake. */
+        *p++ = tls->early_byte;
+        size--;
+        n = 1;
+
+        tls->early_size = 0;
+
+        if (size == 0) {
+            return n;
+        }
+    }
+
+    nread = 0;
+
+    ret = SSL_read_early_data(tls->session, p, size, &nread);
+
+    err = (ret == SSL_READ_EARLY_DATA_ERROR) ? nxt_socket_errno : 0;
+
+    nxt_debug(c->socket.task, "SSL_read_early_data(%d, %p, %uz): %d %uz err:%d",
+              c->socket.fd, p, size, ret, nread, err);
+
+    switch (ret) {
+
+    case SSL_READ_EARLY_DATA_SUCCESS:
+        return n + nread;
+
+    case SSL_READ_EARLY_DATA_FINISH:
+        /* The rest of data is read after the client Finished message. */
+        tls->early_data = 0;
+        tls->early_done = 1;
+
+        if (n != 0) {
+            return n;
+        }
+
+        return nxt_openssl_conn_io_recvbuf(c, b);
+
+    default: /* SSL_READ_EARLY_DATA_ERROR */
+
+        if (n != 0) {
+            /* The error is reported by the next call. */
+            return n;
+        }
+
+        rc = nxt_openssl_conn_test_error(c->socket.task, c, 0, err,
+                                         NXT_OPENSSL_READ);
+        if (rc == NXT_ERROR) {
+            nxt_openssl_conn_error(c->socket.task, err,
+                                   "SSL_read_early_data(%d, %p, %uz) failed",
+                                   c->socket.fd, p, size);
+        }
+
+        return rc;
+    }
+}
+
+#endif
+
+
 static ssize_t
 nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb)
 {
@@ -1375,10 +2027,35 @@ nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb)
         return 0;
     }
 
+#if (NXT_HAVE_OPENSSL_KTLS)
+    if (niov == 0 && nxt_buf_is_file(sb->buf)) {
+        return nxt_openssl_conn_io_sendfile(task, sb);
+    }
+#endif
+
     return nxt_openssl_conn_io_send(task, sb, iov.iov_base, iov.iov_len);
 }
 
 
+nxt_inline int
+nxt_openssl_write(nxt_openssl_conn_t *tls, void *buf, size_t size)
+{
+#if (NXT_HAVE_OPENSSL_EARLY_DATA)
+    size_t  n;
+
+    if (nxt_slow_path(tls->early_data)) {
+        /*
+         * SSL_write() is not allowed until the end of early data is read,
+         * so a response to early data is sent before the client Finished.
+         */
+        return SSL_write_early_data(tls->session, buf, size, &n) ? (int) n : 0;
+    }
+#endif
+
+    return SSL_write(tls->session, buf, size);
+}
+
+
 static ssize_t
 nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
     size_t size)
@@ -1386,12 +2063,27 @@ nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
     int                 ret;
     nxt_err_t           err;
     nxt_int_t           n;
+    nxt_msec_t          now;
     nxt_conn_t          *c;
     nxt_openssl_conn_t  *tls;
 
     tls = sb->tls;
 
-    ret = SSL_write(tls->session, buf, size);
+    now = task->thread->engine->timers.now;
+
+    /* SSL_write() must be retried with the same length. */
+
+    if (!tls->write_again
+        && nxt_msec_diff(now, tls->write_time) > NXT_TLS_RECORD_IDLE)
+    {
+        tls->records = 0;
+    }
+
+    if (tls->records < NXT_TLS_RECORD_RAMP) {
+        size = nxt_min(size, NXT_TLS_RECORD_SIZE_MIN);
+    }
+
+    ret = nxt_openssl_write(tls, buf, size);
 
     err = (ret <= 0) ? nxt_socket_errno : 0;
 
@@ -1399,6 +2091,13 @@ nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
               sb->socket, buf, size, ret, err);
 
     if (ret > 0) {
+        tls->write_again = 0;
+        tls->write_time = now;
+
+        if (tls->records < NXT_TLS_RECORD_RAMP) {
+            tls->records++;
+        }
+
         return ret;
     }
 
@@ -1409,6 +2108,8 @@ nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
 
     sb->ready = c->socket.write_ready;
 
+    tls->write_again = (n == NXT_AGAIN);
+
     if (n == NXT_ERROR) {
         sb->error = c->socket.error;
         nxt_openssl_conn_error(task, err, "SSL_write(%d, %p, %uz) failed",
@@ -1419,6 +2120,67 @@ nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
 }
 
 
+#if (NXT_HAVE_OPENSSL_KTLS)
+
+static ssize_t
+nxt_openssl_conn_io_sendfile(nxt_task_t *task, nxt_sendbuf_t *sb)
+{
+    size_t              size;
+    nxt_buf_t           *b;
+    nxt_err_t           err;
+    nxt_int_t           n;
+    nxt_conn_t          *c;
+    ossl_ssize_t        ret;
+    nxt_openssl_conn_t  *tls;
+
+    tls = sb->tls;
+    b = sb->buf;
+
+    size = b->file_end - b->file_pos;
+
+    ret = SSL_sendfile(tls->session, b->file->fd, b->file_pos, size, 0);
+
+    err = (ret <= 0) ? nxt_socket_errno : 0;
+
+    nxt_debug(task, "SSL_sendfile(%d, %FD, @%O, %uz): %z err:%d",
+              sb->socket, b->file->fd, b->file_pos, size, ret, err);
+
+    if (ret > 0) {
+        if ((size_t) ret < size) {
+            sb->ready = 0;
+        }
+
+        return ret;
+    }
+
+    if (nxt_slow_path(ret == 0)) {
+        nxt_alert(task, "SSL_sendfile() reported that file was truncated "
+                  "at %O", b->file_pos);
+
+        return NXT_ERROR;
+    }
+
+    c = tls->conn;
+    c->socket.write_ready = sb->ready;
+
+    n = nxt_openssl_conn_test_error(task, c, (int) ret, err,
+                                    NXT_OPENSSL_WRITE);
+
+    sb->ready = c->socket.write_ready;
+
+    if (n == NXT_ERROR) {
+        sb->error = c->socket.error;
+        nxt_openssl_conn_error(task, err,
+                               "SSL_sendfile(%d, %FD, @%O, %uz) failed",
+                               sb->socket, b->file->fd, b->file_pos, size);
+    }
+
+    return n;
+}
+
+#endif
+
+
 static void
 nxt_openssl_conn_io_shutdown(nxt_task_t *task, void *obj, void *data)
 {
@@ -22,6 +22,7 @@ struct nxt_regex_match_s {
 
 static void *nxt_pcre_malloc(size_t size);
 static void nxt_pcre_free(void *p);
+static void nxt_regex_set_free(nxt_task_t *task, void *obj, void *data);
 
 static nxt_mp_t  *nxt_pcre_mp;
 
@@ -133,3 +134,153 @@ nxt_regex_match(nxt_regex_t *re, u_char *subject, size_t length,
 
     return (ret != PCRE_ERROR_NOMATCH);
 }
+
+
+/*
+ * The regexes of a set are compiled as the single alternation
+ * "(?:re0)(*:0)|(?:re1)(*:1)|..." where the mark names the matched regex.
+ * The set is JIT compiled if the JIT is available.
+ */
+
+nxt_regex_t *
+nxt_regex_compile_set(nxt_mp_t *mp, nxt_str_t *sources, nxt_uint_t n,
+    nxt_regex_err_t *err)
+{
+    u_char       *p, *end;
+    size_t       size;
+    void         *saved_malloc, *saved_free;
+    nxt_str_t    source;
+    nxt_uint_t   i;
+    nxt_regex_t  *re;
+
+    size = 0;
+
+    for (i = 0; i < n; i++) {
+        size += nxt_length("|(?:)(*:)") + sources[i].length + NXT_INT_T_LEN;
+    }
+
+    p = nxt_mp_alloc(mp, size);
+    if (nxt_slow_path(p == NULL)) {
+        goto alloc_fail;
+    }
+
+    source.start = p;
+    end = p + size;
+
+    for (i = 0; i < n; i++) {
+        if (i != 0) {
+            *p++ = '|';
+        }
+
+        p = nxt_sprintf(p, end, "(?:%V)(*:%ui)", &sources[i], i);
+    }
+
+    source.length = p - source.start;
+
+    re = nxt_regex_compile(mp, &source, err);
+
+    nxt_mp_free(mp, source.start);
+
+    if (nxt_slow_path(re == NULL)) {
+        return NULL;
+    }
+
+    if (nxt_slow_path(nxt_mp_cleanup(mp, nxt_regex_set_free, NULL, re, NULL)
+                      != NXT_OK))
+    {
+        goto alloc_fail;
+    }
+
+    saved_malloc = pcre_malloc;
+    saved_free = pcre_free;
+
+    pcre_malloc = nxt_pcre_malloc;
+    pcre_free = nxt_pcre_free;
+    nxt_pcre_mp = mp;
+
+    /* The set is matched by the interpreter if the study fails. */
+    re->extra = pcre_study(re->code, PCRE_STUDY_JIT_COMPILE, &err->msg);
+
+    pcre_malloc = saved_malloc;
+    pcre_free = saved_free;
+
+    return re;
+
+alloc_fail:
+
+    err->offset = 0;
+    err->msg = "memory allocation failed";
+
+    return NULL;
+}
+
+
+static void
+nxt_regex_set_free(nxt_task_t *task, void *obj, void *data)
+{
+    void         *saved_free;
+    nxt_regex_t  *re;
+
+    re = obj;
+
+    if (re->extra == NULL) {
+        return;
+    }
+
+    saved_free = pcre_free;
+    pcre_free = nxt_pcre_free;
+
+    /* The JIT code is not allocated from the memory pool. */
+    pcre_free_study(re->extra);
+
+    pcre_free = saved_free;
+}
+
+
+/*
+ * Returns the index of the matched regex of the set,
+ * NXT_DECLINED if no regex matches, or NXT_ERROR.
+ */
+
+nxt_int_t
+nxt_regex_match_set(nxt_regex_t *re, u_char *subject, size_t length,
+    nxt_regex_match_t *match)
+{
+    int         ret;
+    u_char      *mark;
+    pcre_extra  extra;
+
+    if (re->extra != NULL) {
+        extra = *re->extra;
+
+    } else {
+        nxt_memzero(&extra, sizeof(pcre_extra));
+    }
+
+    mark = NULL;
+
+    extra.flags |= PCRE_EXTRA_MARK;
+    extra.mark = &mark;
+
+    ret = pcre_exec(re->code, &extra, (const char *) subject, length, 0, 0,
+                    match->ovec, match->ovecsize);
+    if (nxt_slow_path(ret < PCRE_ERROR_NOMATCH)) {
+        nxt_thread_log_error(NXT_LOG_ERR,
+                             "pcre_exec() failed: %d on \"%*s\" using \"%V\"",
+                             ret, length, subject, &re->pattern);
+
+        return NXT_ERROR;
+    }
+
+    if (ret == PCRE_ERROR_NOMATCH) {
+        return NXT_DECLINED;
+    }
+
+    if (nxt_slow_path(mark == NULL)) {
+        nxt_thread_log_alert("pcre_exec() returned no mark on \"%*s\" "
+                             "using \"%V\"", length, subject, &re->pattern);
+        return NXT_ERROR;
+    }
+
+    return nxt_int_parse(mark, nxt_strlen(mark));
+}
@@ -12,6 +12,7 @@
 
 static void *nxt_pcre2_malloc(PCRE2_SIZE size, void *memory_data);
 static void nxt_pcre2_free(void *p, void *memory_data);
+static void nxt_regex_set_free(nxt_task_t *task, void *obj, void *data);
 
 
 struct nxt_regex_s {
@@ -159,3 +160,115 @@ nxt_regex_match(nxt_regex_t *re, u_char *subject, size_t length,
 
     return (ret != PCRE2_ERROR_NOMATCH);
 }
+
+
+/*
+ * The regexes of a set are compiled as the single alternation
+ * "(?:re0)(*:0)|(?:re1)(*:1)|..." where the mark names the matched regex.
+ * The set is JIT compiled if the JIT is available.
+ */
+
+nxt_regex_t *
+nxt_regex_compile_set(nxt_mp_t *mp, nxt_str_t *sources, nxt_uint_t n,
+    nxt_regex_err_t *err)
+{
+    u_char       *p, *end;
+    size_t       size;
+    nxt_str_t    source;
+    nxt_uint_t   i;
+    nxt_regex_t  *re;
+
+    static const u_char  alloc_error[] = "memory allocation failed";
+
+    size = 0;
+
+    for (i = 0; i < n; i++) {
+        size += nxt_length("|(?:)(*:)") + sources[i].length + NXT_INT_T_LEN;
+    }
+
+    p = nxt_mp_alloc(mp, size);
+    if (nxt_slow_path(p == NULL)) {
+        goto alloc_fail;
+    }
+
+    source.start = p;
+    end = p + size;
+
+    for (i = 0; i < n; i++) {
+        if (i != 0) {
+            *p++ = '|';
+        }
+
+        p = nxt_sprintf(p, end, "(?:%V)(*:%ui)", &sources[i], i);
+    }
+
+    source.length = p - source.start;
+
+    re = nxt_regex_compile(mp, &source, err);
+
+    nxt_mp_free(mp, source.start);
+
+    if (nxt_slow_path(re == NULL)) {
+        return NULL;
+    }
+
+    if (nxt_slow_path(nxt_mp_cleanup(mp, nxt_regex_set_free, NULL, re, NULL)
+                      != NXT_OK))
+    {
+        goto alloc_fail;
+    }
+
+    /* The set is matched by the interpreter if the JIT fails. */
+    (void) pcre2_jit_compile(re->code, PCRE2_JIT_COMPLETE);
+
+    return re;
+
+alloc_fail:
+
+    err->offset = 0;
+    nxt_memcpy(err->msg, alloc_error, sizeof(alloc_error));
+
+    return NULL;
+}
+
+
+static void
+nxt_regex_set_free(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_regex_t  *re;
+
+    re = obj;
+
+    /* The JIT code is not allocated from the memory pool. */
+    pcre2_code_free(re->code);
+}
+
+
+/*
+ * Returns the index of the matched regex of the set,
+ * NXT_DECLINED if no regex matches, or NXT_ERROR.
+ */
+
+nxt_int_t
+nxt_regex_match_set(nxt_regex_t *re, u_char *subject, size_t length,
+    nxt_regex_match_t *match)
+{
+    nxt_int_t   ret;
+    PCRE2_SPTR  mark;
+
+    ret = nxt_regex_match(re, subject, length, match);
+
+    if (ret != 1) {
+        return (ret == 0) ? NXT_DECLINED : NXT_ERROR;
+    }
+
+    mark = pcre2_get_mark(match);
+
+    if (nxt_slow_path(mark == NULL)) {
+        nxt_thread_log_alert("pcre2_get_mark() failed on \"%*s\" "
+                             "using \"%V\"", length, subject, &re->pattern);
+        return NXT_ERROR;
+    }
+
+    return nxt_int_parse(mark, nxt_strlen(mark));
+}
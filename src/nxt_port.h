@@ -58,6 +58,7 @@ struct nxt_port_handlers_s {
 
     /* Status report. */
     nxt_port_handler_t  status;
+    nxt_port_handler_t  status_shm;
 
     nxt_port_handler_t  oosm;
     nxt_port_handler_t  shm_ack;
@@ -114,6 +115,7 @@ typedef enum {
     _NXT_PORT_MSG_DATA            = nxt_port_handler_idx(data),
     _NXT_PORT_MSG_APP_RESTART     = nxt_port_handler_idx(app_restart),
     _NXT_PORT_MSG_STATUS          = nxt_port_handler_idx(status),
+    _NXT_PORT_MSG_STATUS_SHM      = nxt_port_handler_idx(status_shm),
 
     _NXT_PORT_MSG_OOSM            = nxt_port_handler_idx(oosm),
     _NXT_PORT_MSG_SHM_ACK         = nxt_port_handler_idx(shm_ack),
@@ -159,6 +161,7 @@ typedef enum {
     NXT_PORT_MSG_DATA_LAST        = nxt_msg_last(_NXT_PORT_MSG_DATA),
     NXT_PORT_MSG_APP_RESTART      = nxt_msg_last(_NXT_PORT_MSG_APP_RESTART),
     NXT_PORT_MSG_STATUS           = nxt_msg_last(_NXT_PORT_MSG_STATUS),
+    NXT_PORT_MSG_STATUS_SHM       = nxt_msg_last(_NXT_PORT_MSG_STATUS_SHM),
 
     NXT_PORT_MSG_OOSM             = nxt_msg_last(_NXT_PORT_MSG_OOSM),
     NXT_PORT_MSG_SHM_ACK          = nxt_msg_last(_NXT_PORT_MSG_SHM_ACK),
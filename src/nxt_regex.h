@@ -35,6 +35,10 @@ NXT_EXPORT nxt_regex_t *nxt_regex_compile(nxt_mp_t *mp, nxt_str_t *source,
 NXT_EXPORT nxt_regex_match_t *nxt_regex_match_create(nxt_mp_t *mp, size_t size);
 NXT_EXPORT nxt_int_t nxt_regex_match(nxt_regex_t *re, u_char *subject,
     size_t length, nxt_regex_match_t *match);
+NXT_EXPORT nxt_regex_t *nxt_regex_compile_set(nxt_mp_t *mp,
+    nxt_str_t *sources, nxt_uint_t n, nxt_regex_err_t *err);
+NXT_EXPORT nxt_int_t nxt_regex_match_set(nxt_regex_t *re, u_char *subject,
+    size_t length, nxt_regex_match_t *match);
 
 #endif /* NXT_HAVE_REGEX */
 
@@ -15,6 +15,7 @@
 #include <nxt_script.h>
 #endif
 #include <nxt_http.h>
+#include <nxt_upstream.h>
 #include <nxt_port_memory_int.h>
 #include <nxt_unit_request.h>
 #include <nxt_unit_response.h>
@@ -107,6 +108,16 @@ static void nxt_router_app_restart_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
 static void nxt_router_status_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
+static void nxt_router_status_shm_handler(nxt_task_t *task,
+    nxt_port_recv_msg_t *msg);
+static nxt_array_t *nxt_router_status_latencies(void);
+static size_t nxt_router_status_size(nxt_array_t *latencies);
+static void nxt_router_status_fill(nxt_status_report_t *report, size_t size,
+    nxt_array_t *latencies);
+static nxt_int_t nxt_router_status_shm_create(nxt_task_t *task,
+    nxt_router_t *router);
+static void nxt_router_status_publish(nxt_task_t *task, void *obj,
+    void *data);
 static void nxt_router_remove_pid_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
 
@@ -126,6 +137,8 @@ static nxt_int_t nxt_router_conf_forward_header(nxt_mp_t *mp,
     nxt_conf_value_t *conf, nxt_http_forward_header_t *fh);
 
 static nxt_app_t *nxt_router_app_find(nxt_queue_t *queue, nxt_str_t *name);
+static nxt_int_t nxt_router_app_latency_update(nxt_app_t *app,
+    nxt_uint_t threads);
 static nxt_int_t nxt_router_apps_hash_test(nxt_lvlhsh_query_t *lhq, void *data);
 static nxt_int_t nxt_router_apps_hash_add(nxt_router_conf_t *rtcf,
     nxt_app_t *app);
@@ -152,6 +165,8 @@ static void nxt_router_tls_rpc_handler(nxt_task_t *task,
 static nxt_int_t nxt_router_conf_tls_insert(nxt_router_temp_conf_t *tmcf,
     nxt_conf_value_t *value, nxt_socket_conf_t *skcf, nxt_tls_init_t *tls_init,
     nxt_bool_t last);
+static nxt_thread_pool_t *nxt_router_tls_thread_pool(nxt_task_t *task,
+    nxt_router_t *router);
 #endif
 #if (NXT_HAVE_NJS)
 static void nxt_router_js_module_rpc_handler(nxt_task_t *task,
@@ -169,6 +184,10 @@ static nxt_socket_conf_t *nxt_router_socket_conf(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_str_t *name);
 static nxt_int_t nxt_router_listen_socket_find(nxt_router_temp_conf_t *tmcf,
     nxt_socket_conf_t *nskcf, nxt_sockaddr_t *sa);
+static void nxt_router_listen_socket_reuseport(nxt_task_t *task,
+    nxt_listen_socket_t *ls, nxt_conf_value_t *value);
+static void nxt_router_listen_socket_steer(nxt_task_t *task,
+    nxt_listen_socket_t *ls, nxt_router_conf_t *rtcf);
 
 static nxt_int_t nxt_router_engines_create(nxt_task_t *task,
     nxt_router_t *router, nxt_router_temp_conf_t *tmcf,
@@ -198,6 +217,10 @@ static void nxt_router_engines_post(nxt_router_t *router,
     nxt_router_temp_conf_t *tmcf);
 static void nxt_router_engine_post(nxt_event_engine_t *engine,
     nxt_work_t *jobs);
+static void nxt_router_engine_cpu_bind(nxt_event_engine_t *engine,
+    nxt_cpuset_t *set);
+static void nxt_router_engine_cpu_bind_handler(nxt_task_t *task, void *obj,
+    void *data);
 
 static void nxt_router_thread_start(void *data);
 static void nxt_router_rt_add_port(nxt_task_t *task, void *obj,
@@ -216,6 +239,10 @@ static void nxt_router_thread_exit_handler(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_router_req_headers_ack_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, nxt_request_rpc_data_t *req_rpc_data);
+static void nxt_router_app_latency_add(nxt_task_t *task,
+    nxt_request_rpc_data_t *req_rpc_data, nxt_uint_t metric);
+static void nxt_router_listen_sockets_close(nxt_task_t *task,
+    nxt_listen_socket_t *ls);
 static void nxt_router_listen_socket_release(nxt_task_t *task,
     nxt_socket_conf_t *skcf);
 
@@ -294,6 +321,7 @@ static const nxt_port_handlers_t  nxt_router_process_port_handlers = {
     .data         = nxt_router_conf_data_handler,
     .app_restart  = nxt_router_app_restart_handler,
     .status       = nxt_router_status_handler,
+    .status_shm   = nxt_router_status_shm_handler,
     .remove_pid   = nxt_router_remove_pid_handler,
     .access_log   = nxt_router_access_log_reopen_handler,
     .rpc_ready    = nxt_port_rpc_handler,
@@ -369,8 +397,19 @@ nxt_router_start(nxt_task_t *task, nxt_process_data_t *data)
     nxt_queue_init(&router->sockets);
     nxt_queue_init(&router->apps);
 
+#if (NXT_TLS)
+    nxt_queue_init(&router->tls_session_caches);
+#endif
+
+    ret = nxt_router_status_shm_create(task, router);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
     nxt_router = router;
 
+    nxt_router_status_publish(task, &router->status_timer, NULL);
+
     controller_port = rt->port_by_type[NXT_PROCESS_CONTROLLER];
     if (controller_port != NULL) {
         nxt_router_greet_controller(task, controller_port);
@@ -946,15 +985,11 @@ nxt_router_app_restart_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 static void
 nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 {
-    u_char               *p;
-    size_t               alloc;
-    nxt_app_t            *app;
-    nxt_buf_t            *b;
-    nxt_uint_t           type;
-    nxt_port_t           *port;
-    nxt_status_app_t     *app_stat;
-    nxt_event_engine_t   *engine;
-    nxt_status_report_t  *report;
+    size_t       size;
+    nxt_buf_t    *b;
+    nxt_uint_t   type;
+    nxt_port_t   *port;
+    nxt_array_t  *latencies;
 
     port = nxt_runtime_port_find(task->thread->runtime,
                                  msg->port_msg.pid,
@@ -964,22 +999,137 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         return;
     }
 
-    alloc = sizeof(nxt_status_report_t);
+    latencies = nxt_router_status_latencies();
+    size = nxt_router_status_size(latencies);
+
+    b = nxt_buf_mem_alloc(port->mem_pool, size, 0);
+    if (nxt_slow_path(b == NULL)) {
+        type = NXT_PORT_MSG_RPC_ERROR;
+        goto fail;
+    }
+
+    nxt_router_status_fill((nxt_status_report_t *) b->mem.free, size,
+                           latencies);
+
+    b->mem.free = b->mem.end;
+
+    type = NXT_PORT_MSG_RPC_READY_LAST;
+
+fail:
+
+    nxt_port_socket_write(task, port, type, -1, msg->port_msg.stream, 0, b);
+}
+
+
+static void
+nxt_router_status_shm_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
+{
+    nxt_fd_t    fd;
+    nxt_uint_t  type;
+    nxt_port_t  *port;
+
+    port = nxt_runtime_port_find(task->thread->runtime,
+                                 msg->port_msg.pid,
+                                 msg->port_msg.reply_port);
+    if (nxt_slow_path(port == NULL)) {
+        nxt_alert(task,
+                  "nxt_router_status_shm_handler(): reply port not found");
+        return;
+    }
+
+    if (nxt_router->status_shm != NULL) {
+        fd = nxt_router->status_shm_fd;
+        type = NXT_PORT_MSG_RPC_READY_LAST;
+
+    } else {
+        fd = -1;
+        type = NXT_PORT_MSG_RPC_ERROR;
+    }
+
+    nxt_port_socket_write(task, port, type, fd, msg->port_msg.stream, 0, NULL);
+}
+
+
+/*
+ * The current listeners refer to the current configuration which
+ * cannot be released until the next one is applied by this thread.
+ * There are no listeners while a new configuration is being created.
+ */
+
+static nxt_array_t *
+nxt_router_status_latencies(void)
+{
+    nxt_socket_conf_t  *skcf;
+    nxt_router_conf_t  *rtcf;
+
+    rtcf = NULL;
+
+    nxt_thread_spin_lock(&nxt_router->lock);
+
+    if (!nxt_queue_is_empty(&nxt_router->sockets)) {
+        skcf = nxt_queue_link_data(nxt_queue_first(&nxt_router->sockets),
+                                   nxt_socket_conf_t, link);
+        rtcf = skcf->router_conf;
+    }
+
+    nxt_thread_spin_unlock(&nxt_router->lock);
+
+    return (rtcf != NULL) ? rtcf->latencies : NULL;
+}
+
+
+static size_t
+nxt_router_status_size(nxt_array_t *latencies)
+{
+    size_t                size;
+    nxt_app_t             *app;
+    nxt_uint_t            i;
+    nxt_status_latency_t  **latency;
+
+    size = sizeof(nxt_status_report_t);
 
     nxt_queue_each(app, &nxt_router->apps, nxt_app_t, link) {
 
-        alloc += sizeof(nxt_status_app_t) + app->name.length;
+        size += sizeof(nxt_status_app_t) + app->name.length;
 
     } nxt_queue_loop;
 
-    b = nxt_buf_mem_alloc(port->mem_pool, alloc, 0);
-    if (nxt_slow_path(b == NULL)) {
-        type = NXT_PORT_MSG_RPC_ERROR;
-        goto fail;
+    if (latencies != NULL) {
+        latency = latencies->elts;
+
+        for (i = 0; i < latencies->nelts; i++) {
+            size += sizeof(nxt_status_route_t) + latency[i]->name.length;
+        }
     }
 
-    report = (nxt_status_report_t *) b->mem.free;
-    b->mem.free = b->mem.end;
+    return size;
+}
+
+
+/*
+ * The report items are followed by their names stored from the end
+ * of the report, the pointers are offsets from the report start.
+ */
+
+static void
+nxt_router_status_fill(nxt_status_report_t *report, size_t size,
+    nxt_array_t *latencies)
+{
+    u_char                *p;
+    nxt_app_t             *app;
+    nxt_uint_t            i, n;
+    nxt_status_app_t      *app_stat;
+    nxt_event_engine_t    *engine;
+    nxt_status_route_t    *route_stat;
+    nxt_status_latency_t  **latency;
+
+    latency = NULL;
+    n = 0;
+
+    if (latencies != NULL) {
+        latency = latencies->elts;
+        n = latencies->nelts;
+    }
 
     nxt_memzero(report, sizeof(nxt_status_report_t));
 
@@ -989,12 +1139,17 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         report->idle_conns += engine->idle_conns_cnt;
         report->closed_conns += engine->closed_conns_cnt;
         report->requests += engine->requests_cnt;
+        report->static_cache_hits += engine->static_cache_hits_cnt;
+        report->static_cache_misses += engine->static_cache_misses_cnt;
+        report->tls_session_cache_hits += engine->tls_session_cache_hits_cnt;
+        report->tls_session_cache_misses +=
+                                       engine->tls_session_cache_misses_cnt;
 
     } nxt_queue_loop;
 
     report->apps_count = 0;
     app_stat = report->apps;
-    p = b->mem.end;
+    p = (u_char *) report + size;
 
     nxt_queue_each(app, &nxt_router->apps, nxt_app_t, link) {
         p -= app->name.length;
@@ -1002,22 +1157,123 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         nxt_memcpy(p, app->name.start, app->name.length);
 
         app_stat->name.length = app->name.length;
-        app_stat->name.start = (u_char *) (p - b->mem.pos);
+        app_stat->name.start = (u_char *) (p - (u_char *) report);
 
         app_stat->active_requests = app->active_requests;
         app_stat->pending_processes = app->pending_processes;
         app_stat->processes = app->processes;
         app_stat->idle_processes = app->idle_processes;
 
+        nxt_memzero(app_stat->latency, sizeof(app_stat->latency));
+        nxt_status_latency_merge(app->latency, app_stat->latency);
+
         report->apps_count++;
         app_stat++;
     } nxt_queue_loop;
 
-    type = NXT_PORT_MSG_RPC_READY_LAST;
+    route_stat = (nxt_status_route_t *) app_stat;
 
-fail:
+    report->routes_count = n;
+    report->routes = (nxt_status_route_t *) ((u_char *) route_stat
+                                             - (u_char *) report);
 
-    nxt_port_socket_write(task, port, type, -1, msg->port_msg.stream, 0, b);
+    for (i = 0; i < n; i++) {
+        p -= latency[i]->name.length;
+
+        nxt_memcpy(p, latency[i]->name.start, latency[i]->name.length);
+
+        route_stat->name.length = latency[i]->name.length;
+        route_stat->name.start = (u_char *) (p - (u_char *) report);
+        route_stat->step = latency[i]->step;
+
+        nxt_memzero(route_stat->latency, sizeof(route_stat->latency));
+        nxt_status_latency_merge(latency[i], route_stat->latency);
+
+        route_stat++;
+    }
+}
+
+
+static nxt_int_t
+nxt_router_status_shm_create(nxt_task_t *task, nxt_router_t *router)
+{
+    nxt_fd_t            fd;
+    nxt_status_shm_t    *shm;
+    nxt_event_engine_t  *engine;
+
+    fd = nxt_shm_open(task, NXT_STATUS_SHM_SIZE);
+    if (nxt_slow_path(fd == -1)) {
+        return NXT_ERROR;
+    }
+
+    shm = nxt_mem_mmap(NULL, NXT_STATUS_SHM_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+    if (nxt_slow_path(shm == MAP_FAILED)) {
+        nxt_fd_close(fd);
+        return NXT_ERROR;
+    }
+
+    nxt_status_shm_init(shm, NXT_STATUS_SHM_SIZE);
+
+    router->status_shm = shm;
+    router->status_shm_fd = fd;
+
+    engine = task->thread->engine;
+
+    router->status_timer.bias = NXT_TIMER_DEFAULT_BIAS;
+    router->status_timer.work_queue = &engine->fast_work_queue;
+    router->status_timer.handler = nxt_router_status_publish;
+    router->status_timer.task = &engine->task;
+    router->status_timer.log = engine->task.log;
+
+    return NXT_OK;
+}
+
+
+/*
+ * The report is published by the main router thread, so readers of
+ * the shared memory do not affect the worker engines.
+ */
+
+static void
+nxt_router_status_publish(nxt_task_t *task, void *obj, void *data)
+{
+    size_t            size;
+    nxt_bool_t        fits;
+    nxt_array_t       *latencies;
+    nxt_realtime_t    *now;
+    nxt_status_shm_t  *shm;
+
+    shm = nxt_router->status_shm;
+
+    latencies = nxt_router_status_latencies();
+    size = nxt_router_status_size(latencies);
+
+    fits = (size <= shm->size - sizeof(nxt_status_shm_t));
+
+    if (nxt_slow_path(!fits && (shm->length != 0 || shm->updated == 0))) {
+        nxt_log(task, NXT_LOG_WARN, "status report of %uz bytes does not fit "
+                "to shared memory", size);
+    }
+
+    nxt_status_shm_lock(shm);
+
+    if (fits) {
+        nxt_router_status_fill((nxt_status_report_t *) shm->report, size,
+                               latencies);
+        shm->length = size;
+
+    } else {
+        shm->length = 0;
+    }
+
+    now = nxt_thread_realtime(task->thread);
+    shm->updated = (uint64_t) now->sec * 1000 + now->nsec / 1000000;
+
+    nxt_status_shm_unlock(shm);
+
+    nxt_timer_add(task->thread->engine, &nxt_router->status_timer,
+                  NXT_STATUS_SHM_INTERVAL);
 }
 
 
@@ -1174,6 +1430,7 @@ nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data)
     nxt_queue_link_t             *qlk;
     nxt_socket_conf_t            *skcf;
     nxt_router_conf_t            *rtcf;
+    nxt_listen_socket_t          *ls;
     nxt_router_temp_conf_t       *tmcf;
     const nxt_event_interface_t  *interface;
 #if (NXT_TLS)
@@ -1249,7 +1506,7 @@ nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data)
 
     rt = task->thread->runtime;
 
-    interface = nxt_service_get(rt->services, "engine", NULL);
+    interface = nxt_service_get(rt->services, "engine", rt->engine);
 
     router = rtcf->router;
 
@@ -1269,6 +1526,18 @@ nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data)
 
     nxt_router_engines_post(router, tmcf);
 
+    /* The CPU affinity of engines might have been changed. */
+
+    nxt_queue_each(skcf, &updating_sockets, nxt_socket_conf_t, link) {
+
+        ls = skcf->listen;
+
+        if (ls->reuseport == NXT_LISTEN_REUSEPORT_CPU && ls->nsockets != 0) {
+            nxt_router_listen_socket_steer(task, ls, rtcf);
+        }
+
+    } nxt_queue_loop;
+
     nxt_queue_add(&router->sockets, &updating_sockets);
     nxt_queue_add(&router->sockets, &creating_sockets);
 
@@ -1346,7 +1615,6 @@ void
 nxt_router_conf_error(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 {
     nxt_app_t          *app;
-    nxt_socket_t       s;
     nxt_router_t       *router;
     nxt_queue_link_t   *qlk;
     nxt_socket_conf_t  *skcf;
@@ -1359,11 +1627,8 @@ nxt_router_conf_error(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
          qlk = nxt_queue_next(qlk))
     {
         skcf = nxt_queue_link_data(qlk, nxt_socket_conf_t, link);
-        s = skcf->listen->socket;
 
-        if (s != -1) {
-            nxt_socket_close(task, s);
-        }
+        nxt_router_listen_sockets_close(task, skcf->listen);
 
         nxt_free(skcf->listen);
     }
@@ -1641,6 +1906,10 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     static nxt_str_t  conf_commands_path = nxt_string("/tls/conf_commands");
     static nxt_str_t  conf_cache_path = nxt_string("/tls/session/cache_size");
     static nxt_str_t  conf_timeout_path = nxt_string("/tls/session/timeout");
+    static nxt_str_t  conf_http2_path = nxt_string("/tls/http2");
+    static nxt_str_t  conf_ktls_path = nxt_string("/tls/ktls");
+    static nxt_str_t  conf_offload_path = nxt_string("/tls/handshake_offload");
+    static nxt_str_t  conf_early_data_path = nxt_string("/tls/early_data");
     static nxt_str_t  conf_tickets = nxt_string("/tls/session/tickets");
 #endif
 #if (NXT_HAVE_NJS)
@@ -1650,6 +1919,8 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     static nxt_str_t  websocket_path = nxt_string("/settings/http/websocket");
     static nxt_str_t  forwarded_path = nxt_string("/forwarded");
     static nxt_str_t  client_ip_path = nxt_string("/client_ip");
+    static nxt_str_t  reuseport_path = nxt_string("/reuseport");
+    static nxt_str_t  cpu_affinity_path = nxt_string("/settings/cpu_affinity");
 
     root = nxt_conf_json_parse(tmcf->mem_pool, start, end, NULL);
     if (root == NULL) {
@@ -1671,6 +1942,18 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         rtcf->threads = nxt_ncpu;
     }
 
+    conf = nxt_conf_get_path(root, &cpu_affinity_path);
+
+    if (conf != NULL) {
+        nxt_conf_get_string(conf, &name);
+
+        rtcf->cpuset = nxt_cpuset_parse(mp, &name);
+        if (nxt_slow_path(rtcf->cpuset == NULL)) {
+            nxt_alert(task, "invalid CPU list \"%V\"", &name);
+            return NXT_ERROR;
+        }
+    }
+
     conf = nxt_conf_get_path(root, &static_path);
 
     ret = nxt_router_conf_process_static(task, rtcf, conf);
@@ -1726,6 +2009,11 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             if (prev != NULL && nxt_strstr_eq(&app->conf, &prev->conf)) {
                 nxt_mp_destroy(app_mp);
 
+                ret = nxt_router_app_latency_update(prev, rtcf->threads);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    goto fail;
+                }
+
                 nxt_queue_remove(&prev->link);
                 nxt_queue_insert_tail(&tmcf->previous, &prev->link);
 
@@ -1831,6 +2119,12 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
             nxt_debug(task, "application language module: \"%s\"", lang->file);
 
+            app->latency = nxt_status_latency_create(app_mp, rtcf->threads,
+                                                NXT_STATUS_LATENCY_METRICS);
+            if (nxt_slow_path(app->latency == NULL)) {
+                goto app_fail;
+            }
+
             ret = nxt_thread_mutex_create(&app->mutex);
             if (ret != NXT_OK) {
                 goto app_fail;
@@ -2040,6 +2334,20 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
                 }
             }
 
+            conf = nxt_conf_get_path(listener, &access_log_path);
+
+            if (conf != NULL) {
+                skcf->log_filter = nxt_router_access_log_filter_create(task,
+                                                                    mp, conf);
+                if (nxt_slow_path(skcf->log_filter == NULL)) {
+                    return NXT_ERROR;
+                }
+            }
+
+            value = nxt_conf_get_path(listener, &reuseport_path);
+
+            nxt_router_listen_socket_reuseport(task, skcf->listen, value);
+
 #if (NXT_TLS)
             certificate = nxt_conf_get_path(listener, &certificate_path);
 
@@ -2062,12 +2370,49 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
                     tls_init->timeout = nxt_conf_get_number(value);
                 }
 
+                tls_init->session_cache = NULL;
+
+                if (tls_init->cache_size != 0) {
+                    tls_init->session_cache = nxt_tls_session_cache_use(task,
+                                    mp, &router->tls_session_caches, &name,
+                                    nxt_min(tls_init->cache_size,
+                                            NXT_INT32_T_MAX));
+
+                    if (nxt_slow_path(tls_init->session_cache == NULL)) {
+                        goto fail;
+                    }
+                }
+
                 tls_init->conf_cmds = nxt_conf_get_path(listener,
                                                         &conf_commands_path);
 
                 tls_init->tickets_conf = nxt_conf_get_path(listener,
                                                            &conf_tickets);
 
+                value = nxt_conf_get_path(listener, &conf_http2_path);
+                tls_init->http2 = (value != NULL
+                                   && nxt_conf_get_boolean(value));
+
+                value = nxt_conf_get_path(listener, &conf_ktls_path);
+                tls_init->ktls = (value != NULL
+                                  && nxt_conf_get_boolean(value));
+
+                value = nxt_conf_get_path(listener, &conf_early_data_path);
+                tls_init->early_data = (value != NULL
+                                        && nxt_conf_get_boolean(value));
+
+                tls_init->thread_pool = NULL;
+
+                value = nxt_conf_get_path(listener, &conf_offload_path);
+
+                if (value != NULL && nxt_conf_get_boolean(value)) {
+                    tls_init->thread_pool = nxt_router_tls_thread_pool(task,
+                                                                       router);
+                    if (nxt_slow_path(tls_init->thread_pool == NULL)) {
+                        goto fail;
+                    }
+                }
+
                 n = nxt_conf_array_elements_count_or_1(certificate);
 
                 for (i = 0; i < n; i++) {
@@ -2193,9 +2538,57 @@ nxt_router_conf_tls_insert(nxt_router_temp_conf_t *tmcf,
     return NXT_OK;
 }
 
+
+/*
+ * TLS handshakes of listeners with "handshake_offload" run in a thread
+ * pool shared by all router engines.  The pool is created on demand and
+ * is never destroyed, idle threads exit after the pool timeout.
+ */
+
+static nxt_thread_pool_t *
+nxt_router_tls_thread_pool(nxt_task_t *task, nxt_router_t *router)
+{
+    if (router->tls_thread_pool == NULL) {
+        router->tls_thread_pool = nxt_thread_pool_create(nxt_ncpu,
+                                                         60000 * 1000000LL,
+                                                         NULL,
+                                                         task->thread->engine,
+                                                         NULL);
+    }
+
+    return router->tls_thread_pool;
+}
+
 #endif
 
 
+/*
+ * Static files are opened in a thread pool shared by all router engines,
+ * so that a slow file system does not block the engines.  The pool has
+ * as many threads as there are engines; it is created on demand and is
+ * never destroyed, idle threads exit after the pool timeout.
+ */
+
+nxt_thread_pool_t *
+nxt_router_static_thread_pool(nxt_task_t *task, nxt_router_conf_t *rtcf)
+{
+    nxt_router_t        *router;
+    nxt_event_engine_t  *engine;
+
+    router = rtcf->router;
+
+    if (router->static_thread_pool == NULL) {
+        engine = task->thread->engine;
+
+        router->static_thread_pool = nxt_thread_pool_create(rtcf->threads,
+                                                            60000 * 1000000LL,
+                                                            NULL, engine, NULL);
+    }
+
+    return router->static_thread_pool;
+}
+
+
 #if (NXT_HAVE_NJS)
 
 static void
@@ -2469,6 +2862,34 @@ nxt_router_app_find(nxt_queue_t *queue, nxt_str_t *name)
 }
 
 
+/*
+ * A reused application gets larger latency slots if the number of router
+ * threads has grown; the previous slots are kept and merged on status
+ * request since engines may still update them.
+ */
+
+static nxt_int_t
+nxt_router_app_latency_update(nxt_app_t *app, nxt_uint_t threads)
+{
+    nxt_status_latency_t  *latency;
+
+    if (app->latency->engines >= threads) {
+        return NXT_OK;
+    }
+
+    latency = nxt_status_latency_create(app->mem_pool, threads,
+                                        NXT_STATUS_LATENCY_METRICS);
+    if (nxt_slow_path(latency == NULL)) {
+        return NXT_ERROR;
+    }
+
+    latency->prev = app->latency;
+    app->latency = latency;
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_router_app_queue_init(nxt_task_t *task, nxt_port_t *port)
 {
@@ -2788,17 +3209,67 @@ nxt_router_listen_socket_find(nxt_router_temp_conf_t *tmcf,
 }
 
 
+/*
+ * The "reuseport" mode is set when a listen socket is created; a socket
+ * kept from the previous configuration preserves its mode.
+ */
+
+static void
+nxt_router_listen_socket_reuseport(nxt_task_t *task, nxt_listen_socket_t *ls,
+    nxt_conf_value_t *value)
+{
+    nxt_str_t   str;
+    nxt_uint_t  reuseport;
+
+    reuseport = 0;
+
+    if (value != NULL) {
+        if (nxt_conf_type(value) == NXT_CONF_BOOLEAN) {
+            if (nxt_conf_get_boolean(value)) {
+                reuseport = NXT_LISTEN_REUSEPORT;
+            }
+
+        } else {
+            nxt_conf_get_string(value, &str);
+
+            if (nxt_str_eq(&str, "cpu", 3)) {
+                reuseport = NXT_LISTEN_REUSEPORT_CPU;
+            }
+        }
+    }
+
+#if (NXT_HAVE_UNIX_DOMAIN)
+    if (ls->sockaddr->u.sockaddr.sa_family == AF_UNIX) {
+        reuseport = 0;
+    }
+#endif
+
+    if (ls->socket == -1) {
+        ls->reuseport = reuseport;
+        return;
+    }
+
+    if (ls->reuseport != reuseport) {
+        nxt_log(task, NXT_LOG_WARN, "listener \"%*s\" \"reuseport\" change "
+                "is applied only to a new listen socket",
+                (size_t) ls->sockaddr->length,
+                nxt_sockaddr_start(ls->sockaddr));
+    }
+}
+
+
 static void
 nxt_router_listen_socket_rpc_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_socket_conf_t *skcf)
 {
-    size_t            size;
-    uint32_t          stream;
-    nxt_int_t         ret;
-    nxt_buf_t         *b;
-    nxt_port_t        *main_port, *router_port;
-    nxt_runtime_t     *rt;
-    nxt_socket_rpc_t  *rpc;
+    size_t               size;
+    uint32_t             stream;
+    nxt_int_t            ret;
+    nxt_buf_t            *b;
+    nxt_port_t           *main_port, *router_port;
+    nxt_runtime_t        *rt;
+    nxt_socket_rpc_t     *rpc;
+    nxt_listen_socket_t  *ls;
 
     rpc = nxt_mp_alloc(tmcf->mem_pool, sizeof(nxt_socket_rpc_t));
     if (rpc == NULL) {
@@ -2808,16 +3279,30 @@ nxt_router_listen_socket_rpc_create(nxt_task_t *task,
     rpc->socket_conf = skcf;
     rpc->temp_conf = tmcf;
 
-    size = nxt_sockaddr_size(skcf->listen->sockaddr);
+    ls = skcf->listen;
+
+    if (ls->reuseport && ls->sockets == NULL) {
+        ls->sockets = nxt_malloc(tmcf->router_conf->threads
+                                 * sizeof(nxt_socket_t));
+        if (ls->sockets == NULL) {
+            goto fail;
+        }
+    }
 
-    b = nxt_buf_mem_alloc(tmcf->mem_pool, size, 0);
+    size = nxt_sockaddr_size(ls->sockaddr);
+
+    b = nxt_buf_mem_alloc(tmcf->mem_pool, size + 1, 0);
     if (b == NULL) {
         goto fail;
     }
 
     b->completion_handler = nxt_buf_dummy_completion;
 
-    b->mem.free = nxt_cpymem(b->mem.free, skcf->listen->sockaddr, size);
+    b->mem.free = nxt_cpymem(b->mem.free, ls->sockaddr, size);
+
+    if (ls->reuseport) {
+        *b->mem.free++ = ls->reuseport;
+    }
 
     rt = task->thread->runtime;
     main_port = rt->port_by_type[NXT_PROCESS_MAIN];
@@ -2851,11 +3336,14 @@ static void
 nxt_router_listen_socket_ready(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     void *data)
 {
-    nxt_int_t         ret;
-    nxt_socket_t      s;
-    nxt_socket_rpc_t  *rpc;
+    nxt_int_t            ret;
+    nxt_uint_t           threads;
+    nxt_socket_t         s;
+    nxt_socket_rpc_t     *rpc;
+    nxt_listen_socket_t  *ls;
 
     rpc = data;
+    ls = rpc->socket_conf->listen;
 
     s = msg->fd[0];
 
@@ -2864,14 +3352,38 @@ nxt_router_listen_socket_ready(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         goto fail;
     }
 
-    nxt_socket_defer_accept(task, s, rpc->socket_conf->listen->sockaddr);
+    nxt_socket_defer_accept(task, s, ls->sockaddr);
 
     ret = nxt_listen_socket(task, s, NXT_LISTEN_BACKLOG);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto fail;
     }
 
-    rpc->socket_conf->listen->socket = s;
+    if (ls->sockets != NULL) {
+        /*
+         * The sockets of a SO_REUSEPORT group are created one by one,
+         * so their group indexes follow the engine indexes.
+         */
+
+        ls->sockets[ls->nsockets++] = s;
+
+        threads = rpc->temp_conf->router_conf->threads;
+
+        if (ls->nsockets < threads) {
+            nxt_router_listen_socket_rpc_create(task, rpc->temp_conf,
+                                                rpc->socket_conf);
+            return;
+        }
+
+        if (ls->reuseport == NXT_LISTEN_REUSEPORT_CPU) {
+            nxt_router_listen_socket_steer(task, ls,
+                                           rpc->temp_conf->router_conf);
+        }
+
+        s = ls->sockets[0];
+    }
+
+    ls->socket = s;
 
     nxt_work_queue_add(&task->thread->engine->fast_work_queue,
                        nxt_router_conf_apply, task, rpc->temp_conf, NULL);
@@ -2886,6 +3398,28 @@ nxt_router_listen_socket_ready(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 }
 
 
+/*
+ * The engine with index i accepts on the socket with index i modulo group
+ * size and is bound to the CPU with index i modulo set size, so a CPU of
+ * the set is mapped to the socket of the first engine bound to it.
+ */
+
+static void
+nxt_router_listen_socket_steer(nxt_task_t *task, nxt_listen_socket_t *ls,
+    nxt_router_conf_t *rtcf)
+{
+    nxt_uint_t    ncpus;
+    nxt_cpuset_t  *set;
+
+    set = rtcf->cpuset;
+
+    ncpus = (set != NULL) ? nxt_min(set->nelts, rtcf->threads) : 0;
+
+    (void) nxt_socket_reuseport_cpu(task, ls->sockets[0], ls->nsockets,
+                                    (set != NULL) ? set->cpus : NULL, ncpus);
+}
+
+
 static void
 nxt_router_listen_socket_error(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     void *data)
@@ -2978,6 +3512,8 @@ nxt_router_tls_rpc_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         }
 
         tlscf->no_wait_shutdown = 1;
+        tlscf->thread_pool = tls->tls_init->thread_pool;
+        tlscf->early_data = tls->tls_init->early_data;
         tls->socket_conf->tls = tlscf;
 
     } else {
@@ -3250,6 +3786,8 @@ nxt_router_engines_create(nxt_task_t *task, nxt_router_t *router,
             return NXT_ERROR;
         }
 
+        recf->engine->status_index = n;
+
         ret = nxt_router_engine_conf_create(tmcf, recf);
         if (nxt_slow_path(ret != NXT_OK)) {
             return ret;
@@ -3543,10 +4081,18 @@ nxt_router_engines_post(nxt_router_t *router, nxt_router_temp_conf_t *tmcf)
             break;
         }
 
+        if (recf->action != NXT_ROUTER_ENGINE_DELETE
+            && (tmcf->router_conf->cpuset != NULL || router->cpu_bound))
+        {
+            nxt_router_engine_cpu_bind(engine, tmcf->router_conf->cpuset);
+        }
+
         nxt_router_engine_post(engine, recf->jobs);
 
         recf++;
     }
+
+    router->cpu_bound = (tmcf->router_conf->cpuset != NULL);
 }
 
 
@@ -3564,6 +4110,49 @@ nxt_router_engine_post(nxt_event_engine_t *engine, nxt_work_t *jobs)
 }
 
 
+/*
+ * The engine threads are bound to the CPUs of the set in turn by their
+ * status index; without the set they restore the mask of the router
+ * main thread if they have been bound by a previous configuration.
+ */
+
+static void
+nxt_router_engine_cpu_bind(nxt_event_engine_t *engine, nxt_cpuset_t *set)
+{
+    size_t      size;
+    nxt_work_t  *work;
+
+    size = (set != NULL) ? sizeof(nxt_cpuset_t)
+                           + set->nelts * sizeof(uint16_t)
+                         : 0;
+
+    work = nxt_zalloc(sizeof(nxt_work_t) + size);
+    if (nxt_slow_path(work == NULL)) {
+        return;
+    }
+
+    work->handler = nxt_router_engine_cpu_bind_handler;
+    work->task = &engine->task;
+    work->obj = work;
+
+    if (set != NULL) {
+        work->data = work + 1;
+        nxt_memcpy(work->data, set, size);
+    }
+
+    nxt_event_engine_post(engine, work);
+}
+
+
+static void
+nxt_router_engine_cpu_bind_handler(nxt_task_t *task, void *obj, void *data)
+{
+    (void) nxt_cpuset_bind(task, 0, data, task->thread->engine->status_index);
+
+    nxt_free(obj);
+}
+
+
 static nxt_port_handlers_t  nxt_router_app_port_handlers = {
     .rpc_error       = nxt_port_rpc_handler,
     .mmap            = nxt_port_mmap_handler,
@@ -3666,6 +4255,19 @@ nxt_router_rt_add_port(nxt_task_t *task, void *obj, void *data)
 }
 
 
+/* An engine listens on its own socket of a SO_REUSEPORT group. */
+
+nxt_inline nxt_socket_t
+nxt_router_listen_fd(nxt_event_engine_t *engine, nxt_listen_socket_t *ls)
+{
+    if (ls->sockets == NULL) {
+        return ls->socket;
+    }
+
+    return ls->sockets[engine->status_index % ls->nsockets];
+}
+
+
 static void
 nxt_router_listen_socket_create(nxt_task_t *task, void *obj, void *data)
 {
@@ -3684,7 +4286,9 @@ nxt_router_listen_socket_create(nxt_task_t *task, void *obj, void *data)
     skcf = joint->socket_conf;
     ls = skcf->listen;
 
-    lev = nxt_listen_event(task, ls);
+    lev = nxt_listen_event_socket(task, ls,
+                                  nxt_router_listen_fd(task->thread->engine,
+                                                       ls));
     if (nxt_slow_path(lev == NULL)) {
         nxt_router_listen_socket_release(task, skcf);
         return;
@@ -3706,14 +4310,15 @@ nxt_router_listen_socket_create(nxt_task_t *task, void *obj, void *data)
 
 
 nxt_inline nxt_listen_event_t *
-nxt_router_listen_event(nxt_queue_t *listen_connections,
-    nxt_socket_conf_t *skcf)
+nxt_router_listen_event(nxt_event_engine_t *engine, nxt_socket_conf_t *skcf)
 {
     nxt_socket_t        fd;
+    nxt_queue_t         *listen_connections;
     nxt_queue_link_t    *qlk;
     nxt_listen_event_t  *lev;
 
-    fd = skcf->listen->socket;
+    fd = nxt_router_listen_fd(engine, skcf->listen);
+    listen_connections = &engine->listen_connections;
 
     for (qlk = nxt_queue_first(listen_connections);
          qlk != nxt_queue_tail(listen_connections);
@@ -3745,8 +4350,7 @@ nxt_router_listen_socket_update(nxt_task_t *task, void *obj, void *data)
 
     nxt_queue_insert_tail(&engine->joints, &joint->link);
 
-    lev = nxt_router_listen_event(&engine->listen_connections,
-                                  joint->socket_conf);
+    lev = nxt_router_listen_event(engine, joint->socket_conf);
 
     old = lev->socket.data;
     lev->socket.data = joint;
@@ -3778,7 +4382,7 @@ nxt_router_listen_socket_delete(nxt_task_t *task, void *obj, void *data)
 
     engine = task->thread->engine;
 
-    lev = nxt_router_listen_event(&engine->listen_connections, skcf);
+    lev = nxt_router_listen_event(engine, skcf);
 
     nxt_fd_event_delete(engine, &lev->socket);
 
@@ -3806,6 +4410,9 @@ nxt_router_worker_thread_quit(nxt_task_t *task, void *obj, void *data)
 
     engine->shutdown = 1;
 
+    nxt_upstream_keepalive_close(task, engine);
+    nxt_http_compress_cache_free(engine);
+
     if (nxt_queue_is_empty(&engine->joints)) {
         nxt_thread_exit(task->thread);
     }
@@ -3846,6 +4453,27 @@ nxt_router_listen_socket_close(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static void
+nxt_router_listen_sockets_close(nxt_task_t *task, nxt_listen_socket_t *ls)
+{
+    uint32_t  i;
+
+    if (ls->sockets == NULL) {
+        if (ls->socket != -1) {
+            nxt_socket_close(task, ls->socket);
+        }
+
+        return;
+    }
+
+    for (i = 0; i < ls->nsockets; i++) {
+        nxt_socket_close(task, ls->sockets[i]);
+    }
+
+    nxt_free(ls->sockets);
+}
+
+
 static void
 nxt_router_listen_socket_release(nxt_task_t *task, nxt_socket_conf_t *skcf)
 {
@@ -3877,7 +4505,7 @@ nxt_router_listen_socket_release(nxt_task_t *task, nxt_socket_conf_t *skcf)
         return;
     }
 
-    nxt_socket_close(task, ls->socket);
+    nxt_router_listen_sockets_close(task, ls);
 
 #if (NXT_HAVE_UNIX_DOMAIN)
     sa = ls->sockaddr;
@@ -4077,9 +4705,17 @@ nxt_router_response_ready_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 
     b = (msg->size == 0) ? NULL : msg->buf;
 
+    if (b != NULL && !r->header_sent) {
+        nxt_router_app_latency_add(task, req_rpc_data,
+                                   NXT_STATUS_LATENCY_TTFB);
+    }
+
     if (msg->port_msg.last != 0) {
         nxt_debug(task, "router data create last buf");
 
+        nxt_router_app_latency_add(task, req_rpc_data,
+                                   NXT_STATUS_LATENCY_TOTAL);
+
         nxt_buf_chain_add(&b, nxt_http_buf_last(r));
 
         req_rpc_data->rpc_cancel = 0;
@@ -4250,6 +4886,8 @@ nxt_router_req_headers_ack_handler(nxt_task_t *task,
     app = req_rpc_data->app;
     r = req_rpc_data->request;
 
+    nxt_router_app_latency_add(task, req_rpc_data, NXT_STATUS_LATENCY_QUEUE);
+
     start_process = 0;
     unlinked = 0;
 
@@ -4367,6 +5005,28 @@ nxt_router_req_headers_ack_handler(nxt_task_t *task,
 }
 
 
+/*
+ * The application latencies are counted from the moment the request
+ * has been passed to the application, so the queue time includes also
+ * the time of waiting for an application process.
+ */
+
+static void
+nxt_router_app_latency_add(nxt_task_t *task,
+    nxt_request_rpc_data_t *req_rpc_data, nxt_uint_t metric)
+{
+    nxt_nsec_t    now;
+    nxt_thread_t  *thr;
+
+    thr = task->thread;
+    now = nxt_thread_monotonic_time(thr);
+
+    nxt_status_latency_add(req_rpc_data->app->latency,
+                           thr->engine->status_index, metric,
+                           now - req_rpc_data->start_time);
+}
+
+
 static const nxt_http_request_state_t  nxt_http_request_send_state
     nxt_aligned(64) =
 {
@@ -5184,6 +5844,7 @@ nxt_router_process_http_request(nxt_task_t *task, nxt_http_request_t *r,
     req_rpc_data->app = conf->app;
     req_rpc_data->msg_info.body_fd = -1;
     req_rpc_data->rpc_cancel = 1;
+    req_rpc_data->start_time = nxt_thread_monotonic_time(task->thread);
 
     nxt_router_app_use(task, conf->app, 1);
 
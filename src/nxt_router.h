@@ -14,6 +14,7 @@
 
 typedef struct nxt_http_request_s  nxt_http_request_t;
 #include <nxt_application.h>
+#include <nxt_status.h>
 
 
 typedef struct nxt_http_action_s        nxt_http_action_t;
@@ -22,11 +23,27 @@ typedef struct nxt_http_forward_s       nxt_http_forward_t;
 typedef struct nxt_upstream_s           nxt_upstream_t;
 typedef struct nxt_upstreams_s          nxt_upstreams_t;
 typedef struct nxt_router_access_log_s  nxt_router_access_log_t;
+typedef struct nxt_router_access_log_buffer_s
+    nxt_router_access_log_buffer_t;
+typedef struct nxt_router_access_log_format_s
+    nxt_router_access_log_format_t;
 
 
 #define NXT_HTTP_ACTION_ERROR  ((nxt_http_action_t *) -1)
 
 
+/*
+ * The access log filter is tested before a log record is formatted:
+ * the record is written if the response status class is set in the
+ * "status" bit mask and then with the "sample" probability.
+ */
+
+typedef struct {
+    uint32_t                 sample;  /* in millionths */
+    uint8_t                  status;  /* bit mask of status classes */
+} nxt_router_access_log_filter_t;
+
+
 typedef struct {
     nxt_thread_spinlock_t    lock;
     nxt_queue_t              engines;
@@ -35,6 +52,19 @@ typedef struct {
     nxt_queue_t              apps;     /* of nxt_app_t */
 
     nxt_router_access_log_t  *access_log;
+
+    nxt_status_shm_t         *status_shm;
+    nxt_fd_t                 status_shm_fd;
+    nxt_timer_t              status_timer;
+
+    nxt_thread_pool_t        *static_thread_pool;
+
+#if (NXT_TLS)
+    nxt_queue_t              tls_session_caches;
+    nxt_thread_pool_t        *tls_thread_pool;
+#endif
+
+    uint8_t                  cpu_bound;  /* 1 bit */
 } nxt_router_t;
 
 
@@ -53,7 +83,12 @@ typedef struct {
     nxt_lvlhsh_t             apps_hash;
 
     nxt_router_access_log_t  *access_log;
-    nxt_tstr_t               *log_format;
+    nxt_router_access_log_format_t  *log_format;
+    nxt_router_access_log_filter_t  *log_filter;
+
+    nxt_array_t              *latencies;  /* of nxt_status_latency_t * */
+
+    nxt_cpuset_t             *cpuset;  /* of engine threads */
 } nxt_router_conf_t;
 
 
@@ -154,6 +189,8 @@ struct nxt_app_s {
     nxt_port_t             *proto_port;
 
     nxt_port_mmaps_t       outgoing;
+
+    nxt_status_latency_t   *latency;
 };
 
 
@@ -210,6 +247,8 @@ typedef struct {
     nxt_http_forward_t     *forwarded;
     nxt_http_forward_t     *client_ip;
 
+    nxt_router_access_log_filter_t  *log_filter;
+
 #if (NXT_TLS)
     nxt_tls_conf_t         *tls;
 #endif
@@ -231,12 +270,26 @@ typedef struct {
 
 
 struct nxt_router_access_log_s {
-    void                   (*handler)(nxt_task_t *task, nxt_http_request_t *r,
-                                      nxt_router_access_log_t *access_log,
-                                      nxt_tstr_t *format);
-    nxt_fd_t               fd;
-    nxt_str_t              path;
-    uint32_t               count;
+    void                            (*handler)(nxt_task_t *task,
+                                        nxt_http_request_t *r,
+                                        nxt_router_access_log_t *access_log,
+                                        nxt_router_access_log_format_t
+                                            *format);
+    nxt_fd_t                        fd;
+    nxt_str_t                       path;
+    uint32_t                        count;
+
+    /* Zero buffer size means that log records are written directly. */
+    size_t                          buffer_size;
+    nxt_msec_t                      flush;
+
+    nxt_router_access_log_buffer_t  *buffers;
+    nxt_thread_link_t               *link;
+    nxt_thread_spinlock_t           lock;
+    nxt_thread_mutex_t              mutex;
+    nxt_sem_t                       sem;
+    nxt_atomic_uint_t               dropped;
+    nxt_atomic_t                    quit;
 };
 
 
@@ -251,9 +304,13 @@ void nxt_router_listen_event_release(nxt_task_t *task, nxt_listen_event_t *lev,
 void nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data);
 void nxt_router_conf_error(nxt_task_t *task, nxt_router_temp_conf_t *tmcf);
 void nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint);
+nxt_thread_pool_t *nxt_router_static_thread_pool(nxt_task_t *task,
+    nxt_router_conf_t *rtcf);
 
 nxt_int_t nxt_router_access_log_create(nxt_task_t *task,
     nxt_router_conf_t *rtcf, nxt_conf_value_t *value);
+nxt_router_access_log_filter_t *nxt_router_access_log_filter_create(
+    nxt_task_t *task, nxt_mp_t *mp, nxt_conf_value_t *value);
 void nxt_router_access_log_open(nxt_task_t *task, nxt_router_temp_conf_t *tmcf);
 void nxt_router_access_log_use(nxt_thread_spinlock_t *lock,
     nxt_router_access_log_t *access_log);
@@ -13,22 +13,119 @@
 typedef struct {
     nxt_str_t                 path;
     nxt_str_t                 format;
+    size_t                    buffer;
+    nxt_msec_t                flush;
 } nxt_router_access_log_conf_t;
 
 
+/*
+ * Each engine appends log records to its own ring buffer without locking.
+ * The head is moved by the engine only and the tail is moved by the writer
+ * thread only, both are free running byte counters.
+ */
+
+struct nxt_router_access_log_buffer_s {
+    nxt_router_access_log_buffer_t  *next;
+    nxt_event_engine_t              *engine;
+    nxt_atomic_t                    head;
+    nxt_atomic_t                    tail;
+    nxt_atomic_t                    dropped;
+    size_t                          size;
+    u_char                          start[];
+};
+
+
+#define NXT_ROUTER_ACCESS_LOG_BUFFER  (64 * 1024)
+#define NXT_ROUTER_ACCESS_LOG_FLUSH   1000
+#define NXT_ROUTER_ACCESS_LOG_IOVECS  64
+
+
 typedef struct {
     nxt_str_t                 text;
     nxt_router_access_log_t   *access_log;
 } nxt_router_access_log_ctx_t;
 
 
+/*
+ * A log format is compiled into a list of operations which copy literal
+ * text or read request fields directly.  Other variables are resolved by
+ * calling their handlers without the variable cache.  The generic template
+ * string is used for JavaScript formats and for requests which have already
+ * cached variable values, so the same values are logged.
+ */
+
+typedef enum {
+    NXT_ROUTER_ACCESS_LOG_TEXT = 0,
+    NXT_ROUTER_ACCESS_LOG_VAR,
+    NXT_ROUTER_ACCESS_LOG_REPEAT,
+    NXT_ROUTER_ACCESS_LOG_REMOTE_ADDR,
+    NXT_ROUTER_ACCESS_LOG_TIME_LOCAL,
+    NXT_ROUTER_ACCESS_LOG_REQUEST_LINE,
+    NXT_ROUTER_ACCESS_LOG_METHOD,
+    NXT_ROUTER_ACCESS_LOG_REQUEST_URI,
+    NXT_ROUTER_ACCESS_LOG_URI,
+    NXT_ROUTER_ACCESS_LOG_HOST,
+    NXT_ROUTER_ACCESS_LOG_STATUS,
+    NXT_ROUTER_ACCESS_LOG_BODY_BYTES_SENT,
+    NXT_ROUTER_ACCESS_LOG_REFERER,
+    NXT_ROUTER_ACCESS_LOG_USER_AGENT,
+} nxt_router_access_log_op_type_t;
+
+
+typedef struct {
+    nxt_router_access_log_op_type_t  type;
+    nxt_str_t                        text;
+    nxt_var_handler_t                handler;
+    void                             *data;
+    uint32_t                         index;  /* of the repeated variable */
+} nxt_router_access_log_op_t;
+
+
+struct nxt_router_access_log_format_s {
+    nxt_tstr_t                  *tstr;
+    uint32_t                    nops;   /* zero if not compiled */
+    uint8_t                     cacheable;  /* 1 bit */
+    nxt_router_access_log_op_t  ops[];
+};
+
+
+#define NXT_ROUTER_ACCESS_LOG_OPS         64
+#define NXT_ROUTER_ACCESS_LOG_SAMPLE_ALL  1000000
+
+
+static nxt_router_access_log_format_t *nxt_router_access_log_format_create(
+    nxt_task_t *task, nxt_router_conf_t *rtcf, nxt_str_t *str);
+static nxt_int_t nxt_router_access_log_format_compile(
+    nxt_router_conf_t *rtcf, nxt_router_access_log_format_t *format,
+    nxt_str_t *str);
 static void nxt_router_access_log_writer(nxt_task_t *task,
     nxt_http_request_t *r, nxt_router_access_log_t *access_log,
-    nxt_tstr_t *format);
+    nxt_router_access_log_format_t *format);
+static nxt_bool_t nxt_router_access_log_test(nxt_task_t *task,
+    nxt_http_request_t *r);
+static nxt_int_t nxt_router_access_log_format(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_router_access_log_format_t *format,
+    nxt_str_t *text);
+static void nxt_router_access_log_write(nxt_task_t *task,
+    nxt_router_access_log_t *access_log, nxt_str_t *text);
 static void nxt_router_access_log_write_ready(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_router_access_log_write_error(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_router_access_log_append(nxt_task_t *task,
+    nxt_router_access_log_t *access_log, nxt_str_t *text);
+static nxt_router_access_log_buffer_t *nxt_router_access_log_buffer(
+    nxt_task_t *task, nxt_router_access_log_t *access_log);
+static nxt_int_t nxt_router_access_log_thread_create(nxt_task_t *task,
+    nxt_router_access_log_t *access_log);
+static void nxt_router_access_log_thread(void *data);
+static void nxt_router_access_log_thread_exit(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_router_access_log_flush(nxt_router_access_log_t *access_log);
+static void nxt_router_access_log_writev(nxt_fd_t fd, nxt_iobuf_t *iob,
+    nxt_uint_t niob);
+static void nxt_router_access_log_free(nxt_router_access_log_t *access_log);
+static void nxt_router_access_log_exit(void);
 static void nxt_router_access_log_ready(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_router_access_log_error(nxt_task_t *task,
@@ -53,6 +150,36 @@ static nxt_conf_map_t  nxt_router_access_log_conf[] = {
         NXT_CONF_MAP_STR,
         offsetof(nxt_router_access_log_conf_t, format),
     },
+
+    {
+        nxt_string("buffer"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_router_access_log_conf_t, buffer),
+    },
+
+    {
+        nxt_string("flush"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_router_access_log_conf_t, flush),
+    },
+};
+
+
+static const struct {
+    nxt_str_t                        name;
+    nxt_router_access_log_op_type_t  type;
+} nxt_router_access_log_fields[] = {
+    { nxt_string("remote_addr"),       NXT_ROUTER_ACCESS_LOG_REMOTE_ADDR },
+    { nxt_string("time_local"),        NXT_ROUTER_ACCESS_LOG_TIME_LOCAL },
+    { nxt_string("request_line"),      NXT_ROUTER_ACCESS_LOG_REQUEST_LINE },
+    { nxt_string("method"),            NXT_ROUTER_ACCESS_LOG_METHOD },
+    { nxt_string("request_uri"),       NXT_ROUTER_ACCESS_LOG_REQUEST_URI },
+    { nxt_string("uri"),               NXT_ROUTER_ACCESS_LOG_URI },
+    { nxt_string("host"),              NXT_ROUTER_ACCESS_LOG_HOST },
+    { nxt_string("status"),            NXT_ROUTER_ACCESS_LOG_STATUS },
+    { nxt_string("body_bytes_sent"),   NXT_ROUTER_ACCESS_LOG_BODY_BYTES_SENT },
+    { nxt_string("header_referer"),    NXT_ROUTER_ACCESS_LOG_REFERER },
+    { nxt_string("header_user_agent"), NXT_ROUTER_ACCESS_LOG_USER_AGENT },
 };
 
 
@@ -60,19 +187,22 @@ nxt_int_t
 nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
     nxt_conf_value_t *value)
 {
-    u_char                        *p;
-    nxt_int_t                     ret;
-    nxt_str_t                     str;
-    nxt_tstr_t                    *format;
-    nxt_router_t                  *router;
-    nxt_router_access_log_t       *access_log;
-    nxt_router_access_log_conf_t  alcf;
+    size_t                          size;
+    nxt_int_t                       ret;
+    nxt_router_t                    *router;
+    nxt_router_access_log_t         *access_log;
+    nxt_router_access_log_conf_t    alcf;
+    nxt_router_access_log_format_t  *format;
 
     static nxt_str_t  log_format_str = nxt_string("$remote_addr - - "
         "[$time_local] \"$request_line\" $status $body_bytes_sent "
         "\"$header_referer\" \"$header_user_agent\"");
+    static nxt_str_t  sample_str = nxt_string("sample");
+    static nxt_str_t  status_str = nxt_string("status");
 
     alcf.format = log_format_str;
+    alcf.buffer = NXT_ROUTER_ACCESS_LOG_BUFFER;
+    alcf.flush = NXT_ROUTER_ACCESS_LOG_FLUSH;
 
     if (nxt_conf_type(value) == NXT_CONF_STRING) {
         nxt_conf_get_string(value, &alcf.path);
@@ -92,11 +222,28 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
 
     access_log = router->access_log;
 
-    if (access_log != NULL && nxt_strstr_eq(&alcf.path, &access_log->path)) {
+    if (alcf.buffer != 0) {
+        /* The ring buffer size is rounded up to a power of 2. */
+
+        size = 1;
+
+        while (size < alcf.buffer) {
+            size <<= 1;
+        }
+
+        alcf.buffer = size;
+    }
+
+    if (access_log != NULL
+        && nxt_strstr_eq(&alcf.path, &access_log->path)
+        && alcf.buffer == access_log->buffer_size)
+    {
         nxt_router_access_log_use(&router->lock, access_log);
 
+        access_log->flush = alcf.flush;
+
     } else {
-        access_log = nxt_malloc(sizeof(nxt_router_access_log_t)
+        access_log = nxt_zalloc(sizeof(nxt_router_access_log_t)
                                 + alcf.path.length);
         if (access_log == NULL) {
             nxt_alert(task, "failed to allocate access log structure");
@@ -112,24 +259,36 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
                                  + sizeof(nxt_router_access_log_t);
 
         nxt_memcpy(access_log->path.start, alcf.path.start, alcf.path.length);
-    }
 
-    str.length = alcf.format.length + 1;
+        access_log->buffer_size = alcf.buffer;
+        access_log->flush = alcf.flush;
 
-    str.start = nxt_malloc(str.length);
-    if (str.start == NULL) {
-        nxt_alert(task, "failed to allocate log format structure");
-        return NXT_ERROR;
+        if (access_log->buffer_size != 0
+            && nxt_router_access_log_thread_create(task, access_log)
+               != NXT_OK)
+        {
+            nxt_alert(task, "failed to create access log writer thread");
+            nxt_free(access_log);
+            return NXT_ERROR;
+        }
     }
 
-    p = nxt_cpymem(str.start, alcf.format.start, alcf.format.length);
-    *p = '\n';
-
-    format = nxt_tstr_compile(rtcf->tstr_state, &str, NXT_TSTR_LOGGING);
+    format = nxt_router_access_log_format_create(task, rtcf, &alcf.format);
     if (nxt_slow_path(format == NULL)) {
         return NXT_ERROR;
     }
 
+    if (nxt_conf_type(value) == NXT_CONF_OBJECT
+        && (nxt_conf_get_object_member(value, &sample_str, NULL) != NULL
+            || nxt_conf_get_object_member(value, &status_str, NULL) != NULL))
+    {
+        rtcf->log_filter = nxt_router_access_log_filter_create(task,
+                                                      rtcf->mem_pool, value);
+        if (nxt_slow_path(rtcf->log_filter == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
     rtcf->access_log = access_log;
     rtcf->log_format = format;
 
@@ -137,14 +296,215 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
 }
 
 
+nxt_router_access_log_filter_t *
+nxt_router_access_log_filter_create(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *value)
+{
+    u_char                          c;
+    double                          sample;
+    uint32_t                        i, n;
+    nxt_str_t                       str;
+    nxt_conf_value_t                *cv, *status;
+    nxt_router_access_log_filter_t  *filter;
+
+    static nxt_str_t  sample_str = nxt_string("sample");
+    static nxt_str_t  status_str = nxt_string("status");
+
+    filter = nxt_mp_get(mp, sizeof(nxt_router_access_log_filter_t));
+    if (nxt_slow_path(filter == NULL)) {
+        return NULL;
+    }
+
+    filter->sample = NXT_ROUTER_ACCESS_LOG_SAMPLE_ALL;
+    filter->status = 0xff;
+
+    cv = nxt_conf_get_object_member(value, &sample_str, NULL);
+
+    if (cv != NULL) {
+        sample = nxt_conf_get_number(cv);
+
+        filter->sample = sample * NXT_ROUTER_ACCESS_LOG_SAMPLE_ALL + 0.5;
+    }
+
+    status = nxt_conf_get_object_member(value, &status_str, NULL);
+
+    if (status != NULL) {
+        filter->status = 0;
+
+        n = nxt_conf_array_elements_count_or_1(status);
+
+        for (i = 0; i < n; i++) {
+            cv = nxt_conf_get_array_element_or_itself(status, i);
+
+            nxt_conf_get_string(cv, &str);
+
+            /* Status classes are validated as "1xx" - "5xx". */
+            c = str.start[0] - '0';
+
+            filter->status |= 1 << c;
+        }
+    }
+
+    nxt_debug(task, "access log filter sample:%uD status:%02Xd",
+              filter->sample, filter->status);
+
+    return filter;
+}
+
+
+static nxt_router_access_log_format_t *
+nxt_router_access_log_format_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_str_t *str)
+{
+    u_char                          *p;
+    size_t                          size;
+    nxt_str_t                       line;
+    nxt_router_access_log_format_t  *format;
+
+    line.length = str->length + 1;
+
+    line.start = nxt_mp_nget(rtcf->mem_pool, line.length);
+    if (nxt_slow_path(line.start == NULL)) {
+        return NULL;
+    }
+
+    p = nxt_cpymem(line.start, str->start, str->length);
+    *p = '\n';
+
+    size = sizeof(nxt_router_access_log_format_t)
+           + NXT_ROUTER_ACCESS_LOG_OPS * sizeof(nxt_router_access_log_op_t);
+
+    format = nxt_mp_zget(rtcf->mem_pool, size);
+    if (nxt_slow_path(format == NULL)) {
+        return NULL;
+    }
+
+    format->tstr = nxt_tstr_compile(rtcf->tstr_state, &line,
+                                    NXT_TSTR_LOGGING);
+    if (nxt_slow_path(format->tstr == NULL)) {
+        return NULL;
+    }
+
+    if (line.start[0] != '`'
+        && nxt_router_access_log_format_compile(rtcf, format, &line)
+           != NXT_OK)
+    {
+        /* Too many parts, the template string is used. */
+        format->nops = 0;
+    }
+
+    nxt_debug(task, "access log format ops:%uD cacheable:%d",
+              format->nops, format->cacheable);
+
+    return format;
+}
+
+
+static nxt_int_t
+nxt_router_access_log_format_compile(nxt_router_conf_t *rtcf,
+    nxt_router_access_log_format_t *format, nxt_str_t *str)
+{
+    u_char                      *p, *end, *next;
+    nxt_str_t                   part;
+    nxt_uint_t                  i, n;
+    nxt_var_ref_t               *ref;
+    nxt_router_access_log_op_t  *op;
+
+    n = 0;
+
+    p = str->start;
+    end = p + str->length;
+
+    while (p < end) {
+        next = nxt_var_next_part(p, end, &part);
+        if (nxt_slow_path(next == NULL)) {
+            return NXT_ERROR;
+        }
+
+        if (n == NXT_ROUTER_ACCESS_LOG_OPS) {
+            return NXT_DECLINED;
+        }
+
+        op = &format->ops[n++];
+
+        if (part.start == NULL) {
+            op->type = NXT_ROUTER_ACCESS_LOG_TEXT;
+            op->text.length = next - p;
+            op->text.start = p;
+
+            p = next;
+            continue;
+        }
+
+        p = next;
+
+        for (i = 0; i < nxt_nitems(nxt_router_access_log_fields); i++) {
+            if (nxt_strstr_eq(&part, &nxt_router_access_log_fields[i].name)) {
+                op->type = nxt_router_access_log_fields[i].type;
+                break;
+            }
+        }
+
+        if (i < nxt_nitems(nxt_router_access_log_fields)) {
+            continue;
+        }
+
+        ref = nxt_var_ref_get(rtcf->tstr_state, &part);
+        if (nxt_slow_path(ref == NULL)) {
+            return NXT_ERROR;
+        }
+
+        op->type = NXT_ROUTER_ACCESS_LOG_VAR;
+        op->handler = ref->handler;
+        op->data = ref->data;
+
+        format->cacheable |= ref->cacheable;
+
+        /* A variable is evaluated once per record, like a cached one. */
+
+        for (i = 0; i < n - 1; i++) {
+            if (format->ops[i].type == NXT_ROUTER_ACCESS_LOG_VAR
+                && format->ops[i].handler == op->handler
+                && format->ops[i].data == op->data)
+            {
+                op->type = NXT_ROUTER_ACCESS_LOG_REPEAT;
+                op->index = i;
+                break;
+            }
+        }
+    }
+
+    format->nops = n;
+
+    return NXT_OK;
+}
+
+
 static void
 nxt_router_access_log_writer(nxt_task_t *task, nxt_http_request_t *r,
-    nxt_router_access_log_t *access_log, nxt_tstr_t *format)
+    nxt_router_access_log_t *access_log, nxt_router_access_log_format_t *format)
 {
     nxt_int_t                    ret;
+    nxt_str_t                    text;
     nxt_router_conf_t            *rtcf;
     nxt_router_access_log_ctx_t  *ctx;
 
+    if (!nxt_router_access_log_test(task, r)) {
+        goto done;
+    }
+
+    if (format->nops != 0
+        && !(format->cacheable && r->tstr_query != NULL))
+    {
+        ret = nxt_router_access_log_format(task, r, format, &text);
+
+        if (nxt_fast_path(ret == NXT_OK)) {
+            nxt_router_access_log_write(task, access_log, &text);
+        }
+
+        goto done;
+    }
+
     ctx = nxt_mp_get(r->mem_pool, sizeof(nxt_router_access_log_ctx_t));
     if (nxt_slow_path(ctx == NULL)) {
         return;
@@ -152,25 +512,213 @@ nxt_router_access_log_writer(nxt_task_t *task, nxt_http_request_t *r,
 
     ctx->access_log = access_log;
 
-    if (nxt_tstr_is_const(format)) {
-        nxt_tstr_str(format, &ctx->text);
+    rtcf = r->conf->socket_conf->router_conf;
 
-        nxt_router_access_log_write_ready(task, r, ctx);
+    ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                              &r->tstr_cache, r, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return;
+    }
 
-    } else {
-        rtcf = r->conf->socket_conf->router_conf;
+    nxt_tstr_query(task, r->tstr_query, format->tstr, &ctx->text);
+    nxt_tstr_query_resolve(task, r->tstr_query, ctx,
+                           nxt_router_access_log_write_ready,
+                           nxt_router_access_log_write_error);
+    return;
 
-        ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
-                                  &r->tstr_cache, r, r->mem_pool);
-        if (nxt_slow_path(ret != NXT_OK)) {
-            return;
+done:
+
+    nxt_http_request_close_handler(task, r, r->proto.any);
+}
+
+
+/*
+ * The most specific filter is used: the filter of the route action,
+ * then the filter of the listener, and then the global one.
+ */
+
+static nxt_bool_t
+nxt_router_access_log_test(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_uint_t                      class;
+    nxt_socket_conf_t               *skcf;
+    nxt_router_access_log_filter_t  *filter;
+
+    filter = (r->action != NULL) ? r->action->log_filter : NULL;
+
+    if (filter == NULL) {
+        skcf = r->conf->socket_conf;
+        filter = skcf->log_filter;
+
+        if (filter == NULL) {
+            filter = skcf->router_conf->log_filter;
+
+            if (filter == NULL) {
+                return 1;
+            }
         }
+    }
 
-        nxt_tstr_query(task, r->tstr_query, format, &ctx->text);
-        nxt_tstr_query_resolve(task, r->tstr_query, ctx,
-                               nxt_router_access_log_write_ready,
-                               nxt_router_access_log_write_error);
-     }
+    class = r->status / 100;
+
+    if (class > 7) {
+        class = 0;
+    }
+
+    if ((filter->status & (1 << class)) == 0) {
+        return 0;
+    }
+
+    if (filter->sample >= NXT_ROUTER_ACCESS_LOG_SAMPLE_ALL) {
+        return 1;
+    }
+
+    return (nxt_random(&task->thread->random)
+            % NXT_ROUTER_ACCESS_LOG_SAMPLE_ALL) < filter->sample;
+}
+
+
+static nxt_int_t
+nxt_router_access_log_format(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_router_access_log_format_t *format, nxt_str_t *text)
+{
+    u_char                      *p, *end;
+    size_t                      length;
+    nxt_int_t                   ret;
+    nxt_off_t                   bytes;
+    nxt_str_t                   *value, values[NXT_ROUTER_ACCESS_LOG_OPS];
+    nxt_uint_t                  i;
+    nxt_router_access_log_op_t  *op;
+
+    length = 0;
+
+    for (i = 0; i < format->nops; i++) {
+        op = &format->ops[i];
+        value = &values[i];
+
+        switch (op->type) {
+
+        case NXT_ROUTER_ACCESS_LOG_TEXT:
+            *value = op->text;
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_VAR:
+            ret = op->handler(task, value, r, op->data);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_REPEAT:
+            *value = values[op->index];
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_REMOTE_ADDR:
+            value->length = r->remote->address_length;
+            value->start = nxt_sockaddr_address(r->remote);
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_TIME_LOCAL:
+            length += NXT_HTTP_TIME_LOCAL_LEN;
+            continue;
+
+        case NXT_ROUTER_ACCESS_LOG_REQUEST_LINE:
+            *value = r->request_line;
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_METHOD:
+            *value = *r->method;
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_REQUEST_URI:
+            *value = r->target;
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_URI:
+            *value = *r->path;
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_HOST:
+            *value = r->host;
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_STATUS:
+            length += 3;
+            continue;
+
+        case NXT_ROUTER_ACCESS_LOG_BODY_BYTES_SENT:
+            length += NXT_OFF_T_LEN;
+            continue;
+
+        case NXT_ROUTER_ACCESS_LOG_REFERER:
+            if (r->referer != NULL) {
+                value->length = r->referer->value_length;
+                value->start = r->referer->value;
+
+            } else {
+                nxt_str_null(value);
+            }
+
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_USER_AGENT:
+            if (r->user_agent != NULL) {
+                value->length = r->user_agent->value_length;
+                value->start = r->user_agent->value;
+
+            } else {
+                nxt_str_null(value);
+            }
+
+            break;
+        }
+
+        /* Empty values are logged as "-". */
+        length += (value->start != NULL) ? value->length : 1;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    text->start = p;
+    end = p + length;
+
+    for (i = 0; i < format->nops; i++) {
+        op = &format->ops[i];
+        value = &values[i];
+
+        switch (op->type) {
+
+        case NXT_ROUTER_ACCESS_LOG_TIME_LOCAL:
+            p = nxt_http_time_local(task, p);
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_STATUS:
+            p = nxt_sprintf(p, end, "%03d", r->status);
+            break;
+
+        case NXT_ROUTER_ACCESS_LOG_BODY_BYTES_SENT:
+            bytes = nxt_http_proto[r->protocol].body_bytes_sent(task,
+                                                                r->proto);
+            p = nxt_sprintf(p, end, "%O", bytes);
+            break;
+
+        default:
+            if (value->start != NULL) {
+                p = nxt_cpymem(p, value->start, value->length);
+
+            } else {
+                *p++ = '-';
+            }
+        }
+    }
+
+    text->length = p - text->start;
+
+    return NXT_OK;
 }
 
 
@@ -183,12 +731,25 @@ nxt_router_access_log_write_ready(nxt_task_t *task, void *obj, void *data)
     r = obj;
     ctx = data;
 
-    nxt_fd_write(ctx->access_log->fd, ctx->text.start, ctx->text.length);
+    nxt_router_access_log_write(task, ctx->access_log, &ctx->text);
 
     nxt_http_request_close_handler(task, r, r->proto.any);
 }
 
 
+static void
+nxt_router_access_log_write(nxt_task_t *task,
+    nxt_router_access_log_t *access_log, nxt_str_t *text)
+{
+    if (access_log->buffer_size != 0) {
+        nxt_router_access_log_append(task, access_log, text);
+
+    } else {
+        nxt_fd_write(access_log->fd, text->start, text->length);
+    }
+}
+
+
 static void
 nxt_router_access_log_write_error(nxt_task_t *task, void *obj, void *data)
 {
@@ -196,6 +757,300 @@ nxt_router_access_log_write_error(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static void
+nxt_router_access_log_append(nxt_task_t *task,
+    nxt_router_access_log_t *access_log, nxt_str_t *text)
+{
+    size_t                          n, offset;
+    nxt_atomic_uint_t               head, used;
+    nxt_router_access_log_buffer_t  *buf;
+
+    buf = nxt_router_access_log_buffer(task, access_log);
+    if (nxt_slow_path(buf == NULL)) {
+        nxt_fd_write(access_log->fd, text->start, text->length);
+        return;
+    }
+
+    head = buf->head;
+    used = head - buf->tail;
+
+    if (nxt_slow_path(text->length > buf->size - used)) {
+        buf->dropped++;
+        return;
+    }
+
+    offset = head & (buf->size - 1);
+    n = nxt_min(text->length, buf->size - offset);
+
+    nxt_memcpy(buf->start + offset, text->start, n);
+    nxt_memcpy(buf->start, text->start + n, text->length - n);
+
+    /* The full barrier publishes the record to the writer thread. */
+    (void) nxt_atomic_fetch_add(&buf->head, text->length);
+
+    /* The writer thread is woken up once the buffer becomes half full. */
+
+    if (used < buf->size / 2 && used + text->length >= buf->size / 2) {
+        (void) nxt_sem_post(&access_log->sem);
+    }
+}
+
+
+static nxt_router_access_log_buffer_t *
+nxt_router_access_log_buffer(nxt_task_t *task,
+    nxt_router_access_log_t *access_log)
+{
+    nxt_event_engine_t              *engine;
+    nxt_router_access_log_buffer_t  *buf;
+
+    engine = task->thread->engine;
+
+    for (buf = access_log->buffers; buf != NULL; buf = buf->next) {
+        if (buf->engine == engine) {
+            return buf;
+        }
+    }
+
+    buf = nxt_malloc(sizeof(nxt_router_access_log_buffer_t)
+                     + access_log->buffer_size);
+    if (nxt_slow_path(buf == NULL)) {
+        return NULL;
+    }
+
+    buf->engine = engine;
+    buf->head = 0;
+    buf->tail = 0;
+    buf->dropped = 0;
+    buf->size = access_log->buffer_size;
+
+    /* Buffers are never removed, so the list is walked without locking. */
+
+    nxt_thread_spin_lock(&access_log->lock);
+
+    buf->next = access_log->buffers;
+    access_log->buffers = buf;
+
+    nxt_thread_spin_unlock(&access_log->lock);
+
+    return buf;
+}
+
+
+static nxt_int_t
+nxt_router_access_log_thread_create(nxt_task_t *task,
+    nxt_router_access_log_t *access_log)
+{
+    nxt_thread_link_t    *link;
+    nxt_thread_handle_t  handle;
+
+    static nxt_bool_t    exit_handler;
+
+    if (!exit_handler) {
+        if (nxt_slow_path(atexit(nxt_router_access_log_exit) != 0)) {
+            return NXT_ERROR;
+        }
+
+        exit_handler = 1;
+    }
+
+    if (nxt_slow_path(nxt_thread_mutex_create(&access_log->mutex) != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(nxt_sem_init(&access_log->sem, 0) != NXT_OK)) {
+        goto fail;
+    }
+
+    link = nxt_zalloc(sizeof(nxt_thread_link_t));
+    if (nxt_slow_path(link == NULL)) {
+        goto fail_sem;
+    }
+
+    link->start = nxt_router_access_log_thread;
+    link->work.handler = nxt_router_access_log_thread_exit;
+    link->work.task = &task->thread->engine->task;
+    link->work.data = access_log;
+
+    access_log->link = link;
+
+    if (nxt_fast_path(nxt_thread_create(&handle, link) == NXT_OK)) {
+        return NXT_OK;
+    }
+
+    /* The link has been freed by nxt_thread_create(). */
+    access_log->link = NULL;
+
+fail_sem:
+
+    nxt_sem_destroy(&access_log->sem);
+
+fail:
+
+    nxt_thread_mutex_destroy(&access_log->mutex);
+
+    return NXT_ERROR;
+}
+
+
+static void
+nxt_router_access_log_thread(void *data)
+{
+    nxt_thread_t             *thr;
+    nxt_router_access_log_t  *access_log;
+
+    access_log = data;
+    thr = nxt_thread();
+
+    nxt_log_debug(thr->log, "access log writer thread \"%V\"",
+                  &access_log->path);
+
+    while (!access_log->quit) {
+        (void) nxt_sem_wait(&access_log->sem,
+                            (nxt_nsec_t) access_log->flush * 1000000);
+
+        nxt_router_access_log_flush(access_log);
+    }
+
+    nxt_thread_exit(thr);
+}
+
+
+static void
+nxt_router_access_log_thread_exit(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_thread_handle_t  handle;
+
+    handle = (nxt_thread_handle_t) (uintptr_t) obj;
+
+    nxt_thread_wait(handle);
+
+    nxt_router_access_log_free(data);
+}
+
+
+static void
+nxt_router_access_log_flush(nxt_router_access_log_t *access_log)
+{
+    size_t                          n, offset;
+    nxt_uint_t                      i, niob, nbuf;
+    nxt_iobuf_t                     iob[NXT_ROUTER_ACCESS_LOG_IOVECS];
+    nxt_atomic_uint_t               head, tail, dropped;
+    nxt_atomic_uint_t               size[NXT_ROUTER_ACCESS_LOG_IOVECS];
+    nxt_router_access_log_buffer_t  *buf, *bufs[NXT_ROUTER_ACCESS_LOG_IOVECS];
+
+    nxt_thread_mutex_lock(&access_log->mutex);
+
+    buf = access_log->buffers;
+    dropped = 0;
+
+    while (buf != NULL) {
+        niob = 0;
+        nbuf = 0;
+
+        /* A buffer takes up to 2 iovecs if its data wrap around. */
+
+        while (buf != NULL && niob + 2 <= NXT_ROUTER_ACCESS_LOG_IOVECS) {
+            dropped += buf->dropped;
+
+            head = nxt_atomic_fetch_add(&buf->head, 0);
+            tail = buf->tail;
+
+            if (head != tail) {
+                offset = tail & (buf->size - 1);
+                n = nxt_min(head - tail, buf->size - offset);
+
+                nxt_iobuf_set(&iob[niob], buf->start + offset, n);
+                niob++;
+
+                if (n < head - tail) {
+                    nxt_iobuf_set(&iob[niob], buf->start, head - tail - n);
+                    niob++;
+                }
+
+                bufs[nbuf] = buf;
+                size[nbuf] = head - tail;
+                nbuf++;
+            }
+
+            buf = buf->next;
+        }
+
+        if (niob == 0) {
+            continue;
+        }
+
+        nxt_router_access_log_writev(access_log->fd, iob, niob);
+
+        for (i = 0; i < nbuf; i++) {
+            (void) nxt_atomic_fetch_add(&bufs[i]->tail, size[i]);
+        }
+    }
+
+    if (dropped != access_log->dropped) {
+        nxt_thread_log_error(NXT_LOG_WARN,
+                             "access log \"%V\": %uA records dropped",
+                             &access_log->path, dropped - access_log->dropped);
+
+        access_log->dropped = dropped;
+    }
+
+    nxt_thread_mutex_unlock(&access_log->mutex);
+}
+
+
+static void
+nxt_router_access_log_writev(nxt_fd_t fd, nxt_iobuf_t *iob, nxt_uint_t niob)
+{
+    ssize_t    n;
+    nxt_err_t  err;
+
+    while (niob != 0) {
+        n = writev(fd, iob, niob);
+
+        if (nxt_slow_path(n == -1)) {
+            err = nxt_errno;
+
+            if (err == NXT_EINTR) {
+                continue;
+            }
+
+            nxt_thread_log_alert("writev(%FD, %ui) failed %E", fd, niob, err);
+            return;
+        }
+
+        while (niob != 0 && (size_t) n >= iob->iov_len) {
+            n -= iob->iov_len;
+            iob++;
+            niob--;
+        }
+
+        if (niob != 0) {
+            iob->iov_base = (u_char *) iob->iov_base + n;
+            iob->iov_len -= n;
+        }
+    }
+}
+
+
+/* Flushes the records of the current access log on the router exit. */
+
+static void
+nxt_router_access_log_exit(void)
+{
+    nxt_router_access_log_t  *access_log;
+
+    if (nxt_router == NULL) {
+        return;
+    }
+
+    access_log = nxt_router->access_log;
+
+    if (access_log != NULL && access_log->buffer_size != 0) {
+        nxt_router_access_log_flush(access_log);
+    }
+}
+
+
 void
 nxt_router_access_log_open(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 {
@@ -308,14 +1163,44 @@ nxt_router_access_log_release(nxt_task_t *task, nxt_thread_spinlock_t *lock,
 
     nxt_thread_spin_unlock(lock);
 
-    if (access_log != NULL) {
+    if (access_log == NULL) {
+        return;
+    }
+
+    if (access_log->buffer_size != 0) {
+        /* The writer thread flushes the buffers and frees the log. */
+        access_log->quit = 1;
+        (void) nxt_sem_post(&access_log->sem);
+        return;
+    }
 
-        if (access_log->fd != -1) {
-            nxt_fd_close(access_log->fd);
+    nxt_router_access_log_free(access_log);
+}
+
+
+static void
+nxt_router_access_log_free(nxt_router_access_log_t *access_log)
+{
+    nxt_router_access_log_buffer_t  *buf, *next;
+
+    if (access_log->buffer_size != 0) {
+
+        for (buf = access_log->buffers; buf != NULL; buf = next) {
+            next = buf->next;
+            nxt_free(buf);
         }
 
-        nxt_free(access_log);
+        nxt_free(access_log->link);
+
+        nxt_sem_destroy(&access_log->sem);
+        nxt_thread_mutex_destroy(&access_log->mutex);
     }
+
+    if (access_log->fd != -1) {
+        nxt_fd_close(access_log->fd);
+    }
+
+    nxt_free(access_log);
 }
 
 
@@ -34,6 +34,8 @@ typedef struct {
     nxt_msg_info_t          msg_info;
 
     nxt_bool_t              rpc_cancel;
+
+    nxt_nsec_t              start_time;
 } nxt_request_rpc_data_t;
 
 
@@ -965,6 +965,8 @@ nxt_runtime_conf_read_cmd(nxt_task_t *task, nxt_runtime_t *rt)
     static const char  no_state[] =
                        "option \"--statedir\" requires directory\n";
     static const char  no_tmp[] = "option \"--tmpdir\" requires directory\n";
+    static const char  no_engine[] =
+                       "option \"--engine\" requires engine name\n";
 
     static const char  modules_deprecated[] =
            "option \"--modules\" is deprecated; use \"--modulesdir\" instead\n";
@@ -1003,6 +1005,9 @@ nxt_runtime_conf_read_cmd(nxt_task_t *task, nxt_runtime_t *rt)
         "  --state DIR          [deprecated] synonym for --statedir\n"
         "  --tmp DIR            [deprecated] synonym for --tmpdir\n"
         "\n"
+        "  --engine NAME        set event engine name\n"
+        "                       default: the first available engine\n"
+        "\n"
         "  --user USER          set non-privileged processes to run"
                                 " as specified user\n"
         "                       default: \"" NXT_USER "\"\n"
@@ -1143,6 +1148,19 @@ nxt_runtime_conf_read_cmd(nxt_task_t *task, nxt_runtime_t *rt)
             continue;
         }
 
+        if (nxt_strcmp(p, "--engine") == 0) {
+            if (*argv == NULL) {
+                write(STDERR_FILENO, no_engine, nxt_length(no_engine));
+                return NXT_ERROR;
+            }
+
+            p = *argv++;
+
+            rt->engine = p;
+
+            continue;
+        }
+
         if (nxt_strcmp(p, "--no-daemon") == 0) {
             rt->daemon = 0;
             continue;
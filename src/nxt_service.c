@@ -17,6 +17,9 @@ static const nxt_service_t  nxt_services[] = {
     { "engine", "epoll", &nxt_epoll_edge_engine },
     { "engine", "epoll_edge", &nxt_epoll_edge_engine },
     { "engine", "epoll_level", &nxt_epoll_level_engine },
+#if (NXT_HAVE_IO_URING)
+    { "engine", "io_uring", &nxt_io_uring_engine },
+#endif
 
 #elif (NXT_HAVE_EPOLL)
     { "engine", "epoll", &nxt_epoll_level_engine },
@@ -6,6 +6,10 @@
 
 #include <nxt_main.h>
 
+#if (NXT_LINUX)
+#include <linux/filter.h>
+#endif
+
 
 static const char *nxt_socket_sockopt_name(nxt_uint_t level,
     nxt_uint_t sockopt);
@@ -71,6 +75,71 @@ nxt_socket_defer_accept(nxt_task_t *task, nxt_socket_t s, nxt_sockaddr_t *sa)
 }
 
 
+/*
+ * A classic BPF program steers a new connection to a socket of
+ * a SO_REUSEPORT group of "n" sockets.  A connection received on the
+ * CPU cpus[i] goes to the socket with index i modulo group size, and
+ * a connection received on any other CPU goes to the socket with index
+ * of the CPU modulo group size.
+ */
+
+nxt_int_t
+nxt_socket_reuseport_cpu(nxt_task_t *task, nxt_socket_t s, nxt_uint_t n,
+    const uint16_t *cpus, nxt_uint_t ncpus)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+
+    int                 ret;
+    nxt_uint_t          i;
+    struct sock_fprog   prog;
+    struct sock_filter  *code, *pc;
+
+    code = nxt_malloc((2 * ncpus + 3) * sizeof(struct sock_filter));
+    if (nxt_slow_path(code == NULL)) {
+        return NXT_ERROR;
+    }
+
+    pc = code;
+
+    *pc++ = (struct sock_filter)
+                BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_CPU);
+
+    for (i = 0; i < ncpus; i++) {
+        *pc++ = (struct sock_filter)
+                    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, cpus[i], 0, 1);
+        *pc++ = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, i % n);
+    }
+
+    *pc++ = (struct sock_filter) BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, n);
+    *pc++ = (struct sock_filter) BPF_STMT(BPF_RET | BPF_A, 0);
+
+    prog.len = pc - code;
+    prog.filter = code;
+
+    ret = setsockopt(s, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                     &prog, sizeof(prog));
+
+    nxt_free(code);
+
+    if (nxt_fast_path(ret == 0)) {
+        nxt_debug(task, "setsockopt(%d, SO_ATTACH_REUSEPORT_CBPF): %ui, %ui",
+                  s, n, ncpus);
+        return NXT_OK;
+    }
+
+    nxt_alert(task, "setsockopt(%d, SO_ATTACH_REUSEPORT_CBPF) failed %E",
+              s, nxt_socket_errno);
+
+#else
+
+    nxt_log(task, NXT_LOG_WARN, "reuseport CPU steering is not supported");
+
+#endif
+
+    return NXT_ERROR;
+}
+
+
 nxt_int_t
 nxt_socket_getsockopt(nxt_task_t *task, nxt_socket_t s, nxt_uint_t level,
     nxt_uint_t sockopt)
@@ -133,6 +202,11 @@ nxt_socket_sockopt_name(nxt_uint_t level, nxt_uint_t sockopt)
         case SO_REUSEADDR:
             return "SO_REUSEADDR";
 
+#ifdef SO_REUSEPORT
+        case SO_REUSEPORT:
+            return "SO_REUSEPORT";
+#endif
+
         case SO_TYPE:
             return "SO_TYPE";
         }
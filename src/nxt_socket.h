@@ -95,6 +95,8 @@ NXT_EXPORT nxt_socket_t nxt_socket_create(nxt_task_t *task, nxt_uint_t family,
     nxt_uint_t type, nxt_uint_t protocol, nxt_uint_t flags);
 NXT_EXPORT void nxt_socket_defer_accept(nxt_task_t *task, nxt_socket_t s,
     nxt_sockaddr_t *sa);
+NXT_EXPORT nxt_int_t nxt_socket_reuseport_cpu(nxt_task_t *task,
+    nxt_socket_t s, nxt_uint_t n, const uint16_t *cpus, nxt_uint_t ncpus);
 NXT_EXPORT nxt_int_t nxt_socket_getsockopt(nxt_task_t *task, nxt_socket_t s,
     nxt_uint_t level, nxt_uint_t sockopt);
 NXT_EXPORT nxt_int_t nxt_socket_setsockopt(nxt_task_t *task, nxt_socket_t s,
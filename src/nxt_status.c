@@ -8,6 +8,88 @@
 #include <nxt_status.h>
 
 
+static nxt_conf_value_t *nxt_status_routes_get(nxt_status_report_t *report,
+    nxt_mp_t *mp);
+static nxt_conf_value_t *nxt_status_steps_get(nxt_status_report_t *report,
+    nxt_mp_t *mp, nxt_status_route_t *route, nxt_uint_t n);
+static nxt_conf_value_t *nxt_status_latency_get(nxt_mp_t *mp,
+    nxt_status_histogram_t *hist, nxt_uint_t metrics);
+static nxt_conf_value_t *nxt_status_histogram_get(nxt_mp_t *mp,
+    nxt_status_histogram_t *hist);
+static u_char *nxt_status_metrics_label(u_char *p, u_char *end,
+    const char *label, nxt_str_t *value);
+static u_char *nxt_status_metrics_histogram(u_char *p, u_char *end,
+    const char *family, nxt_str_t *labels, nxt_status_histogram_t *hist);
+
+
+#define NXT_STATUS_METRICS_HEAD  2048
+#define NXT_STATUS_METRICS_LINE  160
+
+
+static nxt_str_t  nxt_status_latency_names[] = {
+    nxt_string("ttfb"),
+    nxt_string("total"),
+    nxt_string("queue"),
+};
+
+
+nxt_status_latency_t *
+nxt_status_latency_create(nxt_mp_t *mp, nxt_uint_t engines,
+    nxt_uint_t metrics)
+{
+    size_t                size;
+    nxt_status_latency_t  *latency;
+
+    latency = nxt_mp_zget(mp, sizeof(nxt_status_latency_t));
+    if (nxt_slow_path(latency == NULL)) {
+        return NULL;
+    }
+
+    latency->engines = engines;
+    latency->metrics = metrics;
+    latency->stride = nxt_align_size(metrics * sizeof(nxt_status_histogram_t),
+                                     NXT_STATUS_LATENCY_ALIGN);
+
+    size = engines * latency->stride;
+
+    latency->slots = nxt_mp_align(mp, NXT_STATUS_LATENCY_ALIGN, size);
+    if (nxt_slow_path(latency->slots == NULL)) {
+        return NULL;
+    }
+
+    nxt_memzero(latency->slots, size);
+
+    return latency;
+}
+
+
+/* The engine slots are summed up to the "hist" array of "metrics" items. */
+
+void
+nxt_status_latency_merge(nxt_status_latency_t *latency,
+    nxt_status_histogram_t *hist)
+{
+    nxt_uint_t              e, m, i;
+    nxt_status_histogram_t  *slot;
+
+    for ( /* void */ ; latency != NULL; latency = latency->prev) {
+
+        for (e = 0; e < latency->engines; e++) {
+            slot = (nxt_status_histogram_t *) (latency->slots
+                                               + e * latency->stride);
+
+            for (m = 0; m < latency->metrics; m++) {
+                hist[m].sum += slot[m].sum;
+
+                for (i = 0; i < NXT_STATUS_LATENCY_BUCKETS; i++) {
+                    hist[m].buckets[i] += slot[m].buckets[i];
+                }
+            }
+        }
+    }
+}
+
+
 nxt_conf_value_t *
 nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
 {
@@ -15,7 +97,7 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
     nxt_str_t         name;
     nxt_int_t         ret;
     nxt_status_app_t  *app;
-    nxt_conf_value_t  *status, *obj, *apps, *app_obj;
+    nxt_conf_value_t  *status, *obj, *apps, *app_obj, *cache, *routes;
 
     static nxt_str_t conns_str = nxt_string("connections");
     static nxt_str_t acc_str = nxt_string("accepted");
@@ -28,8 +110,16 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
     static nxt_str_t procs_str = nxt_string("processes");
     static nxt_str_t run_str = nxt_string("running");
     static nxt_str_t start_str = nxt_string("starting");
+    static nxt_str_t static_str = nxt_string("static");
+    static nxt_str_t cache_str = nxt_string("open_file_cache");
+    static nxt_str_t tls_str = nxt_string("tls");
+    static nxt_str_t session_cache_str = nxt_string("session_cache");
+    static nxt_str_t hits_str = nxt_string("hits");
+    static nxt_str_t misses_str = nxt_string("misses");
+    static nxt_str_t routes_str = nxt_string("routes");
+    static nxt_str_t latency_str = nxt_string("latency");
 
-    status = nxt_conf_create_object(mp, 3);
+    status = nxt_conf_create_object(mp, 6);
     if (nxt_slow_path(status == NULL)) {
         return NULL;
     }
@@ -57,17 +147,61 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
 
     nxt_conf_set_member_integer(obj, &total_str, report->requests, 0);
 
+    obj = nxt_conf_create_object(mp, 1);
+    if (nxt_slow_path(obj == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(status, &static_str, obj, 2);
+
+    cache = nxt_conf_create_object(mp, 2);
+    if (nxt_slow_path(cache == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(obj, &cache_str, cache, 0);
+
+    nxt_conf_set_member_integer(cache, &hits_str, report->static_cache_hits, 0);
+    nxt_conf_set_member_integer(cache, &misses_str,
+                                report->static_cache_misses, 1);
+
+    obj = nxt_conf_create_object(mp, 1);
+    if (nxt_slow_path(obj == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(status, &tls_str, obj, 3);
+
+    cache = nxt_conf_create_object(mp, 2);
+    if (nxt_slow_path(cache == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(obj, &session_cache_str, cache, 0);
+
+    nxt_conf_set_member_integer(cache, &hits_str,
+                                report->tls_session_cache_hits, 0);
+    nxt_conf_set_member_integer(cache, &misses_str,
+                                report->tls_session_cache_misses, 1);
+
+    routes = nxt_status_routes_get(report, mp);
+    if (nxt_slow_path(routes == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(status, &routes_str, routes, 4);
+
     apps = nxt_conf_create_object(mp, report->apps_count);
     if (nxt_slow_path(apps == NULL)) {
         return NULL;
     }
 
-    nxt_conf_set_member(status, &apps_str, apps, 2);
+    nxt_conf_set_member(status, &apps_str, apps, 5);
 
     for (i = 0; i < report->apps_count; i++) {
         app = &report->apps[i];
 
-        app_obj = nxt_conf_create_object(mp, 2);
+        app_obj = nxt_conf_create_object(mp, 3);
         if (nxt_slow_path(app_obj == NULL)) {
             return NULL;
         }
@@ -99,7 +233,582 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
         nxt_conf_set_member(app_obj, &reqs_str, obj, 1);
 
         nxt_conf_set_member_integer(obj, &active_str, app->active_requests, 0);
+
+        obj = nxt_status_latency_get(mp, app->latency,
+                                     NXT_STATUS_LATENCY_METRICS);
+        if (nxt_slow_path(obj == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_set_member(app_obj, &latency_str, obj, 2);
     }
 
     return status;
 }
+
+
+/*
+ * The routes object follows the "routes" configuration: it contains
+ * the steps of the routes array or the named routes of their steps.
+ */
+
+static nxt_conf_value_t *
+nxt_status_routes_get(nxt_status_report_t *report, nxt_mp_t *mp)
+{
+    size_t              i, n;
+    nxt_str_t           name;
+    nxt_int_t           ret;
+    nxt_uint_t          count, member;
+    nxt_conf_value_t    *routes, *steps;
+    nxt_status_route_t  *route;
+
+    route = nxt_pointer_to(report, (uintptr_t) report->routes);
+    n = report->routes_count;
+
+    if (n != 0 && route[0].name.length == 0) {
+        return nxt_status_steps_get(report, mp, route, n);
+    }
+
+    count = 0;
+
+    for (i = 0; i < n; i++) {
+        count += (route[i].step == 0);
+    }
+
+    routes = nxt_conf_create_object(mp, count);
+    if (nxt_slow_path(routes == NULL)) {
+        return NULL;
+    }
+
+    member = 0;
+
+    for (i = 0; i < n; i += count) {
+
+        for (count = 1; i + count < n; count++) {
+            if (route[i + count].step == 0) {
+                break;
+            }
+        }
+
+        steps = nxt_status_steps_get(report, mp, &route[i], count);
+        if (nxt_slow_path(steps == NULL)) {
+            return NULL;
+        }
+
+        name.length = route[i].name.length;
+        name.start = nxt_pointer_to(report, (uintptr_t) route[i].name.start);
+
+        ret = nxt_conf_set_member_dup(routes, mp, &name, steps, member++);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+    }
+
+    return routes;
+}
+
+
+static nxt_conf_value_t *
+nxt_status_steps_get(nxt_status_report_t *report, nxt_mp_t *mp,
+    nxt_status_route_t *route, nxt_uint_t n)
+{
+    u_char            *p;
+    nxt_str_t         name;
+    nxt_uint_t        i;
+    nxt_conf_value_t  *steps, *obj;
+
+    steps = nxt_conf_create_object(mp, n);
+    if (nxt_slow_path(steps == NULL)) {
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++) {
+        obj = nxt_status_latency_get(mp, route[i].latency,
+                                     NXT_STATUS_LATENCY_QUEUE);
+        if (nxt_slow_path(obj == NULL)) {
+            return NULL;
+        }
+
+        p = nxt_mp_nget(mp, NXT_INT32_T_LEN);
+        if (nxt_slow_path(p == NULL)) {
+            return NULL;
+        }
+
+        name.start = p;
+        name.length = nxt_sprintf(p, p + NXT_INT32_T_LEN, "%uD",
+                                  route[i].step)
+                      - p;
+
+        nxt_conf_set_member(steps, &name, obj, i);
+    }
+
+    return steps;
+}
+
+
+static nxt_conf_value_t *
+nxt_status_latency_get(nxt_mp_t *mp, nxt_status_histogram_t *hist,
+    nxt_uint_t metrics)
+{
+    nxt_uint_t        i;
+    nxt_conf_value_t  *latency, *obj;
+
+    latency = nxt_conf_create_object(mp, metrics);
+    if (nxt_slow_path(latency == NULL)) {
+        return NULL;
+    }
+
+    for (i = 0; i < metrics; i++) {
+        obj = nxt_status_histogram_get(mp, &hist[i]);
+        if (nxt_slow_path(obj == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_set_member(latency, &nxt_status_latency_names[i], obj, i);
+    }
+
+    return latency;
+}
+
+
+/*
+ * A percentile is reported as the upper bound of the bucket where it falls,
+ * in microseconds, or as null if it falls to the unbounded bucket.
+ * All the values are zero if nothing has been counted yet.
+ */
+
+static nxt_conf_value_t *
+nxt_status_histogram_get(nxt_mp_t *mp, nxt_status_histogram_t *hist)
+{
+    int64_t           bound;
+    uint64_t          count, total, rank;
+    nxt_str_t         *name;
+    nxt_uint_t        i, p;
+    nxt_conf_value_t  *obj, *buckets;
+
+    static nxt_str_t count_str = nxt_string("count");
+    static nxt_str_t sum_str = nxt_string("sum");
+    static nxt_str_t buckets_str = nxt_string("buckets");
+
+    static const struct {
+        nxt_str_t     name;
+        nxt_uint_t    percent;
+    } percentiles[] = {
+        { nxt_string("p50"), 50 },
+        { nxt_string("p90"), 90 },
+        { nxt_string("p99"), 99 },
+    };
+
+    obj = nxt_conf_create_object(mp, 3 + nxt_nitems(percentiles));
+    if (nxt_slow_path(obj == NULL)) {
+        return NULL;
+    }
+
+    buckets = nxt_conf_create_array(mp, NXT_STATUS_LATENCY_BUCKETS);
+    if (nxt_slow_path(buckets == NULL)) {
+        return NULL;
+    }
+
+    total = 0;
+
+    for (i = 0; i < NXT_STATUS_LATENCY_BUCKETS; i++) {
+        nxt_conf_set_element_integer(buckets, i, hist->buckets[i]);
+        total += hist->buckets[i];
+    }
+
+    nxt_conf_set_member_integer(obj, &count_str, total, 0);
+    nxt_conf_set_member_integer(obj, &sum_str, hist->sum, 1);
+
+    for (p = 0; p < nxt_nitems(percentiles); p++) {
+        name = (nxt_str_t *) &percentiles[p].name;
+
+        if (total == 0) {
+            nxt_conf_set_member_integer(obj, name, 0, 2 + p);
+            continue;
+        }
+
+        rank = (total * percentiles[p].percent + 99) / 100;
+        count = 0;
+
+        for (i = 0; i < NXT_STATUS_LATENCY_BUCKETS - 1; i++) {
+            count += hist->buckets[i];
+
+            if (count >= rank) {
+                break;
+            }
+        }
+
+        if (i == NXT_STATUS_LATENCY_BUCKETS - 1) {
+            nxt_conf_set_member_null(obj, name, 2 + p);
+            continue;
+        }
+
+        bound = (int64_t) 1 << (NXT_STATUS_LATENCY_SHIFT + i);
+
+        nxt_conf_set_member_integer(obj, name, bound, 2 + p);
+    }
+
+    nxt_conf_set_member(obj, &buckets_str, buckets, 2 + p);
+
+    return obj;
+}
+
+
+void
+nxt_status_shm_init(nxt_status_shm_t *shm, size_t size)
+{
+    nxt_memzero(shm, sizeof(nxt_status_shm_t));
+
+    shm->magic = NXT_STATUS_SHM_MAGIC;
+    shm->version = NXT_STATUS_SHM_VERSION;
+    shm->size = size;
+}
+
+
+void
+nxt_status_shm_lock(nxt_status_shm_t *shm)
+{
+    (void) nxt_atomic_fetch_add(&shm->seq, 1);
+}
+
+
+void
+nxt_status_shm_unlock(nxt_status_shm_t *shm)
+{
+    (void) nxt_atomic_fetch_add(&shm->seq, 1);
+}
+
+
+/*
+ * The report is copied to the memory pool, NULL is returned if there is
+ * no consistent copy after NXT_STATUS_SHM_TRIES attempts or the report
+ * has not been published.
+ */
+
+nxt_status_report_t *
+nxt_status_shm_read(nxt_status_shm_t *shm, nxt_mp_t *mp)
+{
+    size_t               length, size;
+    nxt_uint_t           n;
+    nxt_atomic_uint_t    seq;
+    nxt_status_report_t  *report;
+
+    if (shm->magic != NXT_STATUS_SHM_MAGIC
+        || shm->version != NXT_STATUS_SHM_VERSION)
+    {
+        return NULL;
+    }
+
+    report = NULL;
+    size = 0;
+
+    for (n = 0; n < NXT_STATUS_SHM_TRIES; n++) {
+        seq = shm->seq;
+
+        if (seq & 1) {
+            nxt_cpu_pause();
+            continue;
+        }
+
+        nxt_memory_barrier();
+
+        length = shm->length;
+
+        if (length < sizeof(nxt_status_report_t)
+            || length > shm->size - sizeof(nxt_status_shm_t))
+        {
+            nxt_memory_barrier();
+
+            if (shm->seq == seq) {
+                return NULL;
+            }
+
+            continue;
+        }
+
+        if (length > size) {
+            report = nxt_mp_alloc(mp, length);
+            if (nxt_slow_path(report == NULL)) {
+                return NULL;
+            }
+
+            size = length;
+        }
+
+        nxt_memcpy(report, shm->report, length);
+
+        nxt_memory_barrier();
+
+        if (shm->seq == seq) {
+            return report;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+ * The report is formatted in the Prometheus text exposition format,
+ * latencies are histograms in seconds.
+ */
+
+nxt_buf_t *
+nxt_status_metrics(nxt_status_report_t *report, nxt_mp_t *mp)
+{
+    u_char              *p, *end, *l, *lend;
+    size_t              size;
+    uint32_t            states[3];
+    nxt_str_t           name, labels;
+    nxt_buf_t           *b;
+    nxt_uint_t          i, m, s;
+    nxt_status_app_t    *app;
+    nxt_status_route_t  *route;
+
+    static const char  *state_names[] = { "running", "starting", "idle" };
+
+    route = nxt_pointer_to(report, (uintptr_t) report->routes);
+
+    size = NXT_STATUS_METRICS_HEAD;
+    labels.length = 0;
+
+    for (i = 0; i < report->apps_count; i++) {
+        app = &report->apps[i];
+
+        size += (4 + NXT_STATUS_LATENCY_METRICS
+                     * (NXT_STATUS_LATENCY_BUCKETS + 2))
+                * (NXT_STATUS_METRICS_LINE + 2 * app->name.length);
+
+        labels.length = nxt_max(labels.length, app->name.length);
+    }
+
+    for (i = 0; i < report->routes_count; i++) {
+        size += NXT_STATUS_LATENCY_QUEUE * (NXT_STATUS_LATENCY_BUCKETS + 2)
+                * (NXT_STATUS_METRICS_LINE + 2 * route[i].name.length);
+
+        labels.length = nxt_max(labels.length, route[i].name.length);
+    }
+
+    l = nxt_mp_nget(mp, 2 * labels.length + NXT_STATUS_METRICS_LINE);
+    if (nxt_slow_path(l == NULL)) {
+        return NULL;
+    }
+
+    labels.start = l;
+    lend = l + 2 * labels.length + NXT_STATUS_METRICS_LINE;
+
+    b = nxt_buf_mem_alloc(mp, size, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NULL;
+    }
+
+    p = b->mem.free;
+    end = b->mem.end;
+
+    p = nxt_sprintf(p, end,
+                "# HELP unit_connections_accepted_total Accepted connections.\n"
+                "# TYPE unit_connections_accepted_total counter\n"
+                "unit_connections_accepted_total %uL\n"
+                "# HELP unit_connections_active Active connections.\n"
+                "# TYPE unit_connections_active gauge\n"
+                "unit_connections_active %uL\n"
+                "# HELP unit_connections_idle Idle connections.\n"
+                "# TYPE unit_connections_idle gauge\n"
+                "unit_connections_idle %uL\n"
+                "# HELP unit_connections_closed_total Closed connections.\n"
+                "# TYPE unit_connections_closed_total counter\n"
+                "unit_connections_closed_total %uL\n"
+                "# HELP unit_requests_total Requests.\n"
+                "# TYPE unit_requests_total counter\n"
+                "unit_requests_total %uL\n"
+                "# HELP unit_static_open_file_cache_hits_total "
+                    "Open file cache hits.\n"
+                "# TYPE unit_static_open_file_cache_hits_total counter\n"
+                "unit_static_open_file_cache_hits_total %uL\n"
+                "# HELP unit_static_open_file_cache_misses_total "
+                    "Open file cache misses.\n"
+                "# TYPE unit_static_open_file_cache_misses_total counter\n"
+                "unit_static_open_file_cache_misses_total %uL\n"
+                "# HELP unit_tls_session_cache_hits_total "
+                    "TLS session cache hits.\n"
+                "# TYPE unit_tls_session_cache_hits_total counter\n"
+                "unit_tls_session_cache_hits_total %uL\n"
+                "# HELP unit_tls_session_cache_misses_total "
+                    "TLS session cache misses.\n"
+                "# TYPE unit_tls_session_cache_misses_total counter\n"
+                "unit_tls_session_cache_misses_total %uL\n",
+                report->accepted_conns,
+                report->accepted_conns - report->closed_conns
+                - report->idle_conns,
+                report->idle_conns, report->closed_conns, report->requests,
+                report->static_cache_hits, report->static_cache_misses,
+                report->tls_session_cache_hits,
+                report->tls_session_cache_misses);
+
+    if (report->apps_count != 0) {
+        p = nxt_sprintf(p, end,
+                   "# HELP unit_application_processes Application processes.\n"
+                   "# TYPE unit_application_processes gauge\n");
+
+        for (i = 0; i < report->apps_count; i++) {
+            app = &report->apps[i];
+
+            name.length = app->name.length;
+            name.start = nxt_pointer_to(report, (uintptr_t) app->name.start);
+
+            states[0] = app->processes;
+            states[1] = app->pending_processes;
+            states[2] = app->idle_processes;
+
+            for (s = 0; s < nxt_nitems(states); s++) {
+                p = nxt_sprintf(p, end, "unit_application_processes{");
+                p = nxt_status_metrics_label(p, end, "application", &name);
+                p = nxt_sprintf(p, end, ",state=\"%s\"} %uD\n",
+                                state_names[s], states[s]);
+            }
+        }
+
+        p = nxt_sprintf(p, end,
+                    "# HELP unit_application_requests_active "
+                        "Active application requests.\n"
+                    "# TYPE unit_application_requests_active gauge\n");
+
+        for (i = 0; i < report->apps_count; i++) {
+            app = &report->apps[i];
+
+            name.length = app->name.length;
+            name.start = nxt_pointer_to(report, (uintptr_t) app->name.start);
+
+            p = nxt_sprintf(p, end, "unit_application_requests_active{");
+            p = nxt_status_metrics_label(p, end, "application", &name);
+            p = nxt_sprintf(p, end, "} %uD\n", app->active_requests);
+        }
+
+        p = nxt_sprintf(p, end,
+                    "# HELP unit_application_latency_seconds "
+                        "Application request latency.\n"
+                    "# TYPE unit_application_latency_seconds histogram\n");
+
+        for (i = 0; i < report->apps_count; i++) {
+            app = &report->apps[i];
+
+            name.length = app->name.length;
+            name.start = nxt_pointer_to(report, (uintptr_t) app->name.start);
+
+            for (m = 0; m < NXT_STATUS_LATENCY_METRICS; m++) {
+                l = nxt_status_metrics_label(labels.start, lend,
+                                             "application", &name);
+                l = nxt_status_metrics_label(l, lend, ",metric",
+                                             &nxt_status_latency_names[m]);
+                labels.length = l - labels.start;
+
+                p = nxt_status_metrics_histogram(p, end,
+                                             "unit_application_latency_seconds",
+                                             &labels, &app->latency[m]);
+            }
+        }
+    }
+
+    if (report->routes_count != 0) {
+        p = nxt_sprintf(p, end,
+                    "# HELP unit_route_latency_seconds Route step latency.\n"
+                    "# TYPE unit_route_latency_seconds histogram\n");
+
+        for (i = 0; i < report->routes_count; i++) {
+            name.length = route[i].name.length;
+            name.start = nxt_pointer_to(report,
+                                        (uintptr_t) route[i].name.start);
+
+            for (m = 0; m < NXT_STATUS_LATENCY_QUEUE; m++) {
+                l = nxt_status_metrics_label(labels.start, lend, "route",
+                                             &name);
+                l = nxt_sprintf(l, lend, ",step=\"%uD\"", route[i].step);
+                l = nxt_status_metrics_label(l, lend, ",metric",
+                                             &nxt_status_latency_names[m]);
+                labels.length = l - labels.start;
+
+                p = nxt_status_metrics_histogram(p, end,
+                                                 "unit_route_latency_seconds",
+                                                 &labels, &route[i].latency[m]);
+            }
+        }
+    }
+
+    b->mem.free = p;
+
+    return b;
+}
+
+
+/* A label value is quoted and escaped as the text format requires. */
+
+static u_char *
+nxt_status_metrics_label(u_char *p, u_char *end, const char *label,
+    nxt_str_t *value)
+{
+    u_char  c, *s, *last;
+
+    p = nxt_sprintf(p, end, "%s=\"", label);
+
+    s = value->start;
+    last = s + value->length;
+
+    while (s < last && end - p > 2) {
+        c = *s++;
+
+        switch (c) {
+
+        case '\\':
+        case '"':
+            *p++ = '\\';
+            *p++ = c;
+            break;
+
+        case '\n':
+            *p++ = '\\';
+            *p++ = 'n';
+            break;
+
+        default:
+            *p++ = c;
+            break;
+        }
+    }
+
+    if (p < end) {
+        *p++ = '"';
+    }
+
+    return p;
+}
+
+
+static u_char *
+nxt_status_metrics_histogram(u_char *p, u_char *end, const char *family,
+    nxt_str_t *labels, nxt_status_histogram_t *hist)
+{
+    uint64_t    bound, count;
+    nxt_uint_t  i;
+
+    count = 0;
+
+    for (i = 0; i < NXT_STATUS_LATENCY_BUCKETS - 1; i++) {
+        count += hist->buckets[i];
+        bound = (uint64_t) 1 << (NXT_STATUS_LATENCY_SHIFT + i);
+
+        p = nxt_sprintf(p, end, "%s_bucket{%V,le=\"%uL.%06uL\"} %uL\n",
+                        family, labels, bound / 1000000, bound % 1000000,
+                        count);
+    }
+
+    count += hist->buckets[i];
+
+    return nxt_sprintf(p, end,
+                       "%s_bucket{%V,le=\"+Inf\"} %uL\n"
+                       "%s_sum{%V} %uL.%06uL\n"
+                       "%s_count{%V} %uL\n",
+                       family, labels, count,
+                       family, labels, hist->sum / 1000000,
+                       hist->sum % 1000000,
+                       family, labels, count);
+}
@@ -7,27 +7,154 @@
 #define _NXT_STATUS_H_INCLUDED_
 
 
+/*
+ * Latencies are counted in log-scaled buckets: the first bucket counts
+ * latencies less than 64 microseconds, each next bucket has twice
+ * the upper bound of the previous one, and the last bucket is unbounded.
+ */
+
+#define NXT_STATUS_LATENCY_BUCKETS  20
+#define NXT_STATUS_LATENCY_SHIFT    6
+#define NXT_STATUS_LATENCY_ALIGN    64
+
+
+typedef enum {
+    NXT_STATUS_LATENCY_TTFB = 0,
+    NXT_STATUS_LATENCY_TOTAL,
+    NXT_STATUS_LATENCY_QUEUE,
+    NXT_STATUS_LATENCY_METRICS,
+} nxt_status_latency_metric_t;
+
+
+typedef struct {
+    uint64_t          sum;  /* in microseconds */
+    uint64_t          buckets[NXT_STATUS_LATENCY_BUCKETS];
+} nxt_status_histogram_t;
+
+
+/*
+ * Each router worker engine records latencies to its own cache line
+ * aligned slot of histograms without locks, the slots are merged
+ * on status request.  A latency created to replace a smaller one
+ * keeps the previous one, which may be still updated by engines.
+ */
+
+typedef struct nxt_status_latency_s  nxt_status_latency_t;
+
+struct nxt_status_latency_s {
+    nxt_str_t               name;
+    uint32_t                step;
+    uint32_t                engines;
+    uint32_t                metrics;
+    size_t                  stride;
+    u_char                  *slots;
+    nxt_status_latency_t    *prev;
+};
+
+
 typedef struct {
-    nxt_str_t         name;
-    uint32_t          active_requests;
-    uint32_t          pending_processes;
-    uint32_t          processes;
-    uint32_t          idle_processes;
+    nxt_str_t               name;
+    uint32_t                active_requests;
+    uint32_t                pending_processes;
+    uint32_t                processes;
+    uint32_t                idle_processes;
+    nxt_status_histogram_t  latency[NXT_STATUS_LATENCY_METRICS];
 } nxt_status_app_t;
 
 
+/* Route steps do not count the application queue time. */
+
+typedef struct {
+    nxt_str_t               name;
+    uint32_t                step;
+    nxt_status_histogram_t  latency[NXT_STATUS_LATENCY_QUEUE];
+} nxt_status_route_t;
+
+
 typedef struct {
-    uint64_t          accepted_conns;
-    uint64_t          idle_conns;
-    uint64_t          closed_conns;
-    uint64_t          requests;
+    uint64_t            accepted_conns;
+    uint64_t            idle_conns;
+    uint64_t            closed_conns;
+    uint64_t            requests;
+    uint64_t            static_cache_hits;
+    uint64_t            static_cache_misses;
+    uint64_t            tls_session_cache_hits;
+    uint64_t            tls_session_cache_misses;
+
+    size_t              routes_count;
+    nxt_status_route_t  *routes;
 
-    size_t            apps_count;
-    nxt_status_app_t  apps[];
+    size_t              apps_count;
+    nxt_status_app_t    apps[];
 } nxt_status_report_t;
 
 
+/*
+ * The router periodically publishes the status report to a shared memory
+ * segment.  The report follows the header and has the layout of
+ * nxt_status_report_t of the same version, its pointers are offsets from
+ * the report start.  The "seq" field is odd while the report is being
+ * updated, a reader copies the report and retries if "seq" has changed.
+ * The "length" field is zero if the report does not fit to the segment.
+ */
+
+#define NXT_STATUS_SHM_MAGIC     0x4d54584e  /* "NXTM" */
+#define NXT_STATUS_SHM_VERSION   2
+#define NXT_STATUS_SHM_SIZE      (4 * 1024 * 1024)
+#define NXT_STATUS_SHM_INTERVAL  1000  /* in milliseconds */
+#define NXT_STATUS_SHM_TRIES     100
+
+
+typedef struct {
+    uint32_t            magic;
+    uint32_t            version;
+    uint64_t            size;
+    nxt_atomic_t        seq;
+    uint64_t            updated;  /* in milliseconds since the Epoch */
+    uint64_t            length;
+    uint64_t            report[];
+} nxt_status_shm_t;
+
+
+nxt_status_latency_t *nxt_status_latency_create(nxt_mp_t *mp,
+    nxt_uint_t engines, nxt_uint_t metrics);
+void nxt_status_latency_merge(nxt_status_latency_t *latency,
+    nxt_status_histogram_t *hist);
 nxt_conf_value_t *nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp);
+void nxt_status_shm_init(nxt_status_shm_t *shm, size_t size);
+void nxt_status_shm_lock(nxt_status_shm_t *shm);
+void nxt_status_shm_unlock(nxt_status_shm_t *shm);
+nxt_status_report_t *nxt_status_shm_read(nxt_status_shm_t *shm,
+    nxt_mp_t *mp);
+nxt_buf_t *nxt_status_metrics(nxt_status_report_t *report, nxt_mp_t *mp);
+
+
+nxt_inline void
+nxt_status_latency_add(nxt_status_latency_t *latency, uint32_t engine,
+    nxt_uint_t metric, nxt_nsec_t time)
+{
+    uint64_t                us, n;
+    nxt_uint_t              i;
+    nxt_status_histogram_t  *hist;
+
+    if (nxt_slow_path(engine >= latency->engines)) {
+        return;
+    }
+
+    hist = (nxt_status_histogram_t *) (latency->slots
+                                       + engine * latency->stride);
+    hist += metric;
+
+    us = time / 1000;
+    n = us >> NXT_STATUS_LATENCY_SHIFT;
+
+    for (i = 0; n != 0 && i < NXT_STATUS_LATENCY_BUCKETS - 1; i++) {
+        n >>= 1;
+    }
+
+    hist->sum += us;
+    hist->buckets[i]++;
+}
 
 
 #endif /* _NXT_STATUS_H_INCLUDED_ */
@@ -25,12 +25,37 @@
 
 #define NXT_TLS_BUFFER_SIZE       4096
 
+/*
+ * Dynamic TLS record sizing.  A new connection, or a connection which
+ * has not sent anything for a while, sends small records which fit in
+ * one TCP segment, so a client is able to decrypt and process data as
+ * soon as the first packet arrives instead of waiting for a whole 16K
+ * record.  1369 bytes are 1500-bytes MTU less IPv6 and TCP headers with
+ * timestamps, and less up to 59 bytes of TLS record overhead.  After
+ * a number of records the TCP congestion window has usually grown, and
+ * the record size is not limited anymore, so OpenSSL sends maximum 16K
+ * records with less overhead for bulk transfers.
+ */
+
+#define NXT_TLS_RECORD_SIZE_MIN   1369
+#define NXT_TLS_RECORD_RAMP       40
+#define NXT_TLS_RECORD_IDLE       1000  /* msec */
+
+/* The maximum TLSv1.3 early data size accepted in one connection. */
+
+#define NXT_TLS_EARLY_DATA_MAX    16384
+
+/* The maximum SSLv3/TLS session ID length. */
 
-typedef struct nxt_tls_conf_s         nxt_tls_conf_t;
-typedef struct nxt_tls_bundle_conf_s  nxt_tls_bundle_conf_t;
-typedef struct nxt_tls_init_s         nxt_tls_init_t;
-typedef struct nxt_tls_ticket_s       nxt_tls_ticket_t;
-typedef struct nxt_tls_tickets_s      nxt_tls_tickets_t;
+#define NXT_TLS_SESSION_ID_LEN    32
+
+
+typedef struct nxt_tls_conf_s           nxt_tls_conf_t;
+typedef struct nxt_tls_bundle_conf_s    nxt_tls_bundle_conf_t;
+typedef struct nxt_tls_init_s           nxt_tls_init_t;
+typedef struct nxt_tls_ticket_s         nxt_tls_ticket_t;
+typedef struct nxt_tls_tickets_s        nxt_tls_tickets_t;
+typedef struct nxt_tls_session_cache_s  nxt_tls_session_cache_t;
 
 typedef struct {
     nxt_int_t                     (*library_init)(nxt_task_t *task);
@@ -78,7 +103,10 @@ struct nxt_tls_conf_s {
 
     size_t                        buffer_size;
 
+    nxt_thread_pool_t             *thread_pool;
+
     uint8_t                       no_wait_shutdown;  /* 1 bit */
+    uint8_t                       early_data;        /* 1 bit */
 };
 
 
@@ -87,11 +115,27 @@ struct nxt_tls_init_s {
     nxt_time_t                    timeout;
     nxt_conf_value_t              *conf_cmds;
     nxt_conf_value_t              *tickets_conf;
+    nxt_tls_session_cache_t       *session_cache;
+    nxt_thread_pool_t             *thread_pool;
+    uint8_t                       http2;        /* 1 bit */
+    uint8_t                       ktls;         /* 1 bit */
+    uint8_t                       early_data;   /* 1 bit */
 
     nxt_tls_conf_t                *conf;
 };
 
 
+nxt_tls_session_cache_t *nxt_tls_session_cache_use(nxt_task_t *task,
+    nxt_mp_t *mp, nxt_queue_t *caches, nxt_str_t *name, uint32_t max);
+nxt_int_t nxt_tls_session_cache_add(nxt_tls_session_cache_t *cache, u_char *id,
+    size_t id_length, u_char *data, size_t length, nxt_time_t expires);
+size_t nxt_tls_session_cache_lookup(nxt_tls_session_cache_t *cache, u_char *id,
+    size_t id_length, u_char *buf, size_t size, nxt_time_t now,
+    nxt_bool_t remove);
+void nxt_tls_session_cache_delete(nxt_tls_session_cache_t *cache, u_char *id,
+    size_t id_length);
+
+
 #if (NXT_HAVE_OPENSSL)
 extern const nxt_tls_lib_t        nxt_openssl_lib;
 
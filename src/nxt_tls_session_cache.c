@@ -0,0 +1,388 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+
+
+/*
+ * A TLS session cache keeps serialized sessions of a listener in a shared
+ * memory zone, so the sessions are available to all router engine threads
+ * and outlive TLS contexts which are rebuilt on each reconfiguration.
+ * A new configuration finds the cache by the listener name and the cache
+ * size, a cache which is not used by any configuration anymore is unmapped
+ * when another cache is requested.  Sessions are looked up by the session
+ * ID, expired sessions are removed on lookup, and the least recently used
+ * sessions are evicted once the number of sessions reaches the cache size
+ * or the zone runs out of memory.  A listener which accepts TLSv1.3 early
+ * data looks sessions up for a single use, a session is removed under the
+ * same lock it is found with, so a replayed ClientHello is not able to
+ * resume the session again in any router thread.
+ */
+
+#define NXT_TLS_SESSION_CACHE_ENTRY  1024  /* zone bytes per session */
+#define NXT_TLS_SESSION_CACHE_MIN    (256 * 1024)
+#define NXT_TLS_SESSION_CACHE_MAX    (256 * 1024 * 1024)
+#define NXT_TLS_SESSION_CACHE_PAGE   4096
+#define NXT_TLS_SESSION_CACHE_HASH   65536
+
+
+typedef struct nxt_tls_session_s  nxt_tls_session_t;
+
+struct nxt_tls_session_s {
+    nxt_queue_link_t         link;
+    nxt_tls_session_t        *next;
+    nxt_time_t               expires;
+    uint32_t                 hash;
+    uint32_t                 length;
+    uint8_t                  id_length;
+    u_char                   id[NXT_TLS_SESSION_ID_LEN];
+    u_char                   data[];
+};
+
+
+struct nxt_tls_session_cache_s {
+    nxt_queue_link_t         link;
+    nxt_str_t                name;
+    nxt_atomic_t             count;
+    size_t                   size;
+
+    nxt_thread_spinlock_t    lock;
+    nxt_mem_zone_t           *zone;
+    nxt_queue_t              lru;
+    nxt_tls_session_t        **buckets;
+    uint32_t                 mask;
+    uint32_t                 sessions;
+    uint32_t                 max;
+    size_t                   used;
+    size_t                   limit;
+};
+
+
+static nxt_tls_session_cache_t *nxt_tls_session_cache_create(nxt_str_t *name,
+    uint32_t max);
+static void nxt_tls_session_cache_release(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_tls_session_t **nxt_tls_session_cache_find(
+    nxt_tls_session_cache_t *cache, uint32_t hash, u_char *id,
+    size_t id_length);
+static void nxt_tls_session_cache_remove(nxt_tls_session_cache_t *cache,
+    nxt_tls_session_t **prev);
+static nxt_bool_t nxt_tls_session_cache_evict(nxt_tls_session_cache_t *cache);
+
+
+nxt_tls_session_cache_t *
+nxt_tls_session_cache_use(nxt_task_t *task, nxt_mp_t *mp, nxt_queue_t *caches,
+    nxt_str_t *name, uint32_t max)
+{
+    nxt_int_t                ret;
+    nxt_tls_session_cache_t  *cache, *found;
+
+    found = NULL;
+
+    nxt_queue_each(cache, caches, nxt_tls_session_cache_t, link) {
+
+        if (cache->max == max && nxt_strstr_eq(&cache->name, name)) {
+            found = cache;
+            continue;
+        }
+
+        if (cache->count == 0) {
+            nxt_debug(task, "tls session cache \"%V\" destroy", &cache->name);
+
+            nxt_queue_remove(&cache->link);
+            nxt_mem_munmap(cache, cache->size);
+        }
+
+    } nxt_queue_loop;
+
+    if (found == NULL) {
+        found = nxt_tls_session_cache_create(name, max);
+        if (nxt_slow_path(found == NULL)) {
+            return NULL;
+        }
+
+        nxt_queue_insert_tail(caches, &found->link);
+    }
+
+    ret = nxt_mp_cleanup(mp, nxt_tls_session_cache_release, task, found, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    (void) nxt_atomic_fetch_add(&found->count, 1);
+
+    return found;
+}
+
+
+static nxt_tls_session_cache_t *
+nxt_tls_session_cache_create(nxt_str_t *name, uint32_t max)
+{
+    u_char                   *p;
+    size_t                   size, zone_size;
+    uint32_t                 n;
+    nxt_tls_session_cache_t  *cache;
+
+    zone_size = (size_t) max * NXT_TLS_SESSION_CACHE_ENTRY;
+    zone_size = nxt_max(zone_size, NXT_TLS_SESSION_CACHE_MIN);
+    zone_size = nxt_min(zone_size, NXT_TLS_SESSION_CACHE_MAX);
+
+    for (n = 1; n < max && n < NXT_TLS_SESSION_CACHE_HASH; n <<= 1) {
+        /* void */
+    }
+
+    size = sizeof(nxt_tls_session_cache_t) + n * sizeof(nxt_tls_session_t *)
+           + name->length;
+    size = nxt_align_size(size, NXT_TLS_SESSION_CACHE_PAGE);
+
+    p = nxt_mem_mmap(NULL, size + zone_size, PROT_READ | PROT_WRITE,
+                     NXT_MEM_MAP_SHARED, -1, 0);
+    if (nxt_slow_path(p == MAP_FAILED)) {
+        return NULL;
+    }
+
+    /* The anonymous mapping is zero-filled. */
+
+    cache = (nxt_tls_session_cache_t *) p;
+
+    cache->size = size + zone_size;
+
+    cache->zone = nxt_mem_zone_init(p + size, zone_size,
+                                    NXT_TLS_SESSION_CACHE_PAGE);
+    if (nxt_slow_path(cache->zone == NULL)) {
+        nxt_mem_munmap(p, cache->size);
+        return NULL;
+    }
+
+    cache->buckets = (nxt_tls_session_t **) (cache + 1);
+    cache->mask = n - 1;
+
+    cache->name.length = name->length;
+    cache->name.start = (u_char *) &cache->buckets[n];
+    nxt_memcpy(cache->name.start, name->start, name->length);
+
+    nxt_queue_init(&cache->lru);
+
+    cache->max = max;
+
+    /* Zone chunks are rounded up, so only half of the zone is counted. */
+    cache->limit = zone_size / 2;
+
+    return cache;
+}
+
+
+static void
+nxt_tls_session_cache_release(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_tls_session_cache_t  *cache;
+
+    cache = obj;
+
+    (void) nxt_atomic_fetch_add(&cache->count, -1);
+}
+
+
+nxt_int_t
+nxt_tls_session_cache_add(nxt_tls_session_cache_t *cache, u_char *id,
+    size_t id_length, u_char *data, size_t length, nxt_time_t expires)
+{
+    size_t             size;
+    uint32_t           hash;
+    nxt_tls_session_t  *sess, **prev;
+
+    size = sizeof(nxt_tls_session_t) + length;
+
+    if (id_length == 0
+        || id_length > NXT_TLS_SESSION_ID_LEN
+        || size > cache->limit)
+    {
+        return NXT_DECLINED;
+    }
+
+    hash = nxt_murmur_hash2(id, id_length);
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    prev = nxt_tls_session_cache_find(cache, hash, id, id_length);
+
+    if (*prev != NULL) {
+        nxt_tls_session_cache_remove(cache, prev);
+    }
+
+    while (cache->sessions >= cache->max || cache->used + size > cache->limit)
+    {
+        (void) nxt_tls_session_cache_evict(cache);
+    }
+
+    for ( ;; ) {
+        sess = nxt_mem_zone_alloc(cache->zone, size);
+
+        if (nxt_fast_path(sess != NULL)) {
+            break;
+        }
+
+        if (!nxt_tls_session_cache_evict(cache)) {
+            nxt_thread_spin_unlock(&cache->lock);
+            return NXT_ERROR;
+        }
+    }
+
+    sess->expires = expires;
+    sess->hash = hash;
+    sess->length = length;
+    sess->id_length = id_length;
+    nxt_memcpy(sess->id, id, id_length);
+    nxt_memcpy(sess->data, data, length);
+
+    prev = &cache->buckets[hash & cache->mask];
+    sess->next = *prev;
+    *prev = sess;
+
+    nxt_queue_insert_head(&cache->lru, &sess->link);
+
+    cache->sessions++;
+    cache->used += size;
+
+    nxt_thread_spin_unlock(&cache->lock);
+
+    return NXT_OK;
+}
+
+
+size_t
+nxt_tls_session_cache_lookup(nxt_tls_session_cache_t *cache, u_char *id,
+    size_t id_length, u_char *buf, size_t size, nxt_time_t now,
+    nxt_bool_t remove)
+{
+    size_t             length;
+    uint32_t           hash;
+    nxt_tls_session_t  *sess, **prev;
+
+    if (id_length == 0 || id_length > NXT_TLS_SESSION_ID_LEN) {
+        return 0;
+    }
+
+    hash = nxt_murmur_hash2(id, id_length);
+
+    length = 0;
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    prev = nxt_tls_session_cache_find(cache, hash, id, id_length);
+    sess = *prev;
+
+    if (sess != NULL) {
+
+        if (sess->expires <= now) {
+            nxt_tls_session_cache_remove(cache, prev);
+
+        } else if (sess->length <= size) {
+            length = sess->length;
+            nxt_memcpy(buf, sess->data, length);
+
+            if (remove) {
+                nxt_tls_session_cache_remove(cache, prev);
+
+            } else {
+                nxt_queue_remove(&sess->link);
+                nxt_queue_insert_head(&cache->lru, &sess->link);
+            }
+        }
+    }
+
+    nxt_thread_spin_unlock(&cache->lock);
+
+    return length;
+}
+
+
+void
+nxt_tls_session_cache_delete(nxt_tls_session_cache_t *cache, u_char *id,
+    size_t id_length)
+{
+    uint32_t           hash;
+    nxt_tls_session_t  **prev;
+
+    if (id_length == 0 || id_length > NXT_TLS_SESSION_ID_LEN) {
+        return;
+    }
+
+    hash = nxt_murmur_hash2(id, id_length);
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    prev = nxt_tls_session_cache_find(cache, hash, id, id_length);
+
+    if (*prev != NULL) {
+        nxt_tls_session_cache_remove(cache, prev);
+    }
+
+    nxt_thread_spin_unlock(&cache->lock);
+}
+
+
+static nxt_tls_session_t **
+nxt_tls_session_cache_find(nxt_tls_session_cache_t *cache, uint32_t hash,
+    u_char *id, size_t id_length)
+{
+    nxt_tls_session_t  *sess, **prev;
+
+    prev = &cache->buckets[hash & cache->mask];
+
+    for (sess = *prev; sess != NULL; sess = sess->next) {
+
+        if (sess->hash == hash
+            && sess->id_length == id_length
+            && memcmp(sess->id, id, id_length) == 0)
+        {
+            break;
+        }
+
+        prev = &sess->next;
+    }
+
+    return prev;
+}
+
+
+static void
+nxt_tls_session_cache_remove(nxt_tls_session_cache_t *cache,
+    nxt_tls_session_t **prev)
+{
+    nxt_tls_session_t  *sess;
+
+    sess = *prev;
+    *prev = sess->next;
+
+    nxt_queue_remove(&sess->link);
+
+    cache->sessions--;
+    cache->used -= sizeof(nxt_tls_session_t) + sess->length;
+
+    nxt_mem_zone_free(cache->zone, sess);
+}
+
+
+static nxt_bool_t
+nxt_tls_session_cache_evict(nxt_tls_session_cache_t *cache)
+{
+    nxt_queue_link_t   *link;
+    nxt_tls_session_t  *sess, **prev;
+
+    if (nxt_queue_is_empty(&cache->lru)) {
+        return 0;
+    }
+
+    link = nxt_queue_last(&cache->lru);
+    sess = nxt_queue_link_data(link, nxt_tls_session_t, link);
+
+    prev = nxt_tls_session_cache_find(cache, sess->hash, sess->id,
+                                      sess->id_length);
+
+    nxt_tls_session_cache_remove(cache, prev);
+
+    return 1;
+}
@@ -63,6 +63,12 @@ nxt_upstreams_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         if (nxt_slow_path(ret != NXT_OK)) {
             return NXT_ERROR;
         }
+
+        ret = nxt_upstream_keepalive_create(task, tmcf, upcf,
+                                            &upstreams->upstream[i]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
     }
 
     tmcf->router_conf->upstreams = upstreams;
@@ -12,6 +12,7 @@ typedef struct nxt_upstream_proxy_s            nxt_upstream_proxy_t;
 typedef struct nxt_upstream_round_robin_s      nxt_upstream_round_robin_t;
 typedef struct nxt_upstream_round_robin_server_s
     nxt_upstream_round_robin_server_t;
+typedef struct nxt_upstream_keepalive_s        nxt_upstream_keepalive_t;
 
 
 typedef void (*nxt_upstream_peer_ready_t)(nxt_task_t *task,
@@ -38,6 +39,12 @@ typedef struct {
 } nxt_upstream_server_proto_t;
 
 
+typedef struct {
+    uint32_t                                   max_idle;
+    nxt_msec_t                                 idle_timeout;
+} nxt_upstream_keepalive_conf_t;
+
+
 struct nxt_upstream_s {
     const nxt_upstream_server_proto_t          *proto;
 
@@ -47,6 +54,8 @@ struct nxt_upstream_s {
     } type;
 
     nxt_str_t                                  name;
+
+    nxt_upstream_keepalive_conf_t              *keepalive;
 };
 
 
@@ -77,5 +86,15 @@ nxt_int_t nxt_upstream_round_robin_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *upstream_conf,
     nxt_upstream_t *upstream);
 
+nxt_int_t nxt_upstream_keepalive_create(nxt_task_t *task,
+    nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *upstream_conf,
+    nxt_upstream_t *upstream);
+nxt_conn_t *nxt_upstream_keepalive_get(nxt_task_t *task,
+    nxt_upstream_server_t *us);
+nxt_int_t nxt_upstream_keepalive_put(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_conn_t *c);
+void nxt_upstream_keepalive_close(nxt_task_t *task,
+    nxt_event_engine_t *engine);
+
 
 #endif /* _NXT_UPSTREAM_H_INCLUDED_ */
@@ -0,0 +1,495 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_upstream.h>
+
+
+/*
+ * Idle upstream connections are kept per engine and grouped by
+ * the server address, so any upstream that resolves to the same
+ * server can reuse them.  The most recently used connection is
+ * taken first, a connection is closed instead of being kept if
+ * there are already "max_idle" idle connections to the server.
+ */
+
+struct nxt_upstream_keepalive_s {
+    nxt_queue_t                idle;      /* of nxt_conn_t.link */
+    nxt_sockaddr_t             *sockaddr;
+    uint32_t                   count;
+    nxt_msec_t                 timeout;
+};
+
+
+static nxt_upstream_keepalive_t *nxt_upstream_keepalive_find(
+    nxt_event_engine_t *engine, nxt_sockaddr_t *sa, nxt_bool_t create);
+static nxt_int_t nxt_upstream_keepalive_hash_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+static void *nxt_upstream_keepalive_hash_alloc(void *data, size_t size);
+static void nxt_upstream_keepalive_hash_free(void *data, void *p);
+static ssize_t nxt_upstream_keepalive_io_read_handler(nxt_task_t *task,
+    nxt_conn_t *c);
+static void nxt_upstream_keepalive_idle_close(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_keepalive_idle_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_msec_t nxt_upstream_keepalive_timer_value(nxt_conn_t *c,
+    uintptr_t data);
+static void nxt_upstream_keepalive_conn_close(nxt_task_t *task,
+    nxt_upstream_keepalive_t *ka, nxt_conn_t *c);
+static ssize_t nxt_upstream_keepalive_reserved_io_read(nxt_task_t *task,
+    nxt_conn_t *c);
+static void nxt_upstream_keepalive_reserved(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_keepalive_conn_free(nxt_task_t *task, void *obj,
+    void *data);
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_idle_state;
+static const nxt_conn_state_t  nxt_upstream_keepalive_reserved_state;
+static const nxt_conn_state_t  nxt_upstream_keepalive_close_state;
+
+
+static nxt_conf_map_t  nxt_upstream_keepalive_conf[] = {
+    {
+        nxt_string("max_idle"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_upstream_keepalive_conf_t, max_idle),
+    },
+
+    {
+        nxt_string("idle_timeout"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_upstream_keepalive_conf_t, idle_timeout),
+    },
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_upstream_keepalive_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_upstream_keepalive_hash_test,
+    nxt_upstream_keepalive_hash_alloc,
+    nxt_upstream_keepalive_hash_free,
+};
+
+
+nxt_int_t
+nxt_upstream_keepalive_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream)
+{
+    nxt_mp_t                       *mp;
+    nxt_int_t                      ret;
+    nxt_conf_value_t               *conf;
+    nxt_upstream_keepalive_conf_t  *kcf;
+
+    static nxt_str_t  keepalive = nxt_string("keepalive");
+
+    conf = nxt_conf_get_object_member(upstream_conf, &keepalive, NULL);
+
+    if (conf == NULL) {
+        return NXT_OK;
+    }
+
+    mp = tmcf->router_conf->mem_pool;
+
+    kcf = nxt_mp_alloc(mp, sizeof(nxt_upstream_keepalive_conf_t));
+    if (nxt_slow_path(kcf == NULL)) {
+        return NXT_ERROR;
+    }
+
+    kcf->max_idle = 16;
+    kcf->idle_timeout = 60 * 1000;
+
+    ret = nxt_conf_map_object(mp, conf, nxt_upstream_keepalive_conf,
+                              nxt_nitems(nxt_upstream_keepalive_conf), kcf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (kcf->max_idle != 0) {
+        upstream->keepalive = kcf;
+    }
+
+    return NXT_OK;
+}
+
+
+nxt_conn_t *
+nxt_upstream_keepalive_get(nxt_task_t *task, nxt_upstream_server_t *us)
+{
+    nxt_conn_t                *c;
+    nxt_queue_link_t          *lnk;
+    nxt_event_engine_t        *engine;
+    nxt_upstream_keepalive_t  *ka;
+
+    engine = task->thread->engine;
+
+    ka = nxt_upstream_keepalive_find(engine, us->sockaddr, 0);
+
+    if (ka == NULL) {
+        return NULL;
+    }
+
+    for (lnk = nxt_queue_first(&ka->idle);
+         lnk != nxt_queue_tail(&ka->idle);
+         lnk = nxt_queue_next(lnk))
+    {
+        c = nxt_queue_link_data(lnk, nxt_conn_t, link);
+
+        /*
+         * A connection which has been closed by the server or has
+         * unexpected data is left to its already queued idle handler.
+         */
+        if (c->socket.closed || c->socket.error || c->socket.read_ready) {
+            continue;
+        }
+
+        nxt_queue_remove(lnk);
+        ka->count--;
+
+        nxt_timer_disable(engine, &c->read_timer);
+        nxt_fd_event_block_read(engine, &c->socket);
+
+        /*
+         * A read operation can be already queued, the reserved state
+         * ignores it until the connection owner sets its own state.
+         */
+        c->read_state = &nxt_upstream_keepalive_reserved_state;
+        c->socket.data = NULL;
+
+        nxt_debug(task, "upstream keepalive get fd:%d, idle: %uD",
+                  c->socket.fd, ka->count);
+
+        return c;
+    }
+
+    return NULL;
+}
+
+
+nxt_int_t
+nxt_upstream_keepalive_put(nxt_task_t *task, nxt_upstream_server_t *us,
+    nxt_conn_t *c)
+{
+    nxt_event_engine_t             *engine;
+    nxt_upstream_keepalive_t       *ka;
+    nxt_upstream_keepalive_conf_t  *kcf;
+
+    kcf = us->upstream->keepalive;
+
+    if (kcf == NULL || c->socket.fd == -1
+        || c->socket.closed || c->socket.error || c->read != NULL)
+    {
+        return NXT_DECLINED;
+    }
+
+    engine = task->thread->engine;
+
+    if (engine->shutdown) {
+        return NXT_DECLINED;
+    }
+
+    ka = nxt_upstream_keepalive_find(engine, us->sockaddr, 1);
+
+    if (nxt_slow_path(ka == NULL)) {
+        return NXT_DECLINED;
+    }
+
+    if (ka->count >= kcf->max_idle) {
+        return NXT_DECLINED;
+    }
+
+    nxt_timer_disable(engine, &c->read_timer);
+    nxt_timer_disable(engine, &c->write_timer);
+
+    /*
+     * The server sockaddr belongs to the router configuration
+     * which can be destroyed while the connection is idle.
+     */
+    c->remote = ka->sockaddr;
+    c->socket.data = ka;
+    c->write = NULL;
+
+    task = &c->task;
+    c->socket.task = task;
+    c->read_timer.task = task;
+    c->write_timer.task = task;
+
+    c->read_work_queue = &engine->read_work_queue;
+    c->write_work_queue = &engine->write_work_queue;
+    c->read_timer.work_queue = &engine->read_work_queue;
+    c->write_timer.work_queue = &engine->write_work_queue;
+
+    nxt_queue_insert_head(&ka->idle, &c->link);
+    ka->count++;
+    ka->timeout = kcf->idle_timeout;
+
+    nxt_debug(task, "upstream keepalive put fd:%d, idle: %uD",
+              c->socket.fd, ka->count);
+
+    c->read_state = &nxt_upstream_keepalive_idle_state;
+
+    /*
+     * The read is called directly instead of nxt_conn_read()
+     * to not leave a queued operation on a reusable connection.
+     */
+    c->io->read(task, c, ka);
+
+    return NXT_OK;
+}
+
+
+void
+nxt_upstream_keepalive_close(nxt_task_t *task, nxt_event_engine_t *engine)
+{
+    nxt_conn_t                *c;
+    nxt_queue_link_t          *lnk;
+    nxt_lvlhsh_each_t         lhe;
+    nxt_upstream_keepalive_t  *ka;
+
+    nxt_lvlhsh_each_init(&lhe, &nxt_upstream_keepalive_hash_proto);
+
+    for ( ;; ) {
+        ka = nxt_lvlhsh_each(&engine->upstream_keepalive, &lhe);
+
+        if (ka == NULL) {
+            break;
+        }
+
+        while (!nxt_queue_is_empty(&ka->idle)) {
+            lnk = nxt_queue_first(&ka->idle);
+            nxt_queue_remove(lnk);
+
+            c = nxt_queue_link_data(lnk, nxt_conn_t, link);
+
+            nxt_debug(task, "upstream keepalive close fd:%d", c->socket.fd);
+
+            nxt_timer_delete(engine, &c->read_timer);
+            nxt_timer_delete(engine, &c->write_timer);
+
+            (void) nxt_fd_event_close(engine, &c->socket);
+
+            nxt_socket_close(task, c->socket.fd);
+            c->socket.fd = -1;
+
+            nxt_conn_free(task, c);
+        }
+
+        ka->count = 0;
+    }
+}
+
+
+static nxt_upstream_keepalive_t *
+nxt_upstream_keepalive_find(nxt_event_engine_t *engine, nxt_sockaddr_t *sa,
+    nxt_bool_t create)
+{
+    nxt_int_t                 ret;
+    nxt_lvlhsh_query_t        lhq;
+    nxt_upstream_keepalive_t  *ka;
+
+    lhq.key.length = sa->length;
+    lhq.key.start = nxt_sockaddr_start(sa);
+    lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
+    lhq.proto = &nxt_upstream_keepalive_hash_proto;
+
+    if (nxt_lvlhsh_find(&engine->upstream_keepalive, &lhq) == NXT_OK) {
+        return lhq.value;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    ka = nxt_mp_zalloc(engine->mem_pool, sizeof(nxt_upstream_keepalive_t));
+    if (nxt_slow_path(ka == NULL)) {
+        return NULL;
+    }
+
+    ka->sockaddr = nxt_mp_alloc(engine->mem_pool, nxt_sockaddr_size(sa));
+    if (nxt_slow_path(ka->sockaddr == NULL)) {
+        return NULL;
+    }
+
+    nxt_memcpy(ka->sockaddr, sa, nxt_sockaddr_size(sa));
+
+    nxt_queue_init(&ka->idle);
+
+    lhq.key.start = nxt_sockaddr_start(ka->sockaddr);
+    lhq.replace = 0;
+    lhq.value = ka;
+    lhq.pool = engine->mem_pool;
+
+    ret = nxt_lvlhsh_insert(&engine->upstream_keepalive, &lhq);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    return ka;
+}
+
+
+static nxt_int_t
+nxt_upstream_keepalive_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_str_t                 name;
+    nxt_upstream_keepalive_t  *ka;
+
+    ka = data;
+
+    name.length = ka->sockaddr->length;
+    name.start = nxt_sockaddr_start(ka->sockaddr);
+
+    return nxt_strstr_eq(&lhq->key, &name) ? NXT_OK : NXT_DECLINED;
+}
+
+
+static void *
+nxt_upstream_keepalive_hash_alloc(void *data, size_t size)
+{
+    return nxt_mp_align(data, size, size);
+}
+
+
+static void
+nxt_upstream_keepalive_hash_free(void *data, void *p)
+{
+    nxt_mp_free(data, p);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_idle_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_keepalive_idle_close,
+    .close_handler = nxt_upstream_keepalive_idle_close,
+    .error_handler = nxt_upstream_keepalive_idle_close,
+
+    .io_read_handler = nxt_upstream_keepalive_io_read_handler,
+
+    .timer_handler = nxt_upstream_keepalive_idle_timeout,
+    .timer_value = nxt_upstream_keepalive_timer_value,
+};
+
+
+static ssize_t
+nxt_upstream_keepalive_io_read_handler(nxt_task_t *task, nxt_conn_t *c)
+{
+    u_char  buf[1];
+
+    /*
+     * An idle server connection should not have any data,
+     * so the data are not read and the connection is closed.
+     */
+    return c->io->recv(c, buf, 1, MSG_PEEK);
+}
+
+
+static void
+nxt_upstream_keepalive_idle_close(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "upstream keepalive idle close fd:%d", c->socket.fd);
+
+    if (c->read_state != &nxt_upstream_keepalive_idle_state) {
+        return;
+    }
+
+    nxt_upstream_keepalive_conn_close(task, data, c);
+}
+
+
+static void
+nxt_upstream_keepalive_idle_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    c = nxt_read_timer_conn(timer);
+
+    nxt_debug(task, "upstream keepalive idle timeout fd:%d", c->socket.fd);
+
+    c->block_read = 1;
+
+    nxt_upstream_keepalive_conn_close(task, c->socket.data, c);
+}
+
+
+static nxt_msec_t
+nxt_upstream_keepalive_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_upstream_keepalive_t  *ka;
+
+    ka = c->socket.data;
+
+    return ka->timeout;
+}
+
+
+static void
+nxt_upstream_keepalive_conn_close(nxt_task_t *task,
+    nxt_upstream_keepalive_t *ka, nxt_conn_t *c)
+{
+    nxt_queue_remove(&c->link);
+    ka->count--;
+
+    c->read_state = &nxt_upstream_keepalive_reserved_state;
+    c->write_state = &nxt_upstream_keepalive_close_state;
+
+    nxt_conn_close(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_reserved_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_keepalive_reserved,
+    .close_handler = nxt_upstream_keepalive_reserved,
+    .error_handler = nxt_upstream_keepalive_reserved,
+
+    .io_read_handler = nxt_upstream_keepalive_reserved_io_read,
+};
+
+
+static ssize_t
+nxt_upstream_keepalive_reserved_io_read(nxt_task_t *task, nxt_conn_t *c)
+{
+    return NXT_AGAIN;
+}
+
+
+static void
+nxt_upstream_keepalive_reserved(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_debug(task, "upstream keepalive reserved");
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_close_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_keepalive_conn_free,
+};
+
+
+static void
+nxt_upstream_keepalive_conn_free(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "upstream keepalive conn free");
+
+    nxt_conn_free(task, c);
+}
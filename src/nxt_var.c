@@ -50,14 +50,10 @@ struct nxt_var_query_s {
 static nxt_int_t nxt_var_hash_test(nxt_lvlhsh_query_t *lhq, void *data);
 static nxt_var_decl_t *nxt_var_hash_find(nxt_str_t *name);
 
-static nxt_var_ref_t *nxt_var_ref_get(nxt_tstr_state_t *state, nxt_str_t *name);
-
 static nxt_int_t nxt_var_cache_test(nxt_lvlhsh_query_t *lhq, void *data);
 static nxt_str_t *nxt_var_cache_value(nxt_task_t *task, nxt_tstr_state_t *state,
     nxt_var_cache_t *cache, uint32_t index, void *ctx);
 
-static u_char *nxt_var_next_part(u_char *start, u_char *end, nxt_str_t *part);
-
 
 static const nxt_lvlhsh_proto_t  nxt_var_hash_proto  nxt_aligned(64) = {
     NXT_LVLHSH_DEFAULT,
@@ -108,7 +104,7 @@ nxt_var_hash_find(nxt_str_t *name)
 }
 
 
-static nxt_var_ref_t *
+nxt_var_ref_t *
 nxt_var_ref_get(nxt_tstr_state_t *state, nxt_str_t *name)
 {
     nxt_int_t       ret;
@@ -414,7 +410,7 @@ nxt_var_test(nxt_tstr_state_t *state, nxt_str_t *str, u_char *error)
 }
 
 
-static u_char *
+u_char *
 nxt_var_next_part(u_char *start, u_char *end, nxt_str_t *part)
 {
     size_t      length;
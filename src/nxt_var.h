@@ -53,6 +53,9 @@ nxt_var_field_t *nxt_var_field_get(nxt_array_t *fields, uint16_t index);
 nxt_var_field_t *nxt_var_field_new(nxt_mp_t *mp, nxt_str_t *name,
     uint32_t hash);
 
+nxt_var_ref_t *nxt_var_ref_get(nxt_tstr_state_t *state, nxt_str_t *name);
+u_char *nxt_var_next_part(u_char *start, u_char *end, nxt_str_t *part);
+
 nxt_var_t *nxt_var_compile(nxt_tstr_state_t *state, nxt_str_t *str);
 nxt_int_t nxt_var_test(nxt_tstr_state_t *state, nxt_str_t *str, u_char *error);
 
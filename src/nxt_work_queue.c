@@ -229,6 +229,13 @@ nxt_work_queue_pop(nxt_work_queue_t *wq, nxt_task_t **task, void **obj,
 void
 nxt_locked_work_queue_add(nxt_locked_work_queue_t *lwq, nxt_work_t *work)
 {
+    /*
+     * A work may be queued again right after it has been popped from
+     * another locked queue, e.g. a job work posted from a thread pool
+     * back to an engine, so its next link may be stale.
+     */
+    work->next = NULL;
+
     nxt_thread_spin_lock(&lwq->lock);
 
     if (lwq->tail != NULL) {
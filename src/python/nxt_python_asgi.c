@@ -689,8 +689,9 @@ nxt_py_asgi_create_http_scope(nxt_unit_request_info_t *req,
     }
 
     p = nxt_unit_sptr_get(&r->version);
-    SET_ITEM(scope, http_version, p[7] == '1' ? nxt_py_1_1_str
-                                              : nxt_py_1_0_str)
+    SET_ITEM(scope, http_version, p[5] == '2' ? nxt_py_2_str
+                                  : p[7] == '1' ? nxt_py_1_1_str
+                                                : nxt_py_1_0_str)
     SET_ITEM(scope, scheme, scheme)
 
     v = PyString_FromStringAndSize(nxt_unit_sptr_get(&r->method),
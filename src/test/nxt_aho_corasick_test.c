@@ -0,0 +1,116 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include "nxt_tests.h"
+
+
+typedef struct {
+    const char  *keyword;
+    nxt_uint_t  anchor;
+} nxt_aho_corasick_test_keyword_t;
+
+
+typedef struct {
+    const char  *string;
+    nxt_bool_t  caseless;
+    nxt_bool_t  match;
+} nxt_aho_corasick_test_t;
+
+
+nxt_int_t
+nxt_aho_corasick_test(nxt_thread_t *thr)
+{
+    nxt_mp_t            *mp;
+    nxt_int_t           ret;
+    nxt_uint_t          i, caseless;
+    nxt_bool_t          match;
+    nxt_aho_corasick_t  *ac[2];
+
+    static const nxt_aho_corasick_test_keyword_t  keywords[] = {
+        { "he",        0 },
+        { "she",       NXT_AHO_CORASICK_END },
+        { "hers",      NXT_AHO_CORASICK_BEGIN },
+        { "/api/",     NXT_AHO_CORASICK_BEGIN },
+        { ".php",      NXT_AHO_CORASICK_END },
+        { "/index",    NXT_AHO_CORASICK_BEGIN | NXT_AHO_CORASICK_END },
+        { "Admin",     0 },
+    };
+
+    static const nxt_aho_corasick_test_t  tests[] = {
+        { "",              0, 0 },
+        { "xhex",          0, 1 },
+        { "ushers",        0, 1 },
+        { "xshe",          0, 1 },
+        { "xsHe",          0, 0 },
+        { "xsHe",          1, 1 },
+        { "hers",          0, 1 },
+        { "/api/v1",       0, 1 },
+        { "/v1/api/",      0, 0 },
+        { "/a.php",        0, 1 },
+        { "/a.php/",       0, 0 },
+        { "/a.PHP",        0, 0 },
+        { "/a.PHP",        1, 1 },
+        { "/index",        0, 1 },
+        { "/index/",       0, 0 },
+        { "/x/index",      0, 0 },
+        { "/admin",        0, 0 },
+        { "/admin",        1, 1 },
+        { "/xAdminx",      0, 1 },
+        { "/abc",          0, 0 },
+        { "\xff\xfe",      0, 0 },
+    };
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    for (caseless = 0; caseless < 2; caseless++) {
+        ac[caseless] = nxt_aho_corasick_create(mp, caseless);
+        if (ac[caseless] == NULL) {
+            goto fail;
+        }
+
+        for (i = 0; i < nxt_nitems(keywords); i++) {
+            ret = nxt_aho_corasick_add(ac[caseless],
+                                       (u_char *) keywords[i].keyword,
+                                       nxt_strlen(keywords[i].keyword),
+                                       keywords[i].anchor);
+            if (ret != NXT_OK) {
+                goto fail;
+            }
+        }
+
+        if (nxt_aho_corasick_compile(ac[caseless]) != NXT_OK) {
+            goto fail;
+        }
+    }
+
+    for (i = 0; i < nxt_nitems(tests); i++) {
+        match = nxt_aho_corasick_match(ac[tests[i].caseless],
+                                       (u_char *) tests[i].string,
+                                       nxt_strlen(tests[i].string));
+
+        if (match != tests[i].match) {
+            nxt_log_alert(thr->log,
+                          "nxt_aho_corasick_match(\"%s\", %d) test failed: %d",
+                          tests[i].string, tests[i].caseless, match);
+            goto fail;
+        }
+    }
+
+    nxt_mp_destroy(mp);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "nxt_aho_corasick test passed");
+
+    return NXT_OK;
+
+fail:
+
+    nxt_mp_destroy(mp);
+
+    return NXT_ERROR;
+}
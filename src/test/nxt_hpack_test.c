@@ -0,0 +1,222 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_hpack.h>
+#include "nxt_tests.h"
+
+
+typedef struct {
+    nxt_str_t  block;
+    nxt_str_t  fields;
+    size_t     size;
+} nxt_hpack_test_t;
+
+
+/* Requests from RFC 7541, Appendix C.3 and C.4. */
+
+static const nxt_hpack_test_t  nxt_hpack_tests[] = {
+    { nxt_string("\x82\x86\x84\x41\x0f\x77\x77\x77\x2e\x65\x78\x61\x6d\x70"
+                 "\x6c\x65\x2e\x63\x6f\x6d"),
+      nxt_string(":method: GET\n:scheme: http\n:path: /\n"
+                 ":authority: www.example.com\n"),
+      57 },
+
+    { nxt_string("\x82\x86\x84\xbe\x58\x08\x6e\x6f\x2d\x63\x61\x63\x68\x65"),
+      nxt_string(":method: GET\n:scheme: http\n:path: /\n"
+                 ":authority: www.example.com\ncache-control: no-cache\n"),
+      110 },
+
+    { nxt_string("\x82\x87\x85\xbf\x40\x0a\x63\x75\x73\x74\x6f\x6d\x2d\x6b"
+                 "\x65\x79\x0c\x63\x75\x73\x74\x6f\x6d\x2d\x76\x61\x6c\x75"
+                 "\x65"),
+      nxt_string(":method: GET\n:scheme: https\n:path: /index.html\n"
+                 ":authority: www.example.com\ncustom-key: custom-value\n"),
+      164 },
+
+    { nxt_string("\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab"
+                 "\x90\xf4\xff"),
+      nxt_string(":method: GET\n:scheme: http\n:path: /\n"
+                 ":authority: www.example.com\n"),
+      57 },
+
+    { nxt_string("\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf"),
+      nxt_string(":method: GET\n:scheme: http\n:path: /\n"
+                 ":authority: www.example.com\ncache-control: no-cache\n"),
+      110 },
+
+    { nxt_string("\x82\x87\x85\xbf\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f"
+                 "\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf"),
+      nxt_string(":method: GET\n:scheme: https\n:path: /index.html\n"
+                 ":authority: www.example.com\ncustom-key: custom-value\n"),
+      164 },
+};
+
+
+static const nxt_str_t  nxt_hpack_invalid[] = {
+    /* Zero index. */
+    nxt_string("\x80"),
+    /* Absent dynamic table entry. */
+    nxt_string("\xbe"),
+    /* Truncated string. */
+    nxt_string("\x04\x05/abc"),
+    /* Too large table size update. */
+    nxt_string("\x3f\xe2\x1f"),
+    /* Integer overflow. */
+    nxt_string("\xff\xff\xff\xff\xff\xff\x01"),
+    /* Huffman padding longer than 7 bits. */
+    nxt_string("\x04\x82\x1f\xff"),
+    /* Huffman padding with zero bits. */
+    nxt_string("\x04\x81\x60"),
+};
+
+
+static nxt_int_t nxt_hpack_test_block(nxt_thread_t *thr, nxt_hpack_t *hp,
+    nxt_mp_t *mp, const nxt_str_t *block, const nxt_str_t *expected);
+
+
+nxt_int_t
+nxt_hpack_test(nxt_thread_t *thr)
+{
+    u_char       *p, buf[128];
+    nxt_mp_t     *mp;
+    nxt_int_t    ret;
+    nxt_str_t    block, expected;
+    nxt_uint_t   i;
+    nxt_hpack_t  hp;
+
+    nxt_thread_time_update(thr);
+
+    if (nxt_hpack_init() != NXT_OK) {
+        nxt_log_alert(thr->log, "hpack huffman tree init failed");
+        return NXT_ERROR;
+    }
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    ret = NXT_ERROR;
+
+    for (i = 0; i < nxt_nitems(nxt_hpack_tests); i++) {
+
+        if (i % 3 == 0) {
+            nxt_hpack_table_init(&hp, mp);
+        }
+
+        if (nxt_hpack_test_block(thr, &hp, mp, &nxt_hpack_tests[i].block,
+                                 &nxt_hpack_tests[i].fields)
+            != NXT_OK)
+        {
+            goto done;
+        }
+
+        if (hp.size != nxt_hpack_tests[i].size) {
+            nxt_log_alert(thr->log, "hpack test #%ui failed: "
+                          "table size %uz, expected %uz",
+                          i, hp.size, nxt_hpack_tests[i].size);
+            goto done;
+        }
+
+        if (i % 3 == 2) {
+            nxt_hpack_table_free(&hp);
+        }
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_hpack_invalid); i++) {
+        nxt_hpack_table_init(&hp, mp);
+
+        if (nxt_hpack_test_block(thr, &hp, mp, &nxt_hpack_invalid[i], NULL)
+            != NXT_OK)
+        {
+            goto done;
+        }
+
+        nxt_hpack_table_free(&hp);
+    }
+
+    p = nxt_hpack_encode_status(buf, 200);
+    p = nxt_hpack_encode_status(p, 418);
+    p = nxt_hpack_encode_field(p, (u_char *) "Content-Type", 12,
+                               (u_char *) "text/plain", 10);
+    p = nxt_hpack_encode_field(p, (u_char *) "X-Test", 6,
+                               (u_char *) "1", 1);
+
+    block.start = buf;
+    block.length = p - buf;
+
+    nxt_str_set(&expected, ":status: 200\n:status: 418\n"
+                           "content-type: text/plain\nx-test: 1\n");
+
+    nxt_hpack_table_init(&hp, mp);
+
+    if (nxt_hpack_test_block(thr, &hp, mp, &block, &expected) != NXT_OK) {
+        goto done;
+    }
+
+    if (hp.size != 0) {
+        nxt_log_alert(thr->log, "hpack encoder test failed: table size %uz",
+                      hp.size);
+        goto done;
+    }
+
+    ret = NXT_OK;
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "hpack test passed");
+
+done:
+
+    nxt_mp_destroy(mp);
+
+    return ret;
+}
+
+
+static nxt_int_t
+nxt_hpack_test_block(nxt_thread_t *thr, nxt_hpack_t *hp, nxt_mp_t *mp,
+    const nxt_str_t *block, const nxt_str_t *expected)
+{
+    u_char             *pos, *end, *p, buf[512];
+    nxt_int_t          ret;
+    nxt_str_t          result;
+    nxt_hpack_field_t  field;
+
+    pos = block->start;
+    end = pos + block->length;
+    p = buf;
+
+    for ( ;; ) {
+        ret = nxt_hpack_decode(hp, mp, &pos, end, &field);
+
+        if (ret != NXT_OK) {
+            break;
+        }
+
+        p = nxt_sprintf(p, buf + sizeof(buf), "%V: %V\n",
+                        &field.name, &field.value);
+    }
+
+    if (expected == NULL) {
+        if (ret == NXT_ERROR) {
+            return NXT_OK;
+        }
+
+        nxt_log_alert(thr->log, "hpack invalid block test failed: "
+                      "\"%V\" is accepted", block);
+        return NXT_ERROR;
+    }
+
+    result.start = buf;
+    result.length = p - buf;
+
+    if (ret != NXT_DONE || !nxt_strstr_eq(&result, expected)) {
+        nxt_log_alert(thr->log, "hpack test failed: \"%V\", expected \"%V\"",
+                      &result, expected);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
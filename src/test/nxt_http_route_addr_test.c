@@ -0,0 +1,258 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_http_route_addr.h>
+#include "nxt_tests.h"
+
+
+typedef struct {
+    nxt_str_t   addr;
+    nxt_bool_t  match;
+} nxt_http_route_addr_test_t;
+
+
+#define NXT_HTTP_ROUTE_ADDR_TEST_RANGES  8
+#define NXT_HTTP_ROUTE_ADDR_TEST_RUNS    1000
+
+
+static nxt_int_t nxt_http_route_addr_test_patterns(nxt_thread_t *thr,
+    nxt_mp_t *mp);
+static nxt_int_t nxt_http_route_addr_test_ranges(nxt_thread_t *thr,
+    nxt_mp_t *mp);
+
+
+static const char  nxt_http_route_addr_test_conf[] =
+    "[\"10.0.0.0/8\", \"192.168.1.10\", \"172.16.0.5-172.16.1.7\","
+    " \"172.16.0.0/12:8080\", \"*:9000-9001\", \"2001:db8::/32\","
+    " \"[2001:db9::1-2001:db9::ff]:443\", \"fe80::1\", \"!10.1.1.1\"]";
+
+
+static const nxt_http_route_addr_test_t  nxt_http_route_addr_tests[] = {
+    { nxt_string("10.1.2.3:80"),             1 },
+    { nxt_string("10.255.255.255:80"),       1 },
+    { nxt_string("11.0.0.1:80"),             0 },
+    { nxt_string("9.255.255.255:80"),        0 },
+    { nxt_string("192.168.1.10:1"),          1 },
+    { nxt_string("192.168.1.11:1"),          0 },
+    { nxt_string("172.16.0.4:80"),           0 },
+    { nxt_string("172.16.0.5:80"),           1 },
+    { nxt_string("172.16.0.255:80"),         1 },
+    { nxt_string("172.16.1.7:80"),           1 },
+    { nxt_string("172.16.1.8:80"),           0 },
+    { nxt_string("172.16.1.8:8080"),         1 },
+    { nxt_string("172.31.255.255:8080"),     1 },
+    { nxt_string("172.32.0.1:8080"),         0 },
+    { nxt_string("1.2.3.4:9000"),            1 },
+    { nxt_string("1.2.3.4:9002"),            0 },
+    { nxt_string("[::1]:9001"),              1 },
+    { nxt_string("[::1]:80"),                0 },
+    { nxt_string("[2001:db8:1::1]:80"),      1 },
+    { nxt_string("[2001:db7:ffff::1]:80"),   0 },
+    { nxt_string("[2001:db9::1]:443"),       1 },
+    { nxt_string("[2001:db9::ff]:443"),      1 },
+    { nxt_string("[2001:db9::100]:443"),     0 },
+    { nxt_string("[2001:db9::80]:80"),       0 },
+    { nxt_string("[fe80::1]:80"),            1 },
+    { nxt_string("[fe80::2]:80"),            0 },
+};
+
+
+nxt_int_t
+nxt_http_route_addr_test(nxt_thread_t *thr)
+{
+    nxt_mp_t   *mp;
+    nxt_int_t  ret;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_http_route_addr_test_patterns(thr, mp);
+
+    if (ret == NXT_OK) {
+        ret = nxt_http_route_addr_test_ranges(thr, mp);
+    }
+
+    nxt_mp_destroy(mp);
+
+    if (ret == NXT_OK) {
+        nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                      "nxt_http_route_addr test passed");
+    }
+
+    return ret;
+}
+
+
+static nxt_int_t
+nxt_http_route_addr_test_patterns(nxt_thread_t *thr, nxt_mp_t *mp)
+{
+    nxt_int_t                      ret;
+    nxt_uint_t                     i, n;
+    nxt_bool_t                     match;
+    nxt_sockaddr_t                 *sa;
+    nxt_conf_value_t               *conf;
+    nxt_http_route_addr_tree_t     *tree;
+    nxt_http_route_addr_pattern_t  *pattern;
+
+    conf = nxt_conf_json_parse(mp, (u_char *) nxt_http_route_addr_test_conf,
+                               (u_char *) nxt_http_route_addr_test_conf
+                               + nxt_length(nxt_http_route_addr_test_conf),
+                               NULL);
+    if (conf == NULL) {
+        return NXT_ERROR;
+    }
+
+    n = nxt_conf_array_elements_count(conf);
+
+    pattern = nxt_mp_alloc(mp, n * sizeof(nxt_http_route_addr_pattern_t));
+    if (pattern == NULL) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < n; i++) {
+        ret = nxt_http_route_addr_pattern_parse(mp, &pattern[i],
+                                          nxt_conf_get_array_element(conf, i));
+        if (ret != NXT_OK) {
+            nxt_log_alert(thr->log, "nxt_http_route_addr_pattern_parse(%ui) "
+                          "failed: %i", i, ret);
+            return NXT_ERROR;
+        }
+    }
+
+    tree = nxt_http_route_addr_tree_create(mp, pattern, n);
+    if (tree == NULL) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_http_route_addr_tests); i++) {
+        sa = nxt_sockaddr_parse(mp, (nxt_str_t *)
+                                    &nxt_http_route_addr_tests[i].addr);
+        if (sa == NULL) {
+            return NXT_ERROR;
+        }
+
+        match = nxt_http_route_addr_tree_match(tree, sa);
+
+        if (match != nxt_http_route_addr_tests[i].match) {
+            nxt_log_alert(thr->log, "nxt_http_route_addr_tree_match(\"%V\") "
+                          "test failed: %d",
+                          &nxt_http_route_addr_tests[i].addr, match);
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * Random IPv4 ranges are split into prefixes by the tree,
+ * so the tree is compared with the plain range test.
+ */
+
+static nxt_int_t
+nxt_http_route_addr_test_ranges(nxt_thread_t *thr, nxt_mp_t *mp)
+{
+    uint32_t                       key, addr, start, end, probe[4];
+    nxt_uint_t                     run, i, j, k;
+    nxt_bool_t                     match, expect;
+    nxt_sockaddr_t                 *sa;
+    nxt_http_route_addr_tree_t     *tree;
+    nxt_http_route_addr_pattern_t  pattern[NXT_HTTP_ROUTE_ADDR_TEST_RANGES];
+
+    sa = nxt_sockaddr_alloc(mp, sizeof(struct sockaddr_in),
+                            NXT_INET_ADDR_STR_LEN);
+    if (sa == NULL) {
+        return NXT_ERROR;
+    }
+
+    sa->u.sockaddr_in.sin_family = AF_INET;
+    sa->u.sockaddr_in.sin_port = htons(80);
+
+    key = 0;
+
+    for (run = 0; run < NXT_HTTP_ROUTE_ADDR_TEST_RUNS; run++) {
+
+        for (i = 0; i < NXT_HTTP_ROUTE_ADDR_TEST_RANGES; i++) {
+            key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+            start = key;
+
+            key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+            /* Mostly short ranges of various alignments. */
+            end = start + (key >> (key & 31));
+
+            if (end < start) {
+                end = 0xffffffff;
+            }
+
+            nxt_memzero(&pattern[i], sizeof(nxt_http_route_addr_pattern_t));
+
+            pattern[i].base.match_type = NXT_HTTP_ROUTE_ADDR_RANGE;
+            pattern[i].base.addr_family = AF_INET;
+            pattern[i].base.port.start = 0;
+            pattern[i].base.port.end = 65535;
+            pattern[i].addr.v4.start = htonl(start);
+            pattern[i].addr.v4.end = htonl(end);
+        }
+
+        tree = nxt_http_route_addr_tree_create(mp, pattern,
+                                               NXT_HTTP_ROUTE_ADDR_TEST_RANGES);
+        if (tree == NULL) {
+            return NXT_ERROR;
+        }
+
+        for (i = 0; i < NXT_HTTP_ROUTE_ADDR_TEST_RANGES; i++) {
+            start = ntohl(pattern[i].addr.v4.start);
+            end = ntohl(pattern[i].addr.v4.end);
+
+            key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+            probe[0] = start - 1;
+            probe[1] = start;
+            probe[2] = end;
+            probe[3] = end + 1;
+
+            for (j = 0; j < 5; j++) {
+                if (j < 4) {
+                    addr = probe[j];
+
+                } else if (end - start != 0xffffffff) {
+                    addr = start + key % (end - start + 1);
+
+                } else {
+                    addr = key;
+                }
+
+                expect = 0;
+
+                for (k = 0; k < NXT_HTTP_ROUTE_ADDR_TEST_RANGES; k++) {
+                    if (ntohl(pattern[k].addr.v4.start) <= addr
+                        && addr <= ntohl(pattern[k].addr.v4.end))
+                    {
+                        expect = 1;
+                        break;
+                    }
+                }
+
+                sa->u.sockaddr_in.sin_addr.s_addr = htonl(addr);
+
+                match = nxt_http_route_addr_tree_match(tree, sa);
+
+                if (match != expect) {
+                    nxt_log_alert(thr->log, "nxt_http_route_addr_tree_match("
+                                  "%08xD) in %08xD-%08xD test failed: %d",
+                                  addr, start, end, match);
+                    return NXT_ERROR;
+                }
+            }
+        }
+    }
+
+    return NXT_OK;
+}
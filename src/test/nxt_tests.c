@@ -138,6 +138,14 @@ main(int argc, char **argv)
         return 1;
     }
 
+    if (nxt_aho_corasick_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_http_route_addr_test(thr) != NXT_OK) {
+        return 1;
+    }
+
     if (nxt_gmtime_test(thr) != NXT_OK) {
         return 1;
     }
@@ -166,6 +174,16 @@ main(int argc, char **argv)
         return 1;
     }
 
+    if (nxt_hpack_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+#if (NXT_HAVE_IO_URING)
+    if (nxt_io_uring_test(thr) != NXT_OK) {
+        return 1;
+    }
+#endif
+
 #if (NXT_HAVE_CLONE_NEWUSER)
     if (nxt_clone_creds_test(thr) != NXT_OK) {
         return 1;
@@ -56,6 +56,11 @@ def pytest_addoption(parser):
         type=str,
         help="Default user for non-privileged processes of unitd",
     )
+    parser.addoption(
+        "--engine",
+        type=str,
+        help="Event engine of unitd, e.g. io_uring",
+    )
     parser.addoption(
         "--fds-threshold",
         type=int,
@@ -90,6 +95,7 @@ def pytest_configure(config):
     option.config = config.option
 
     option.detailed = config.option.detailed
+    option.engine = config.option.engine
     option.fds_threshold = config.option.fds_threshold
     option.print_log = config.option.print_log
     option.save_log = config.option.save_log
@@ -307,6 +313,9 @@ def unit_run(state_dir=None):
     if option.user:
         unitd_args.extend(['--user', option.user])
 
+    if option.engine:
+        unitd_args.extend(['--engine', option.engine])
+
     with open(f'{temp_dir}/unit.log', 'w') as log:
         unit_instance['process'] = subprocess.Popen(unitd_args, stderr=log)
 
@@ -0,0 +1,35 @@
+count = 0
+
+
+def application(environ, start_response):
+    global count
+
+    count += 1
+
+    body = f'{environ["REQUEST_URI"]} {count}'.encode()
+    length = int(environ.get('HTTP_X_LENGTH', 0))
+
+    if length:
+        body = b'X' * length
+
+    headers = [
+        ('Content-Length', str(len(body))),
+        ('X-Count', str(count)),
+    ]
+
+    cache_control = environ.get('HTTP_X_CACHE_CONTROL')
+    if cache_control is not None:
+        headers.append(('Cache-Control', cache_control))
+
+    cookie = environ.get('HTTP_X_SET_COOKIE')
+    if cookie is not None:
+        headers.append(('Set-Cookie', cookie))
+
+    vary = environ.get('HTTP_X_VARY')
+    if vary is not None:
+        headers.append(('Vary', vary))
+
+    status = environ.get('HTTP_X_STATUS', '200')
+
+    start_response(status, headers)
+    return [body]
@@ -1,7 +1,9 @@
+import re
 import time
 
 import pytest
 from unit.applications.lang.python import ApplicationPython
+from unit.log import Log
 from unit.option import option
 
 prerequisites = {'modules': {'python': 'any'}}
@@ -294,6 +296,187 @@ def test_access_log_format(wait_for_record):
     check_format('$uri $status $uri $status', '/ 200 / 200')
 
 
+def test_access_log_buffer(wait_for_record):
+    load('empty')
+
+    assert 'success' in client.conf(
+        {
+            'path': f'{option.temp_dir}/access.log',
+            'format': '$uri $status',
+            'buffer': 1024,
+            'flush': 1,
+        },
+        'access_log',
+    ), 'access_log buffer'
+
+    for i in range(100):
+        assert client.get(url=f'/buffer{i}')['status'] == 200
+
+    for i in range(100):
+        assert (
+            wait_for_record(fr'^\/buffer{i} 200$', 'access.log') is not None
+        ), 'buffered'
+
+
+def test_access_log_buffer_off(search_in_file):
+    load('empty')
+
+    assert 'success' in client.conf(
+        {'path': f'{option.temp_dir}/access.log', 'buffer': 0},
+        'access_log',
+    ), 'access_log buffer off'
+
+    assert client.get(url='/unbuffered')['status'] == 200
+
+    time.sleep(0.1)
+
+    assert (
+        search_in_file(r'"GET /unbuffered HTTP/1.1"', 'access.log')
+        is not None
+    ), 'unbuffered'
+
+
+def test_access_log_format_fields(wait_for_record):
+    load('empty')
+
+    set_format(
+        '$method $request_uri $uri $host $status $arg_a '
+        '"$header_referer" "$header_x_test" ${cookie_c}$dollar'
+    )
+
+    assert (
+        client.get(
+            url='/fields?a=b',
+            headers={
+                'Host': 'example.com',
+                'X-Test': 'test',
+                'Cookie': 'c=d',
+                'Connection': 'close',
+            },
+        )['status']
+        == 200
+    )
+
+    assert (
+        wait_for_record(
+            r'^GET /fields\?a=b /fields example.com 200 b "-" "test" d\$$',
+            'access.log',
+        )
+        is not None
+    ), 'fields'
+
+
+def conf_filter(listener=None, action=None, **kwargs):
+    listener_conf = {"pass": "routes"}
+    action_conf = {"return": 200}
+
+    if listener is not None:
+        listener_conf['access_log'] = listener
+
+    if action is not None:
+        action_conf['access_log'] = action
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": listener_conf},
+            "routes": [
+                {"match": {"uri": "/missing*"}, "action": {"return": 404}},
+                {"action": action_conf},
+            ],
+            "applications": {},
+            "access_log": {
+                "path": f'{option.temp_dir}/access.log',
+                "format": '$uri $status',
+                **kwargs,
+            },
+        }
+    ), 'access_log filter'
+
+
+def check_filter(wait_for_record, search_in_file, logged, skipped):
+    for url in logged + skipped:
+        client.get(url=url)
+
+    client.get(url='/marker')
+
+    for url in logged:
+        assert (
+            wait_for_record(fr'^{url} \d+$', 'access.log') is not None
+        ), f'logged {url}'
+
+    for url in skipped:
+        assert (
+            search_in_file(fr'^{url} \d+$', 'access.log') is None
+        ), f'skipped {url}'
+
+
+def test_access_log_filter_status(wait_for_record, search_in_file):
+    conf_filter(status=['2xx'])
+
+    check_filter(
+        wait_for_record, search_in_file, ['/ok', '/marker'], ['/missing']
+    )
+
+    conf_filter(status='4xx')
+
+    client.get(url='/ok2')
+    client.get(url='/missing2')
+
+    assert (
+        wait_for_record(r'^/missing2 404$', 'access.log') is not None
+    ), 'status string'
+    assert search_in_file(r'^/ok2', 'access.log') is None, 'status skipped'
+
+
+def test_access_log_filter_sample(wait_for_record, search_in_file):
+    conf_filter(sample=0)
+
+    for _ in range(10):
+        client.get(url='/sampled')
+
+    conf_filter(sample=1)
+
+    client.get(url='/marker')
+
+    assert wait_for_record(r'^/marker 200$', 'access.log') is not None
+    assert search_in_file(r'^/sampled', 'access.log') is None, 'sample 0'
+
+    conf_filter(sample=0.5)
+
+    for i in range(200):
+        client.get(url=f'/half{i}')
+
+    conf_filter()
+
+    client.get(url='/marker2')
+
+    assert wait_for_record(r'^/marker2 200$', 'access.log') is not None
+
+    half = len(re.findall(r'^/half\d+ 200$', Log.read('access.log'), re.M))
+
+    assert 50 < half < 150, 'sample 0.5'
+
+
+def test_access_log_filter_override(wait_for_record, search_in_file):
+    conf_filter(listener={"sample": 1}, sample=0)
+
+    client.get(url='/listener')
+
+    assert (
+        wait_for_record(r'^/listener 200$', 'access.log') is not None
+    ), 'listener overrides global'
+
+    conf_filter(listener={"sample": 0}, action={"status": "2xx"})
+
+    client.get(url='/action')
+    client.get(url='/missing')
+
+    assert (
+        wait_for_record(r'^/action 200$', 'access.log') is not None
+    ), 'action overrides listener'
+    assert search_in_file(r'^/missing', 'access.log') is None, 'listener'
+
+
 def test_access_log_variables(wait_for_record):
     load('mirror')
 
@@ -322,3 +505,32 @@ def test_access_log_incorrect(temp_dir, skip_alert):
         },
         'access_log',
     ), 'access_log format incorrect'
+
+    def check_error(name, value):
+        assert 'error' in client.conf(
+            {'path': f'{temp_dir}/access.log', name: value},
+            'access_log',
+        ), f'access_log {name} incorrect'
+
+    check_error('buffer', -1)
+    check_error('buffer', '1k')
+    check_error('buffer', 1073741825)
+    check_error('flush', 0)
+    check_error('flush', 86401)
+    check_error('flush', 1.5)
+    check_error('sample', -0.1)
+    check_error('sample', 1.1)
+    check_error('sample', '1')
+    check_error('status', '200')
+    check_error('status', '6xx')
+    check_error('status', [])
+    check_error('status', ['2xx', 3])
+
+    assert 'error' in client.conf(
+        {"pass": "routes", "access_log": {"sample": 2}},
+        'listeners/*:8080',
+    ), 'listener access_log incorrect'
+    assert 'error' in client.conf(
+        {"return": 200, "access_log": {"status": "2yy"}},
+        'routes/0/action',
+    ), 'action access_log incorrect'
@@ -0,0 +1,304 @@
+import gzip
+import shutil
+import subprocess
+import zlib
+from pathlib import Path
+
+import pytest
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {'modules': {'zlib': 'any', 'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    client.load('body_generate')
+
+    Path(f'{temp_dir}/assets').mkdir()
+    Path(f'{temp_dir}/assets/index.html').write_text('0123456789' * 1000)
+    Path(f'{temp_dir}/assets/file.txt').write_text('0123456789' * 1000)
+
+
+def compress_update(compress, app=True, temp_dir=None):
+    if app:
+        action = {
+            "pass": "applications/body_generate",
+            "response_headers": {"Content-Type": "text/html"},
+        }
+    else:
+        action = {"share": f'{temp_dir}/assets$uri'}
+
+    action['compress'] = compress
+
+    assert 'success' in client.conf(
+        [{"action": action}], 'routes'
+    ), 'configure compress'
+    assert 'success' in client.conf(
+        {"*:8080": {"pass": "routes"}}, 'listeners'
+    ), 'listeners'
+
+
+def get(length=1000, accept='gzip', url='/', method='GET'):
+    headers = {
+        'Host': 'localhost',
+        'X-Length': str(length),
+        'Connection': 'close',
+    }
+
+    if accept is not None:
+        headers['Accept-Encoding'] = accept
+
+    resp = client._resp_to_dict(
+        client.http(
+            method,
+            url=url,
+            headers=headers,
+            encoding='latin-1',
+            raw_resp=True,
+        )
+    )
+
+    resp['body'] = resp['body'].encode('latin-1')
+
+    if resp['headers'].get('Transfer-Encoding') == 'chunked':
+        resp['body'] = client._parse_chunked_body(resp['body'])
+
+    return resp
+
+
+def test_compress_gzip():
+    compress_update({"encodings": "gzip"})
+
+    resp = get()
+    assert resp['status'] == 200, 'status'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'encoding'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+    assert 'Content-Length' not in resp['headers'], 'no length'
+    assert gzip.decompress(resp['body']) == b'X' * 1000, 'body'
+    assert len(resp['body']) < 1000, 'compressed'
+
+
+def test_compress_large():
+    compress_update({"encodings": ["gzip"], "level": 1})
+
+    for length in [8191, 8192, 8193, 1000000]:
+        resp = get(length)
+        assert resp['headers']['Content-Encoding'] == 'gzip', 'encoding'
+        assert gzip.decompress(resp['body']) == b'X' * length, 'body'
+
+
+def test_compress_identity():
+    compress_update({})
+
+    resp = get(accept=None)
+    assert 'Content-Encoding' not in resp['headers'], 'no accept encoding'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+    assert resp['headers']['Content-Length'] == '1000', 'length'
+    assert resp['body'] == b'X' * 1000, 'body'
+
+    resp = get(accept='br, deflate')
+    assert 'Content-Encoding' not in resp['headers'], 'unknown encoding'
+    assert resp['body'] == b'X' * 1000, 'unknown encoding body'
+
+
+def test_compress_accept_encoding():
+    compress_update({"encodings": "gzip"})
+
+    def encoding(accept):
+        return get(accept=accept)['headers'].get('Content-Encoding')
+
+    assert encoding('GZIP') == 'gzip', 'case'
+    assert encoding('deflate, gzip;q=0.5') == 'gzip', 'q'
+    assert encoding('gzip; q=1.0') == 'gzip', 'q spaces'
+    assert encoding('*') == 'gzip', 'star'
+    assert encoding('gzip;q=0') is None, 'q zero'
+    assert encoding('gzip;q=0.000') is None, 'q zero fraction'
+    assert encoding('*;q=0') is None, 'star q zero'
+    assert encoding('gzip;q=0, *') is None, 'q zero and star'
+    assert encoding('identity') is None, 'identity'
+    assert encoding('gzipx') is None, 'prefix'
+
+
+def test_compress_min_length():
+    compress_update({"min_length": 100})
+
+    resp = get(99)
+    assert 'Content-Encoding' not in resp['headers'], 'short'
+    assert resp['body'] == b'X' * 99, 'short body'
+
+    resp = get(100)
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'long enough'
+    assert gzip.decompress(resp['body']) == b'X' * 100, 'body'
+
+    compress_update({})
+
+    assert 'Content-Encoding' not in get(19)['headers'], 'default min length'
+    assert get(20)['headers']['Content-Encoding'] == 'gzip', 'default'
+
+
+def test_compress_types(temp_dir):
+    compress_update({}, app=False, temp_dir=temp_dir)
+
+    resp = get(url='/file.txt')
+    assert 'Content-Encoding' not in resp['headers'], 'default types'
+    assert 'Vary' not in resp['headers'], 'no vary'
+
+    resp = get(url='/index.html')
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'html'
+    assert gzip.decompress(resp['body']) == b'0123456789' * 1000, 'body'
+
+    compress_update({"types": ["text/*", "!text/html"]}, False, temp_dir)
+
+    resp = get(url='/file.txt')
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'types'
+    assert gzip.decompress(resp['body']) == b'0123456789' * 1000, 'body'
+
+    resp = get(url='/index.html')
+    assert 'Content-Encoding' not in resp['headers'], 'types negation'
+
+
+def test_compress_static_not_modified(temp_dir):
+    compress_update({}, app=False, temp_dir=temp_dir)
+
+    resp = get(url='/index.html')
+    etag = resp['headers']['ETag']
+    assert etag.startswith('W/"'), 'weak etag'
+
+    resp = get(url='/index.html', accept=None)
+    assert resp['headers']['ETag'] == etag[2:], 'strong etag'
+
+
+def test_compress_head(temp_dir):
+    compress_update({}, app=False, temp_dir=temp_dir)
+
+    resp = get(url='/index.html', method='HEAD')
+    assert resp['status'] == 200, 'status'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'encoding'
+    assert resp['body'] == b'', 'no body'
+
+
+def test_compress_invalid():
+    def check_error(compress):
+        assert 'error' in client.conf(
+            {"pass": "applications/body_generate", "compress": compress},
+            'routes/0/action',
+        ), 'invalid compress'
+
+    compress_update({})
+
+    check_error({"encodings": "br"})
+    check_error({"encodings": []})
+    check_error({"encodings": [1]})
+    check_error({"level": 0})
+    check_error({"level": 20})
+    check_error({"min_length": -1})
+    check_error({"types": 1})
+    check_error({"unknown": 1})
+    check_error("gzip")
+
+
+def test_compress_not_modified(temp_dir):
+    compress_update({}, app=False, temp_dir=temp_dir)
+
+    etag = get(url='/index.html')['headers']['ETag']
+
+    resp = client.get(
+        url='/index.html',
+        headers={
+            'Host': 'localhost',
+            'Accept-Encoding': 'gzip',
+            'If-None-Match': etag,
+            'Connection': 'close',
+        },
+    )
+    assert resp['status'] == 304, 'status'
+    assert resp['headers']['ETag'] == etag, 'weak etag'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+    assert 'Content-Encoding' not in resp['headers'], 'no encoding'
+
+
+def test_compress_zstd():
+    if not option.available['modules']['zstd']:
+        pytest.skip('requires zstd')
+
+    if shutil.which('zstd') is None:
+        pytest.skip('requires zstd command line tool')
+
+    def unzstd(data):
+        return subprocess.run(
+            ['zstd', '-d', '-c'], input=data, capture_output=True, check=True
+        ).stdout
+
+    compress_update({"encodings": ["zstd", "gzip"], "level": 1})
+
+    for length in [1000, 8193, 1000000]:
+        resp = get(length, accept='zstd')
+        assert resp['headers']['Content-Encoding'] == 'zstd', 'encoding'
+        assert unzstd(resp['body']) == b'X' * length, 'body'
+
+    resp = get(accept='gzip')
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'gzip fallback'
+    assert gzip.decompress(resp['body']) == b'X' * 1000, 'gzip body'
+
+
+def test_compress_flush():
+    client.load('delayed')
+
+    assert 'success' in client.conf(
+        [
+            {
+                "action": {
+                    "pass": "applications/delayed",
+                    "response_headers": {"Content-Type": "text/html"},
+                    "compress": {},
+                }
+            }
+        ],
+        'routes',
+    )
+    assert 'success' in client.conf(
+        {"*:8080": {"pass": "routes"}}, 'listeners'
+    ), 'listeners'
+
+    body = b'0123456789' * 20
+
+    sock = client.post(
+        headers={
+            'Host': 'localhost',
+            'Accept-Encoding': 'gzip',
+            'X-Parts': '2',
+            'X-Delay': '3',
+            'Connection': 'close',
+        },
+        body=body,
+        no_recv=True,
+    )
+
+    def unchunk(data):
+        out = b''
+
+        while b'\r\n' in data.lstrip(b'\r\n'):
+            size, data = data.lstrip(b'\r\n').split(b'\r\n', 1)
+            size = int(size, 16)
+
+            out += data[:size]
+            data = data[size:]
+
+        return out
+
+    data = client.recvall(sock, read_timeout=1)
+    header, data = data.split(b'\r\n\r\n', 1)
+
+    assert b'Content-Encoding: gzip' in header, 'encoding'
+
+    decompressor = zlib.decompressobj(16 + zlib.MAX_WBITS)
+
+    assert decompressor.decompress(unchunk(data)) == body[:100], 'flushed'
+
+    data += client.recvall(sock)
+    sock.close()
+
+    assert gzip.decompress(unchunk(data)) == body, 'body'
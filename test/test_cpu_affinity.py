@@ -0,0 +1,59 @@
+import os
+import time
+
+import pytest
+from conftest import pid_by_name
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(system):
+    if system != 'Linux':
+        pytest.skip('CPU affinity is supported on Linux only')
+
+
+def cpus_allowed(pid):
+    cpus = []
+
+    for tid in os.listdir(f'/proc/{pid}/task'):
+        with open(f'/proc/{pid}/task/{tid}/status') as f:
+            for line in f:
+                if line.startswith('Cpus_allowed_list:'):
+                    cpus.append(line.split()[1])
+
+    return cpus
+
+
+def conf_cpu_affinity(cpus):
+    settings = {} if cpus is None else {"cpu_affinity": cpus}
+
+    return client.conf(
+        {
+            "settings": settings,
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        }
+    )
+
+
+def test_cpu_affinity_router():
+    cpu = str(min(os.sched_getaffinity(0)))
+    router = pid_by_name('unit: router')
+
+    assert 'success' in conf_cpu_affinity(cpu)
+    assert client.get()['status'] == 200
+
+    time.sleep(0.2)
+
+    assert cpus_allowed(router).count(cpu) >= os.cpu_count(), 'bound'
+
+    assert 'success' in conf_cpu_affinity(None)
+    assert client.get()['status'] == 200
+
+
+def test_cpu_affinity_invalid():
+    for cpus in ['', 'a', '1-0', '0,', ',0', '0-', '1024', '0 1', 3]:
+        assert 'error' in conf_cpu_affinity(cpus), cpus
@@ -0,0 +1,306 @@
+import gzip
+import time
+
+import pytest
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+def cache_update(cache, extra=None):
+    action = {"pass": "applications/cache", "cache": cache}
+
+    if extra is not None:
+        action.update(extra)
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": action}],
+            "applications": {
+                "cache": {
+                    "type": client.get_application_type(),
+                    "processes": {"spare": 0},
+                    "path": f'{option.test_dir}/python/cache',
+                    "working_directory": f'{option.test_dir}/python/cache',
+                    "module": "wsgi",
+                }
+            },
+        }
+    ), 'configure cache'
+
+
+def get(url='/', headers=None, method='GET'):
+    fields = {'Host': 'localhost', 'Connection': 'close'}
+
+    if headers is not None:
+        fields.update(headers)
+
+    return client.http(method, url=url, headers=fields, encoding='latin-1')
+
+
+def count(url='/', cache_control='max-age=60', headers=None, method='GET'):
+    fields = {}
+
+    if cache_control is not None:
+        fields['X-Cache-Control'] = cache_control
+
+    if headers is not None:
+        fields.update(headers)
+
+    resp = get(url, fields, method)
+    assert resp['status'] == 200, 'status'
+
+    return int(resp['headers']['X-Count'])
+
+
+def test_http_cache():
+    cache_update({})
+
+    assert count() == 1, 'first'
+    assert count() == 1, 'cached'
+
+    resp = get()
+    assert resp['body'] == '/ 1', 'cached body'
+    assert resp['headers']['Cache-Control'] == 'max-age=60', 'cached header'
+    assert resp['headers']['Content-Length'] == '3', 'cached length'
+    assert 'Age' in resp['headers'], 'age'
+    assert 'Date' in resp['headers'], 'date'
+
+    assert count('/other') == 2, 'other uri'
+    assert count('/other') == 2, 'other uri cached'
+    assert count('/?a=1') == 3, 'other args'
+
+
+def test_http_cache_head():
+    cache_update({})
+
+    assert count(method='HEAD') == 1, 'head not stored'
+    assert count() == 2, 'get'
+
+    resp = get(method='HEAD')
+    assert resp['headers']['X-Count'] == '2', 'head cached'
+    assert resp['headers']['Content-Length'] == '3', 'head length'
+    assert resp['body'] == '', 'head body'
+
+    cache_update({"key": "$method$host$request_uri"})
+
+    assert count() == 3, 'method key'
+    assert count(method='HEAD') == 4, 'head method key'
+
+
+def test_http_cache_control():
+    cache_update({})
+
+    assert count(cache_control=None) == 1, 'no cache control'
+    assert count(cache_control=None) == 2, 'no cache control again'
+
+    for cache_control in [
+        'no-store, max-age=60',
+        'max-age=60, private',
+        'no-cache',
+        'max-age=0',
+        's-maxage=0, max-age=60',
+    ]:
+        first = count(cache_control=cache_control)
+        assert count(cache_control=cache_control) == first + 1, cache_control
+
+    first = count(cache_control='public, s-maxage=60, max-age=0')
+    assert count() == first, 's-maxage'
+
+
+def test_http_cache_valid():
+    cache_update({"valid": 1})
+
+    assert count(cache_control=None) == 1, 'first'
+    assert count(cache_control=None) == 1, 'valid'
+
+    time.sleep(2)
+
+    assert count(cache_control=None) == 2, 'expired'
+
+
+def test_http_cache_max_age():
+    cache_update({})
+
+    assert count(cache_control='max-age=1') == 1, 'first'
+    assert count(cache_control='max-age=1') == 1, 'cached'
+
+    time.sleep(2)
+
+    assert count(cache_control='max-age=1') == 2, 'expired'
+
+
+def test_http_cache_stale_while_revalidate():
+    cache_update({})
+
+    control = 'max-age=1, stale-while-revalidate=60'
+
+    assert count(cache_control=control) == 1, 'first'
+
+    time.sleep(2)
+
+    assert count(cache_control=control) == 2, 'revalidated'
+    assert count(cache_control=control) == 2, 'updated'
+
+    cache_update({"stale_while_revalidate": 60})
+
+    assert count(cache_control='max-age=1') == 3, 'option first'
+
+    time.sleep(2)
+
+    assert count(cache_control='max-age=1') == 4, 'option revalidated'
+    assert count(cache_control='max-age=1') == 4, 'option updated'
+
+
+def test_http_cache_uncacheable():
+    cache_update({})
+
+    assert count(headers={'X-Set-Cookie': 'a=b'}) == 1, 'set cookie'
+    assert count(headers={'X-Set-Cookie': 'a=b'}) == 2, 'set cookie again'
+
+    assert count(headers={'Authorization': 'Basic a'}) == 3, 'authorization'
+    assert count() == 4, 'authorization not cached'
+    assert count(headers={'Authorization': 'Basic a'}) == 5, 'authorization'
+
+    resp = get(
+        '/404', headers={'X-Status': '404', 'X-Cache-Control': 'max-age=60'}
+    )
+    assert resp['status'] == 404, 'not found'
+    resp = get(
+        '/404', headers={'X-Status': '404', 'X-Cache-Control': 'max-age=60'}
+    )
+    assert resp['headers']['X-Count'] == '7', 'not found not cached'
+
+    assert count('/post', method='POST') == 8, 'post'
+    assert count('/post', method='POST') == 9, 'post not cached'
+    assert count('/post') == 10, 'post not stored'
+
+    vary = {'X-Vary': 'Accept-Encoding'}
+    assert count('/vary', headers=vary) == 11, 'vary'
+    assert count('/vary', headers=vary) == 12, 'vary not cached'
+
+    vary = {'X-Vary': '*'}
+    assert count('/vary', headers=vary) == 13, 'vary star'
+    assert count('/vary', headers=vary) == 14, 'vary star not cached'
+
+
+def test_http_cache_key():
+    cache_update({"key": "$uri"})
+
+    assert count('/?a=1') == 1, 'first'
+    assert count('/?a=2') == 1, 'args ignored'
+
+    cache_update({"key": "$uri$header_x_variant"})
+
+    assert count(headers={'X-Variant': 'a'}) == 2, 'variant a'
+    assert count(headers={'X-Variant': 'b'}) == 3, 'variant b'
+    assert count(headers={'X-Variant': 'a'}) == 2, 'variant a cached'
+
+
+def test_http_cache_max_size():
+    cache_update({"max_size": 2000})
+
+    assert count('/a', headers={'X-Length': '1200'}) == 1, 'first'
+    assert count('/a', headers={'X-Length': '1200'}) == 1, 'cached'
+    assert count('/b', headers={'X-Length': '1200'}) == 2, 'second'
+    assert count('/b', headers={'X-Length': '1200'}) == 2, 'second cached'
+    assert count('/a', headers={'X-Length': '1200'}) == 3, 'evicted'
+
+    assert count('/c', headers={'X-Length': '3000'}) == 4, 'too large'
+    assert count('/c', headers={'X-Length': '3000'}) == 5, 'not cached'
+
+
+def test_http_cache_concurrent():
+    cache_update({})
+
+    length = 4 * 1024 * 1024
+
+    assert count('/big', headers={'X-Length': str(length)}) == 1, 'first'
+
+    socks = [
+        client.get(
+            url='/big',
+            headers={'Host': 'localhost', 'Connection': 'close'},
+            no_recv=True,
+        )
+        for _ in range(10)
+    ]
+
+    starts = [sock.recv(1) for sock in socks]
+
+    cache_update({"max_size": 1000})
+
+    for sock, start in zip(socks, starts):
+        resp = client._resp_to_dict((start + client.recvall(sock)).decode())
+        sock.close()
+
+        assert resp['headers']['X-Count'] == '1', 'concurrent cached'
+        assert resp['body'] == 'X' * length, 'concurrent body'
+
+    assert count('/big', headers={'X-Length': '10'}) == 2, 'new cache'
+
+
+def test_http_cache_response_headers():
+    cache_update({}, {"response_headers": {"X-Action": "$uri"}})
+
+    assert count() == 1, 'first'
+
+    resp = get()
+    assert resp['headers']['X-Count'] == '1', 'cached'
+    assert resp['headers']['X-Action'] == '/', 'response headers'
+
+
+def test_http_cache_invalid():
+    def check_error(cache):
+        assert 'error' in client.conf(
+            {"pass": "applications/cache", "cache": cache},
+            'routes/0/action',
+        ), 'invalid cache'
+
+    cache_update({})
+
+    check_error(True)
+    check_error({"valid": -1})
+    check_error({"max_size": 4294967296})
+    check_error({"stale_while_revalidate": "1"})
+    check_error({"key": "$blah"})
+    check_error({"unknown": 1})
+
+
+def test_http_cache_compress():
+    if not option.available['modules'].get('zlib'):
+        pytest.skip('requires zlib')
+
+    cache_update(
+        {},
+        {
+            "compress": {"encodings": "gzip", "types": "*"},
+            "response_headers": {"Content-Type": "text/plain"},
+        },
+    )
+
+    headers = {'X-Length': '1000', 'Accept-Encoding': 'gzip'}
+
+    assert count(headers=headers) == 1, 'first'
+
+    resp = client.http(
+        'GET',
+        url='/',
+        headers={'Host': 'localhost', 'Connection': 'close', **headers},
+        encoding='latin-1',
+        raw_resp=True,
+    )
+    resp = client._resp_to_dict(resp)
+    body = client._parse_chunked_body(resp['body'].encode('latin-1'))
+
+    assert resp['headers']['X-Count'] == '1', 'cached'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'compressed'
+    assert gzip.decompress(body) == b'X' * 1000, 'compressed body'
+
+    resp = get(headers={'X-Length': '1000'})
+    assert resp['headers']['X-Count'] == '1', 'identity cached'
+    assert resp['body'] == 'X' * 1000, 'identity body'
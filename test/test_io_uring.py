@@ -0,0 +1,115 @@
+import time
+
+import pytest
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    if option.engine != 'io_uring':
+        pytest.skip('requires --engine io_uring')
+
+
+def test_io_uring_body_large():
+    client.load('mirror')
+
+    body = '0123456789abcdef' * 64 * 1024
+
+    resp = client.post(body=body)
+
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == body, 'body'
+
+
+def test_io_uring_body_large_static(temp_dir):
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{temp_dir}$uri'}}],
+            "applications": {},
+        }
+    )
+
+    body = b'X' * 300000
+
+    for i in range(10):
+        start = time.time()
+
+        sock = client.post(
+            headers={
+                'Host': 'localhost',
+                'Content-Length': str(len(body)),
+                'Connection': 'close',
+            },
+            body='',
+            no_recv=True,
+        )
+
+        for pos in range(0, len(body), 65536):
+            sock.sendall(body[pos : pos + 65536])
+
+        resp = client._resp_to_dict(
+            client.recvall(sock, read_timeout=5).decode()
+        )
+        sock.close()
+
+        assert resp.get('status') == 405, f'status {i}'
+        assert time.time() - start < 2, f'not stalled {i}'
+
+
+def test_io_uring_body_slow():
+    client.load('mirror')
+
+    body = '0123456789' * 1000
+
+    sock = client.post(
+        headers={
+            'Host': 'localhost',
+            'Content-Length': str(len(body)),
+            'Connection': 'close',
+        },
+        body='',
+        no_recv=True,
+    )
+
+    for i in range(0, len(body), 2500):
+        time.sleep(0.1)
+        sock.sendall(body[i : i + 2500].encode())
+
+    resp = client._resp_to_dict(client.recvall(sock).decode())
+    sock.close()
+
+    assert resp['body'] == body, 'body'
+
+
+def test_io_uring_keepalive():
+    client.load('mirror')
+
+    (resp, sock) = client.get(
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=1,
+    )
+
+    assert resp['status'] == 200, 'init'
+
+    for i, body in enumerate(['0123456789', 'X' * 100000, '', 'Y' * 20000]):
+        (resp, sock) = client.post(
+            headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+            sock=sock,
+            start=True,
+            body=body,
+            read_timeout=1,
+        )
+
+        assert resp['status'] == 200, f'keep-alive status {i}'
+        assert resp['body'] == body, f'keep-alive body {i}'
+
+    resp = client.post(sock=sock, body='0123456789')
+
+    assert resp['body'] == '0123456789', 'keep-alive close'
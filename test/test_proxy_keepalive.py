@@ -0,0 +1,210 @@
+import socket
+import threading
+import time
+
+import pytest
+from conftest import run_process
+from unit.applications.proto import ApplicationProto
+from unit.utils import waitforsocket
+
+client = ApplicationProto()
+SERVER_PORT = 7999
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    run_process(run_server, SERVER_PORT)
+    waitforsocket(SERVER_PORT)
+
+    set_keepalive({"max_idle": 4})
+
+
+def run_server(server_port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+
+    server_address = ('127.0.0.1', server_port)
+    sock.bind(server_address)
+    sock.listen(10)
+
+    def read_request(connection, data):
+        while b'\r\n\r\n' not in data:
+            part = connection.recv(4096)
+
+            if not part:
+                return None, b''
+
+            data += part
+
+        header, data = data.split(b'\r\n\r\n', 1)
+
+        return header.decode(), data
+
+    def serve(connection, conn_id):
+        data = b''
+
+        while True:
+            header, data = read_request(connection, data)
+
+            if header is None:
+                break
+
+            uri = header.split(' ')[1]
+            body = str(conn_id).encode()
+
+            if uri == '/chunked':
+                connection.sendall(
+                    b'HTTP/1.1 200 OK\r\n'
+                    b'Transfer-Encoding: chunked\r\n\r\n'
+                    + b'%x\r\n' % len(body)
+                    + body
+                    + b'\r\n0\r\n\r\n'
+                )
+
+            elif uri == '/close' or 'Connection: close' in header:
+                connection.sendall(
+                    b'HTTP/1.1 200 OK\r\n'
+                    b'Connection: close\r\n'
+                    + b'Content-Length: %d\r\n\r\n' % len(body)
+                    + body
+                )
+                break
+
+            elif uri == '/drop':
+                connection.sendall(
+                    b'HTTP/1.1 200 OK\r\n'
+                    + b'Content-Length: %d\r\n\r\n' % len(body)
+                    + body
+                )
+                time.sleep(0.2)
+                break
+
+            else:
+                connection.sendall(
+                    b'HTTP/1.1 200 OK\r\n'
+                    + b'Content-Length: %d\r\n\r\n' % len(body)
+                    + body
+                )
+
+        connection.close()
+
+    conn_id = 0
+
+    while True:
+        connection, _ = sock.accept()
+
+        conn_id += 1
+
+        threading.Thread(
+            target=serve, args=(connection, conn_id), daemon=True
+        ).start()
+
+
+def set_keepalive(keepalive):
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "upstreams/one"}},
+            "routes": [],
+            "upstreams": {
+                "one": {
+                    "servers": {f'127.0.0.1:{SERVER_PORT}': {}},
+                    "keepalive": keepalive,
+                }
+            },
+        }
+    ), 'upstream keepalive configuration'
+
+
+def get_conn_ids(url='/', count=4, delay=0):
+    # All requests use one client connection so that they are
+    # processed by the same router thread.
+
+    resp, sock = client.get(
+        url=url,
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=0.5,
+    )
+
+    ids = []
+
+    for i in range(count):
+        if i != 0:
+            time.sleep(delay)
+
+            resp, sock = client.get(
+                url=url,
+                headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+                start=True,
+                sock=sock,
+                read_timeout=0.5,
+            )
+
+        assert resp['status'] == 200, 'status'
+
+        ids.append(resp['body'])
+
+    sock.close()
+
+    return ids
+
+
+def test_proxy_keepalive():
+    ids = get_conn_ids()
+
+    assert len(set(ids)) == 1, 'reused'
+
+
+def test_proxy_keepalive_chunked():
+    ids = get_conn_ids('/chunked')
+
+    assert len(set(ids)) == 1, 'chunked reused'
+
+
+def test_proxy_keepalive_disabled():
+    set_keepalive({"max_idle": 0})
+
+    ids = get_conn_ids()
+
+    assert len(set(ids)) == len(ids), 'not reused'
+
+
+def test_proxy_keepalive_connection_close():
+    ids = get_conn_ids('/close')
+
+    assert len(set(ids)) == len(ids), 'connection close'
+
+
+def test_proxy_keepalive_idle_timeout():
+    set_keepalive({"idle_timeout": 1})
+
+    ids = get_conn_ids(count=2)
+
+    assert ids[0] == ids[1], 'reused before timeout'
+
+    ids = get_conn_ids(count=2, delay=1.5)
+
+    assert ids[0] != ids[1], 'closed after timeout'
+
+
+def test_proxy_keepalive_server_closed():
+    ids = get_conn_ids('/drop', delay=0.5)
+
+    assert len(set(ids)) == len(ids), 'server closed'
+
+    ids = get_conn_ids('/drop', count=10)
+
+    assert len(ids) == 10, 'server closed retry'
+
+
+def test_proxy_keepalive_invalid():
+    def check_keepalive(keepalive):
+        assert 'error' in client.conf(
+            keepalive, 'upstreams/one/keepalive'
+        ), 'invalid keepalive'
+
+    check_keepalive({"max_idle": -1})
+    check_keepalive({"max_idle": "1"})
+    check_keepalive({"idle_timeout": "1"})
+    check_keepalive({"blah": 1})
+    check_keepalive('1')
@@ -1,3 +1,4 @@
+import os
 import re
 import shutil
 import subprocess
@@ -300,3 +301,28 @@ def test_python_restart_longstart():
     assert len(new_pids) == 1, 'restart 1'
 
     assert len(new_pids.intersection(pids)) == 0, 'restart all new'
+
+
+def test_python_cpu_affinity():
+    cpu = str(min(os.sched_getaffinity(0)))
+
+    assert 'success' in client.conf(
+        {"cpus": cpu, "spread": True},
+        f'applications/{client.app_name}/cpu_affinity',
+    )
+    conf_proc('2')
+
+    pids = pids_for_process()
+    assert len(pids) == 2, 'processes'
+
+    for pid in pids:
+        with open(f'/proc/{pid}/status') as f:
+            assert f'Cpus_allowed_list:\t{cpu}\n' in f.read(), 'bound'
+
+    assert client.get()['status'] == 200
+
+    assert 'error' in client.conf(
+        {"spread": True}, f'applications/{client.app_name}/cpu_affinity'
+    ), 'cpus required'
+
+    stop_all()
@@ -0,0 +1,86 @@
+import os
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+def listen_sockets(port):
+    count = 0
+
+    with open('/proc/net/tcp') as f:
+        for line in f.readlines()[1:]:
+            local, state = line.split()[1], line.split()[3]
+
+            if state == '0A' and int(local.split(':')[1], 16) == port:
+                count += 1
+
+    return count
+
+
+def conf_reuseport(reuseport, settings=None):
+    listener = {"pass": "routes"}
+
+    if reuseport is not None:
+        listener["reuseport"] = reuseport
+
+    return client.conf(
+        {
+            "settings": {} if settings is None else settings,
+            "listeners": {"*:8080": listener},
+            "routes": [{"action": {"return": 204}}],
+            "applications": {},
+        }
+    )
+
+
+def test_reuseport(system):
+    if system != 'Linux':
+        return
+
+    assert 'success' in conf_reuseport(True)
+
+    assert listen_sockets(8080) == os.cpu_count(), 'sockets'
+
+    for _ in range(10):
+        assert client.get()['status'] == 204
+
+    assert 'success' in conf_reuseport(None)
+    assert listen_sockets(8080) == os.cpu_count(), 'kept sockets'
+
+    assert 'success' in client.conf({}, 'listeners')
+    assert listen_sockets(8080) == 0, 'closed sockets'
+
+    assert 'success' in conf_reuseport(False)
+    assert listen_sockets(8080) == 1, 'single socket'
+
+
+def test_reuseport_cpu(system):
+    if system != 'Linux':
+        return
+
+    assert 'success' in conf_reuseport('cpu')
+
+    for _ in range(10):
+        assert client.get()['status'] == 204
+
+
+def test_reuseport_cpu_affinity(system):
+    if system != 'Linux':
+        return
+
+    cpus = sorted(os.sched_getaffinity(0))
+
+    for affinity in [str(cpus[-1]), f'{cpus[0]}-{cpus[-1]}', None]:
+        settings = None if affinity is None else {"cpu_affinity": affinity}
+
+        assert 'success' in conf_reuseport('cpu', settings), affinity
+        assert listen_sockets(8080) == os.cpu_count(), 'sockets'
+
+        for _ in range(10):
+            assert client.get()['status'] == 204
+
+
+def test_reuseport_invalid():
+    assert 'error' in conf_reuseport('numa')
+    assert 'error' in conf_reuseport(1)
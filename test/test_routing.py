@@ -316,6 +316,34 @@ def test_routes_match_regex_negative_case_sensitive(require):
     assert client.get(url='/BLAH')['status'] == 200, '/BLAH'
 
 
+def test_routes_match_regex_set(require):
+    require({'modules': {'regex': True}})
+
+    route_match({"uri": ["~^/a[0-9]+$", "~\\.php$", "~^/x(y|z)", "/exact"]})
+
+    assert client.get(url='/a12')['status'] == 200, '/a12'
+    assert client.get(url='/a')['status'] == 404, '/a'
+    assert client.get(url='/b.php')['status'] == 200, '/b.php'
+    assert client.get(url='/b.phpx')['status'] == 404, '/b.phpx'
+    assert client.get(url='/xz')['status'] == 200, '/xz'
+    assert client.get(url='/xw')['status'] == 404, '/xw'
+    assert client.get(url='/exact')['status'] == 200, '/exact'
+
+    route_match({"uri": ["!~^/a", "!~\\.php$", "~^/[a-z]", "~^/1"]})
+
+    assert client.get(url='/abc')['status'] == 404, 'negative /abc'
+    assert client.get(url='/b.php')['status'] == 404, 'negative /b.php'
+    assert client.get(url='/bc')['status'] == 200, 'negative /bc'
+    assert client.get(url='/1')['status'] == 200, 'negative /1'
+    assert client.get(url='/2')['status'] == 404, 'negative /2'
+
+    route_match({"uri": ["!~^/a", "!~(b)\\1"]})
+
+    assert client.get(url='/abc')['status'] == 404, 'backreference /abc'
+    assert client.get(url='/bb')['status'] == 404, 'backreference /bb'
+    assert client.get(url='/bc')['status'] == 200, 'backreference /bc'
+
+
 def test_routes_pass_encode():
     python_dir = f'{option.test_dir}/python'
 
@@ -1821,6 +1849,46 @@ def test_routes_source_cidr_ipv6():
     assert client.get(port=8081)['status'] == 404, '0 ipv4'
 
 
+def test_routes_source_many():
+    assert 'success' in client.conf(
+        {
+            "*:8080": {"pass": "routes"},
+            "[::1]:8081": {"pass": "routes"},
+        },
+        'listeners',
+    ), 'source listeners configure'
+
+    def get_ipv6():
+        return client.get(sock_type='ipv6', port=8081)
+
+    addrs = [f'10.{i}.0.0/16' for i in range(8)]
+
+    route_match({"source": addrs})
+    assert client.get()['status'] == 404, 'many'
+    assert get_ipv6()['status'] == 404, 'many ipv6'
+
+    route_match({"source": addrs + ["127.0.0.0-127.0.0.1"]})
+    assert client.get()['status'] == 200, 'many range'
+    assert get_ipv6()['status'] == 404, 'many range ipv6'
+
+    route_match({"source": addrs + ["127.0.0.2-127.255.255.255"]})
+    assert client.get()['status'] == 404, 'many range 2'
+
+    route_match({"source": addrs + ["127.0.0.0/8", "!127.0.0.1"]})
+    assert client.get()['status'] == 404, 'many negative'
+
+    route_match({"source": addrs + ["!127.0.0.2", "127.0.0.0/8"]})
+    assert client.get()['status'] == 200, 'many negative 2'
+
+    route_match({"source": addrs + ["::/0"]})
+    assert client.get()['status'] == 404, 'many ipv6 cidr'
+    assert get_ipv6()['status'] == 200, 'many ipv6 cidr ipv6'
+
+    route_match({"source": addrs + ["*:1-65535"]})
+    assert client.get()['status'] == 200, 'many port'
+    assert get_ipv6()['status'] == 200, 'many port ipv6'
+
+
 def test_routes_source_unix(temp_dir):
     addr = f'{temp_dir}/sock'
 
@@ -2006,3 +2074,149 @@ def test_routes_match_destination_proxy():
     ), 'proxy configure'
 
     assert client.get()['status'] == 200, 'proxy'
+
+
+def test_routes_index():
+    def action(status):
+        return {"return": status}
+
+    assert 'success' in client.conf(
+        [
+            {"match": {"host": "a.com", "uri": "/exact"}, "action": action(201)},
+            {"match": {"uri": "/pre*"}, "action": action(202)},
+            {"match": {"uri": "/prefix/deeper*"}, "action": action(203)},
+            {"match": {"uri": "/other/deep*"}, "action": action(205)},
+            {"match": {"uri": "/other*"}, "action": action(206)},
+            {"match": {"uri": "*.php"}, "action": action(207)},
+            {"match": {"host": "b.com"}, "action": action(208)},
+            {"match": {"uri": ["/x", "/y*"]}, "action": action(209)},
+            {"match": {"host": "!c.com", "uri": "/neg"}, "action": action(210)},
+            {"match": {"uri": "/exact"}, "action": action(211)},
+            {"match": {"method": "POST"}, "action": action(212)},
+            {"action": action(213)},
+        ],
+        'routes',
+    ), 'routes configure'
+
+    def check(uri, status, host='localhost', method='GET'):
+        assert (
+            client.http(
+                method,
+                url=uri,
+                headers={'Host': host, 'Connection': 'close'},
+            )['status']
+            == status
+        ), f'{method} {host}{uri}'
+
+    check('/exact', 201, 'a.com')
+    check('/exact', 211)
+    check('/exact/', 213)
+    check('/exact', 208, 'b.com')
+    check('/a', 208, 'b.com')
+    check('/pre', 202)
+    check('/prefix/deeper/x', 202)
+    check('/other/deep/x', 205)
+    check('/other/x', 206)
+    check('/otherwise', 206)
+    check('/other.php', 206)
+    check('/index.php', 207)
+    check('/x', 209)
+    check('/x/', 213)
+    check('/y/z', 209)
+    check('/neg', 210)
+    check('/neg', 213, 'c.com')
+    check('/post', 212, method='POST')
+    check('/', 213)
+
+
+def test_routes_index_many():
+    routes = []
+
+    for i in range(200):
+        routes.append(
+            {"match": {"host": f'h{i}.com'}, "action": {"return": 300 + i % 8}}
+        )
+        routes.append(
+            {"match": {"uri": f'/u{i}'}, "action": {"return": 400 + i % 8}}
+        )
+        routes.append(
+            {"match": {"uri": f'/p{i}/*'}, "action": {"return": 500 + i % 8}}
+        )
+
+    routes.append({"action": {"return": 200}})
+
+    assert 'success' in client.conf(routes, 'routes'), 'routes configure'
+
+    def check(uri, status, host='localhost'):
+        assert (
+            client.get(url=uri, headers={'Host': host, 'Connection': 'close'})[
+                'status'
+            ]
+            == status
+        ), f'{host}{uri}'
+
+    check('/', 200)
+    check('/u17', 401)
+    check('/u17', 401, 'h198.com')
+    check('/u199', 302, 'h2.com')
+    check('/p123/x', 503)
+    check('/p123', 200)
+    check('/u200', 200)
+    check('/', 307, 'h199.com')
+
+
+def test_routes_match_uri_set():
+    route_match(
+        {
+            "uri": [
+                "!/blah*",
+                "/exact",
+                "/prefix/*",
+                "*.php",
+                "*sub*",
+                "/a*b",
+                "/e1",
+                "/e2",
+                "/e3",
+                "/e4",
+                "/e5",
+            ]
+        }
+    )
+
+    assert client.get(url='/exact')['status'] == 200, 'exact'
+    assert client.get(url='/exact/')['status'] == 404, 'exact trailing'
+    assert client.get(url='/Exact')['status'] == 404, 'exact case'
+    assert client.get(url='/prefix/x')['status'] == 200, 'prefix'
+    assert client.get(url='/x/prefix/')['status'] == 404, 'prefix middle'
+    assert client.get(url='/index.php')['status'] == 200, 'suffix'
+    assert client.get(url='/index.php/')['status'] == 404, 'suffix middle'
+    assert client.get(url='/xsubx')['status'] == 200, 'substring'
+    assert client.get(url='/axxb')['status'] == 200, 'not in set'
+    assert client.get(url='/e5')['status'] == 200, 'last'
+    assert client.get(url='/e6')['status'] == 404, 'none'
+    assert client.get(url='/blah/sub')['status'] == 404, 'negative'
+
+
+def test_routes_match_headers_set():
+    route_match(
+        {"headers": {"x-blah": [f'value{i}' for i in range(10)] + ["*x*"]}}
+    )
+
+    def check(value, status):
+        assert (
+            client.get(
+                headers={
+                    'Host': 'localhost',
+                    'X-blah': value,
+                    'Connection': 'close',
+                }
+            )['status']
+            == status
+        ), f'header {value}'
+
+    check('value1', 200)
+    check('VALUE9', 200)
+    check('value10', 404)
+    check('yXy', 200)
+    check('value', 404)
@@ -234,6 +234,52 @@ def test_static_two_clients():
     sock2.close()
 
 
+def test_static_concurrent():
+    socks = [
+        client.get(url=url, no_recv=True)
+        for url in ['/', '/README', '/dir/file', '/blah', '/dir'] * 10
+    ]
+
+    for sock, (status, body) in zip(
+        socks,
+        [
+            (200, '0123456789'),
+            (200, 'readme'),
+            (200, 'blah'),
+            (404, None),
+            (301, ''),
+        ]
+        * 10,
+    ):
+        resp = client._resp_to_dict(client.recvall(sock).decode())
+        sock.close()
+
+        assert resp['status'] == status, 'concurrent status'
+
+        if body is not None:
+            assert resp['body'] == body, 'concurrent body'
+
+
+def test_static_concurrent_files(temp_dir):
+    os.makedirs(f'{temp_dir}/assets/many')
+
+    for i in range(50):
+        with open(f'{temp_dir}/assets/many/{i}', 'w') as f:
+            f.write(str(i) * 100)
+
+    socks = [
+        (client.get(url=f'/many/{i % 50}', no_recv=True), i % 50)
+        for i in range(100)
+    ]
+
+    for sock, i in socks:
+        resp = client._resp_to_dict(client.recvall(sock).decode())
+        sock.close()
+
+        assert resp['status'] == 200, 'concurrent files status'
+        assert resp['body'] == str(i) * 100, 'concurrent files body'
+
+
 def test_static_mime_types():
     assert 'success' in client.conf(
         {
@@ -0,0 +1,115 @@
+import os
+from pathlib import Path
+
+import pytest
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    Path(f'{temp_dir}/assets').mkdir()
+    Path(f'{temp_dir}/assets/index.html').write_text('0123456789')
+
+    os.utime(f'{temp_dir}/assets/index.html', (1000000000, 1000000000))
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{temp_dir}/assets$uri'}}],
+            "applications": {},
+        }
+    )
+
+
+def get(headers=None, method='GET'):
+    fields = {'Host': 'localhost', 'Connection': 'close'}
+
+    if headers is not None:
+        fields.update(headers)
+
+    return client.http(method, url='/index.html', headers=fields)
+
+
+def check_not_modified(headers, method='GET'):
+    resp = get(headers, method)
+
+    assert resp['status'] == 304, f'status {headers}'
+    assert resp['body'] == '', f'body {headers}'
+    assert 'Content-Length' not in resp['headers'], f'length {headers}'
+    assert 'Transfer-Encoding' not in resp['headers'], f'chunked {headers}'
+    assert 'ETag' in resp['headers'], f'etag {headers}'
+
+
+def check_modified(headers, body='0123456789'):
+    resp = get(headers)
+
+    assert resp['status'] == 200, f'status {headers}'
+    assert resp['body'] == body, f'body {headers}'
+
+
+def test_static_conditional_if_none_match():
+    etag = get()['headers']['ETag']
+
+    check_not_modified({'If-None-Match': etag})
+    check_not_modified({'If-None-Match': etag}, 'HEAD')
+    check_not_modified({'If-None-Match': f'W/{etag}'})
+    check_not_modified({'If-None-Match': f'"a", {etag}'})
+    check_not_modified({'If-None-Match': f'"a",W/{etag} ,"b"'})
+    check_not_modified({'If-None-Match': '*'})
+
+    check_modified({'If-None-Match': '"a"'})
+    check_modified({'If-None-Match': '"a", "b"'})
+    check_modified({'If-None-Match': etag[:-1]})
+    check_modified({'If-None-Match': etag[1:-1]})
+    check_modified({'If-None-Match': ''})
+
+
+def test_static_conditional_if_modified_since():
+    last_modified = get()['headers']['Last-Modified']
+
+    assert last_modified == 'Sun, 09 Sep 2001 01:46:40 GMT', 'last modified'
+
+    check_not_modified({'If-Modified-Since': last_modified})
+    check_not_modified({'If-Modified-Since': 'Mon, 10 Sep 2001 00:00:00 GMT'})
+
+    check_modified({'If-Modified-Since': 'Sat, 08 Sep 2001 00:00:00 GMT'})
+    check_modified({'If-Modified-Since': 'invalid'})
+
+
+def test_static_conditional_precedence():
+    resp = get()
+    etag = resp['headers']['ETag']
+    last_modified = resp['headers']['Last-Modified']
+
+    check_modified(
+        {'If-None-Match': '"a"', 'If-Modified-Since': last_modified}
+    )
+    check_not_modified(
+        {
+            'If-None-Match': etag,
+            'If-Modified-Since': 'Sat, 08 Sep 2001 00:00:00 GMT',
+        }
+    )
+
+
+def test_static_conditional_range():
+    etag = get()['headers']['ETag']
+
+    check_not_modified({'If-None-Match': etag, 'Range': 'bytes=0-1'})
+
+    resp = get({'If-None-Match': '"a"', 'Range': 'bytes=0-1'})
+    assert resp['status'] == 206, 'range'
+    assert resp['body'] == '01', 'range body'
+
+
+def test_static_conditional_modified(temp_dir):
+    resp = get()
+    etag = resp['headers']['ETag']
+    last_modified = resp['headers']['Last-Modified']
+
+    Path(f'{temp_dir}/assets/index.html').write_text('9876543210')
+
+    check_modified({'If-None-Match': etag}, '9876543210')
+    check_modified({'If-Modified-Since': last_modified}, '9876543210')
@@ -0,0 +1,187 @@
+import os
+import time
+from pathlib import Path
+
+import pytest
+from unit.applications.proto import ApplicationProto
+from unit.option import option
+from unit.status import Status
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(f'{assets_dir}/dir').mkdir(parents=True)
+    Path(f'{assets_dir}/index.html').write_text('index')
+    Path(f'{assets_dir}/dir/index.html').write_text('dir index')
+    Path(f'{assets_dir}/file.txt').write_text('file')
+    Path(f'{assets_dir}/file.txt.gz').write_text('gzip')
+
+    cache_update({})
+
+
+def cache_update(cache, extra=None):
+    action = {
+        "share": f'{option.temp_dir}/assets$uri',
+        "open_file_cache": cache,
+    }
+
+    if extra is not None:
+        action.update(extra)
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": action}],
+            "applications": {},
+        }
+    ), 'configure open file cache'
+
+
+def get(url='/index.html', headers=None):
+    fields = {'Host': 'localhost', 'Connection': 'close'}
+
+    if headers is not None:
+        fields.update(headers)
+
+    return client.get(url=url, headers=fields)
+
+
+def check_cache(hits, misses):
+    assert Status.get('/static/open_file_cache') == {
+        'hits': hits,
+        'misses': misses,
+    }, 'counters'
+
+
+def test_static_open_file_cache():
+    Status.init()
+
+    assert get()['body'] == 'index', 'first'
+    check_cache(0, 1)
+
+    assert get()['body'] == 'index', 'second'
+    assert get()['body'] == 'index', 'third'
+    check_cache(2, 1)
+
+    resp = get('/dir')
+    assert resp['status'] == 301, 'directory'
+    assert get('/dir')['status'] == 301, 'directory cached'
+    check_cache(3, 2)
+
+    resp = get('/dir/')
+    assert resp['body'] == 'dir index', 'index'
+    check_cache(3, 3)
+
+
+def test_static_open_file_cache_stale(temp_dir):
+    cache_update({"valid": 1})
+
+    assert get()['body'] == 'index', 'first'
+
+    Path(f'{temp_dir}/assets/index.tmp').write_text('new index')
+    os.rename(
+        f'{temp_dir}/assets/index.tmp', f'{temp_dir}/assets/index.html'
+    )
+
+    assert get()['body'] == 'index', 'cached'
+
+    time.sleep(2)
+
+    assert get()['body'] == 'new index', 'expired'
+
+
+def test_static_open_file_cache_deleted(temp_dir):
+    assert get()['body'] == 'index', 'first'
+
+    os.remove(f'{temp_dir}/assets/index.html')
+
+    assert get()['body'] == 'index', 'cached descriptor'
+
+
+def test_static_open_file_cache_errors(temp_dir):
+    cache_update({"valid": 1})
+
+    Status.init()
+
+    assert get('/new.html')['status'] == 404, 'not found'
+    check_cache(0, 1)
+
+    Path(f'{temp_dir}/assets/new.html').write_text('new')
+
+    assert get('/new.html')['status'] == 404, 'not found cached'
+    check_cache(1, 1)
+
+    time.sleep(2)
+
+    assert get('/new.html')['body'] == 'new', 'not found expired'
+
+    cache_update({"errors": False})
+
+    Status.init()
+
+    assert get('/none.html')['status'] == 404, 'errors disabled'
+    assert get('/none.html')['status'] == 404, 'errors disabled again'
+    check_cache(0, 2)
+
+
+def test_static_open_file_cache_max():
+    cache_update({"max": 1})
+
+    Status.init()
+
+    assert get()['body'] == 'index', 'first'
+    assert get('/file.txt')['body'] == 'file', 'second'
+    assert get()['body'] == 'index', 'evicted'
+    assert get()['body'] == 'index', 'cached'
+    check_cache(1, 3)
+
+
+def test_static_open_file_cache_precompressed():
+    cache_update({}, {"precompressed": True})
+
+    Status.init()
+
+    for _ in range(2):
+        resp = get('/file.txt', {'Accept-Encoding': 'gzip'})
+        assert resp['body'] == 'gzip', 'precompressed'
+        assert resp['headers']['Content-Encoding'] == 'gzip', 'encoding'
+
+    check_cache(2, 2)
+
+
+def test_static_open_file_cache_chroot(temp_dir):
+    if not option.available['features']['chroot']:
+        pytest.skip('requires chroot')
+
+    cache_update({}, {"chroot": f'{temp_dir}/assets'})
+
+    assert get()['body'] == 'index', 'chroot'
+    assert get()['body'] == 'index', 'chroot cached'
+
+    cache_update({}, {"chroot": f'{temp_dir}/assets/dir'})
+
+    assert get()['status'] == 403, 'chroot reconfigured'
+
+
+def test_static_open_file_cache_invalid():
+    def check_error(cache):
+        assert 'error' in client.conf(
+            {
+                "share": f'{option.temp_dir}/assets$uri',
+                "open_file_cache": cache,
+            },
+            'routes/0/action',
+        ), 'invalid open file cache'
+
+    check_error(True)
+    check_error({"max": 0})
+    check_error({"max": -1})
+    check_error({"max": 4294967296})
+    check_error({"valid": 0})
+    check_error({"valid": "1"})
+    check_error({"errors": 1})
+    check_error({"unknown": 1})
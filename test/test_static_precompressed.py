@@ -0,0 +1,157 @@
+from pathlib import Path
+
+import pytest
+from unit.applications.proto import ApplicationProto
+from unit.option import option
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(f'{assets_dir}/dir').mkdir(parents=True)
+    Path(f'{assets_dir}/index.html').write_text('index')
+    Path(f'{assets_dir}/index.html.gz').write_text('gzip')
+    Path(f'{assets_dir}/index.html.br').write_text('br')
+    Path(f'{assets_dir}/index.html.zst').write_text('zstd')
+    Path(f'{assets_dir}/file.js').write_text('file')
+    Path(f'{assets_dir}/file.js.gz').write_text('gzip file')
+    Path(f'{assets_dir}/dir.html').write_text('dir')
+    Path(f'{assets_dir}/dir.html.gz').mkdir()
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "share": f'{assets_dir}$uri',
+                        "precompressed": True,
+                    }
+                }
+            ],
+            "applications": {},
+        }
+    )
+
+
+def action_update(precompressed, temp_dir):
+    assert 'success' in client.conf(
+        {"share": f'{temp_dir}/assets$uri', "precompressed": precompressed},
+        'routes/0/action',
+    ), 'configure precompressed'
+
+
+def get(url='/index.html', accept=None, method='GET'):
+    headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    if accept is not None:
+        headers['Accept-Encoding'] = accept
+
+    return client.http(method, url=url, headers=headers)
+
+
+def test_static_precompressed():
+    resp = get()
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == 'index', 'no accept encoding'
+    assert 'Content-Encoding' not in resp['headers'], 'no encoding'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+
+    resp = get(accept='gzip')
+    assert resp['body'] == 'gzip', 'gzip'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'gzip encoding'
+    assert resp['headers']['Content-Type'] == 'text/html', 'type'
+    assert resp['headers']['Content-Length'] == '4', 'length'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'gzip vary'
+
+    resp = get(accept='gzip, zstd')
+    assert resp['body'] == 'zstd', 'zstd'
+    assert resp['headers']['Content-Encoding'] == 'zstd', 'zstd encoding'
+
+    assert get(accept='gzip, zstd, br')['body'] == 'br', 'br'
+    assert get(accept='br;q=0, gzip')['body'] == 'gzip', 'q zero'
+    assert get(accept='*')['body'] == 'br', 'star'
+    assert get(accept='identity')['body'] == 'index', 'identity'
+
+
+def test_static_precompressed_etag():
+    etag = get()['headers']['ETag']
+    etag_gzip = get(accept='gzip')['headers']['ETag']
+
+    assert etag != etag_gzip, 'etag'
+
+
+def test_static_precompressed_head():
+    resp = get(accept='gzip', method='HEAD')
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == '', 'body'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'encoding'
+    assert resp['headers']['Content-Length'] == '4', 'length'
+
+
+def test_static_precompressed_order(temp_dir):
+    action_update(["gzip", "br"], temp_dir)
+
+    assert get(accept='br, gzip')['body'] == 'gzip', 'order'
+    assert get(accept='br')['body'] == 'br', 'br'
+    assert get(accept='zstd')['body'] == 'index', 'not configured'
+
+    action_update("zstd", temp_dir)
+
+    assert get(accept='gzip, zstd')['body'] == 'zstd', 'string'
+
+
+def test_static_precompressed_missing():
+    resp = get(url='/file.js', accept='br, gzip')
+    assert resp['body'] == 'gzip file', 'fallback to the next encoding'
+
+    resp = get(url='/dir.html', accept='gzip')
+    assert resp['body'] == 'dir', 'not a file'
+    assert 'Content-Encoding' not in resp['headers'], 'not a file encoding'
+
+    assert get(url='/none.html', accept='gzip')['status'] == 404, 'not found'
+
+
+def test_static_precompressed_chroot(temp_dir):
+    if not option.available['features']['chroot']:
+        pytest.skip('requires chroot')
+
+    assert 'success' in client.conf(
+        {
+            "share": f'{temp_dir}/assets$uri',
+            "chroot": f'{temp_dir}/assets',
+            "precompressed": True,
+        },
+        'routes/0/action',
+    ), 'configure chroot'
+
+    assert get(accept='gzip')['body'] == 'gzip', 'chroot'
+    assert get(url='/file.js', accept='br')['body'] == 'file', 'chroot missing'
+
+
+def test_static_precompressed_disabled(temp_dir):
+    action_update(False, temp_dir)
+
+    resp = get(accept='gzip')
+    assert resp['body'] == 'index', 'disabled'
+    assert 'Vary' not in resp['headers'], 'disabled vary'
+
+
+def test_static_precompressed_invalid(temp_dir):
+    def check_error(precompressed):
+        assert 'error' in client.conf(
+            {
+                "share": f'{temp_dir}/assets$uri',
+                "precompressed": precompressed,
+            },
+            'routes/0/action',
+        ), 'invalid precompressed'
+
+    check_error("deflate")
+    check_error([])
+    check_error(["gzip", 1])
+    check_error(1)
+    check_error({})
@@ -0,0 +1,207 @@
+import re
+from pathlib import Path
+
+import pytest
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+body = ''.join(f'{i:08d}' for i in range(100000))
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    Path(f'{temp_dir}/assets').mkdir()
+    Path(f'{temp_dir}/assets/file.txt').write_text(body)
+    Path(f'{temp_dir}/assets/empty.txt').write_text('')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{temp_dir}/assets$uri'}}],
+            "applications": {},
+        }
+    )
+
+
+def get(range_value=None, url='/file.txt', method='GET', headers=None):
+    fields = {'Host': 'localhost', 'Connection': 'close'}
+
+    if range_value is not None:
+        fields['Range'] = range_value
+
+    if headers is not None:
+        fields.update(headers)
+
+    return client.http(
+        method, url=url, headers=fields, read_buffer_size=1024 * 1024
+    )
+
+
+def check_range(range_value, start, end):
+    resp = get(range_value)
+
+    assert resp['status'] == 206, f'status {range_value}'
+    assert resp['body'] == body[start : end + 1], f'body {range_value}'
+    assert resp['headers']['Content-Length'] == str(end - start + 1), 'length'
+    assert (
+        resp['headers']['Content-Range'] == f'bytes {start}-{end}/{len(body)}'
+    ), f'content range {range_value}'
+    assert resp['headers']['Content-Type'] == 'text/plain', 'type'
+    assert 'Accept-Ranges' not in resp['headers'], 'no accept ranges'
+
+
+def parse_multipart(resp):
+    content_type = resp['headers']['Content-Type']
+    boundary = re.search(
+        r'^multipart/byteranges; boundary=(\d+)$', content_type
+    ).group(1)
+
+    assert len(resp['body']) == int(resp['headers']['Content-Length'])
+
+    parts = resp['body'].split(f'\r\n--{boundary}')
+    assert parts[0] == '', 'preamble'
+    assert parts[-1] == '--\r\n', 'closing boundary'
+
+    result = []
+
+    for part in parts[1:-1]:
+        headers, data = part[2:].split('\r\n\r\n', 1)
+        fields = dict(h.split(': ', 1) for h in headers.split('\r\n'))
+        result.append((fields, data))
+
+    return result
+
+
+def test_static_range():
+    resp = get()
+    assert resp['status'] == 200, 'no range'
+    assert resp['headers']['Accept-Ranges'] == 'bytes', 'accept ranges'
+
+    check_range('bytes=0-0', 0, 0)
+    check_range('bytes=0-99', 0, 99)
+    check_range('bytes=100-', 100, len(body) - 1)
+    check_range('bytes=-100', len(body) - 100, len(body) - 1)
+    check_range('bytes=-1000000', 0, len(body) - 1)
+    check_range('bytes=799990-1000000', 799990, len(body) - 1)
+    check_range('bytes= 10-20 ', 10, 20)
+    check_range('BYTES=10-20', 10, 20)
+
+
+def test_static_range_large():
+    check_range('bytes=1-700000', 1, 700000)
+    check_range('bytes=131072-393216', 131072, 393216)
+
+
+def test_static_range_not_satisfiable():
+    for range_value in ['bytes=800000-', 'bytes=900000-900001', 'bytes=-0']:
+        resp = get(range_value)
+        assert resp['status'] == 416, f'status {range_value}'
+        assert (
+            resp['headers']['Content-Range'] == f'bytes */{len(body)}'
+        ), f'content range {range_value}'
+        assert resp['body'] == '', f'body {range_value}'
+
+    resp = get('bytes=0-1', url='/empty.txt')
+    assert resp['status'] == 416, 'empty file'
+
+
+def test_static_range_invalid():
+    for range_value in [
+        'bytes=',
+        'bytes=-',
+        'bytes=a-b',
+        'bytes=10-5',
+        'bytes=0-1,',
+        'bytes=0-1;2-3',
+        'items=0-1',
+        'bytes=99999999999999999999-',
+        ','.join(['bytes=0-0'] + ['1-1'] * 16),
+    ]:
+        resp = get(range_value)
+        assert resp['status'] == 200, f'ignored {range_value}'
+        assert resp['body'] == body, f'body {range_value}'
+
+
+def test_static_range_multipart():
+    resp = get('bytes=0-9,100-199,-5')
+
+    assert resp['status'] == 206, 'status'
+    assert 'Content-Range' not in resp['headers'], 'no content range'
+
+    parts = parse_multipart(resp)
+
+    assert len(parts) == 3, 'parts'
+
+    for (fields, data), (start, end) in zip(
+        parts, [(0, 9), (100, 199), (len(body) - 5, len(body) - 1)]
+    ):
+        assert fields['Content-Type'] == 'text/plain', 'part type'
+        assert (
+            fields['Content-Range'] == f'bytes {start}-{end}/{len(body)}'
+        ), 'part range'
+        assert data == body[start : end + 1], 'part body'
+
+
+def test_static_range_multipart_large():
+    resp = get('bytes=0-300000,400000-,10-19')
+
+    parts = parse_multipart(resp)
+
+    assert len(parts) == 3, 'parts'
+    assert parts[0][1] == body[: 300000 + 1], 'first'
+    assert parts[1][1] == body[400000:], 'second'
+    assert parts[2][1] == body[10:20], 'third'
+
+
+def test_static_range_multipart_unsatisfiable_part():
+    check_range('bytes=900000-,0-9', 0, 9)
+
+
+def test_static_range_overlapping():
+    for range_value in [
+        'bytes=' + ','.join(['0-'] * 16),
+        'bytes=0-499999,300000-',
+        'bytes=-800000,0-0',
+    ]:
+        resp = get(range_value)
+        assert resp['status'] == 200, f'ignored {range_value}'
+        assert resp['body'] == body, f'body {range_value}'
+        assert 'Content-Range' not in resp['headers'], 'no content range'
+
+    resp = get('bytes=0-9,5-14')
+
+    parts = parse_multipart(resp)
+
+    assert resp['status'] == 206, 'small overlap'
+    assert [data for _, data in parts] == [body[0:10], body[5:15]], 'parts'
+
+
+def test_static_range_if_range():
+    resp = get()
+    etag = resp['headers']['ETag']
+    last_modified = resp['headers']['Last-Modified']
+
+    resp = get('bytes=0-9', headers={'If-Range': etag})
+    assert resp['status'] == 206, 'etag match'
+
+    resp = get('bytes=0-9', headers={'If-Range': '"0-0"'})
+    assert resp['status'] == 200, 'etag mismatch'
+    assert resp['body'] == body, 'etag mismatch body'
+
+    resp = get('bytes=0-9', headers={'If-Range': f'W/{etag}'})
+    assert resp['status'] == 200, 'weak etag'
+
+    resp = get('bytes=0-9', headers={'If-Range': last_modified})
+    assert resp['status'] == 206, 'date match'
+
+    resp = get(
+        'bytes=0-9', headers={'If-Range': 'Mon, 01 Jan 2001 00:00:00 GMT'}
+    )
+    assert resp['status'] == 200, 'date mismatch'
+
+
+def test_static_range_head():
+    resp = get('bytes=0-9', method='HEAD')
+    assert resp['status'] == 200, 'head'
+    assert resp['headers']['Content-Length'] == str(len(body)), 'head length'
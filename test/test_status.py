@@ -152,7 +152,10 @@ def test_status_applications():
         assert apps == expert.sort()
 
     def check_application(name, running, starting, idle, active):
-        assert Status.get(f'/applications/{name}') == {
+        status = Status.get(f'/applications/{name}')
+        del status['latency']
+
+        assert status == {
             'processes': {
                 'running': running,
                 'starting': starting,
@@ -240,3 +243,76 @@ def test_status_proxy():
     assert client.get()['status'] == 200
     check_connections(2, 0, 0, 2)
     assert Status.get('/requests/total') == 2, 'proxy'
+
+
+def test_status_latency():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes/main"}},
+            "routes": {
+                "main": [
+                    {
+                        "match": {"uri": "/app"},
+                        "action": {"pass": "applications/delayed"},
+                    },
+                    {"action": {"return": 200}},
+                ]
+            },
+            "applications": {"delayed": app_default("delayed")},
+        },
+    )
+
+    assert list(client.conf_get('/status/routes/main').keys()) == ['0', '1']
+
+    Status.init()
+
+    assert client.get()['status'] == 200
+    assert client.get()['status'] == 200
+
+    latency = Status.get('/routes/main/1')
+    assert latency['ttfb']['count'] == 2, 'return ttfb'
+    assert latency['total']['count'] == 2, 'return total'
+    assert sum(latency['total']['buckets']) == 2, 'return buckets'
+    assert Status.get('/routes/main/0/total/count') == 0, 'app route'
+
+    assert (
+        client.get(
+            url='/app',
+            headers={
+                'Host': 'localhost',
+                'X-Delay': '1',
+                'Connection': 'close',
+            },
+        )['status']
+        == 200
+    )
+
+    assert Status.get('/routes/main/0/total/count') == 1, 'app route total'
+
+    latency = Status.get('/applications/delayed/latency')
+    assert latency['queue']['count'] == 1, 'app queue'
+    assert latency['ttfb']['count'] == 1, 'app ttfb'
+    assert latency['total']['count'] == 1, 'app total'
+    assert latency['total']['sum'] >= 1000000, 'app total sum'
+
+    latency = client.conf_get('/status/applications/delayed/latency/total')
+    assert latency['p50'] >= 1048576, 'app total p50'
+    assert latency['p99'] == latency['p50'], 'app total p99'
+
+    assert 'success' in client.conf('{"return": 204}', 'routes/main/1/action')
+    assert client.conf_get('/status/routes/main/1/total/count') == 0, 'reset'
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {"action": {"return": 200}},
+                {"action": {"return": 201}},
+            ],
+            "applications": {},
+        },
+    )
+    assert list(client.conf_get('/status/routes').keys()) == ['0', '1']
+
+    assert client.get()['status'] == 200
+    assert client.conf_get('/status/routes/0/ttfb/count') == 1, 'array'
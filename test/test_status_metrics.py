@@ -0,0 +1,83 @@
+import time
+
+from unit.applications.proto import ApplicationProto
+from unit.option import option
+
+client = ApplicationProto()
+
+
+def metrics():
+    resp = client.get(
+        url='/metrics',
+        sock_type='unix',
+        addr=f'{option.temp_dir}/control.unit.sock',
+    )
+
+    assert resp['status'] == 200, 'metrics status'
+    assert resp['headers']['Content-Type'].startswith('text/plain')
+
+    return resp['body']
+
+
+def metric(body, name):
+    for line in body.splitlines():
+        if line.startswith(f'{name} '):
+            return float(line.split(' ')[1])
+
+    return None
+
+
+def wait_metric(name, value):
+    for _ in range(50):
+        body = metrics()
+
+        if metric(body, name) == value:
+            return body
+
+        time.sleep(0.1)
+
+    assert metric(body, name) == value, name
+    return body
+
+
+def test_status_metrics():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes/main"}},
+            "routes": {"main": [{"action": {"return": 200}}]},
+            "applications": {},
+        }
+    )
+
+    status = client.conf_get('/status')
+    requests = status['requests']['total']
+    accepted = status['connections']['accepted']
+
+    assert '# TYPE unit_requests_total counter' in metrics()
+
+    for _ in range(3):
+        assert client.get()['status'] == 200
+
+    body = wait_metric('unit_requests_total', requests + 3)
+
+    assert metric(body, 'unit_connections_accepted_total') == accepted + 3
+    assert (
+        metric(
+            body,
+            'unit_route_latency_seconds_count'
+            '{route="main",step="0",metric="total"}',
+        )
+        == 3
+    )
+    assert (
+        'unit_route_latency_seconds_bucket'
+        '{route="main",step="0",metric="total",le="+Inf"} 3' in body
+    )
+
+
+def test_status_metrics_method():
+    assert client.post(
+        url='/metrics',
+        sock_type='unix',
+        addr=f'{option.temp_dir}/control.unit.sock',
+    )['status'] == 405, 'metrics method'
@@ -0,0 +1,165 @@
+import shutil
+import subprocess
+
+import pytest
+from unit.applications.tls import ApplicationTLS
+from unit.option import option
+
+prerequisites = {'modules': {'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    if shutil.which('openssl') is None:
+        pytest.skip('openssl command line tool is required')
+
+    client.certificate()
+
+    if 'success' not in conf_early_data(True):
+        pytest.skip('TLSv1.3 early data is not supported')
+
+
+def conf_early_data(early_data, session=None):
+    if session is None:
+        session = {"cache_size": 16}
+
+    return client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {
+                        "certificate": "default",
+                        "early_data": early_data,
+                        "session": session,
+                    },
+                }
+            },
+            "routes": [
+                {
+                    "match": {
+                        "tls_early_data": True,
+                        "method": ["!GET", "!HEAD", "!OPTIONS"],
+                    },
+                    "action": {"return": 425},
+                },
+                {
+                    "action": {
+                        "return": 200,
+                        "response_headers": {"X-Early": "e$tls_early_data"},
+                    }
+                },
+            ],
+            "applications": {},
+        }
+    )
+
+
+def request(method='GET', close=True):
+    conn = 'close' if close else 'keep-alive'
+
+    return (
+        f'{method} / HTTP/1.1\r\nHost: localhost\r\n'
+        f'Content-Length: 0\r\nConnection: {conn}\r\n\r\n'
+    )
+
+
+def s_client(*args, data=''):
+    return subprocess.run(
+        [
+            'openssl',
+            's_client',
+            '-connect',
+            '127.0.0.1:8080',
+            '-tls1_3',
+            '-ign_eof',
+            *args,
+        ],
+        input=data.encode(),
+        capture_output=True,
+        timeout=10,
+    ).stdout.decode('latin-1')
+
+
+def session(name='session'):
+    sess = f'{option.temp_dir}/{name}.pem'
+
+    out = s_client('-sess_out', sess, data=request())
+    assert 'X-Early: e\r\n' in out, 'full handshake'
+
+    return sess
+
+
+def early_data(sess, method='GET', data='', name='early'):
+    early = f'{option.temp_dir}/{name}'
+
+    with open(early, 'w') as f:
+        f.write(request(method, close=(data == '')))
+
+    return s_client('-sess_in', sess, '-early_data', early, data=data)
+
+
+def test_tls_early_data():
+    out = early_data(session())
+
+    assert 'Early data was accepted' in out, 'accepted'
+    assert 'HTTP/1.1 200' in out, 'status'
+    assert 'X-Early: e1\r\n' in out, 'variable'
+
+
+def test_tls_early_data_replay():
+    sess = session()
+
+    assert 'Early data was accepted' in early_data(sess), 'first'
+
+    out = early_data(sess, data=request())
+
+    assert 'Early data was rejected' in out, 'replay rejected'
+    assert 'X-Early: e\r\n' in out, 'replay after handshake'
+
+
+def test_tls_early_data_unsafe_method():
+    out = early_data(session(), method='POST')
+
+    assert 'Early data was accepted' in out, 'accepted'
+    assert 'HTTP/1.1 425' in out, 'rejected by route'
+
+    out = s_client(data=request('POST'))
+    assert 'HTTP/1.1 200' in out, 'no early data'
+
+
+def test_tls_early_data_keepalive():
+    out = early_data(session(), data=request())
+
+    assert 'Early data was accepted' in out, 'accepted'
+    assert out.count('HTTP/1.1 200') == 2, 'two responses'
+    assert out.index('X-Early: e1\r\n') < out.index('X-Early: e\r\n'), 'order'
+
+
+def test_tls_early_data_disabled():
+    sess = session()
+
+    assert 'success' in conf_early_data(False)
+
+    out = early_data(sess, data=request())
+
+    assert 'Early data was accepted' not in out, 'disabled'
+    assert 'X-Early: e\r\n' in out, 'after handshake'
+
+
+def test_tls_early_data_invalid():
+    assert 'error' in conf_early_data('yes'), 'invalid value'
+    assert 'error' in conf_early_data(True, {}), 'no session cache'
+    assert 'error' in conf_early_data(True, {"cache_size": 0}), 'zero cache'
+    assert 'error' in conf_early_data(
+        True, {"cache_size": 16, "tickets": True}
+    ), 'stateless tickets'
+    assert 'success' in conf_early_data(
+        True, {"cache_size": 16, "tickets": False}
+    ), 'no tickets'
+
+    assert 'error' in client.conf(
+        {"tls_early_data": 'yes'}, 'routes/0/match'
+    ), 'invalid match'
@@ -0,0 +1,81 @@
+import socket
+import ssl
+
+import pytest
+from unit.applications.tls import ApplicationTLS
+
+prerequisites = {'modules': {'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    client.certificate()
+
+    assert 'success' in conf_offload(True)
+
+
+def conf_offload(offload):
+    return client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {
+                        "certificate": "default",
+                        "handshake_offload": offload,
+                    },
+                }
+            },
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        }
+    )
+
+
+def get_ssl_close():
+    return client.get_ssl(
+        headers={'Host': 'localhost', 'Connection': 'close'}
+    )
+
+
+def test_tls_handshake_offload():
+    for _ in range(10):
+        assert get_ssl_close()['status'] == 200
+
+    socks = []
+
+    for _ in range(10):
+        socks.append(
+            client.get_ssl(
+                headers={'Host': 'localhost', 'Connection': 'close'},
+                no_recv=True,
+            )
+        )
+
+    for sock in socks:
+        assert client.recvall(sock).startswith(b'HTTP/1.1 200'), 'parallel'
+        sock.close()
+
+    assert 'success' in conf_offload(False)
+    assert get_ssl_close()['status'] == 200
+
+
+def test_tls_handshake_offload_failed():
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.set_ciphers('eNULL')
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    with pytest.raises((ssl.SSLError, OSError)):
+        with socket.create_connection(('127.0.0.1', 8080)) as sock:
+            context.wrap_socket(sock).close()
+
+    assert get_ssl_close()['status'] == 200
+
+
+def test_tls_handshake_offload_invalid():
+    assert 'error' in conf_offload('yes'), 'invalid value'
+    assert 'error' in conf_offload(1), 'invalid number'
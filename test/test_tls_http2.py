@@ -0,0 +1,285 @@
+import shutil
+import socket
+import ssl
+import struct
+import subprocess
+import time
+
+import pytest
+from unit.applications.tls import ApplicationTLS
+
+prerequisites = {'modules': {'python': 'any', 'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    curl = shutil.which('curl')
+
+    if curl is None or 'HTTP2' not in subprocess.check_output(
+        [curl, '--version'], text=True
+    ):
+        pytest.skip('requires curl with HTTP/2 support')
+
+
+def add_tls(application='variables', http2=True):
+    client.load(application)
+
+    client.certificate()
+
+    assert 'success' in client.conf(
+        {
+            "pass": f"applications/{application}",
+            "tls": {"certificate": "default", "http2": http2},
+        },
+        'listeners/*:8080',
+    )
+
+
+def curl(*args, urls=('/',)):
+    output = subprocess.check_output(
+        [
+            'curl',
+            '-k',
+            '-s',
+            '-i',
+            '--http2',
+            '-H',
+            'Content-Type: text/html',
+            '-H',
+            'Custom-Header: blah',
+            *args,
+            *[f'https://127.0.0.1:8080{url}' for url in urls],
+        ],
+        text=True,
+    )
+
+    return output.split('\n\n')[:-1]
+
+
+def headers(resp):
+    lines = resp.split('\n')
+    fields = {}
+
+    for line in lines[1:]:
+        name, value = line.split(': ', 1)
+        fields[name.lower()] = value
+
+    return lines[0], fields
+
+
+def test_tls_http2_get():
+    add_tls()
+
+    resps = curl()
+
+    status, fields = headers(resps[0])
+
+    assert status.startswith('HTTP/2 200'), 'status'
+    assert fields['server-protocol'] == 'HTTP/2.0', 'protocol'
+    assert fields['request-method'] == 'GET', 'method'
+    assert fields['request-uri'] == '/', 'uri'
+    assert fields['http-host'] == '127.0.0.1:8080', 'host'
+    assert fields['custom-header'] == 'blah', 'custom header'
+    assert fields['wsgi-url-scheme'] == 'https', 'scheme'
+    assert 'connection' not in fields, 'no connection header'
+
+
+def test_tls_http2_post():
+    add_tls()
+
+    body = 'X' * 100000
+
+    output = subprocess.check_output(
+        [
+            'curl',
+            '-k',
+            '-s',
+            '--http2',
+            '-H',
+            'Content-Type: text/plain',
+            '-H',
+            'Custom-Header: blah',
+            '--data-binary',
+            body,
+            'https://127.0.0.1:8080/',
+        ],
+        text=True,
+    )
+
+    assert output == body, 'body'
+
+
+def test_tls_http2_post_chunked():
+    add_tls(application='mirror')
+
+    body = '0123456789' * 1000
+
+    output = subprocess.check_output(
+        [
+            'curl',
+            '-k',
+            '-s',
+            '--http2',
+            '-H',
+            'Transfer-Encoding: chunked',
+            '--data-binary',
+            body,
+            'https://127.0.0.1:8080/',
+        ],
+        text=True,
+    )
+
+    assert output == body, 'body without content length'
+
+
+def test_tls_http2_multiple():
+    add_tls()
+
+    urls = [f'/{i}' for i in range(10)]
+
+    resps = curl(urls=urls)
+
+    assert len(resps) == 10, 'responses'
+
+    for i, resp in enumerate(resps):
+        status, fields = headers(resp)
+
+        assert status.startswith('HTTP/2 200'), 'status'
+        assert fields['request-uri'] == f'/{i}', 'uri'
+
+    assert 'Re-using existing connection' in subprocess.run(
+        [
+            'curl',
+            '-k',
+            '-s',
+            '-v',
+            '--http2',
+            '-o',
+            '/dev/null',
+            '-o',
+            '/dev/null',
+            'https://127.0.0.1:8080/',
+            'https://127.0.0.1:8080/',
+        ],
+        capture_output=True,
+        text=True,
+    ).stderr, 'connection reuse'
+
+
+def test_tls_http2_disabled():
+    add_tls(http2=False)
+
+    resps = curl()
+
+    status, fields = headers(resps[0])
+
+    assert status.startswith('HTTP/1.1 200'), 'http/1.1 fallback'
+    assert fields['server-protocol'] == 'HTTP/1.1', 'protocol'
+
+
+def test_tls_http2_invalid():
+    client.load('empty')
+
+    client.certificate()
+
+    assert 'error' in client.conf(
+        {
+            "pass": "applications/empty",
+            "tls": {"certificate": "default", "http2": "yes"},
+        },
+        'listeners/*:8080',
+    ), 'invalid http2 value'
+
+
+def test_tls_http2_rapid_reset(wait_for_record):
+    client.certificate()
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {"certificate": "default", "http2": True},
+                }
+            },
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        }
+    )
+
+    def frame(type, flags, stream, payload=b''):
+        return (
+            struct.pack('>I', len(payload))[1:]
+            + struct.pack('>BBI', type, flags, stream)
+            + payload
+        )
+
+    # GET / with the :authority "localhost", HPACK encoded.
+    headers = b'\x82\x87\x84\x41\x09localhost'
+
+    context = ssl.create_default_context()
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.set_alpn_protocols(['h2'])
+
+    sock = context.wrap_socket(
+        socket.create_connection(('127.0.0.1', 8080), timeout=10)
+    )
+
+    assert sock.selected_alpn_protocol() == 'h2', 'alpn'
+
+    sock.sendall(b'PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n' + frame(0x4, 0, 0))
+
+    stream = 1
+
+    for _ in range(3):
+        data = b''
+
+        for _ in range(100):
+            data += frame(0x1, 0x5, stream, headers)
+            data += frame(0x3, 0, stream, struct.pack('>I', 0x8))
+            stream += 2
+
+        try:
+            sock.sendall(data)
+
+        except (ConnectionError, ssl.SSLError):
+            break
+
+        time.sleep(0.2)
+
+    resp = b''
+
+    while True:
+        try:
+            part = sock.recv(16384)
+
+        except (ConnectionError, ssl.SSLError):
+            break
+
+        if not part:
+            break
+
+        resp += part
+
+    sock.close()
+
+    goaway = None
+    pos = 0
+
+    while pos + 9 <= len(resp):
+        length = int.from_bytes(resp[pos : pos + 3], 'big')
+        type = resp[pos + 3]
+
+        if type == 0x7:
+            goaway = struct.unpack('>II', resp[pos + 9 : pos + 17])
+
+        pos += 9 + length
+
+    assert goaway is not None, 'goaway'
+    assert goaway[1] == 0xB, 'enhance your calm'
+    assert goaway[0] < 599, 'last stream'
+
+    assert wait_for_record(r'h2p client reset too many streams'), 'log'
@@ -0,0 +1,64 @@
+import os
+
+import pytest
+from unit.applications.tls import ApplicationTLS
+
+prerequisites = {'modules': {'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    os.makedirs(f'{temp_dir}/assets')
+
+    with open(f'{temp_dir}/assets/big', 'wb') as big:
+        big.write(os.urandom(1024 * 1024))
+
+    client.certificate()
+
+    if 'success' not in conf_ktls(temp_dir, True):
+        pytest.skip('kTLS is not supported')
+
+
+def conf_ktls(temp_dir, ktls):
+    return client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {"certificate": "default", "ktls": ktls},
+                }
+            },
+            "routes": [{"action": {"share": f'{temp_dir}/assets$uri'}}],
+            "applications": {},
+        }
+    )
+
+
+def test_tls_ktls_static(temp_dir):
+    with open(f'{temp_dir}/assets/big', 'rb') as f:
+        data = f.read()
+
+    for _ in range(2):
+        resp = client.get_ssl(url='/big', encoding='latin-1')
+
+        assert resp['status'] == 200, 'status'
+        assert resp['body'].encode('latin-1') == data, 'body'
+
+    resp = client.get_ssl(
+        url='/big',
+        encoding='latin-1',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=10-19,-5',
+            'Connection': 'close',
+        },
+    )
+
+    assert resp['status'] == 206, 'ranges status'
+    assert data[10:20].decode('latin-1') in resp['body'], 'ranges body'
+
+
+def test_tls_ktls_invalid(temp_dir):
+    assert 'error' in conf_ktls(temp_dir, 'yes'), 'invalid ktls value'
@@ -0,0 +1,124 @@
+import os
+import socket
+import ssl
+import time
+
+import pytest
+from unit.applications.tls import ApplicationTLS
+
+prerequisites = {'modules': {'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+# Small record payload plus generous TLS record overhead.
+RECORD_SMALL = 1369 + 256
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    os.makedirs(f'{temp_dir}/assets')
+
+    with open(f'{temp_dir}/assets/big', 'wb') as big:
+        big.write(os.urandom(512 * 1024))
+
+    client.certificate()
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {"certificate": "default"},
+                }
+            },
+            "routes": [{"action": {"share": f'{temp_dir}/assets$uri'}}],
+            "applications": {},
+        }
+    )
+
+
+class TLSRecords:
+    def __init__(self):
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+
+        self.incoming = ssl.MemoryBIO()
+        self.outgoing = ssl.MemoryBIO()
+        self.tls = context.wrap_bio(self.incoming, self.outgoing)
+        self.sock = socket.create_connection(('127.0.0.1', 8080))
+        self.sock.settimeout(10)
+
+        while True:
+            try:
+                self.tls.do_handshake()
+                break
+
+            except ssl.SSLWantReadError:
+                self.sock.sendall(self.outgoing.read())
+                self.incoming.write(self.sock.recv(65536))
+
+        self.sock.sendall(self.outgoing.read())
+
+    def get(self, url, length):
+        self.tls.write(
+            f'GET {url} HTTP/1.1\r\nHost: localhost\r\n\r\n'.encode()
+        )
+        self.sock.sendall(self.outgoing.read())
+
+        raw = b''
+        data = b''
+
+        while (
+            b'\r\n\r\n' not in data
+            or len(data.split(b'\r\n\r\n', 1)[1]) < length
+        ):
+            part = self.sock.recv(65536)
+            assert part, 'connection closed'
+
+            raw += part
+            self.incoming.write(part)
+
+            try:
+                while True:
+                    data += self.tls.read(65536)
+
+            except ssl.SSLWantReadError:
+                pass
+
+        return self.records(raw), data
+
+    @staticmethod
+    def records(raw):
+        sizes = []
+
+        while len(raw) >= 5:
+            size = int.from_bytes(raw[3:5], 'big')
+
+            if raw[0] == 23:
+                sizes.append(size)
+
+            raw = raw[5 + size :]
+
+        return sizes
+
+    def close(self):
+        self.sock.close()
+
+
+def test_tls_records_ramp():
+    conn = TLSRecords()
+
+    sizes, data = conn.get('/big', 512 * 1024)
+
+    assert data.startswith(b'HTTP/1.1 200'), 'status'
+    assert max(sizes[:10]) <= RECORD_SMALL, 'small records first'
+    assert max(sizes) > 8192, 'large records later'
+
+    time.sleep(1.5)
+
+    sizes, _ = conn.get('/big', 512 * 1024)
+
+    assert max(sizes[:10]) <= RECORD_SMALL, 'small records after idle'
+
+    conn.close()
@@ -13,6 +13,7 @@ from OpenSSL.SSL import (
     _lib,
 )
 from unit.applications.tls import ApplicationTLS
+from unit.status import Status
 
 prerequisites = {'modules': {'openssl': 'any'}}
 
@@ -73,6 +74,18 @@ def connect(ctx=None, session=None):
     )
 
 
+def wait_session_cache(value):
+    # Offloaded handshakes are counted once the job returns to the engine.
+
+    for _ in range(50):
+        if Status.get('/tls/session_cache') == value:
+            return
+
+        time.sleep(0.1)
+
+    assert Status.get('/tls/session_cache') == value, 'session cache'
+
+
 @pytest.mark.skipif(
     not hasattr(_lib, 'SSL_session_reused'),
     reason='session reuse is not supported',
@@ -133,6 +146,60 @@ def test_tls_session_timeout():
     assert not reused, 'timeout'
 
 
+@pytest.mark.skipif(
+    not hasattr(_lib, 'SSL_session_reused'),
+    reason='session reuse is not supported',
+)
+def test_tls_session_reconfigure():
+    assert 'success' in add_session(cache_size=5)
+
+    Status.init()
+
+    _, sess, ctx, reused = connect()
+    assert not reused, 'new connection'
+
+    assert 'success' in client.conf({"return": 204}, 'routes/0/action')
+
+    _, _, _, reused = connect(ctx, sess)
+    assert reused, 'reconfigure'
+
+    assert Status.get('/tls/session_cache') == {'hits': 1, 'misses': 0}
+
+    assert 'success' in add_session(cache_size=6)
+
+    _, _, _, reused = connect(ctx, sess)
+    assert not reused, 'cache size changed'
+
+
+@pytest.mark.skipif(
+    not hasattr(_lib, 'SSL_session_reused'),
+    reason='session reuse is not supported',
+)
+def test_tls_session_handshake_offload():
+    assert 'success' in client.conf(
+        'true', 'listeners/*:8080/tls/handshake_offload'
+    )
+    assert 'success' in add_session(cache_size=5)
+
+    Status.init()
+
+    _, sess, ctx, reused = connect()
+    assert not reused, 'new connection'
+
+    for _ in range(3):
+        _, _, _, reused = connect(ctx, sess)
+        assert reused, 'offload'
+
+    wait_session_cache({'hits': 3, 'misses': 0})
+
+    assert 'success' in add_session(cache_size=6)
+
+    _, _, _, reused = connect(ctx, sess)
+    assert not reused, 'offload miss'
+
+    wait_session_cache({'hits': 3, 'misses': 1})
+
+
 def test_tls_session_invalid():
     assert 'error' in add_session(cache_size=-1)
     assert 'error' in add_session(cache_size={})
@@ -0,0 +1,9 @@
+import re
+
+
+def check_zlib(output_version):
+    return re.search('--zlib', output_version)
+
+
+def check_zstd(output_version):
+    return re.search('--zstd', output_version)
@@ -2,6 +2,7 @@ import subprocess
 import sys
 
 from unit.check.chroot import check_chroot
+from unit.check.compress import check_zlib, check_zstd
 from unit.check.go import check_go
 from unit.check.isolation import check_isolation
 from unit.check.njs import check_njs
@@ -38,6 +39,8 @@ def discover_available(unit):
     option.available['modules']['node'] = check_node()
     option.available['modules']['openssl'] = check_openssl(output_version)
     option.available['modules']['regex'] = check_regex(output_version)
+    option.available['modules']['zlib'] = check_zlib(output_version)
+    option.available['modules']['zstd'] = check_zstd(output_version)
 
     # Discover features using check. Features should be discovered after
     # modules since some features can require modules.
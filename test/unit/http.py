@@ -116,9 +116,9 @@ class HTTP1:
 
             headers = resp.get('headers')
             if headers and headers.get('Transfer-Encoding') == 'chunked':
-                resp['body'] = self._parse_chunked_body(resp['body']).decode(
-                    encoding
-                )
+                resp['body'] = self._parse_chunked_body(
+                    resp['body'].encode(encoding)
+                ).decode(encoding)
 
             if 'json' in kwargs:
                 resp = self._parse_json(resp)
@@ -14,6 +14,9 @@ class Status:
                 'closed': 0,
             },
             'requests': {'total': 0},
+            'static': {'open_file_cache': {'hits': 0, 'misses': 0}},
+            'tls': {'session_cache': {'hits': 0, 'misses': 0}},
+            'routes': {},
             'applications': {},
         }
 
@@ -30,6 +33,10 @@ class Status:
                     for k in d1
                     if k in d2
                 }
+            elif isinstance(d1, list) and isinstance(d2, list):
+                return [find_diffs(v1, v2) for v1, v2 in zip(d1, d2)]
+            elif d1 is None or d2 is None:
+                return d1
             else:
                 return d1 - d2
 